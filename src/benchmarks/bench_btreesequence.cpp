@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "benchmark.h"
+#include <microcore/data/btreesequence.h>
+#include <microcore/data/indexeddatastore.h>
+#include <microcore/data/indexedmodel.h>
+#include <deque>
+#include <vector>
+
+using namespace ::microcore::data;
+using namespace ::microcore::benchmarks;
+
+namespace {
+
+using Deque = std::deque<const int *>;
+using BTree = BTreeSequence<const int *>;
+
+template<class S>
+void fill(S &sequence, std::size_t count)
+{
+    static const int value {0};
+    for (std::size_t i = 0; i < count; ++i) {
+        sequence.push_back(&value);
+    }
+}
+
+// Inserts and removes a row in the middle
+template<class S>
+void benchmarkMiddleInsert(State &state)
+{
+    S sequence {};
+    fill(sequence, state.argument());
+    const int value {1};
+    std::size_t index {0};
+    while (state.next()) {
+        sequence.insert(std::begin(sequence) + index, &value);
+        sequence.erase(std::begin(sequence) + (state.argument() - index));
+        index = (index + 7919) % state.argument();
+    }
+}
+
+// Moves a row, like IndexedModel::move() does
+template<class S>
+void benchmarkMove(State &state)
+{
+    S sequence {};
+    fill(sequence, state.argument());
+    std::size_t index {0};
+    while (state.next()) {
+        std::size_t toIndex {(index * 31) % state.argument()};
+        const int *value {sequence[index]};
+        sequence.erase(std::begin(sequence) + index);
+        sequence.insert(std::begin(sequence) + toIndex, value);
+        index = (index + 7919) % state.argument();
+    }
+}
+
+template<class S>
+void benchmarkRandomAccess(State &state)
+{
+    S sequence {};
+    fill(sequence, state.argument());
+    std::size_t index {0};
+    while (state.next()) {
+        doNotOptimize(sequence[index]);
+        index = (index + 7919) % state.argument();
+    }
+}
+
+// Iterates over all the rows, per row
+template<class S>
+void benchmarkIterate(State &state)
+{
+    S sequence {};
+    fill(sequence, state.argument());
+    auto it = std::begin(sequence);
+    while (state.next()) {
+        doNotOptimize(*it);
+        ++it;
+        if (it == std::end(sequence)) {
+            it = std::begin(sequence);
+        }
+    }
+}
+
+class IdentityMapper
+{
+public:
+    using KeyType = int;
+    int operator()(int value) const
+    {
+        return value;
+    }
+};
+
+template<class S>
+void benchmarkModelMove(State &state)
+{
+    IndexedDataStore<int, int> store {};
+    IndexedModel<int, IdentityMapper, S> model {store};
+    std::vector<int> values {};
+    for (std::size_t i = 0; i < state.argument(); ++i) {
+        values.push_back(static_cast<int>(i));
+    }
+    model.append(std::move(values));
+    std::size_t index {0};
+    while (state.next()) {
+        model.move(index, (index * 31) % state.argument());
+        index = (index + 7919) % state.argument();
+    }
+}
+
+}
+
+// Argument is the number of rows
+MICROCORE_BENCHMARK_ARGS(DequeMiddleInsert, 1000, 50000, 500000)
+{
+    benchmarkMiddleInsert<Deque>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(BTreeMiddleInsert, 1000, 50000, 500000)
+{
+    benchmarkMiddleInsert<BTree>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(DequeMove, 1000, 50000, 500000)
+{
+    benchmarkMove<Deque>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(BTreeMove, 1000, 50000, 500000)
+{
+    benchmarkMove<BTree>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(DequeRandomAccess, 1000, 50000, 500000)
+{
+    benchmarkRandomAccess<Deque>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(BTreeRandomAccess, 1000, 50000, 500000)
+{
+    benchmarkRandomAccess<BTree>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(DequeIterate, 1000, 50000, 500000)
+{
+    benchmarkIterate<Deque>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(BTreeIterate, 1000, 50000, 500000)
+{
+    benchmarkIterate<BTree>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(DequeModelMove, 1000, 50000, 500000)
+{
+    benchmarkModelMove<Deque>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(BTreeModelMove, 1000, 50000, 500000)
+{
+    benchmarkModelMove<BTree>(state);
+}
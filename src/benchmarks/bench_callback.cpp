@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "benchmark.h"
+#include <microcore/core/callback.h>
+#include <microcore/core/pipe.h>
+#include <microcore/core/staticpipeline.h>
+#include <functional>
+
+using namespace ::microcore::core;
+using namespace ::microcore::benchmarks;
+
+namespace {
+
+class Error
+{
+public:
+    static Error cancelled()
+    {
+        return Error();
+    }
+    static Error timeout()
+    {
+        return Error();
+    }
+};
+
+// What a pipeline hop used to cost: callbacks are std::function,
+// built with std::bind, and copied by the job into its own handler.
+class LegacyJob
+{
+public:
+    using OnResult = std::function<void (int &&)>;
+    using OnError = std::function<void (Error &&)>;
+    explicit LegacyJob(int value)
+        : m_value {value}
+    {
+    }
+    void execute(OnResult &&onResult, OnError &&onError)
+    {
+        std::function<void ()> handler {[this, onResult, onError]() {
+            onResult(m_value + 1);
+        }};
+        handler();
+    }
+private:
+    int m_value {0};
+};
+
+class LegacyStage
+{
+public:
+    void send(int &&value)
+    {
+        using namespace std::placeholders;
+        LegacyJob::OnResult onResult {std::bind(&LegacyStage::onResult, this, _1)};
+        LegacyJob::OnError onError {std::bind(&LegacyStage::onError, this, _1)};
+        LegacyJob job {value};
+        job.execute(std::move(onResult), std::move(onError));
+    }
+    int result() const
+    {
+        return m_result;
+    }
+private:
+    void onResult(int &&value)
+    {
+        m_result = value;
+    }
+    void onError(Error &&)
+    {
+    }
+    int m_result {0};
+};
+
+// The same hop with Callback: callbacks are lambdas stored
+// inline, and moved by the job into its own handler.
+class CallbackJob
+{
+public:
+    using OnResult = Callback<void (int &&)>;
+    using OnError = Callback<void (Error &&)>;
+    explicit CallbackJob(int value)
+        : m_value {value}
+    {
+    }
+    void execute(OnResult &&onResult, OnError &&onError)
+    {
+        m_onResult = std::move(onResult);
+        m_onError = std::move(onError);
+        Callback<void ()> handler {[this]() {
+            m_onResult(m_value + 1);
+        }};
+        handler();
+    }
+private:
+    int m_value {0};
+    OnResult m_onResult {};
+    OnError m_onError {};
+};
+
+class CallbackStage
+{
+public:
+    void send(int &&value)
+    {
+        CallbackJob job {value};
+        job.execute([this](int &&result) { m_result = result; }, [](Error &&) {});
+    }
+    int result() const
+    {
+        return m_result;
+    }
+private:
+    int m_result {0};
+};
+
+class IncrementJob: public IJob<int, Error>
+{
+public:
+    explicit IncrementJob(int value)
+        : m_value {value}
+    {
+    }
+    void execute(OnResult &&onResult, OnError &&) override
+    {
+        onResult(m_value + 1);
+    }
+private:
+    int m_value {0};
+};
+
+class IncrementJobFactory: public IJobFactory<int, int, Error>
+{
+public:
+    std::unique_ptr<IJob<int, Error>> create(int &&request) const override
+    {
+        return std::unique_ptr<IJob<int, Error>>(new IncrementJob(request));
+    }
+};
+
+}
+
+MICROCORE_BENCHMARK(LegacyFunctionHop)
+{
+    LegacyStage stage {};
+    while (state.next()) {
+        stage.send(1);
+        doNotOptimize(stage.result());
+    }
+}
+
+MICROCORE_BENCHMARK(CallbackHop)
+{
+    CallbackStage stage {};
+    while (state.next()) {
+        stage.send(1);
+        doNotOptimize(stage.result());
+    }
+}
+
+// Argument is the number of pipes in the pipeline. Allocations
+// include the IJob created by the factory for each pipe.
+MICROCORE_BENCHMARK_ARGS(PipeHop, 1, 4)
+{
+    using IntPipe = Pipe<int, int, Error>;
+    IncrementJobFactory factory {};
+    int result {0};
+    std::unique_ptr<IntPipe> last {new IntPipe(factory, [&result](int &&value) { result = value; }, [](Error &&) {})};
+    std::vector<std::unique_ptr<IntPipe>> pipes {};
+    IntPipe *first {last.get()};
+    for (std::size_t i = 1; i < state.argument(); ++i) {
+        pipes.push_back(first->prepend(factory));
+        first = pipes.back().get();
+    }
+    while (state.next()) {
+        first->send(0);
+        doNotOptimize(result);
+    }
+}
+
+MICROCORE_BENCHMARK(StaticPipeHop)
+{
+    IncrementJobFactory factory {};
+    int result {0};
+    auto pipe = makePipeline(factory, factory, factory, factory).create([&result](int &&value) { result = value; }, [](Error &&) {});
+    while (state.next()) {
+        pipe->send(0);
+        doNotOptimize(result);
+    }
+}
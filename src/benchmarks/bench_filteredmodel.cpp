@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "benchmark.h"
+#include <microcore/data/btreesequence.h>
+#include <microcore/data/filteredmodel.h>
+#include <microcore/data/indexeddatastore.h>
+#include <microcore/data/indexedmodel.h>
+#include <vector>
+
+using namespace ::microcore::data;
+using namespace ::microcore::benchmarks;
+
+namespace {
+
+class Score
+{
+public:
+    explicit Score(int k, int v)
+        : key {k}
+        , value {v}
+    {
+    }
+    int key {0};
+    int value {0};
+};
+
+class ScoreMapper
+{
+public:
+    using KeyType = int;
+    int operator()(const Score &score) const
+    {
+        return score.key;
+    }
+};
+
+using Sequence = BTreeSequence<const Score *>;
+
+class Fixture
+{
+public:
+    explicit Fixture(std::size_t count)
+    {
+        std::vector<Score> scores {};
+        scores.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            scores.emplace_back(static_cast<int>(i), static_cast<int>(i * 7919 % count));
+        }
+        source.append(std::move(scores));
+    }
+    IndexedDataStore<int, Score> store {};
+    IndexedModel<Score, ScoreMapper, Sequence> source {store};
+};
+
+// Accepts the rows whose value is a multiple of modulo
+class Multiple
+{
+public:
+    explicit Multiple(int modulo)
+        : m_modulo {modulo}
+    {
+    }
+    bool operator()(const Score &score) const
+    {
+        return score.value % m_modulo == 0;
+    }
+private:
+    int m_modulo {1};
+};
+
+}
+
+// Argument is the number of rows
+
+// Changes the predicate by building a new filtered model
+MICROCORE_BENCHMARK_ARGS(FilteredModelRebuild, 1000, 10000, 100000)
+{
+    Fixture fixture {state.argument()};
+    int modulo {2};
+    while (state.next()) {
+        FilteredModel<Score, Sequence> filtered {fixture.source, Multiple(modulo)};
+        doNotOptimize(filtered);
+        modulo = modulo % 4 + 2;
+    }
+}
+
+// Changes the predicate of a filtered model
+MICROCORE_BENCHMARK_ARGS(FilteredModelSetPredicate, 1000, 10000, 100000)
+{
+    Fixture fixture {state.argument()};
+    FilteredModel<Score, Sequence> filtered {fixture.source, Multiple(2)};
+    int modulo {3};
+    while (state.next()) {
+        filtered.setPredicate(Multiple(modulo));
+        modulo = modulo % 4 + 2;
+    }
+}
+
+// Updates a row in the source, its predicate being evaluated again
+MICROCORE_BENCHMARK_ARGS(FilteredModelUpdate, 1000, 10000, 100000)
+{
+    Fixture fixture {state.argument()};
+    FilteredModel<Score, Sequence> filtered {fixture.source, Multiple(2)};
+    std::size_t index {0};
+    int value {0};
+    while (state.next()) {
+        fixture.source.update(index, Score(fixture.source[index]->key, value));
+        index = (index + 7919) % state.argument();
+        ++value;
+    }
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "benchmark.h"
+#include <microcore/data/indexeddatastore.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace ::microcore::data;
+using namespace ::microcore::benchmarks;
+
+namespace {
+
+class Entity
+{
+public:
+    explicit Entity(int v)
+        : value {v}
+    {
+    }
+    int value {0};
+};
+
+// Keys look like the string ids of our entities
+std::vector<std::string> createKeys(std::size_t count)
+{
+    std::vector<std::string> keys {};
+    keys.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        keys.push_back("entity-" + std::to_string(i * 7919 % (count * 4)) + "-" + std::to_string(i));
+    }
+    return keys;
+}
+
+template<class P, class E = NoEviction>
+class Fixture
+{
+public:
+    explicit Fixture(std::size_t count, std::size_t keyCount = 0)
+        : keys {createKeys(std::max(count + 1, keyCount))}
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            std::string key {keys[i]};
+            store.add(std::move(key), Entity(static_cast<int>(i)));
+        }
+    }
+    IndexedDataStore<std::string, Entity, P, E> store {};
+    std::vector<std::string> keys {};
+};
+
+// Adds a key, to a store holding argument entries
+template<class P, bool Unique>
+void benchmarkAdd(State &state)
+{
+    Fixture<P> fixture {state.argument()};
+    const std::string &key {fixture.keys.back()};
+    while (state.next()) {
+        std::string addedKey {key};
+        if (Unique) {
+            doNotOptimize(fixture.store.addUnique(std::move(addedKey), Entity(1)));
+        } else {
+            doNotOptimize(fixture.store.add(std::move(addedKey), Entity(1)));
+        }
+        state.pause();
+        fixture.store.remove(key);
+        state.resume();
+    }
+}
+
+template<class P, class E = NoEviction>
+void benchmarkUpdate(State &state)
+{
+    Fixture<P, E> fixture {state.argument()};
+    std::size_t index {0};
+    while (state.next()) {
+        doNotOptimize(fixture.store.update(fixture.keys[index], Entity(1)));
+        index = (index + 7) % state.argument();
+    }
+}
+
+template<class P>
+void benchmarkRemove(State &state)
+{
+    Fixture<P> fixture {state.argument()};
+    const std::string &key {fixture.keys.back()};
+    while (state.next()) {
+        state.pause();
+        std::string addedKey {key};
+        fixture.store.add(std::move(addedKey), Entity(1));
+        state.resume();
+        doNotOptimize(fixture.store.remove(key));
+    }
+}
+
+// Adds keys to a full store, each key evicting an entry
+template<class E>
+void benchmarkEvict(State &state)
+{
+    Fixture<FlatHashStorage, E> fixture {state.argument(), 2 * state.argument()};
+    fixture.store.setBudget(state.argument() * sizeof(Entity));
+    std::size_t index {state.argument()};
+    while (state.next()) {
+        std::string key {fixture.keys[index]};
+        doNotOptimize(fixture.store.add(std::move(key), Entity(1)));
+        index = (index + 1) % fixture.keys.size();
+    }
+}
+
+}
+
+// Argument is the number of entries in the store
+MICROCORE_BENCHMARK_ARGS(MapStoreAdd, 1000, 100000, 1000000)
+{
+    benchmarkAdd<OrderedStorage, false>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(FlatHashStoreAdd, 1000, 100000, 1000000)
+{
+    benchmarkAdd<FlatHashStorage, false>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(MapStoreAddUnique, 1000, 100000, 1000000)
+{
+    benchmarkAdd<OrderedStorage, true>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(FlatHashStoreAddUnique, 1000, 100000, 1000000)
+{
+    benchmarkAdd<FlatHashStorage, true>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(MapStoreUpdate, 1000, 100000, 1000000)
+{
+    benchmarkUpdate<OrderedStorage>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(FlatHashStoreUpdate, 1000, 100000, 1000000)
+{
+    benchmarkUpdate<FlatHashStorage>(state);
+}
+
+// Updates track the most recently used entries
+MICROCORE_BENCHMARK_ARGS(LruStoreUpdate, 1000, 100000, 1000000)
+{
+    benchmarkUpdate<FlatHashStorage, LruEviction>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(ClockStoreUpdate, 1000, 100000, 1000000)
+{
+    benchmarkUpdate<FlatHashStorage, ClockEviction>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(LruStoreEvict, 1000, 100000, 1000000)
+{
+    benchmarkEvict<LruEviction>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(ClockStoreEvict, 1000, 100000, 1000000)
+{
+    benchmarkEvict<ClockEviction>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(MapStoreRemove, 1000, 100000, 1000000)
+{
+    benchmarkRemove<OrderedStorage>(state);
+}
+
+MICROCORE_BENCHMARK_ARGS(FlatHashStoreRemove, 1000, 100000, 1000000)
+{
+    benchmarkRemove<FlatHashStorage>(state);
+}
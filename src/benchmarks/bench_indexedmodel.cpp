@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "benchmark.h"
+#include <microcore/data/indexeddatastore.h>
+#include <microcore/data/indexedmodel.h>
+#include <algorithm>
+#include <vector>
+
+using namespace ::microcore::data;
+using namespace ::microcore::benchmarks;
+
+namespace {
+
+class Entity
+{
+public:
+    explicit Entity(int k, int v)
+        : key {k}
+        , value {v}
+    {
+    }
+    bool operator==(const Entity &other) const
+    {
+        return key == other.key && value == other.value;
+    }
+    int key {0};
+    int value {0};
+};
+
+class EntityMapper
+{
+public:
+    using KeyType = int;
+    int operator()(const Entity &entity) const
+    {
+        return entity.key;
+    }
+};
+
+using EntityModel = IndexedModel<Entity, EntityMapper>;
+
+class Fixture
+{
+public:
+    explicit Fixture(std::size_t count)
+    {
+        std::vector<Entity> entities {};
+        entities.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            entities.emplace_back(static_cast<int>(i), 0);
+        }
+        model.append(std::move(entities));
+    }
+    IndexedDataStore<int, Entity> store {};
+    EntityModel model {store};
+};
+
+}
+
+// Argument is the number of rows in the model
+
+// Locates the row of a key like the model did before
+// indexing positions, for comparison
+MICROCORE_BENCHMARK_ARGS(LinearRowLookup, 1000, 10000, 100000)
+{
+    Fixture fixture {state.argument()};
+    EntityMapper mapper {};
+    int key {0};
+    while (state.next()) {
+        auto it = std::find_if(std::begin(fixture.model), std::end(fixture.model), [key, &mapper](const Entity *entity) {
+            return mapper(*entity) == key;
+        });
+        doNotOptimize(it);
+        key = (key + 7919) % static_cast<int>(state.argument());
+    }
+}
+
+// An update of the store, that is located in the model
+MICROCORE_BENCHMARK_ARGS(ModelExternalUpdate, 1000, 10000, 100000)
+{
+    Fixture fixture {state.argument()};
+    int key {0};
+    while (state.next()) {
+        doNotOptimize(fixture.store.update(key, Entity(key, 1)));
+        key = (key + 7919) % static_cast<int>(state.argument());
+    }
+}
+
+// A removal from the store, that is located in the model
+MICROCORE_BENCHMARK_ARGS(ModelExternalRemove, 1000, 10000, 100000)
+{
+    Fixture fixture {state.argument()};
+    int key {0};
+    while (state.next()) {
+        doNotOptimize(fixture.store.remove(key));
+        state.pause();
+        std::vector<Entity> entities {};
+        entities.emplace_back(key, 0);
+        fixture.model.insert(static_cast<std::size_t>(key), std::move(entities));
+        state.resume();
+        key = (key + 7919) % static_cast<int>(state.argument());
+    }
+}
+
+// New contents with three changes: a removed, an inserted and an updated row
+std::vector<Entity> changedEntities(std::size_t count, int generation)
+{
+    std::vector<Entity> entities {};
+    entities.reserve(count);
+    for (std::size_t i = 1; i < count; ++i) {
+        entities.emplace_back(static_cast<int>(i), i == count / 2 ? generation : 0);
+    }
+    entities.emplace(std::begin(entities) + count / 3, static_cast<int>(count + generation), 0);
+    return entities;
+}
+
+// Reloads the model with replace()
+MICROCORE_BENCHMARK_ARGS(ModelReplace, 1000, 5000, 50000)
+{
+    Fixture fixture {state.argument()};
+    int generation {0};
+    while (state.next()) {
+        state.pause();
+        std::vector<Entity> entities {changedEntities(state.argument(), ++generation)};
+        state.resume();
+        fixture.model.replace(std::move(entities));
+    }
+}
+
+// Reloads the model by clearing it and appending the values
+MICROCORE_BENCHMARK_ARGS(ModelClearAppend, 1000, 5000, 50000)
+{
+    Fixture fixture {state.argument()};
+    int generation {0};
+    while (state.next()) {
+        state.pause();
+        std::vector<Entity> entities {changedEntities(state.argument(), ++generation)};
+        state.resume();
+        fixture.model.clear();
+        fixture.model.append(std::move(entities));
+    }
+}
+
+// A move in the model
+MICROCORE_BENCHMARK_ARGS(ModelMove, 1000, 10000, 100000)
+{
+    Fixture fixture {state.argument()};
+    std::size_t index {0};
+    while (state.next()) {
+        fixture.model.move(index, state.argument() / 2);
+        index = (index + 7919) % state.argument();
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "benchmark.h"
+#include <microcore/data/journal.h>
+#include <cstdio>
+#include <string>
+
+using namespace ::microcore::data;
+using namespace ::microcore::benchmarks;
+
+namespace {
+
+using Store = IndexedDataStore<int, std::string, FlatHashStorage>;
+
+const std::string Path {"bench_journal.snapshot"};
+
+void fill(Store &store, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        store.add(static_cast<int>(i), std::string(100, 'a'));
+    }
+}
+
+// A synchronization, updating 100 entries
+void synchronize(Store &store, std::size_t iteration)
+{
+    for (std::size_t i = 0; i < 100; ++i) {
+        store.update(static_cast<int>((iteration * 100 + i) % 1000), std::string(100, 'b'));
+    }
+}
+
+void cleanup()
+{
+    std::remove(Path.c_str());
+    std::remove((Path + ".journal").c_str());
+    std::remove((Path + ".journal.old").c_str());
+}
+
+}
+
+// Argument is the number of entries of the store
+
+// Persists each synchronization by writing a snapshot
+MICROCORE_BENCHMARK_ARGS(SynchronizationSnapshot, 1000, 10000, 100000)
+{
+    Store store {};
+    fill(store, state.argument());
+    std::size_t iteration {0};
+    while (state.next()) {
+        synchronize(store, iteration++);
+        doNotOptimize(store.saveSnapshot(Path));
+    }
+    cleanup();
+}
+
+// Persists each synchronization by committing the journal
+MICROCORE_BENCHMARK_ARGS(SynchronizationJournal, 1000, 10000, 100000)
+{
+    Store store {};
+    fill(store, state.argument());
+    std::size_t iteration {0};
+    {
+        Journal<int, std::string, FlatHashStorage> journal {store, Path};
+        journal.setCompactionSize(0);
+        journal.open();
+        while (state.next()) {
+            synchronize(store, iteration++);
+            doNotOptimize(journal.commit());
+        }
+    }
+    cleanup();
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "benchmark.h"
+#include <microcore/core/listenerrepository.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace ::microcore::core;
+using namespace ::microcore::benchmarks;
+
+namespace {
+
+class Listener
+{
+public:
+    using Ptr = std::shared_ptr<Listener>;
+    void onUpdate(int key, const int &value)
+    {
+        m_sum += key + value;
+    }
+    void onInvalidation()
+    {
+    }
+    int sum() const
+    {
+        return m_sum;
+    }
+private:
+    int m_sum {0};
+};
+
+// What a notification used to cost: a std::function built
+// from std::bind, and a weak_ptr lock per listener.
+class LegacyRepository
+{
+public:
+    void addListener(const Listener::Ptr &listener)
+    {
+        m_listeners.emplace_back(listener);
+    }
+    void notify(std::function<void (Listener &)> &&function)
+    {
+        for (const std::weak_ptr<Listener> &listener : m_listeners) {
+            const std::shared_ptr<Listener> &sharedListener {listener.lock()};
+            if (sharedListener) {
+                function(*sharedListener);
+            }
+        }
+    }
+private:
+    std::vector<std::weak_ptr<Listener>> m_listeners {};
+};
+
+template<class Repository>
+std::vector<Listener::Ptr> addListeners(Repository &repository, std::size_t count)
+{
+    std::vector<Listener::Ptr> listeners {};
+    for (std::size_t i = 0; i < count; ++i) {
+        listeners.push_back(std::make_shared<Listener>());
+        repository.addListener(listeners.back());
+    }
+    return listeners;
+}
+
+}
+
+// Argument is the number of listeners
+MICROCORE_BENCHMARK_ARGS(LegacyNotify, 1, 16)
+{
+    using namespace std::placeholders;
+    LegacyRepository repository {};
+    std::vector<Listener::Ptr> listeners {addListeners(repository, state.argument())};
+    int value {1};
+    while (state.next()) {
+        repository.notify(std::bind(&Listener::onUpdate, _1, 1, std::ref(value)));
+    }
+    doNotOptimize(listeners.front()->sum());
+}
+
+MICROCORE_BENCHMARK_ARGS(WeakNotify, 1, 16)
+{
+    ListenerRepository<Listener> repository {};
+    std::vector<Listener::Ptr> listeners {addListeners(repository, state.argument())};
+    int value {1};
+    while (state.next()) {
+        repository.notify([&value](Listener &listener) {
+            listener.onUpdate(1, value);
+        });
+    }
+    doNotOptimize(listeners.front()->sum());
+}
+
+MICROCORE_BENCHMARK_ARGS(StrongNotify, 1, 16)
+{
+    ListenerRepository<Listener, ListenerReference::Strong> repository {};
+    std::vector<Listener::Ptr> listeners {addListeners(repository, state.argument())};
+    int value {1};
+    while (state.next()) {
+        repository.notify([&value](Listener &listener) {
+            listener.onUpdate(1, value);
+        });
+    }
+    doNotOptimize(listeners.front()->sum());
+}
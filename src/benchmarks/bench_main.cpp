@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "benchmark.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace {
+
+std::atomic<std::uint64_t> allocations {0};
+
+std::uint64_t now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+class Entry
+{
+public:
+    std::string name {};
+    ::microcore::benchmarks::Function function {nullptr};
+    std::vector<std::size_t> arguments {};
+};
+
+std::vector<Entry> & registry()
+{
+    static std::vector<Entry> entries {};
+    return entries;
+}
+
+}
+
+void * operator new(std::size_t size)
+{
+    ++allocations;
+    void *data {std::malloc(size == 0 ? 1 : size)};
+    if (data == nullptr) {
+        throw std::bad_alloc();
+    }
+    return data;
+}
+
+void operator delete(void *data) noexcept
+{
+    std::free(data);
+}
+
+void operator delete(void *data, std::size_t) noexcept
+{
+    std::free(data);
+}
+
+namespace microcore { namespace benchmarks {
+
+State::State(std::size_t iterations, std::size_t argument)
+    : m_iterations {iterations}
+    , m_argument {argument}
+{
+}
+
+std::size_t State::argument() const
+{
+    return m_argument;
+}
+
+bool State::next()
+{
+    if (m_current == 0) {
+        resume();
+    }
+    if (m_current == m_iterations) {
+        pause();
+        return false;
+    }
+    ++m_current;
+    return true;
+}
+
+void State::pause()
+{
+    if (m_running) {
+        m_elapsed += now() - m_start;
+        m_allocations += allocationCount() - m_startAllocations;
+        m_running = false;
+    }
+}
+
+void State::resume()
+{
+    if (!m_running) {
+        m_running = true;
+        m_startAllocations = allocationCount();
+        m_start = now();
+    }
+}
+
+std::size_t State::iterations() const
+{
+    return m_iterations;
+}
+
+std::uint64_t State::elapsed() const
+{
+    return m_elapsed;
+}
+
+std::uint64_t State::allocations() const
+{
+    return m_allocations;
+}
+
+int registerBenchmark(const char *name, Function function, std::vector<std::size_t> arguments)
+{
+    Entry entry {};
+    entry.name = name;
+    entry.function = function;
+    entry.arguments = std::move(arguments);
+    registry().push_back(std::move(entry));
+    return 0;
+}
+
+std::uint64_t allocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+}}
+
+int main(int argc, char **argv)
+{
+    using namespace ::microcore::benchmarks;
+    static const std::uint64_t MinimumTime {200 * 1000 * 1000};
+    static const std::size_t MaximumIterations {1000 * 1000 * 1000};
+    const char *filter {argc > 1 ? argv[1] : nullptr};
+
+    std::printf("%-48s %12s %14s %12s\n", "Benchmark", "Iterations", "ns/iteration", "allocs/it.");
+    for (const Entry &entry : registry()) {
+        if (filter != nullptr && entry.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        std::vector<std::size_t> arguments {entry.arguments};
+        if (arguments.empty()) {
+            arguments.push_back(0);
+        }
+        for (std::size_t argument : arguments) {
+            std::size_t iterations {1};
+            while (true) {
+                State state {iterations, argument};
+                entry.function(state);
+                if (state.elapsed() >= MinimumTime || iterations >= MaximumIterations) {
+                    std::string name {entry.name};
+                    if (!entry.arguments.empty()) {
+                        name += "/" + std::to_string(argument);
+                    }
+                    std::printf("%-48s %12zu %14.1f %12.2f\n", name.c_str(), iterations,
+                                static_cast<double>(state.elapsed()) / iterations,
+                                static_cast<double>(state.allocations()) / iterations);
+                    break;
+                }
+                iterations *= 10;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "benchmark.h"
+#include <microcore/data/indexeddatastore.h>
+#include <microcore/data/indexedmodel.h>
+#include <microcore/data/pagedmodel.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace ::microcore::core;
+using namespace ::microcore::data;
+using namespace ::microcore::benchmarks;
+
+namespace {
+
+class Entity
+{
+public:
+    explicit Entity(int k, int v)
+        : key {k}
+        , value {v}
+    {
+    }
+    int key {0};
+    int value {0};
+};
+
+class EntityMapper
+{
+public:
+    using KeyType = int;
+    int operator()(const Entity &entity) const
+    {
+        return entity.key;
+    }
+};
+
+class Error
+{
+public:
+    static Error cancelled()
+    {
+        return Error();
+    }
+    static Error timeout()
+    {
+        return Error();
+    }
+    bool empty() const
+    {
+        return true;
+    }
+};
+
+std::vector<Entity> entities(std::size_t offset, std::size_t count)
+{
+    std::vector<Entity> result {};
+    result.reserve(count);
+    for (std::size_t i = offset; i < offset + count; ++i) {
+        result.emplace_back(static_cast<int>(i), static_cast<int>(i * 7919));
+    }
+    return result;
+}
+
+// Returns the requested page of a collection immediately
+class PageJobFactory: public IJobFactory<PageRequest, std::vector<Entity>, Error>
+{
+public:
+    using Job = IJob<std::vector<Entity>, Error>;
+    class ImmediateJob: public Job
+    {
+    public:
+        explicit ImmediateJob(std::size_t offset, std::size_t count)
+            : m_offset {offset}, m_count {count}
+        {
+        }
+        void execute(Job::OnResult &&onResult, Job::OnError &&onError) override
+        {
+            Q_UNUSED(onError)
+            onResult(entities(m_offset, m_count));
+        }
+    private:
+        std::size_t m_offset {0};
+        std::size_t m_count {0};
+    };
+    explicit PageJobFactory(std::size_t size)
+        : m_size {size}
+    {
+    }
+    std::unique_ptr<Job> create(PageRequest &&request) const override
+    {
+        std::size_t offset {std::min(request.offset, m_size)};
+        return std::unique_ptr<Job>(new ImmediateJob(offset, std::min(request.count, m_size - offset)));
+    }
+private:
+    std::size_t m_size {0};
+};
+
+}
+
+// Argument is the number of rows of the collection
+
+// Loads the whole collection before the first rows are shown
+MICROCORE_BENCHMARK_ARGS(FullCollectionFirstRows, 1000, 10000, 100000)
+{
+    while (state.next()) {
+        IndexedDataStore<int, Entity> store {};
+        IndexedModel<Entity, EntityMapper> model {store};
+        model.append(entities(0, state.argument()));
+        doNotOptimize(model);
+    }
+}
+
+// Loads the first page of the collection
+MICROCORE_BENCHMARK_ARGS(PagedModelFirstRows, 1000, 10000, 100000)
+{
+    PageJobFactory factory {state.argument()};
+    while (state.next()) {
+        IndexedDataStore<int, Entity> store {};
+        PagedModel<Entity, EntityMapper, Error> model {store, factory, 50};
+        model.fetchMore();
+        doNotOptimize(model);
+    }
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "benchmark.h"
+#include <microcore/data/indexeddatastore.h>
+#include <string>
+
+using namespace ::microcore::data;
+using namespace ::microcore::benchmarks;
+
+namespace {
+
+class Post
+{
+public:
+    explicit Post(int id, int thread)
+        : id {id}, thread {thread}
+    {
+    }
+    int id {0};
+    int thread {0};
+};
+
+class ThreadMapper
+{
+public:
+    using KeyType = int;
+    int operator()(const Post &post) const
+    {
+        return post.thread;
+    }
+};
+
+// Exposes the entries, to scan them
+class ScannedStore: public IndexedDataStore<int, Post, FlatHashStorage>
+{
+public:
+    const Container & entries() const
+    {
+        return m_data;
+    }
+};
+
+// Posts are spread in 100 threads
+const int ThreadCount {100};
+
+void fill(IndexedDataStore<int, Post, FlatHashStorage> &store, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        int id {static_cast<int>(i)};
+        store.add(id, Post(id, id % ThreadCount));
+    }
+}
+
+}
+
+// Argument is the number of posts
+
+// Finds the posts of a thread by scanning the store
+MICROCORE_BENCHMARK_ARGS(SecondaryIndexScan, 1000, 10000, 100000)
+{
+    ScannedStore store {};
+    fill(store, state.argument());
+    int thread {0};
+    while (state.next()) {
+        std::size_t count {0};
+        for (const auto &entry : store.entries()) {
+            if (entry.second->thread == thread) {
+                ++count;
+            }
+        }
+        doNotOptimize(count);
+        thread = (thread + 1) % ThreadCount;
+    }
+}
+
+// Finds the posts of a thread with an index
+MICROCORE_BENCHMARK_ARGS(SecondaryIndexFind, 1000, 10000, 100000)
+{
+    IndexedDataStore<int, Post, FlatHashStorage> store {};
+    auto &byThread = store.addIndex(ThreadMapper());
+    fill(store, state.argument());
+    int thread {0};
+    while (state.next()) {
+        std::size_t count {0};
+        for (const Post &post : byThread.find(thread)) {
+            doNotOptimize(post);
+            ++count;
+        }
+        doNotOptimize(count);
+        thread = (thread + 1) % ThreadCount;
+    }
+}
+
+// Adds posts to a store without index
+MICROCORE_BENCHMARK_ARGS(SecondaryIndexAddUnindexed, 1000, 10000, 100000)
+{
+    while (state.next()) {
+        IndexedDataStore<int, Post, FlatHashStorage> store {};
+        fill(store, state.argument());
+        doNotOptimize(store);
+    }
+}
+
+// Adds posts to a store, maintaining an index
+MICROCORE_BENCHMARK_ARGS(SecondaryIndexAddIndexed, 1000, 10000, 100000)
+{
+    while (state.next()) {
+        IndexedDataStore<int, Post, FlatHashStorage> store {};
+        store.addIndex(ThreadMapper());
+        fill(store, state.argument());
+        doNotOptimize(store);
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "benchmark.h"
+#include <microcore/data/indexeddatastore.h>
+#include <cstdio>
+#include <string>
+
+using namespace ::microcore::data;
+using namespace ::microcore::benchmarks;
+
+namespace {
+
+std::string path()
+{
+    return "bench_snapshot.snapshot";
+}
+
+// Writes a snapshot with size values of 100 characters
+void prepare(std::size_t size)
+{
+    IndexedDataStore<int, std::string, FlatHashStorage> store {};
+    for (std::size_t i = 0; i < size; ++i) {
+        store.add(static_cast<int>(i), std::string(100, static_cast<char>('a' + i % 26)));
+    }
+    store.saveSnapshot(path());
+}
+
+}
+
+// Argument is the number of entries of the snapshot
+
+// Opens a snapshot, and reads one value, values being decoded lazily
+MICROCORE_BENCHMARK_ARGS(SnapshotOpen, 1000, 10000, 100000)
+{
+    prepare(state.argument());
+    while (state.next()) {
+        IndexedDataStore<int, std::string, FlatHashStorage> store {};
+        store.openSnapshot(path());
+        doNotOptimize(store.value(0));
+    }
+    std::remove(path().c_str());
+}
+
+// Opens a snapshot, and reads all the values, like a cache that
+// decodes values eagerly
+MICROCORE_BENCHMARK_ARGS(SnapshotOpenAll, 1000, 10000, 100000)
+{
+    prepare(state.argument());
+    while (state.next()) {
+        IndexedDataStore<int, std::string, FlatHashStorage> store {};
+        store.openSnapshot(path());
+        for (std::size_t i = 0; i < state.argument(); ++i) {
+            doNotOptimize(store.value(static_cast<int>(i)));
+        }
+    }
+    std::remove(path().c_str());
+}
+
+// Writes a snapshot
+MICROCORE_BENCHMARK_ARGS(SnapshotSave, 1000, 10000, 100000)
+{
+    IndexedDataStore<int, std::string, FlatHashStorage> store {};
+    for (std::size_t i = 0; i < state.argument(); ++i) {
+        store.add(static_cast<int>(i), std::string(100, 'a'));
+    }
+    while (state.next()) {
+        doNotOptimize(store.saveSnapshot(path()));
+    }
+    std::remove(path().c_str());
+}
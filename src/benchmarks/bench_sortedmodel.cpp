@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "benchmark.h"
+#include <microcore/data/btreesequence.h>
+#include <microcore/data/indexeddatastore.h>
+#include <microcore/data/indexedmodel.h>
+#include <microcore/data/sortedmodel.h>
+#include <algorithm>
+#include <vector>
+
+using namespace ::microcore::data;
+using namespace ::microcore::benchmarks;
+
+namespace {
+
+class Score
+{
+public:
+    explicit Score(int k, int v)
+        : key {k}
+        , value {v}
+    {
+    }
+    int key {0};
+    int value {0};
+};
+
+class ScoreMapper
+{
+public:
+    using KeyType = int;
+    int operator()(const Score &score) const
+    {
+        return score.key;
+    }
+};
+
+class ScoreCompare
+{
+public:
+    bool operator()(const Score &first, const Score &second) const
+    {
+        return first.value < second.value;
+    }
+};
+
+using Sequence = BTreeSequence<const Score *>;
+
+class Fixture
+{
+public:
+    explicit Fixture(std::size_t count)
+    {
+        std::vector<Score> scores {};
+        scores.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            scores.emplace_back(static_cast<int>(i), static_cast<int>(i * 7919 % count));
+        }
+        source.append(std::move(scores));
+    }
+    IndexedDataStore<int, Score> store {};
+    IndexedModel<Score, ScoreMapper, Sequence> source {store};
+};
+
+}
+
+// Argument is the number of rows
+
+// Updates a score, and sorts a copy of the rows, like a model copy
+// re-sorted on every change
+MICROCORE_BENCHMARK_ARGS(ResortUpdate, 1000, 10000, 50000)
+{
+    Fixture fixture {state.argument()};
+    std::size_t index {0};
+    int value {0};
+    while (state.next()) {
+        fixture.source.update(index, Score(fixture.source[index]->key, value));
+        std::vector<const Score *> rows (std::begin(fixture.source), std::end(fixture.source));
+        std::stable_sort(std::begin(rows), std::end(rows), [](const Score *first, const Score *second) {
+            return first->value < second->value;
+        });
+        doNotOptimize(rows);
+        index = (index + 7919) % state.argument();
+        value = (value + 104729) % static_cast<int>(state.argument());
+    }
+}
+
+// Updates a score, the sorted model moving the row
+MICROCORE_BENCHMARK_ARGS(SortedModelUpdate, 1000, 10000, 50000)
+{
+    Fixture fixture {state.argument()};
+    SortedModel<Score, Sequence, ScoreCompare> sorted {fixture.source};
+    std::size_t index {0};
+    int value {0};
+    while (state.next()) {
+        fixture.source.update(index, Score(fixture.source[index]->key, value));
+        index = (index + 7919) % state.argument();
+        value = (value + 104729) % static_cast<int>(state.argument());
+    }
+}
+
+// Inserts and removes a row in the source
+MICROCORE_BENCHMARK_ARGS(SortedModelInsertRemove, 1000, 10000, 50000)
+{
+    Fixture fixture {state.argument()};
+    SortedModel<Score, Sequence, ScoreCompare> sorted {fixture.source};
+    std::size_t index {0};
+    int key {static_cast<int>(state.argument())};
+    while (state.next()) {
+        std::vector<Score> scores {};
+        scores.emplace_back(key, key % 1000);
+        fixture.source.insert(index, std::move(scores));
+        fixture.source.remove(index);
+        index = (index + 7919) % state.argument();
+        ++key;
+    }
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_BENCHMARKS_BENCHMARK_H
+#define MICROCORE_BENCHMARKS_BENCHMARK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace microcore { namespace benchmarks {
+
+/**
+ * @brief State of a running benchmark
+ *
+ * A benchmark function receives a State and should run the
+ * measured code once per iteration, while keeping setup code
+ * outside of the loop:
+ *
+ * @code
+ * MICROCORE_BENCHMARK(MyBenchmark)
+ * {
+ *     Setup setup {};
+ *     while (state.next()) {
+ *         measured();
+ *     }
+ * }
+ * @endcode
+ *
+ * Time and heap allocations are only counted inside the loop.
+ */
+class State
+{
+public:
+    explicit State(std::size_t iterations, std::size_t argument);
+    /**
+     * @brief Argument of this run
+     *
+     * @return the argument the benchmark was registered with, or 0.
+     */
+    std::size_t argument() const;
+    /**
+     * @brief Start the next iteration
+     *
+     * @return if an iteration should be run.
+     */
+    bool next();
+    /**
+     * @brief Pause the measurement
+     *
+     * Time and allocations are not counted until resume() is called.
+     */
+    void pause();
+    /**
+     * @brief Resume the measurement
+     */
+    void resume();
+    std::size_t iterations() const;
+    std::uint64_t elapsed() const;
+    std::uint64_t allocations() const;
+private:
+    std::size_t m_iterations {0};
+    std::size_t m_argument {0};
+    std::size_t m_current {0};
+    bool m_running {false};
+    std::uint64_t m_start {0};
+    std::uint64_t m_startAllocations {0};
+    std::uint64_t m_elapsed {0};
+    std::uint64_t m_allocations {0};
+};
+
+using Function = void (*)(State &state);
+
+/**
+ * @brief Register a benchmark
+ *
+ * Prefer the MICROCORE_BENCHMARK and MICROCORE_BENCHMARK_ARGS
+ * macros to calling this function directly.
+ *
+ * @param name name of the benchmark.
+ * @param function benchmark function.
+ * @param arguments arguments passed to the function, the benchmark being run once per argument.
+ * @return a dummy value.
+ */
+int registerBenchmark(const char *name, Function function, std::vector<std::size_t> arguments = {});
+
+/**
+ * @brief Number of heap allocations since the start of the program
+ *
+ * @return the number of calls to operator new.
+ */
+std::uint64_t allocationCount();
+
+/**
+ * @brief Prevent the compiler from optimizing away a value
+ */
+template<class T>
+inline void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+}}
+
+#define MICROCORE_BENCHMARK_ARGS(name, ...) \
+    static void name(::microcore::benchmarks::State &state); \
+    static const int name##Registered {::microcore::benchmarks::registerBenchmark(#name, &name, {__VA_ARGS__})}; \
+    static void name(::microcore::benchmarks::State &state)
+
+#define MICROCORE_BENCHMARK(name) \
+    static void name(::microcore::benchmarks::State &state); \
+    static const int name##Registered {::microcore::benchmarks::registerBenchmark(#name, &name)}; \
+    static void name(::microcore::benchmarks::State &state)
+
+#endif // MICROCORE_BENCHMARKS_BENCHMARK_H
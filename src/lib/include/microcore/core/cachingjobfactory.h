@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_CORE_CACHINGJOBFACTORY_H
+#define MICROCORE_CORE_CACHINGJOBFACTORY_H
+
+#include <microcore/core/globals.h>
+#include <microcore/core/deferredrelease.h>
+#include <microcore/core/ijobfactory.h>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <QByteArray>
+
+namespace microcore { namespace core {
+
+/**
+ * @brief How CachingJobFactory stores results
+ *
+ * A cached result is stored as a Stored value, created from the
+ * result with store(). Each cache hit creates a new result from the
+ * stored value with load(). size() gives the size, in bytes, of a
+ * stored value, and is used for the byte budget of the cache.
+ *
+ * By default, results are stored as is, copied on each hit, and their
+ * size is sizeof(Result). Specialize this class, or pass another
+ * traits class to CachingJobFactory, for results that cannot be copied,
+ * or that own memory.
+ */
+template<class Result>
+class CacheTraits
+{
+public:
+    using Stored = Result;
+    static Stored store(Result &&result)
+    {
+        return std::move(result);
+    }
+    static Result load(const Stored &stored)
+    {
+        return stored;
+    }
+    static std::size_t size(const Stored &)
+    {
+        return sizeof(Result);
+    }
+};
+
+template<>
+class CacheTraits<QByteArray>
+{
+public:
+    using Stored = QByteArray;
+    static Stored store(QByteArray &&result)
+    {
+        return std::move(result);
+    }
+    static QByteArray load(const Stored &stored)
+    {
+        return stored;
+    }
+    static std::size_t size(const Stored &stored)
+    {
+        return sizeof(QByteArray) + static_cast<std::size_t>(stored.size());
+    }
+};
+
+/**
+ * @brief An IJobFactory that caches results
+ *
+ * This class decorates an IJobFactory. Results are stored in a cache,
+ * keyed by the request. Requests are looked up with a hash function,
+ * and requests that compare equal with KeyEqual are considered
+ * identical. When an IJob created by this factory is
+ * executed with a request that is in the cache, the cached result
+ * is passed synchronously to the success callback, and no decorated
+ * IJob is created. Errors are not cached.
+ *
+ * Cached results expire after a time to live. The cache is also
+ * bounded by a number of entries and by a number of bytes, computed
+ * by Traits, see CacheTraits. When the cache is full, least recently
+ * used results are evicted. Each of those limits can be disabled by
+ * setting it to 0.
+ *
+ * hits() and misses() count the requests that were, or were not,
+ * served by the cache.
+ *
+ * This factory is not thread safe, and IJob created by this factory
+ * should be executed from a single thread. CachingJobFactory do
+ * not handle the lifecycle of the decorated IJobFactory, and should
+ * outlive the IJob it creates. Requests are copied, as a copy is kept
+ * as the key of the cached result.
+ */
+template<class Request, class Result, class Error, class Hash = std::hash<Request>,
+         class KeyEqual = std::equal_to<Request>, class Traits = CacheTraits<Result>>
+class CachingJobFactory final : public IJobFactory<Request, Result, Error>
+{
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param factory factory to decorate.
+     * @param ttl time to live of cached results, in milliseconds.
+     * @param maxEntries maximum number of cached results.
+     * @param maxBytes maximum size of the cached results, in bytes.
+     * @param hash hash function used to look up the requests.
+     * @param equal function used to compare the requests.
+     */
+    explicit CachingJobFactory(const IJobFactory<Request, Result, Error> &factory,
+                               int ttl, std::size_t maxEntries, std::size_t maxBytes = 0,
+                               Hash hash = Hash(), KeyEqual equal = KeyEqual())
+        : m_state {new State(factory, ttl, maxEntries, maxBytes, std::move(hash), std::move(equal))}
+    {
+    }
+    DISABLE_COPY_DISABLE_MOVE(CachingJobFactory);
+    std::unique_ptr<IJob<Result, Error>> create(Request &&request) const override
+    {
+        return std::unique_ptr<IJob<Result, Error>>(new Job(*m_state, std::move(request)));
+    }
+    /**
+     * @brief Number of requests served by the cache
+     *
+     * @return the number of cache hits.
+     */
+    std::size_t hits() const
+    {
+        return m_state->hits;
+    }
+    /**
+     * @brief Number of requests not served by the cache
+     *
+     * @return the number of cache misses.
+     */
+    std::size_t misses() const
+    {
+        return m_state->misses;
+    }
+    /**
+     * @brief Number of cached results
+     *
+     * Expired results that were not evicted yet are counted.
+     *
+     * @return the number of cached results.
+     */
+    std::size_t count() const
+    {
+        return m_state->entries.size();
+    }
+    /**
+     * @brief Size of the cached results
+     *
+     * @return the size of the cached results, in bytes.
+     */
+    std::size_t bytes() const
+    {
+        return m_state->bytes;
+    }
+    /**
+     * @brief Remove the cached result of a request
+     *
+     * @param request request whose result is removed.
+     */
+    void remove(const Request &request)
+    {
+        m_state->remove(request);
+    }
+    /**
+     * @brief Remove all cached results
+     */
+    void clear()
+    {
+        m_state->clear();
+    }
+private:
+    using Clock = std::chrono::steady_clock;
+    // The request of an entry is the key of the index, that is not
+    // moved when the index rehashes
+    class Entry
+    {
+    public:
+        explicit Entry(const Request &key, typename Traits::Stored &&value, std::size_t size, Clock::time_point expiry)
+            : key {&key}, value {std::move(value)}, size {size}, expiry {expiry}
+        {
+        }
+        const Request *key {nullptr};
+        typename Traits::Stored value;
+        std::size_t size {0};
+        Clock::time_point expiry {};
+    };
+    // Decorated jobs are destroyed once none of them is executing a callback
+    using FinishedJobs = DeferredRelease<std::vector<std::unique_ptr<IJob<Result, Error>>>>;
+    class State
+    {
+    public:
+        explicit State(const IJobFactory<Request, Result, Error> &factory,
+                       int ttl, std::size_t maxEntries, std::size_t maxBytes, Hash &&hash, KeyEqual &&equal)
+            : m_factory {factory}
+            , m_ttl {ttl}
+            , m_maxEntries {maxEntries}
+            , m_maxBytes {maxBytes}
+            , m_index(0, std::move(hash), std::move(equal))
+        {
+        }
+        // Find a result, and mark it as the most recently used
+        const Entry * find(const Request &key)
+        {
+            auto it = m_index.find(key);
+            if (it == std::end(m_index)) {
+                return nullptr;
+            }
+            if (m_ttl > 0 && Clock::now() >= it->second->expiry) {
+                erase(it->second);
+                return nullptr;
+            }
+            entries.splice(std::begin(entries), entries, it->second);
+            return &(*it->second);
+        }
+        void insert(Request &&key, typename Traits::Stored &&value)
+        {
+            remove(key);
+            std::size_t size {Traits::size(value)};
+            if (m_maxBytes > 0 && size > m_maxBytes) {
+                return;
+            }
+
+            Clock::time_point expiry {Clock::now() + std::chrono::milliseconds(m_ttl)};
+            auto index = m_index.emplace(std::move(key), std::end(entries)).first;
+            entries.emplace_front(index->first, std::move(value), size, expiry);
+            index->second = std::begin(entries);
+            bytes += size;
+            while ((m_maxEntries > 0 && entries.size() > m_maxEntries) || (m_maxBytes > 0 && bytes > m_maxBytes)) {
+                erase(std::prev(std::end(entries)));
+            }
+        }
+        void remove(const Request &key)
+        {
+            auto it = m_index.find(key);
+            if (it != std::end(m_index)) {
+                erase(it->second);
+            }
+        }
+        void clear()
+        {
+            entries.clear();
+            m_index.clear();
+            bytes = 0;
+        }
+        std::unique_ptr<IJob<Result, Error>> createJob(Request &&request)
+        {
+            return m_factory.create(std::move(request));
+        }
+        std::list<Entry> entries {};
+        std::size_t bytes {0};
+        std::size_t hits {0};
+        std::size_t misses {0};
+        FinishedJobs finishedJobs {};
+    private:
+        void erase(typename std::list<Entry>::iterator it)
+        {
+            bytes -= it->size;
+            m_index.erase(m_index.find(*it->key));
+            entries.erase(it);
+        }
+        const IJobFactory<Request, Result, Error> &m_factory;
+        int m_ttl {0};
+        std::size_t m_maxEntries {0};
+        std::size_t m_maxBytes {0};
+        std::unordered_map<Request, typename std::list<Entry>::iterator, Hash, KeyEqual> m_index;
+    };
+    class Job final : public IJob<Result, Error>
+    {
+    public:
+        explicit Job(State &state, Request &&request)
+            : m_state {state}
+            , m_request {std::move(request)}
+        {
+        }
+        DISABLE_COPY_DISABLE_MOVE(Job);
+        ~Job()
+        {
+            cancel();
+        }
+        void execute(typename IJob<Result, Error>::OnResult &&onResult,
+                     typename IJob<Result, Error>::OnError &&onError) override
+        {
+            const Entry *entry {m_state.find(m_request)};
+            if (entry != nullptr) {
+                ++m_state.hits;
+                onResult(Traits::load(entry->value));
+                return;
+            }
+
+            ++m_state.misses;
+            m_onResult = std::move(onResult);
+            m_onError = std::move(onError);
+
+            // The decorated job can complete while executing
+            typename FinishedJobs::Lock lock {m_state.finishedJobs};
+            m_job = m_state.createJob(Request(m_request));
+            m_job->execute([this](Result &&result) {
+                typename FinishedJobs::Lock lock {m_state.finishedJobs};
+                typename Traits::Stored stored {Traits::store(std::move(result))};
+                Result loaded {Traits::load(stored)};
+                m_state.insert(std::move(m_request), std::move(stored));
+                m_state.finishedJobs.release(std::move(m_job));
+                typename IJob<Result, Error>::OnResult onResult {std::move(m_onResult)};
+                onResult(std::move(loaded));
+            }, [this](Error &&error) {
+                typename FinishedJobs::Lock lock {m_state.finishedJobs};
+                m_state.finishedJobs.release(std::move(m_job));
+                typename IJob<Result, Error>::OnError onError {std::move(m_onError)};
+                onError(std::move(error));
+            });
+        }
+        void cancel() override
+        {
+            if (m_job) {
+                m_job->cancel();
+                m_state.finishedJobs.release(std::move(m_job));
+            }
+        }
+    private:
+        State &m_state;
+        Request m_request;
+        std::unique_ptr<IJob<Result, Error>> m_job {};
+        typename IJob<Result, Error>::OnResult m_onResult {};
+        typename IJob<Result, Error>::OnError m_onError {};
+    };
+    std::unique_ptr<State> m_state {};
+};
+
+}}
+
+#endif // MICROCORE_CORE_CACHINGJOBFACTORY_H
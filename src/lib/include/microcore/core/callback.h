@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_CORE_CALLBACK_H
+#define MICROCORE_CORE_CALLBACK_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace microcore { namespace core {
+
+template<class Signature>
+class Callback;
+
+/**
+ * @brief A move-only callable
+ *
+ * This class is similar to std::function, but is move-only, so
+ * it can hold callables that capture move-only objects, and is
+ * never copied when passed around.
+ *
+ * Callables that are small enough, and that can be moved without
+ * throwing, are stored inline, inside the Callback, without any
+ * allocation. This is the case for lambdas capturing up to four
+ * pointers. Other callables are allocated on the heap.
+ */
+template<class R, class... Args>
+class Callback<R (Args...)>
+{
+public:
+    /**
+     * @brief Size of the inline storage
+     */
+    static const std::size_t InlineSize = 4 * sizeof(void *);
+    Callback() noexcept
+    {
+    }
+    Callback(std::nullptr_t) noexcept
+    {
+    }
+    template<class F, class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Callback>::value>::type>
+    Callback(F &&function)
+    {
+        using Type = typename std::decay<F>::type;
+        using Storage = typename std::conditional<isInline<Type>(), Inline<Type>, Allocated<Type>>::type;
+        Storage::create(&m_storage, std::forward<F>(function));
+        m_operations = Storage::operations();
+    }
+    Callback(const Callback &) = delete;
+    Callback & operator=(const Callback &) = delete;
+    Callback(Callback &&other) noexcept
+    {
+        moveFrom(other);
+    }
+    Callback & operator=(Callback &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+    Callback & operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+    ~Callback()
+    {
+        reset();
+    }
+    explicit operator bool() const noexcept
+    {
+        return m_operations != nullptr;
+    }
+    R operator()(Args... args) const
+    {
+        return m_operations->invoke(&m_storage, std::forward<Args>(args)...);
+    }
+    /**
+     * @brief If a callable type is stored inline
+     *
+     * @return if the callable type F is stored without allocation.
+     */
+    template<class F>
+    static constexpr bool isInline()
+    {
+        return sizeof(F) <= InlineSize
+                && alignof(F) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible<F>::value;
+    }
+private:
+    using Storage = typename std::aligned_storage<InlineSize, alignof(std::max_align_t)>::type;
+    class Operations
+    {
+    public:
+        R (*invoke)(void *storage, Args &&...args);
+        void (*move)(void *from, void *to);
+        void (*destroy)(void *storage);
+    };
+    template<class F>
+    class Inline
+    {
+    public:
+        template<class T>
+        static void create(void *storage, T &&function)
+        {
+            new (storage) F(std::forward<T>(function));
+        }
+        static const Operations * operations()
+        {
+            static const Operations operations {&invoke, &move, &destroy};
+            return &operations;
+        }
+    private:
+        static R invoke(void *storage, Args &&...args)
+        {
+            return (*static_cast<F *>(storage))(std::forward<Args>(args)...);
+        }
+        static void move(void *from, void *to)
+        {
+            new (to) F(std::move(*static_cast<F *>(from)));
+            static_cast<F *>(from)->~F();
+        }
+        static void destroy(void *storage)
+        {
+            static_cast<F *>(storage)->~F();
+        }
+    };
+    template<class F>
+    class Allocated
+    {
+    public:
+        template<class T>
+        static void create(void *storage, T &&function)
+        {
+            *static_cast<F **>(storage) = new F(std::forward<T>(function));
+        }
+        static const Operations * operations()
+        {
+            static const Operations operations {&invoke, &move, &destroy};
+            return &operations;
+        }
+    private:
+        static R invoke(void *storage, Args &&...args)
+        {
+            return (**static_cast<F **>(storage))(std::forward<Args>(args)...);
+        }
+        static void move(void *from, void *to)
+        {
+            *static_cast<F **>(to) = *static_cast<F **>(from);
+        }
+        static void destroy(void *storage)
+        {
+            delete *static_cast<F **>(storage);
+        }
+    };
+    void moveFrom(Callback &other) noexcept
+    {
+        if (other.m_operations != nullptr) {
+            other.m_operations->move(&other.m_storage, &m_storage);
+            m_operations = other.m_operations;
+            other.m_operations = nullptr;
+        }
+    }
+    void reset() noexcept
+    {
+        if (m_operations != nullptr) {
+            m_operations->destroy(&m_storage);
+            m_operations = nullptr;
+        }
+    }
+    const Operations *m_operations {nullptr};
+    mutable Storage m_storage;
+};
+
+}}
+
+#endif // MICROCORE_CORE_CALLBACK_H
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_CORE_CANCELLATIONTOKEN_H
+#define MICROCORE_CORE_CANCELLATIONTOKEN_H
+
+#include <microcore/core/globals.h>
+#include <memory>
+#include <type_traits>
+
+namespace microcore { namespace core {
+
+/**
+ * @brief A token used to cancel IJob
+ *
+ * This class is used to cancel requests that are sent to
+ * a Pipe. Copies of a token share the same state, so a token
+ * can be passed along the pipes of a pipeline, and cancelled
+ * from the outside.
+ *
+ * A token is cancelled either explicitly with cancel(), or
+ * when it's deadline, set with setDeadline(), is reached. The
+ * deadline relies on the event loop of the thread that set it.
+ *
+ * A default constructed token is invalid, and is never cancelled.
+ * Use create() to create a valid token.
+ */
+class CancellationToken
+{
+public:
+    /**
+     * @brief State of a token
+     */
+    enum class State
+    {
+        Active,
+        Cancelled,
+        TimedOut
+    };
+    class IListener
+    {
+    public:
+        using Ptr = std::shared_ptr<IListener>;
+        virtual ~IListener() {}
+        virtual void onCancel(State state) = 0;
+        virtual void onInvalidation() = 0;
+    };
+    explicit CancellationToken() = default;
+    DEFAULT_COPY_DEFAULT_MOVE(CancellationToken);
+    /**
+     * @brief Create a valid token
+     *
+     * @return a valid token.
+     */
+    static CancellationToken create();
+    bool isValid() const;
+    State state() const;
+    bool isCancelled() const;
+    /**
+     * @brief Cancel the token
+     *
+     * Listeners are notified with State::Cancelled, if this
+     * token was not already cancelled.
+     */
+    void cancel();
+    /**
+     * @brief Set a deadline
+     *
+     * Listeners are notified with State::TimedOut when the
+     * deadline is reached, if this token was not cancelled before.
+     *
+     * @param msecs deadline, in milliseconds from now.
+     */
+    void setDeadline(int msecs);
+    void addListener(const IListener::Ptr &listener);
+    void removeListener(const IListener::Ptr &listener);
+private:
+    class Data;
+    explicit CancellationToken(std::shared_ptr<Data> data);
+    std::shared_ptr<Data> m_data {};
+};
+
+/**
+ * @brief Errors used to report a cancelled token
+ *
+ * This class is used to create the error reported when a
+ * request is cancelled. By default, it uses the static
+ * cancelled() and timeout() methods of Error. Specialize it
+ * for Error types that do not provide these methods.
+ *
+ * If Error provides neither these methods nor a specialization,
+ * cancellation is disabled, see IsCancellable.
+ */
+template<class Error>
+class CancellationError
+{
+public:
+    template<class E = Error>
+    static auto create(CancellationToken::State state) -> decltype(static_cast<Error>(E::timeout()),
+                                                                    static_cast<Error>(E::cancelled()))
+    {
+        return state == CancellationToken::State::TimedOut ? E::timeout() : E::cancelled();
+    }
+};
+
+/**
+ * @brief If requests failing with Error can be cancelled
+ *
+ * This is the case if CancellationError can create an Error.
+ * Pipe and StaticPipe ignore the tokens of requests that cannot
+ * be cancelled, and only pass them along the pipeline.
+ */
+template<class Error, class = void>
+class IsCancellable : public std::false_type
+{
+};
+
+template<class Error>
+class IsCancellable<Error, decltype(CancellationError<Error>::create(CancellationToken::State()), void())>
+    : public std::true_type
+{
+};
+
+}}
+
+#endif // MICROCORE_CORE_CANCELLATIONTOKEN_H
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_CORE_COALESCINGJOBFACTORY_H
+#define MICROCORE_CORE_COALESCINGJOBFACTORY_H
+
+#include <microcore/core/globals.h>
+#include <microcore/core/deferredrelease.h>
+#include <microcore/core/ijobfactory.h>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace microcore { namespace core {
+
+/**
+ * @brief An IJobFactory that coalesces identical requests
+ *
+ * This class decorates an IJobFactory. Requests are looked up with
+ * a hash function, and requests that compare equal with KeyEqual
+ * are considered identical. When an IJob created by this factory is
+ * executed while an identical request is already being processed, it
+ * do not create a new decorated IJob, but waits for the result of the
+ * running one.
+ *
+ * The result is delivered to all waiting IJob as a shared pointer
+ * to a const Result, so it is never copied. Errors are copied to each
+ * waiting IJob.
+ *
+ * Only running requests are coalesced: once the decorated IJob has
+ * finished, an identical request will create a new IJob. If all the
+ * IJob waiting for a request are cancelled or destroyed, the decorated
+ * IJob is cancelled.
+ *
+ * This factory is not thread safe, and IJob created by this factory
+ * should be executed from a single thread. CoalescingJobFactory do
+ * not handle the lifecycle of the decorated IJobFactory, and should
+ * outlive the IJob it creates. Requests are copied, as a copy is kept
+ * for lookups while the decorated IJob is running.
+ */
+template<class Request, class Result, class Error, class Hash = std::hash<Request>,
+         class KeyEqual = std::equal_to<Request>>
+class CoalescingJobFactory final : public IJobFactory<Request, std::shared_ptr<const Result>, Error>
+{
+public:
+    /**
+     * @brief Type of the results of this factory
+     */
+    using SharedResult = std::shared_ptr<const Result>;
+    /**
+     * @brief Constructor
+     *
+     * @param factory factory to decorate.
+     * @param hash hash function used to look up the requests.
+     * @param equal function used to compare the requests.
+     */
+    explicit CoalescingJobFactory(const IJobFactory<Request, Result, Error> &factory, Hash hash = Hash(),
+                                  KeyEqual equal = KeyEqual())
+        : m_state {new State(factory, std::move(hash), std::move(equal))}
+    {
+    }
+    DISABLE_COPY_DISABLE_MOVE(CoalescingJobFactory);
+    std::unique_ptr<IJob<SharedResult, Error>> create(Request &&request) const override
+    {
+        return std::unique_ptr<IJob<SharedResult, Error>>(new Job(*m_state, std::move(request)));
+    }
+    /**
+     * @brief Number of requests being processed
+     *
+     * Identical requests are counted once.
+     *
+     * @return the number of decorated IJob running.
+     */
+    std::size_t inFlightCount() const
+    {
+        return m_state->flights.size();
+    }
+private:
+    class Job;
+    // A running decorated job, and the jobs waiting for it
+    class Flight
+    {
+    public:
+        const Request *request {nullptr};
+        std::unique_ptr<IJob<Result, Error>> job {};
+        std::list<Job *> waiters {};
+    };
+    // Decorated jobs are destroyed once none of them is executing a callback
+    using FinishedJobs = DeferredRelease<std::vector<std::unique_ptr<IJob<Result, Error>>>>;
+    class State
+    {
+    public:
+        explicit State(const IJobFactory<Request, Result, Error> &factory, Hash &&hash, KeyEqual &&equal)
+            : flights(0, std::move(hash), std::move(equal))
+            , m_factory {factory}
+        {
+        }
+        void attach(Job &job, Request &&request)
+        {
+            typename FinishedJobs::Lock lock {m_finishedJobs};
+            auto it = flights.find(request);
+            if (it != std::end(flights)) {
+                job.m_flight = it->second;
+                job.m_it = job.m_flight->waiters.insert(std::end(job.m_flight->waiters), &job);
+                return;
+            }
+
+            // Requests stored in the map are not moved when it rehashes
+            std::shared_ptr<Flight> flight {std::make_shared<Flight>()};
+            flight->job = m_factory.create(Request(request));
+            it = flights.emplace(std::move(request), flight).first;
+            flight->request = &it->first;
+            job.m_flight = flight;
+            job.m_it = flight->waiters.insert(std::end(flight->waiters), &job);
+
+            std::weak_ptr<Flight> weakFlight {flight};
+            flight->job->execute([this, weakFlight](Result &&result) {
+                onResult(weakFlight, std::move(result));
+            }, [this, weakFlight](Error &&error) {
+                onError(weakFlight, std::move(error));
+            });
+        }
+        void detach(Job &job)
+        {
+            if (!job.m_flight) {
+                return;
+            }
+
+            std::shared_ptr<Flight> flight {std::move(job.m_flight)};
+            flight->waiters.erase(job.m_it);
+            if (flight->waiters.empty() && flight->job) {
+                flight->job->cancel();
+                finish(*flight);
+            }
+        }
+        std::unordered_map<Request, std::shared_ptr<Flight>, Hash, KeyEqual> flights;
+    private:
+        void onResult(const std::weak_ptr<Flight> &weakFlight, Result &&result)
+        {
+            std::shared_ptr<Flight> flight {weakFlight.lock()};
+            if (!flight || !flight->job) {
+                return;
+            }
+
+            typename FinishedJobs::Lock lock {m_finishedJobs};
+            finish(*flight);
+            SharedResult shared {std::make_shared<const Result>(std::move(result))};
+            while (!flight->waiters.empty()) {
+                Job *job {flight->waiters.front()};
+                flight->waiters.pop_front();
+                job->m_flight.reset();
+                job->onResult(shared);
+            }
+        }
+        void onError(const std::weak_ptr<Flight> &weakFlight, Error &&error)
+        {
+            std::shared_ptr<Flight> flight {weakFlight.lock()};
+            if (!flight || !flight->job) {
+                return;
+            }
+
+            typename FinishedJobs::Lock lock {m_finishedJobs};
+            finish(*flight);
+            while (!flight->waiters.empty()) {
+                Job *job {flight->waiters.front()};
+                flight->waiters.pop_front();
+                job->m_flight.reset();
+                job->onError(Error(error));
+            }
+        }
+        void finish(Flight &flight)
+        {
+            flights.erase(flights.find(*flight.request));
+            m_finishedJobs.release(std::move(flight.job));
+        }
+        const IJobFactory<Request, Result, Error> &m_factory;
+        FinishedJobs m_finishedJobs {};
+    };
+    class Job final : public IJob<SharedResult, Error>
+    {
+    public:
+        explicit Job(State &state, Request &&request)
+            : m_state {state}
+            , m_request {std::move(request)}
+        {
+        }
+        DISABLE_COPY_DISABLE_MOVE(Job);
+        ~Job()
+        {
+            cancel();
+        }
+        void execute(typename IJob<SharedResult, Error>::OnResult &&onResult,
+                     typename IJob<SharedResult, Error>::OnError &&onError) override
+        {
+            m_onResult = std::move(onResult);
+            m_onError = std::move(onError);
+            m_state.attach(*this, std::move(m_request));
+        }
+        void cancel() override
+        {
+            m_state.detach(*this);
+        }
+    private:
+        friend class State;
+        void onResult(const SharedResult &result)
+        {
+            typename IJob<SharedResult, Error>::OnResult onResult {std::move(m_onResult)};
+            onResult(SharedResult(result));
+        }
+        void onError(Error &&error)
+        {
+            typename IJob<SharedResult, Error>::OnError onError {std::move(m_onError)};
+            onError(std::move(error));
+        }
+        State &m_state;
+        Request m_request;
+        typename IJob<SharedResult, Error>::OnResult m_onResult {};
+        typename IJob<SharedResult, Error>::OnError m_onError {};
+        std::shared_ptr<Flight> m_flight {};
+        typename std::list<Job *>::iterator m_it {};
+    };
+    std::unique_ptr<State> m_state {};
+};
+
+}}
+
+#endif // MICROCORE_CORE_COALESCINGJOBFACTORY_H
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_CORE_CONCURRENTLISTENERREPOSITORY_H
+#define MICROCORE_CORE_CONCURRENTLISTENERREPOSITORY_H
+
+#include <microcore/core/globals.h>
+#include <microcore/core/tracing.h>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace microcore { namespace core {
+
+/**
+ * @brief A thread safe ListenerRepository
+ *
+ * This class provides the same interface as ListenerRepository,
+ * but can be used from several threads at the same time.
+ *
+ * Listeners are stored in an immutable snapshot. notify() iterates
+ * the current snapshot, while addListener() and removeListener() copy
+ * the snapshot, modify the copy and publish it atomically
+ * (copy-on-write).
+ *
+ * This is not lock free: the snapshot is loaded and published with
+ * the atomic operations on std::shared_ptr, that lock a mutex from a
+ * small pool in common implementations, like libstdc++. notify() takes
+ * such a short lock only to copy the snapshot pointer, and listeners
+ * are called without any lock held, so notifications never wait for
+ * a listener or for a copy of the snapshot.
+ *
+ * Listeners can add or remove listeners while being notified. A
+ * notification is sent to the listeners of the snapshot taken when
+ * it started: an added listener will only be notified of the next
+ * notifications, and a removed listener might still receive the
+ * notification in progress.
+ *
+ * Expired listeners are purged by the notifications that find them.
+ */
+template<class Listener>
+class ConcurrentListenerRepository
+{
+public:
+    using ListenerPtr = std::shared_ptr<Listener>;
+    explicit ConcurrentListenerRepository() = default;
+    DISABLE_COPY_DISABLE_MOVE(ConcurrentListenerRepository);
+    ~ConcurrentListenerRepository()
+    {
+        SnapshotPtr snapshot {load()};
+        for (const std::weak_ptr<Listener> &listener : *snapshot) {
+            ListenerPtr sharedListener {listener.lock()};
+            if (sharedListener) {
+                sharedListener->onInvalidation();
+            }
+        }
+    }
+    bool isEmpty() const
+    {
+        return load()->empty();
+    }
+    std::size_t count() const
+    {
+        return load()->size();
+    }
+    void addListener(const ListenerPtr &listener)
+    {
+        update([&listener](Listeners &listeners) {
+            listeners.emplace_back(listener);
+            return true;
+        });
+    }
+    void removeListener(const ListenerPtr &listener)
+    {
+        const Listener *listenerPtr {listener.get()};
+        update([listenerPtr](Listeners &listeners) {
+            std::size_t size {listeners.size()};
+            listeners.erase(std::remove_if(std::begin(listeners), std::end(listeners),
+                                           [listenerPtr](const std::weak_ptr<Listener> &element) {
+                ListenerPtr sharedElement {element.lock()};
+                return sharedElement ? sharedElement.get() == listenerPtr : listenerPtr == nullptr;
+            }), std::end(listeners));
+            return listeners.size() != size;
+        });
+    }
+    template<class F>
+    void notify(F &&function) const
+    {
+        ListenerTraceScope scope {"ListenerRepository::notify", "listener"};
+        SnapshotPtr snapshot {load()};
+        bool expired {false};
+        for (const std::weak_ptr<Listener> &listener : *snapshot) {
+            // Keep the listener alive while it is notified
+            ListenerPtr sharedListener {listener.lock()};
+            if (sharedListener) {
+                function(*sharedListener);
+            } else {
+                expired = true;
+            }
+        }
+        if (expired) {
+            purge(snapshot);
+        }
+    }
+private:
+    using Listeners = std::vector<std::weak_ptr<Listener>>;
+    using SnapshotPtr = std::shared_ptr<const Listeners>;
+    SnapshotPtr load() const
+    {
+        return std::atomic_load(&m_snapshot);
+    }
+    // Publish a modified copy of the current snapshot
+    //
+    // The modification is applied again if another thread
+    // published a snapshot in the meantime.
+    template<class F>
+    void update(F &&modify)
+    {
+        SnapshotPtr expected {load()};
+        while (true) {
+            std::shared_ptr<Listeners> desired {std::make_shared<Listeners>(*expected)};
+            if (!modify(*desired)) {
+                return;
+            }
+            SnapshotPtr published {std::move(desired)};
+            if (std::atomic_compare_exchange_weak(&m_snapshot, &expected, published)) {
+                return;
+            }
+        }
+    }
+    // Purging is best effort: it is abandoned if the
+    // snapshot was replaced, the next notification will retry
+    void purge(SnapshotPtr expected) const
+    {
+        std::shared_ptr<Listeners> desired {std::make_shared<Listeners>()};
+        desired->reserve(expected->size());
+        std::copy_if(std::begin(*expected), std::end(*expected), std::back_inserter(*desired),
+                     [](const std::weak_ptr<Listener> &listener) {
+            return !listener.expired();
+        });
+        SnapshotPtr published {std::move(desired)};
+        std::atomic_compare_exchange_strong(&m_snapshot, &expected, published);
+    }
+    mutable SnapshotPtr m_snapshot {std::make_shared<const Listeners>()};
+};
+
+}}
+
+#endif // MICROCORE_CORE_CONCURRENTLISTENERREPOSITORY_H
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_CORE_DEFERREDRELEASE_H
+#define MICROCORE_CORE_DEFERREDRELEASE_H
+
+#include <microcore/core/globals.h>
+#include <utility>
+
+namespace microcore { namespace core {
+
+/**
+ * @brief Objects destroyed once no callback is executing
+ *
+ * A class that invokes callbacks, like Pipe, cannot destroy the
+ * objects that are still executing, like an IJob completing, or a
+ * listener being notified, when it is re-entered from one of these
+ * callbacks.
+ *
+ * Such a class holds a Lock for the duration of each callback, and
+ * of each call that can invoke one. Objects are released in the
+ * Container returned by released(), and are destroyed when the last
+ * Lock is destroyed, at the end of the outermost callback.
+ */
+template<class Container>
+class DeferredRelease
+{
+public:
+    /**
+     * @brief A nested callback
+     */
+    class Lock
+    {
+    public:
+        explicit Lock(DeferredRelease<Container> &release)
+            : m_release {release}
+        {
+            ++m_release.m_depth;
+        }
+        DISABLE_COPY_DISABLE_MOVE(Lock);
+        ~Lock()
+        {
+            if (--m_release.m_depth == 0 && !m_release.m_released.empty()) {
+                // Destroyed objects might release other objects
+                Container released {};
+                std::swap(released, m_release.m_released);
+            }
+        }
+    private:
+        DeferredRelease<Container> &m_release;
+    };
+    explicit DeferredRelease() = default;
+    DISABLE_COPY_DISABLE_MOVE(DeferredRelease);
+    /**
+     * @brief If a callback is executing
+     *
+     * @return if a Lock is held.
+     */
+    bool locked() const
+    {
+        return m_depth != 0;
+    }
+    /**
+     * @brief Objects to destroy
+     *
+     * @return the objects destroyed when the last Lock is destroyed.
+     */
+    Container & released()
+    {
+        return m_released;
+    }
+    /**
+     * @brief Release an object
+     *
+     * The object is destroyed immediately if no callback is
+     * executing, and when the last Lock is destroyed otherwise.
+     *
+     * @param value object to release.
+     */
+    void release(typename Container::value_type &&value)
+    {
+        if (m_depth == 0) {
+            typename Container::value_type destroyed {std::move(value)};
+            return;
+        }
+        m_released.emplace_back(std::move(value));
+    }
+private:
+    Container m_released {};
+    int m_depth {0};
+};
+
+}}
+
+#endif // MICROCORE_CORE_DEFERREDRELEASE_H
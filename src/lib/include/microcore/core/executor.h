@@ -32,14 +32,16 @@
 #ifndef MICROCORE_CORE_EXECUTOR_H
 #define MICROCORE_CORE_EXECUTOR_H
 
-#include <functional>
 #include <microcore/core/globals.h>
+#include <microcore/core/cancellationtoken.h>
+#include <microcore/core/instrumentation.h>
 #include <microcore/core/listenerrepository.h>
+#include <microcore/core/tracing.h>
 
 namespace microcore { namespace core {
 
 template<class Error>
-class Executor
+class Executor : public InstrumentedStage
 {
 public:
     class IListener
@@ -76,6 +78,29 @@ public:
     {
         return m_busy;
     }
+    /**
+     * @brief Cancel the current execution
+     *
+     * This only cancels token(). Subclasses should send their requests
+     * with token(), eg. with Pipe::send(), so that they are cancelled
+     * too.
+     */
+    void cancel()
+    {
+        m_token.cancel();
+    }
+    /**
+     * @brief Set the deadline of the next executions
+     *
+     * Like cancel(), the deadline applies to token(), and only
+     * to the requests sent with it.
+     *
+     * @param msecs deadline, in milliseconds, or 0 for no deadline.
+     */
+    void setDeadline(int msecs)
+    {
+        m_deadline = msecs;
+    }
 protected:
     bool canStart() const
     {
@@ -85,40 +110,79 @@ protected:
     {
         return m_busy;
     }
+    /**
+     * @brief Token of the current execution
+     *
+     * A new token is created by doStart(). Pass it with the requests
+     * of the execution, so that cancel() and setDeadline() apply to
+     * them.
+     *
+     * @return the token of the current execution.
+     */
+    const CancellationToken & token() const
+    {
+        return m_token;
+    }
     void doStart()
     {
+        TraceScope scope {"Executor::doStart", "executor"};
         if (!canStart()) {
             return;
         }
-        using namespace std::placeholders;
         m_busy = true;
         m_error = Error();
-        m_listenerRepository.notify(std::bind(&IListener::onStart, _1));
+        m_token = CancellationToken::create();
+        if (m_deadline > 0) {
+            m_token.setDeadline(m_deadline);
+        }
+        if (InstrumentationEnabled && statistics() != nullptr) {
+            m_stopwatch.start();
+        }
+        m_listenerRepository.notify([](IListener &listener) {
+            listener.onStart();
+        });
     }
     void doError(Error &&error)
     {
-        using namespace std::placeholders;
+        TraceScope scope {"Executor::doError", "executor"};
         if (!canFinish()) {
             return;
         }
         m_busy = false;
+        if (InstrumentationEnabled && statistics() != nullptr) {
+            statistics()->executeTime.record(m_stopwatch.elapsed());
+            ++statistics()->errors;
+        }
         m_error = std::move(error);
-        m_listenerRepository.notify(std::bind(&IListener::onError, _1, std::ref(m_error)));
+        const Error &currentError {m_error};
+        m_listenerRepository.notify([&currentError](IListener &listener) {
+            listener.onError(currentError);
+        });
     }
     void doFinish()
     {
-        using namespace std::placeholders;
+        TraceScope scope {"Executor::doFinish", "executor"};
         if (!canFinish()) {
             return;
         }
         m_busy = false;
+        if (InstrumentationEnabled && statistics() != nullptr) {
+            statistics()->executeTime.record(m_stopwatch.elapsed());
+            ++statistics()->results;
+        }
         m_error = Error();
-        m_listenerRepository.notify(std::bind(&IListener::onFinish, _1));
+        m_listenerRepository.notify([](IListener &listener) {
+            listener.onFinish();
+        });
     }
 private:
     ListenerRepository<IListener> m_listenerRepository {};
     bool m_busy {false};
+    // Next to m_busy, so that it takes no space when empty
+    Stopwatch m_stopwatch {};
+    int m_deadline {0};
     Error m_error {};
+    CancellationToken m_token {};
 };
 
 }}
@@ -32,8 +32,8 @@
 #ifndef MICROCORE_CORE_IJOB_H
 #define MICROCORE_CORE_IJOB_H
 
+#include <microcore/core/callback.h>
 #include <memory>
-#include <functional>
 
 namespace microcore { namespace core {
 
@@ -55,11 +55,11 @@ public:
     /**
      * @brief Type of the success callback
      */
-    using OnResult = std::function<void (Result &&)>;
+    using OnResult = Callback<void (Result &&)>;
     /**
      * @brief Type of the error callback
      */
-    using OnError = std::function<void (Error &&)>;
+    using OnError = Callback<void (Error &&)>;
     /**
      * @brief Destructor
      */
@@ -75,6 +75,16 @@ public:
      * @param onError callback used to indicate if the job has failed.
      */
     virtual void execute(OnResult &&onResult, OnError &&onError) = 0;
+    /**
+     * @brief Cancel a job
+     *
+     * Implement this method to abort a task that is being executed,
+     * and release the resources it uses. After this method is called,
+     * the callbacks passed to execute() must not be invoked anymore.
+     *
+     * The default implementation does nothing.
+     */
+    virtual void cancel() {}
 };
 
 }}
@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_CORE_INSTRUMENTATION_H
+#define MICROCORE_CORE_INSTRUMENTATION_H
+
+#include <microcore/core/globals.h>
+#include <microcore/core/callback.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <QByteArray>
+
+class QTimer;
+
+namespace microcore { namespace core {
+
+/**
+ * @brief If instrumentation is compiled in
+ *
+ * Instrumentation is enabled by defining MICROCORE_INSTRUMENTATION,
+ * see the ENABLE_INSTRUMENTATION CMake option. When it is disabled,
+ * Pipe and Executor do not record anything, and the code recording
+ * statistics is removed by the compiler.
+ */
+#ifdef MICROCORE_INSTRUMENTATION
+static constexpr bool InstrumentationEnabled {true};
+#else
+static constexpr bool InstrumentationEnabled {false};
+#endif
+
+/**
+ * @brief A lock-free histogram
+ *
+ * This class records positive values in logarithmic buckets, each
+ * power of two being split in four buckets, so percentiles are
+ * approximated with an error below 25%. Values can be recorded from
+ * any thread without locking.
+ */
+class Histogram
+{
+public:
+    static const std::size_t BucketCount {4 + 62 * 4};
+    explicit Histogram() = default;
+    DISABLE_COPY_DISABLE_MOVE(Histogram);
+    /**
+     * @brief Record a value
+     *
+     * @param value value to record.
+     */
+    void record(std::uint64_t value);
+    std::uint64_t count() const;
+    std::uint64_t sum() const;
+    std::uint64_t max() const;
+    /**
+     * @brief Approximate percentile
+     *
+     * @param percentile percentile, between 0 and 100.
+     * @return the approximate value of the percentile, or 0 if no value were recorded.
+     */
+    std::uint64_t percentile(double percentile) const;
+    void reset();
+private:
+    static std::size_t bucket(std::uint64_t value);
+    static std::uint64_t bucketValue(std::size_t bucket);
+    std::array<std::atomic<std::uint64_t>, BucketCount> m_buckets {};
+    std::atomic<std::uint64_t> m_count {0};
+    std::atomic<std::uint64_t> m_sum {0};
+    std::atomic<std::uint64_t> m_max {0};
+};
+
+/**
+ * @brief Statistics of a stage
+ *
+ * A stage is a Pipe or an Executor. Times are in microseconds, and
+ * sizes in bytes, see ResultSize.
+ *
+ * - queueTime is the time a request waited before being executed.
+ * - executeTime is the time between the start and the end of the execution.
+ * - resultSize is the size of the results.
+ */
+class StageStatistics
+{
+public:
+    /**
+     * @brief Percentiles of a Histogram
+     */
+    class Percentiles
+    {
+    public:
+        std::uint64_t p50 {0};
+        std::uint64_t p95 {0};
+        std::uint64_t p99 {0};
+        std::uint64_t max {0};
+    };
+    /**
+     * @brief Summary of the statistics of a stage
+     */
+    class Summary
+    {
+    public:
+        std::string name {};
+        std::uint64_t results {0};
+        std::uint64_t errors {0};
+        Percentiles queueTime {};
+        Percentiles executeTime {};
+        Percentiles resultSize {};
+    };
+    explicit StageStatistics(const std::string &name);
+    DISABLE_COPY_DISABLE_MOVE(StageStatistics);
+    const std::string & name() const;
+    Summary summary() const;
+    void reset();
+    Histogram queueTime {};
+    Histogram executeTime {};
+    Histogram resultSize {};
+    std::atomic<std::uint64_t> results {0};
+    std::atomic<std::uint64_t> errors {0};
+private:
+    std::string m_name {};
+};
+
+/**
+ * @brief Measure a duration
+ *
+ * When instrumentation is disabled, this class is empty. Classes
+ * that hold many stopwatches derive from it, so that it takes no
+ * space then.
+ *
+ * The clock is only read by start(), and elapsed() is 0 if
+ * start() was not called.
+ */
+#ifdef MICROCORE_INSTRUMENTATION
+class Stopwatch
+{
+public:
+    void start()
+    {
+        m_start = std::chrono::steady_clock::now();
+    }
+    std::uint64_t elapsed() const
+    {
+        using namespace std::chrono;
+        if (m_start == steady_clock::time_point()) {
+            return 0;
+        }
+        return static_cast<std::uint64_t>(duration_cast<microseconds>(steady_clock::now() - m_start).count());
+    }
+private:
+    std::chrono::steady_clock::time_point m_start {};
+};
+#else
+class Stopwatch
+{
+public:
+    void start()
+    {
+    }
+    std::uint64_t elapsed() const
+    {
+        return 0;
+    }
+};
+#endif
+
+/**
+ * @brief A stage recording statistics
+ *
+ * Pipe and Executor derive from this class, that holds the
+ * statistics set with setStatistics(). When instrumentation is
+ * disabled, this class is empty, and statistics() is always null,
+ * so that the recording code is removed.
+ */
+#ifdef MICROCORE_INSTRUMENTATION
+class InstrumentedStage
+{
+public:
+    /**
+     * @brief Set the statistics of this stage
+     *
+     * When instrumentation is enabled, the statistics of this stage
+     * are recorded in the provided statistics, see Instrumentation.
+     *
+     * @param statistics statistics of this stage, or nullptr.
+     */
+    void setStatistics(StageStatistics *statistics)
+    {
+        m_statistics = statistics;
+    }
+protected:
+    StageStatistics * statistics() const
+    {
+        return m_statistics;
+    }
+private:
+    StageStatistics *m_statistics {nullptr};
+};
+#else
+class InstrumentedStage
+{
+public:
+    void setStatistics(StageStatistics *)
+    {
+    }
+protected:
+    StageStatistics * statistics() const
+    {
+        return nullptr;
+    }
+};
+#endif
+
+/**
+ * @brief Size of a result, used by instrumentation
+ *
+ * By default, the size of a result is sizeof(Result). Specialize
+ * this class for results that own memory.
+ */
+template<class Result>
+class ResultSize
+{
+public:
+    static std::uint64_t size(const Result &)
+    {
+        return sizeof(Result);
+    }
+};
+
+template<>
+class ResultSize<QByteArray>
+{
+public:
+    static std::uint64_t size(const QByteArray &result)
+    {
+        return static_cast<std::uint64_t>(result.size());
+    }
+};
+
+/**
+ * @brief A set of StageStatistics
+ *
+ * Stages are created on demand with stage(), and are never
+ * destroyed before the Instrumentation, so the returned references
+ * can be stored, eg. by Pipe::setStatistics().
+ *
+ * The statistics can be queried with summaries(), formatted with
+ * dump(), or dumped periodically with startDump().
+ */
+class Instrumentation
+{
+public:
+    explicit Instrumentation();
+    DISABLE_COPY_DISABLE_MOVE(Instrumentation);
+    ~Instrumentation();
+    /**
+     * @brief Global instance
+     *
+     * @return a global Instrumentation.
+     */
+    static Instrumentation & global();
+    /**
+     * @brief Get or create a stage
+     *
+     * @param name name of the stage.
+     * @return the statistics of the stage.
+     */
+    StageStatistics & stage(const std::string &name);
+    std::vector<StageStatistics::Summary> summaries() const;
+    /**
+     * @brief Format the statistics
+     *
+     * @return one line per stage, with counts and percentiles.
+     */
+    std::string dump() const;
+    void reset();
+    /**
+     * @brief Dump the statistics periodically
+     *
+     * The statistics are dumped by the event loop of the calling thread.
+     *
+     * @param msecs interval between two dumps, in milliseconds.
+     * @param output function receiving the dumps, by default, qDebug().
+     */
+    void startDump(int msecs, Callback<void (const std::string &)> &&output = nullptr);
+    void stopDump();
+private:
+    mutable std::mutex m_mutex {};
+    std::map<std::string, std::unique_ptr<StageStatistics>> m_stages {};
+    std::unique_ptr<QTimer> m_timer {};
+    Callback<void (const std::string &)> m_output {};
+};
+
+}}
+
+#endif // MICROCORE_CORE_INSTRUMENTATION_H
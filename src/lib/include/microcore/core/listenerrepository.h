@@ -33,13 +33,66 @@
 #define MICROCORE_CORE_LISTENERREPOSITORY_H
 
 #include <microcore/core/globals.h>
+#include <microcore/core/deferredrelease.h>
+#include <microcore/core/notificationbatch.h>
+#include <microcore/core/tracing.h>
 #include <memory>
 #include <vector>
 #include <algorithm>
+#include <type_traits>
 
 namespace microcore { namespace core {
 
+/**
+ * @brief How a ListenerRepository references listeners
+ */
+enum class ListenerReference
+{
+    /**
+     * @brief Listeners are weakly referenced
+     *
+     * Listeners are removed when they are destroyed. Each notified
+     * listener is locked for the duration of the notification.
+     */
+    Weak,
+    /**
+     * @brief Listeners are strongly referenced
+     *
+     * Listeners are kept alive until they are explicitly removed
+     * with removeListener(). Notifications are not paying for
+     * locking listeners.
+     */
+    Strong
+};
+
+template<class Listener, ListenerReference Reference>
+class ListenerReferenceTraits;
+
+template<class Listener>
+class ListenerReferenceTraits<Listener, ListenerReference::Weak>
+{
+public:
+    using Element = std::weak_ptr<Listener>;
+    using Guard = std::shared_ptr<Listener>;
+    static Guard lock(const Element &element)
+    {
+        return element.lock();
+    }
+};
+
 template<class Listener>
+class ListenerReferenceTraits<Listener, ListenerReference::Strong>
+{
+public:
+    using Element = std::shared_ptr<Listener>;
+    using Guard = Listener *;
+    static Guard lock(const Element &element)
+    {
+        return element.get();
+    }
+};
+
+template<class Listener, ListenerReference Reference = ListenerReference::Weak>
 class ListenerRepository
 {
 public:
@@ -48,8 +101,10 @@ public:
     DISABLE_COPY_DISABLE_MOVE(ListenerRepository);
     ~ListenerRepository()
     {
-        Invoker invoker {&Listener::onInvalidation};
-        std::for_each(std::begin(m_listeners), std::end(m_listeners), invoker);
+        NotificationBatch::discard(this);
+        notify([](Listener &listener) {
+            listener.onInvalidation();
+        });
     }
     bool isEmpty() const
     {
@@ -66,54 +121,161 @@ public:
     void removeListener(const std::shared_ptr<Listener> &listener)
     {
         const Listener *listenerPtr {listener.get()};
-        m_listeners.erase(std::remove_if(std::begin(m_listeners), std::end(m_listeners),
-                          [listenerPtr](const std::weak_ptr<Listener> &element) {
-            if (element.expired())
-            {
-                return (listenerPtr == nullptr);
-            }
-            else
-            {
-                const std::shared_ptr<Listener> &elementSharedPtr {element.lock()};
-                return (listenerPtr == elementSharedPtr.get());
+        auto matches = [listenerPtr](const Element &element) {
+            Guard guard {Traits::lock(element)};
+            return guard ? &(*guard) == listenerPtr : listenerPtr == nullptr;
+        };
+        if (!m_removed.locked()) {
+            m_listeners.erase(std::remove_if(std::begin(m_listeners), std::end(m_listeners), matches),
+                              std::end(m_listeners));
+            return;
+        }
+
+        // Notifications are iterating the listeners: removed listeners
+        // are cleared, and purged once all notifications are done
+        for (Element &element : m_listeners) {
+            if (matches(element)) {
+                m_removed.release(std::move(element));
+                element = Element();
+                m_dirty = true;
             }
+        }
+    }
+    /**
+     * @brief Notify the listeners
+     *
+     * The function is called with each listener. It is not type
+     * erased, so that lambdas can be inlined.
+     *
+     * Listeners can add or remove listeners while being notified.
+     * Added listeners are notified from the next notification.
+     *
+     * @param function function called with each listener.
+     */
+    template<class F>
+    void notify(F &&function)
+    {
+        // This method will purge expired listeners after invoking non-expired ones
+        ListenerTraceScope scope {"ListenerRepository::notify", "listener"};
+        invoke(function);
+        if (m_removed.locked() || !m_dirty) {
+            return;
+        }
+        m_listeners.erase(std::remove_if(std::begin(m_listeners), std::end(m_listeners), [](const Element &element) {
+            return !Traits::lock(element);
         }), std::end(m_listeners));
+        m_dirty = false;
     }
-    void notify(std::function<void (Listener &)> &&function)
+    template<class F>
+    void notify(F &&function) const
     {
-        // This method will purge expired listeners while invoking non-expired ones
-        Invoker invoker {std::move(function)};
-        m_listeners.erase(std::remove_if(std::begin(m_listeners), std::end(m_listeners), invoker),
-                          std::end(m_listeners));
+        ListenerTraceScope scope {"ListenerRepository::notify", "listener"};
+        invoke(function);
     }
-    void notify(std::function<void (Listener &)> &&function) const
+    /**
+     * @brief Post a notification
+     *
+     * The notification is queued if a NotificationBatch is active,
+     * and sent immediately otherwise. As it might be deferred, the
+     * function should not reference temporary data.
+     *
+     * @param function function called with each listener.
+     */
+    template<class F>
+    void post(F &&function)
     {
-        Invoker invoker {std::move(function)};
-        std::for_each(std::begin(m_listeners), std::end(m_listeners), invoker);
+        NotificationBatch *batch {NotificationBatch::active()};
+        if (batch == nullptr) {
+            notify(std::forward<F>(function));
+            return;
+        }
+        batch->post(this, Deferred<typename std::decay<F>::type>(*this, std::forward<F>(function)));
+    }
+    /**
+     * @brief Post a keyed notification
+     *
+     * Like post(), but only ends the merging of notifications
+     * with the same key, see NotificationBatch.
+     *
+     * @param key key of the notification.
+     * @param function function called with each listener.
+     */
+    template<class Key, class F>
+    void post(const Key &key, F &&function)
+    {
+        NotificationBatch *batch {NotificationBatch::active()};
+        if (batch == nullptr) {
+            notify(std::forward<F>(function));
+            return;
+        }
+        batch->post(this, key, Deferred<typename std::decay<F>::type>(*this, std::forward<F>(function)));
+    }
+    /**
+     * @brief Post a notification that can be merged
+     *
+     * The notification is dropped if a NotificationBatch is active
+     * and already queued a mergeable notification with the same key.
+     *
+     * @param key key of the notification.
+     * @param function function called with each listener.
+     */
+    template<class Key, class F>
+    void coalesce(const Key &key, F &&function)
+    {
+        NotificationBatch *batch {NotificationBatch::active()};
+        if (batch == nullptr) {
+            notify(std::forward<F>(function));
+            return;
+        }
+        batch->coalesce(this, key, Deferred<typename std::decay<F>::type>(*this, std::forward<F>(function)));
     }
 private:
-    // This function will return true for expired listeners
-    // It can be used for std::remove_if to purge them from the repository
-    class Invoker
+    using Traits = ListenerReferenceTraits<Listener, Reference>;
+    using Element = typename Traits::Element;
+    using Guard = typename Traits::Guard;
+    template<class F>
+    class Deferred
     {
     public:
-        explicit Invoker(std::function<void (Listener &)> &&function)
-            : m_function {function}
+        explicit Deferred(ListenerRepository<Listener, Reference> &repository, F &&function)
+            : m_repository {repository}
+            , m_function {std::move(function)}
         {
         }
-        bool operator()(const std::weak_ptr<Listener> &listener) const
+        explicit Deferred(ListenerRepository<Listener, Reference> &repository, const F &function)
+            : m_repository {repository}
+            , m_function {function}
         {
-            if (listener.expired()) {
-                return true;
-            }
-            const std::shared_ptr<Listener> &sharedListener {listener.lock()};
-            m_function(*sharedListener);
-            return false;
+        }
+        void operator()()
+        {
+            m_repository.notify(m_function);
         }
     private:
-        const std::function<void (Listener &)> &m_function;
+        ListenerRepository<Listener, Reference> &m_repository;
+        F m_function;
     };
-    std::vector<std::weak_ptr<Listener>> m_listeners {};
+    // Removed listeners are destroyed once all notifications are done
+    using Removed = DeferredRelease<std::vector<Element>>;
+    // Listeners are indexed, as listeners might be added
+    // during the notification
+    template<class F>
+    void invoke(F &function) const
+    {
+        typename Removed::Lock lock {m_removed};
+        const std::size_t size {m_listeners.size()};
+        for (std::size_t i = 0; i < size; ++i) {
+            Guard guard {Traits::lock(m_listeners[i])};
+            if (guard) {
+                function(*guard);
+            } else {
+                m_dirty = true;
+            }
+        }
+    }
+    std::vector<Element> m_listeners {};
+    mutable Removed m_removed {};
+    mutable bool m_dirty {false};
 };
 
 }}
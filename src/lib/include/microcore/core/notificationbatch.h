@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_CORE_NOTIFICATIONBATCH_H
+#define MICROCORE_CORE_NOTIFICATIONBATCH_H
+
+#include <microcore/core/globals.h>
+#include <microcore/core/callback.h>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace microcore { namespace core {
+
+/**
+ * @brief A scope deferring notifications
+ *
+ * While a NotificationBatch is alive, notifications posted to a
+ * ListenerRepository, see ListenerRepository::post() and
+ * ListenerRepository::coalesce(), are queued instead of being sent.
+ * They are sent in order when the batch is destroyed, or when
+ * flush() is called.
+ *
+ * Coalesced notifications are merged: a notification is dropped if
+ * a notification with the same key, posted by the same repository,
+ * is already queued. Keys are compared with std::less. A keyed
+ * notification posted with post() ends the merging for its key, and
+ * a notification posted without key ends the merging for all keys
+ * of the repository. Coalescing is used for notifications that read
+ * the current state of their source, like updates of a value.
+ *
+ * Batches are per thread. A batch created while another batch is
+ * active on the same thread joins it, and notifications are only
+ * sent when the outermost batch is destroyed. Notifications sent
+ * while flushing are not deferred.
+ *
+ * Notifications sent with ListenerRepository::notify() are never
+ * deferred.
+ */
+class NotificationBatch
+{
+public:
+    explicit NotificationBatch();
+    DISABLE_COPY_DISABLE_MOVE(NotificationBatch);
+    ~NotificationBatch();
+    /**
+     * @brief Active batch
+     *
+     * @return the batch queuing notifications on this thread, or nullptr.
+     */
+    static NotificationBatch * active();
+    /**
+     * @brief Number of queued notifications
+     *
+     * @return the number of queued notifications.
+     */
+    std::size_t pendingCount() const;
+    /**
+     * @brief Number of merged notifications
+     *
+     * @return the number of notifications dropped because they were merged.
+     */
+    std::size_t coalescedCount() const;
+    /**
+     * @brief Send the queued notifications
+     */
+    void flush();
+    /**
+     * @brief Queue a notification
+     *
+     * @param source repository posting the notification.
+     * @param function function sending the notification.
+     */
+    void post(const void *source, Callback<void ()> &&function);
+    /**
+     * @brief Queue a keyed notification
+     *
+     * @param source repository posting the notification.
+     * @param key key of the notification.
+     * @param function function sending the notification.
+     */
+    template<class Key>
+    void post(const void *source, const Key &key, Callback<void ()> &&function)
+    {
+        KeyHolder<Key> probe {source, key};
+        m_candidates.erase(&probe);
+        m_entries.emplace_back(source, std::move(function));
+    }
+    /**
+     * @brief Queue a notification that can be merged
+     *
+     * @param source repository posting the notification.
+     * @param key key of the notification.
+     * @param function function sending the notification.
+     */
+    template<class Key>
+    void coalesce(const void *source, const Key &key, Callback<void ()> &&function)
+    {
+        KeyHolder<Key> probe {source, key};
+        if (m_candidates.find(&probe) != std::end(m_candidates)) {
+            ++m_coalescedCount;
+            return;
+        }
+        m_keys.emplace_back(new KeyHolder<Key>(source, key));
+        m_candidates.insert(m_keys.back().get());
+        m_entries.emplace_back(source, std::move(function));
+    }
+    /**
+     * @brief Drop the notifications of a source
+     *
+     * This method is called by a ListenerRepository being destroyed.
+     *
+     * @param source repository whose notifications are dropped.
+     */
+    static void discard(const void *source);
+private:
+    // Keys of mergeable notifications, ordered by source,
+    // by type, and then by key
+    class IKey
+    {
+    public:
+        explicit IKey(const void *source)
+            : source {source}
+        {
+        }
+        virtual ~IKey() {}
+        virtual const void * type() const = 0;
+        virtual bool less(const IKey &other) const = 0;
+        const void *source {nullptr};
+    };
+    class KeyLess
+    {
+    public:
+        bool operator()(const IKey *first, const IKey *second) const
+        {
+            std::less<const void *> less {};
+            if (first->source != second->source) {
+                return less(first->source, second->source);
+            }
+            if (first->type() != second->type()) {
+                return less(first->type(), second->type());
+            }
+            return first->less(*second);
+        }
+    };
+    template<class Key>
+    class KeyHolder final : public IKey
+    {
+    public:
+        explicit KeyHolder(const void *source, const Key &key)
+            : IKey(source)
+            , m_key {key}
+        {
+        }
+        static const void * staticType()
+        {
+            static const char tag {0};
+            return &tag;
+        }
+        const void * type() const override
+        {
+            return staticType();
+        }
+        bool less(const IKey &other) const override
+        {
+            return std::less<Key>()(m_key, static_cast<const KeyHolder<Key> &>(other).m_key);
+        }
+    private:
+        Key m_key;
+    };
+    class Entry
+    {
+    public:
+        explicit Entry(const void *source, Callback<void ()> &&function)
+            : source {source}, function {std::move(function)}
+        {
+        }
+        const void *source {nullptr};
+        Callback<void ()> function {};
+    };
+    void removeCandidates(const void *source);
+    NotificationBatch *m_outer {nullptr};
+    std::vector<Entry> m_entries {};
+    std::set<const IKey *, KeyLess> m_candidates {};
+    std::vector<std::unique_ptr<IKey>> m_keys {};
+    std::size_t m_coalescedCount {0};
+    bool m_flushing {false};
+};
+
+}}
+
+#endif // MICROCORE_CORE_NOTIFICATIONBATCH_H
@@ -1,12 +1,39 @@
 #ifndef MICROCORE_CORE_PIPE_H
 #define MICROCORE_CORE_PIPE_H
 
+#include <microcore/core/globals.h>
+#include <microcore/core/cancellationtoken.h>
+#include <microcore/core/deferredrelease.h>
 #include <microcore/core/ijobfactory.h>
+#include <microcore/core/instrumentation.h>
+#include <microcore/core/tracing.h>
+#include <algorithm>
+#include <deque>
 #include <map>
-#include <QtGlobal>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 namespace microcore { namespace core {
 
+/**
+ * @brief Order in which a Pipe releases results
+ */
+enum class PipeOrder
+{
+    /**
+     * @brief Results are released in the order the requests were sent
+     */
+    Sequential,
+    /**
+     * @brief Results are released as soon as they are available
+     */
+    Completion
+};
+
+template<class Result, class T, class Error>
+class PipeSink;
+
 /**
  * @brief A pipe for IJob
  *
@@ -26,13 +53,37 @@ namespace microcore { namespace core {
  * will fail, and the reported error will be the one of the failing
  * pipe.
  *
+ * A pipe can execute several IJob at the same time. The maximum
+ * number of requests that are processed by a pipe at the same
+ * time is called the window. When the window is full, send()
+ * refuses new requests. Requests coming from a prepended pipe are
+ * queued instead, and the prepended pipes refuses new requests until
+ * the queue is drained. Results are released either in the order
+ * the requests were sent, or as soon as they are available, see
+ * PipeOrder.
+ *
+ * Requests can be sent with a CancellationToken. The token is
+ * passed along the pipeline with the request. When the token is
+ * cancelled, the IJob processing the request is cancelled, and
+ * an error, created by CancellationError, is sent instead of the
+ * result. Cancellation is only enabled if Error can report it, see
+ * IsCancellable. Otherwise, tokens are only passed along.
+ *
+ * When the global Tracer is enabled, each request gets a flow id
+ * that is passed along the pipeline with the request, so that the
+ * stages processing a request are linked in the trace.
+ *
+ * When instrumentation is enabled, the queue time, execution time,
+ * result size and errors of the pipe are recorded in the statistics
+ * set with setStatistics().
+ *
  * Pipe handle the lifecycle of the IJob it creates using
  * IJobFactory, but do not handle the lifecycle of the
  * IJobFactory. You will also need to handle the lifecycle
  * of Pipe.
  */
 template<class Request, class Result, class Error>
-class Pipe
+class Pipe : public InstrumentedStage
 {
 public:
     /**
@@ -47,15 +98,21 @@ public:
      * @param factory factory used to create IJob for the pipe.
      * @param onResult callback used to indicate if the pipe is successful.
      * @param onError callback used to indicate if the pipe has failed.
+     * @param window maximum number of requests processed at the same time.
+     * @param order order in which results are released.
      */
     Pipe(const IJobFactory<Request, Result, Error> &factory,
-         typename IJob<Result, Error>::OnResult onResult,
-         typename IJob<Result, Error>::OnError onError)
+         typename IJob<Result, Error>::OnResult &&onResult,
+         typename IJob<Result, Error>::OnError &&onError,
+         std::size_t window = 1, PipeOrder order = PipeOrder::Sequential)
         : m_factory {factory}
-        , m_onResult {onResult}
-        , m_onError {onError}
+        , m_onResult {std::move(onResult)}
+        , m_onError {std::move(onError)}
+        , m_window {std::max<std::size_t>(window, 1)}
+        , m_order {order}
     {
     }
+    DISABLE_COPY_DISABLE_MOVE(Pipe);
     /**
      * @brief Prepend a pipe
      *
@@ -66,15 +123,38 @@ public:
      * execution has failed.
      *
      * @param factory factory used to create IJob for the prepended pipe.
+     * @param window maximum number of requests processed at the same time by the prepended pipe.
+     * @param order order in which results are released by the prepended pipe.
      * @return the prepended pipe.
      */
     template<class T>
-    std::unique_ptr<Pipe<T, Request, Error>> prepend(const IJobFactory<T, Request, Error> &factory)
+    std::unique_ptr<Pipe<T, Request, Error>> prepend(const IJobFactory<T, Request, Error> &factory,
+                                                     std::size_t window = 1,
+                                                     PipeOrder order = PipeOrder::Sequential)
+    {
+        OnError onError {[this](Error &&error) {
+            sendError(std::move(error));
+        }};
+        std::unique_ptr<Pipe<T, Request, Error>> pipe {new Pipe<T, Request, Error>(factory, OnResult<Request>(), std::move(onError), window, order)};
+        pipe->m_nextPush = [this](Request &&request, const CancellationToken &token, std::uint64_t flow) {
+            push(std::move(request), token, flow);
+        };
+        pipe->m_nextAccepting = [this]() {
+            return accepting();
+        };
+        return pipe;
+    }
+    /**
+     * @brief If this pipe accepts a new request
+     *
+     * A pipe do not accept new requests when it's window is full
+     * or when a pipe it is prepended to have queued requests.
+     *
+     * @return if this pipe accepts a new request.
+     */
+    bool canSend() const
     {
-        using namespace std::placeholders;
-        OnResult<Request> onResult {std::bind(&Pipe<Request, Result, Error>::send, this, _1)};
-        OnError onError {std::bind(&Pipe<Request, Result, Error>::sendError, this, _1)};
-        return std::unique_ptr<Pipe<T, Request, Error>>(new Pipe<T, Request, Error>(factory, std::move(onResult), std::move(onError)));
+        return m_slots.size() < m_window && accepting();
     }
     /**
      * @brief Execute this pipe
@@ -84,40 +164,318 @@ public:
      * If this pipe is part of a pipeline, the whole pipeline will be
      * executed.
      *
+     * If this pipe do not accept new requests, see canSend(), the
+     * request is not consumed, and false is returned.
+     *
      * @param request request used to execute this pipe.
+     * @param token token used to cancel the request.
+     * @return if the request is accepted.
      */
-    void send(Request &&request)
+    bool send(Request &&request, const CancellationToken &token = CancellationToken())
     {
-        Q_ASSERT(!m_job);
-        using namespace std::placeholders;
-        OnResult<Result> onResult {std::bind(&Pipe<Request, Result, Error>::onResult, this, _1)};
-        OnError onError {std::bind(&Pipe<Request, Result, Error>::sendError, this, _1)};
-        m_job = m_factory.create(std::move(request));
-        m_job->execute(std::move(onResult), std::move(onError));
+        TraceScope scope {"Pipe::send", "pipe"};
+        if (!canSend()) {
+            return false;
+        }
+        start(std::move(request), token);
+        return true;
     }
     /**
      * @brief Send an error through this pipe
      *
      * Send the provided error through this pipe.
      *
+     * If results are released sequentially, the error is
+     * released after the results of the requests sent before it.
+     *
      * @param error error to be sent.
      */
     void sendError(Error &&error)
     {
-        m_onError(std::move(error));
+        if (m_order == PipeOrder::Completion || (m_slots.empty() && m_queue.empty())) {
+            m_onError(std::move(error));
+            return;
+        }
+
+        Pending pending {};
+        pending.error.reset(new Error(std::move(error)));
+        m_queue.push_back(std::move(pending));
+        process();
     }
 private:
+    template<class, class, class> friend class Pipe;
+    template<class, class, class> friend class PipeSink;
     template<class T>
     using OnResult = typename IJob<T, Error>::OnResult;
     using OnError = typename IJob<Result, Error>::OnError;
-    void onResult(Result &&result)
+    // A request, or an error, waiting for the window
+    //
+    // Pending and Slot derive from Stopwatch, that is empty when
+    // instrumentation is disabled.
+    class Pending : public Stopwatch
+    {
+    public:
+        Stopwatch & stopwatch()
+        {
+            return *this;
+        }
+        std::unique_ptr<Request> request {};
+        std::unique_ptr<Error> error {};
+        CancellationToken token {};
+        std::uint64_t flow {0};
+    };
+    class TokenListener final : public CancellationToken::IListener
+    {
+    public:
+        explicit TokenListener(Pipe<Request, Result, Error> &pipe, std::size_t sequence)
+            : m_pipe {pipe}, m_sequence {sequence}
+        {
+        }
+        void onCancel(CancellationToken::State state) override
+        {
+            m_pipe.onTokenCancelled(m_sequence, state);
+        }
+        void onInvalidation() override
+        {
+        }
+    private:
+        Pipe<Request, Result, Error> &m_pipe;
+        std::size_t m_sequence {0};
+    };
+    // A request being processed
+    //
+    // The result or the error is stored when it cannot be
+    // released yet, because results are released sequentially.
+    class Slot : public Stopwatch
+    {
+    public:
+        bool done() const
+        {
+            return result || error;
+        }
+        Stopwatch & stopwatch()
+        {
+            return *this;
+        }
+        std::unique_ptr<IJob<Result, Error>> job {};
+        std::unique_ptr<Result> result {};
+        std::unique_ptr<Error> error {};
+        CancellationToken token {};
+        std::shared_ptr<TokenListener> listener {};
+        std::uint64_t flow {0};
+    };
+    // Jobs are destroyed once none of them is executing a callback
+    using FinishedJobs = DeferredRelease<std::vector<std::unique_ptr<IJob<Result, Error>>>>;
+    bool accepting() const
+    {
+        return m_queue.empty() && (!m_nextAccepting || m_nextAccepting());
+    }
+    void push(Request &&request, const CancellationToken &token, std::uint64_t flow = 0)
+    {
+        if (m_queue.empty() && m_slots.size() < m_window) {
+            start(std::move(request), token, 0, flow);
+            return;
+        }
+
+        Pending pending {};
+        pending.request.reset(new Request(std::move(request)));
+        pending.token = token;
+        if (InstrumentationEnabled && statistics() != nullptr) {
+            pending.stopwatch().start();
+        }
+        pending.flow = flow;
+        m_queue.push_back(std::move(pending));
+    }
+    void start(Request &&request, const CancellationToken &token, std::uint64_t queueTime = 0,
+               std::uint64_t flow = 0)
+    {
+        if (InstrumentationEnabled && statistics() != nullptr) {
+            statistics()->queueTime.record(queueTime);
+        }
+        typename FinishedJobs::Lock lock {m_finishedJobs};
+        std::size_t sequence {m_nextSequence++};
+        if (failCancelled(sequence, token, Cancellable())) {
+            return;
+        }
+
+        TraceScope scope {"IJob::execute", "job"};
+        bool newFlow {flow == 0};
+        if (newFlow) {
+            flow = Tracer::global().createFlow();
+        }
+        scope.flow(newFlow ? 's' : 't', flow);
+
+        std::unique_ptr<IJob<Result, Error>> job {m_factory.create(std::move(request))};
+        IJob<Result, Error> *jobPtr {job.get()};
+        Slot &slot (m_slots[sequence]);
+        slot.job = std::move(job);
+        if (InstrumentationEnabled && statistics() != nullptr) {
+            slot.stopwatch().start();
+        }
+        slot.flow = flow;
+        if (flow != 0) {
+            Tracer::global().asyncBegin("IJob", "job", flow);
+        }
+        slot.token = token;
+        listen(slot, sequence, Cancellable());
+
+        jobPtr->execute([this, sequence](Result &&result) {
+            onJobResult(sequence, std::move(result));
+        }, [this, sequence](Error &&error) {
+            onJobError(sequence, std::move(error));
+        });
+    }
+    void onJobResult(std::size_t sequence, Result &&result)
+    {
+        typename FinishedJobs::Lock lock {m_finishedJobs};
+        auto it = m_slots.find(sequence);
+        if (it == std::end(m_slots) || it->second.done()) {
+            return;
+        }
+
+        finish(it->second);
+        if (InstrumentationEnabled && statistics() != nullptr) {
+            statistics()->executeTime.record(it->second.stopwatch().elapsed());
+            statistics()->resultSize.record(ResultSize<Result>::size(result));
+            ++statistics()->results;
+        }
+        if (m_order == PipeOrder::Completion || it == std::begin(m_slots)) {
+            CancellationToken token {std::move(it->second.token)};
+            std::uint64_t flow {it->second.flow};
+            m_slots.erase(it);
+            release(std::move(result), token, flow);
+        } else {
+            it->second.result.reset(new Result(std::move(result)));
+        }
+        process();
+    }
+    void onJobError(std::size_t sequence, Error &&error)
+    {
+        typename FinishedJobs::Lock lock {m_finishedJobs};
+        auto it = m_slots.find(sequence);
+        if (it == std::end(m_slots) || it->second.done()) {
+            return;
+        }
+
+        finish(it->second);
+        if (InstrumentationEnabled && statistics() != nullptr) {
+            statistics()->executeTime.record(it->second.stopwatch().elapsed());
+            ++statistics()->errors;
+        }
+        fail(it, std::move(error));
+        process();
+    }
+    // Cancelled tokens are only checked if Error can report them,
+    // so that CancellationError is not instantiated otherwise
+    using Cancellable = IsCancellable<Error>;
+    bool failCancelled(std::size_t sequence, const CancellationToken &token, std::true_type)
+    {
+        if (!token.isCancelled()) {
+            return false;
+        }
+        fail(m_slots.emplace(sequence, Slot()).first, CancellationError<Error>::create(token.state()));
+        return true;
+    }
+    bool failCancelled(std::size_t, const CancellationToken &, std::false_type)
+    {
+        return false;
+    }
+    void listen(Slot &slot, std::size_t sequence, std::true_type)
+    {
+        if (slot.token.isValid()) {
+            slot.listener = std::make_shared<TokenListener>(*this, sequence);
+            slot.token.addListener(slot.listener);
+        }
+    }
+    void listen(Slot &, std::size_t, std::false_type)
+    {
+    }
+    void onTokenCancelled(std::size_t sequence, CancellationToken::State state)
+    {
+        typename FinishedJobs::Lock lock {m_finishedJobs};
+        auto it = m_slots.find(sequence);
+        if (it == std::end(m_slots) || it->second.done()) {
+            return;
+        }
+
+        it->second.job->cancel();
+        finish(it->second);
+        if (InstrumentationEnabled && statistics() != nullptr) {
+            ++statistics()->errors;
+        }
+        fail(it, CancellationError<Error>::create(state));
+        process();
+    }
+    void finish(Slot &slot)
+    {
+        if (slot.job) {
+            m_finishedJobs.release(std::move(slot.job));
+            if (slot.flow != 0) {
+                Tracer::global().asyncEnd("IJob", "job", slot.flow);
+            }
+        }
+        slot.listener.reset();
+    }
+    void fail(typename std::map<std::size_t, Slot>::iterator it, Error &&error)
+    {
+        if (m_order == PipeOrder::Completion || it == std::begin(m_slots)) {
+            m_slots.erase(it);
+            m_onError(std::move(error));
+        } else {
+            it->second.error.reset(new Error(std::move(error)));
+        }
+    }
+    void release(Result &&result, const CancellationToken &token, std::uint64_t flow)
+    {
+        if (m_nextPush) {
+            m_nextPush(std::move(result), token, flow);
+        } else {
+            TraceScope scope {"Pipe::release", "pipe"};
+            scope.flow('f', flow);
+            m_onResult(std::move(result));
+        }
+    }
+    // Release completed slots and start pending requests
+    //
+    // Callbacks might reenter this pipe, so the state is
+    // checked again after each step.
+    void process()
     {
-        m_onResult(std::move(result));
+        bool progress {true};
+        while (progress) {
+            progress = false;
+            if (!m_slots.empty() && std::begin(m_slots)->second.done()) {
+                Slot slot {std::move(std::begin(m_slots)->second)};
+                m_slots.erase(std::begin(m_slots));
+                if (slot.result) {
+                    release(std::move(*slot.result), slot.token, slot.flow);
+                } else {
+                    m_onError(std::move(*slot.error));
+                }
+                progress = true;
+            } else if (!m_queue.empty() && (m_queue.front().error || m_slots.size() < m_window)) {
+                Pending pending {std::move(m_queue.front())};
+                m_queue.pop_front();
+                if (pending.error) {
+                    m_slots[m_nextSequence++].error = std::move(pending.error);
+                } else {
+                    start(std::move(*pending.request), pending.token, pending.stopwatch().elapsed(), pending.flow);
+                }
+                progress = true;
+            }
+        }
     }
     const IJobFactory<Request, Result, Error> &m_factory;
-    std::unique_ptr<IJob<Result, Error>> m_job {};
     OnResult<Result> m_onResult {};
     OnError m_onError {};
+    std::size_t m_window {1};
+    PipeOrder m_order {PipeOrder::Sequential};
+    Callback<void (Result &&, const CancellationToken &, std::uint64_t)> m_nextPush {};
+    Callback<bool ()> m_nextAccepting {};
+    std::map<std::size_t, Slot> m_slots {};
+    std::deque<Pending> m_queue {};
+    FinishedJobs m_finishedJobs {};
+    std::size_t m_nextSequence {0};
 };
 
 }}
@@ -0,0 +1,514 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_CORE_STATICPIPELINE_H
+#define MICROCORE_CORE_STATICPIPELINE_H
+
+#include <microcore/core/globals.h>
+#include <microcore/core/callback.h>
+#include <microcore/core/cancellationtoken.h>
+#include <microcore/core/deferredrelease.h>
+#include <microcore/core/ijobfactory.h>
+#include <microcore/core/pipe.h>
+#include <list>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+
+namespace microcore { namespace core {
+
+/**
+ * @brief Types of an IJobFactory
+ *
+ * This class provides the Request, Result and Error types
+ * of a concrete IJobFactory, and the type of the jobs it creates.
+ *
+ * IJobFactory::create() can only return an IJob. A concrete
+ * factory can also provide a non virtual createJob(), with the same
+ * argument, that returns its concrete job type. create() then uses
+ * createJob(), and Job is this concrete type.
+ */
+template<class Factory>
+class FactoryTraits
+{
+private:
+    template<class Request, class Result, class Error>
+    static std::tuple<Request, Result, Error> types(const IJobFactory<Request, Result, Error> *);
+    using Types = decltype(types(std::declval<const Factory *>()));
+public:
+    using Request = typename std::tuple_element<0, Types>::type;
+    using Result = typename std::tuple_element<1, Types>::type;
+    using Error = typename std::tuple_element<2, Types>::type;
+private:
+    template<class F>
+    static auto create(const F &factory, Request &&request, int) -> decltype(factory.createJob(std::move(request)))
+    {
+        return factory.createJob(std::move(request));
+    }
+    template<class F>
+    static auto create(const F &factory, Request &&request, long) -> decltype(factory.create(std::move(request)))
+    {
+        return factory.create(std::move(request));
+    }
+public:
+    using Job = typename decltype(create(std::declval<const Factory &>(), std::declval<Request>(), 0))::element_type;
+    /**
+     * @brief Create a job
+     *
+     * @param factory factory creating the job.
+     * @param request request used to create the job.
+     * @return the created job, with its concrete type if available.
+     */
+    static std::unique_ptr<Job> create(const Factory &factory, Request &&request)
+    {
+        return create(factory, std::move(request), 0);
+    }
+};
+
+/**
+ * @brief If the factories can be chained
+ *
+ * Factories can be chained if the result of each factory is
+ * the request of the next one, and if they all use the same error.
+ */
+template<class... Factories>
+class IsChained : public std::true_type
+{
+};
+
+template<class First, class Second, class... Factories>
+class IsChained<First, Second, Factories...>
+    : public std::integral_constant<bool, std::is_same<typename FactoryTraits<First>::Result, typename FactoryTraits<Second>::Request>::value
+                                          && std::is_same<typename FactoryTraits<First>::Error, typename FactoryTraits<Second>::Error>::value
+                                          && IsChained<Second, Factories...>::value>
+{
+};
+
+/**
+ * @brief Sink of a StaticPipe that calls callbacks
+ */
+template<class Result, class Error>
+class CallbackSink
+{
+public:
+    explicit CallbackSink(typename IJob<Result, Error>::OnResult &&onResult,
+                          typename IJob<Result, Error>::OnError &&onError)
+        : m_onResult {std::move(onResult)}
+        , m_onError {std::move(onError)}
+    {
+    }
+    DISABLE_COPY_DEFAULT_MOVE(CallbackSink);
+    void onResult(Result &&result, const CancellationToken &)
+    {
+        m_onResult(std::move(result));
+    }
+    void onError(Error &&error)
+    {
+        m_onError(std::move(error));
+    }
+private:
+    typename IJob<Result, Error>::OnResult m_onResult {};
+    typename IJob<Result, Error>::OnError m_onError {};
+};
+
+/**
+ * @brief Sink of a StaticPipe that sends to a Pipe
+ *
+ * Results are sent to the Pipe like a prepended pipe would do: they
+ * are queued if the window of the Pipe is full, and the
+ * CancellationToken is passed along.
+ */
+template<class Result, class T, class Error>
+class PipeSink
+{
+public:
+    explicit PipeSink(Pipe<Result, T, Error> &pipe)
+        : m_pipe {&pipe}
+    {
+    }
+    DISABLE_COPY_DEFAULT_MOVE(PipeSink);
+    void onResult(Result &&result, const CancellationToken &token)
+    {
+        m_pipe->push(std::move(result), token);
+    }
+    void onError(Error &&error)
+    {
+        m_pipe->sendError(std::move(error));
+    }
+private:
+    Pipe<Result, T, Error> *m_pipe {nullptr};
+};
+
+/**
+ * @brief A statically composed pipeline
+ *
+ * This class executes a chain of IJobFactory whose types are known
+ * at compile time. It is created by a StaticPipeline.
+ *
+ * Unlike a pipeline made of Pipe, the stages of a StaticPipe are not
+ * connected through callbacks stored in each stage: the result of a
+ * stage is passed directly to the next stage, and the concrete
+ * factories are called without going through IJobFactory.
+ *
+ * Jobs are created with FactoryTraits::create(), and executed with
+ * their concrete type. If the factory only creates IJob, they are
+ * executed through the virtual IJob::execute(), with type-erased
+ * Callback. If it provides a createJob() returning a final job
+ * class, execute() is called without virtual dispatch, and if this
+ * job also provides an execute() template, the callbacks of the
+ * stages are passed to it without being type-erased.
+ *
+ * Each request sent is processed independently, and results
+ * are released as soon as they are available. Requests can be sent
+ * with a CancellationToken, with the same behaviour as Pipe.
+ *
+ * The Sink receives the results and errors. It is either a
+ * CallbackSink or a PipeSink.
+ */
+template<class Sink, class... Factories>
+class StaticPipe
+{
+private:
+    template<std::size_t I>
+    using Stage = FactoryTraits<typename std::tuple_element<I, std::tuple<Factories...>>::type>;
+public:
+    /**
+     * @brief Type of the requests of the pipeline
+     */
+    using Request = typename Stage<0>::Request;
+    /**
+     * @brief Type of the results of the pipeline
+     */
+    using Result = typename Stage<sizeof...(Factories) - 1>::Result;
+    /**
+     * @brief Type of the errors of the pipeline
+     */
+    using Error = typename Stage<0>::Error;
+    /**
+     * @brief Constructor
+     *
+     * Prefer using StaticPipeline to create a StaticPipe.
+     *
+     * @param factories factories used to create IJob for each stage.
+     * @param sink sink receiving results and errors.
+     */
+    explicit StaticPipe(const std::tuple<const Factories &...> &factories, Sink &&sink)
+        : m_factories {factories}
+        , m_sink {std::move(sink)}
+    {
+    }
+    DISABLE_COPY_DISABLE_MOVE(StaticPipe);
+    /**
+     * @brief Execute this pipeline
+     *
+     * Execute this pipeline using the provided request.
+     *
+     * @param request request used to execute the first stage.
+     * @param token token used to cancel the request.
+     */
+    void send(Request &&request, const CancellationToken &token = CancellationToken())
+    {
+        typename FinishedRuns::Lock lock {m_finishedRuns};
+        m_runs.emplace_back();
+        Run &run (m_runs.back());
+        run.it = std::prev(std::end(m_runs));
+        run.token = token;
+        listen(run, Cancellable());
+        if (!run.done) {
+            step<0>(run, std::move(request));
+        }
+    }
+    /**
+     * @brief Number of requests being processed
+     *
+     * @return the number of requests being processed.
+     */
+    std::size_t activeCount() const
+    {
+        return m_runs.size();
+    }
+private:
+    class Run;
+    class TokenListener final : public CancellationToken::IListener
+    {
+    public:
+        explicit TokenListener(StaticPipe<Sink, Factories...> &pipe, Run &run)
+            : m_pipe {pipe}, m_run {run}
+        {
+        }
+        void onCancel(CancellationToken::State state) override
+        {
+            m_pipe.onTokenCancelled(m_run, state);
+        }
+        void onInvalidation() override
+        {
+        }
+    private:
+        StaticPipe<Sink, Factories...> &m_pipe;
+        Run &m_run;
+    };
+    // A request being processed
+    //
+    // Each stage stores the job it created. Jobs are kept until
+    // the run is destroyed, since a job can complete while executing.
+    class Run
+    {
+    public:
+        std::tuple<std::unique_ptr<typename FactoryTraits<Factories>::Job>...> jobs {};
+        std::size_t stage {0};
+        bool done {false};
+        CancellationToken token {};
+        std::shared_ptr<TokenListener> listener {};
+        typename std::list<Run>::iterator it {};
+    };
+    // Runs are destroyed once none of their jobs is executing a callback
+    using FinishedRuns = DeferredRelease<std::list<Run>>;
+    template<std::size_t I>
+    void step(Run &run, typename Stage<I>::Request &&request)
+    {
+        if (failCancelled(run, Cancellable())) {
+            return;
+        }
+
+        using StageResult = typename Stage<I>::Result;
+        auto &job = std::get<I>(run.jobs);
+        job = Stage<I>::create(std::get<I>(m_factories), std::move(request));
+        run.stage = I;
+        job->execute([this, &run](StageResult &&result) {
+            onStageResult<I>(run, std::move(result));
+        }, [this, &run](Error &&error) {
+            onStageError<I>(run, std::move(error));
+        });
+    }
+    template<std::size_t I>
+    void onStageResult(Run &run, typename Stage<I>::Result &&result)
+    {
+        typename FinishedRuns::Lock lock {m_finishedRuns};
+        if (run.done || run.stage != I) {
+            return;
+        }
+        next<I>(run, std::move(result), std::integral_constant<bool, I + 1 == sizeof...(Factories)>());
+    }
+    template<std::size_t I>
+    void onStageError(Run &run, Error &&error)
+    {
+        typename FinishedRuns::Lock lock {m_finishedRuns};
+        if (run.done || run.stage != I) {
+            return;
+        }
+        fail(run, std::move(error));
+    }
+    template<std::size_t I, class T>
+    void next(Run &run, T &&result, std::false_type)
+    {
+        step<I + 1>(run, std::forward<T>(result));
+    }
+    template<std::size_t I, class T>
+    void next(Run &run, T &&result, std::true_type)
+    {
+        CancellationToken token {run.token};
+        retire(run);
+        m_sink.onResult(std::forward<T>(result), token);
+    }
+    // Cancelled tokens are only checked if Error can report them,
+    // see Pipe
+    using Cancellable = IsCancellable<Error>;
+    void listen(Run &run, std::true_type)
+    {
+        if (run.token.isValid()) {
+            run.listener = std::make_shared<TokenListener>(*this, run);
+            run.token.addListener(run.listener);
+        }
+    }
+    void listen(Run &, std::false_type)
+    {
+    }
+    bool failCancelled(Run &run, std::true_type)
+    {
+        if (!run.token.isCancelled()) {
+            return false;
+        }
+        fail(run, CancellationError<Error>::create(run.token.state()));
+        return true;
+    }
+    bool failCancelled(Run &, std::false_type)
+    {
+        return false;
+    }
+    void onTokenCancelled(Run &run, CancellationToken::State state)
+    {
+        typename FinishedRuns::Lock lock {m_finishedRuns};
+        if (run.done) {
+            return;
+        }
+        cancelStage(run, std::integral_constant<std::size_t, 0>());
+        fail(run, CancellationError<Error>::create(state));
+    }
+    template<std::size_t I>
+    void cancelStage(Run &run, std::integral_constant<std::size_t, I>)
+    {
+        if (run.stage == I) {
+            if (std::get<I>(run.jobs)) {
+                std::get<I>(run.jobs)->cancel();
+            }
+            return;
+        }
+        cancelStage(run, std::integral_constant<std::size_t, I + 1>());
+    }
+    void cancelStage(Run &, std::integral_constant<std::size_t, sizeof...(Factories)>)
+    {
+    }
+    void fail(Run &run, Error &&error)
+    {
+        retire(run);
+        m_sink.onError(std::move(error));
+    }
+    void retire(Run &run)
+    {
+        run.done = true;
+        run.listener.reset();
+        std::list<Run> &released (m_finishedRuns.released());
+        released.splice(std::end(released), m_runs, run.it);
+    }
+    std::tuple<const Factories &...> m_factories;
+    Sink m_sink;
+    std::list<Run> m_runs {};
+    FinishedRuns m_finishedRuns {};
+};
+
+/**
+ * @brief A description of a statically composed pipeline
+ *
+ * This class describes a chain of IJobFactory, where the result
+ * of each factory is the request of the next one. It is created with
+ * makePipeline(), and extended with operator|:
+ *
+ * @code
+ * auto pipe = (makePipeline(httpFactory) | jsonFactory | beanFactory).create(onResult, onError);
+ * pipe->send(std::move(request));
+ * @endcode
+ *
+ * The factories are referenced, not copied, and should outlive the
+ * StaticPipe created from this description.
+ *
+ * The factories are used via their concrete types, so declaring
+ * them final allows the compiler to call create() without virtual
+ * dispatch. The jobs they create are also called with their concrete
+ * type if the factories provide createJob(), see StaticPipe. A StaticPipe can also send its results to an existing
+ * Pipe, to continue the processing in a dynamically built pipeline.
+ */
+template<class... Factories>
+class StaticPipeline
+{
+public:
+    using Request = typename FactoryTraits<typename std::tuple_element<0, std::tuple<Factories...>>::type>::Request;
+    using Result = typename FactoryTraits<typename std::tuple_element<sizeof...(Factories) - 1, std::tuple<Factories...>>::type>::Result;
+    using Error = typename FactoryTraits<typename std::tuple_element<0, std::tuple<Factories...>>::type>::Error;
+    explicit StaticPipeline(const std::tuple<const Factories &...> &factories)
+        : m_factories {factories}
+    {
+        static_assert(IsChained<Factories...>::value,
+                      "The result of each factory must be the request of the next one, with the same error type");
+    }
+    /**
+     * @brief Append a factory
+     *
+     * @param factory factory used to create IJob for the appended stage.
+     * @return a pipeline ending with the appended stage.
+     */
+    template<class Factory>
+    StaticPipeline<Factories..., Factory> append(const Factory &factory) const
+    {
+        return StaticPipeline<Factories..., Factory>(std::tuple_cat(m_factories, std::tuple<const Factory &>(factory)));
+    }
+    /**
+     * @brief Create a pipeline that calls callbacks
+     *
+     * @param onResult callback used to indicate if the pipeline is successful.
+     * @param onError callback used to indicate if the pipeline has failed.
+     * @return the created pipeline.
+     */
+    std::unique_ptr<StaticPipe<CallbackSink<Result, Error>, Factories...>> create(typename IJob<Result, Error>::OnResult &&onResult,
+                                                                                  typename IJob<Result, Error>::OnError &&onError) const
+    {
+        using Type = StaticPipe<CallbackSink<Result, Error>, Factories...>;
+        return std::unique_ptr<Type>(new Type(m_factories, CallbackSink<Result, Error>(std::move(onResult), std::move(onError))));
+    }
+    /**
+     * @brief Create a pipeline that sends to a Pipe
+     *
+     * @param pipe pipe receiving the results and errors.
+     * @return the created pipeline.
+     */
+    template<class T>
+    std::unique_ptr<StaticPipe<PipeSink<Result, T, Error>, Factories...>> create(Pipe<Result, T, Error> &pipe) const
+    {
+        using Type = StaticPipe<PipeSink<Result, T, Error>, Factories...>;
+        return std::unique_ptr<Type>(new Type(m_factories, PipeSink<Result, T, Error>(pipe)));
+    }
+private:
+    std::tuple<const Factories &...> m_factories;
+};
+
+/**
+ * @brief Start describing a statically composed pipeline
+ *
+ * @param factories factories of the pipeline, in execution order.
+ * @return a StaticPipeline.
+ */
+template<class Factory, class... Factories>
+StaticPipeline<Factory, Factories...> makePipeline(const Factory &factory, const Factories &...factories)
+{
+    return StaticPipeline<Factory, Factories...>(std::tuple<const Factory &, const Factories &...>(factory, factories...));
+}
+
+/**
+ * @brief Append a factory to a StaticPipeline
+ */
+template<class... Factories, class Factory>
+StaticPipeline<Factories..., Factory> operator|(const StaticPipeline<Factories...> &pipeline, const Factory &factory)
+{
+    return pipeline.append(factory);
+}
+
+/**
+ * @brief Create a StaticPipe sending to a Pipe
+ */
+template<class... Factories, class Result, class T, class Error>
+std::unique_ptr<StaticPipe<PipeSink<Result, T, Error>, Factories...>> operator|(const StaticPipeline<Factories...> &pipeline,
+                                                                                Pipe<Result, T, Error> &pipe)
+{
+    return pipeline.create(pipe);
+}
+
+}}
+
+#endif // MICROCORE_CORE_STATICPIPELINE_H
@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_CORE_THREADEDJOBFACTORY_H
+#define MICROCORE_CORE_THREADEDJOBFACTORY_H
+
+#include <microcore/core/globals.h>
+#include <microcore/core/ijobfactory.h>
+#include <microcore/qt/qobjectptr.h>
+#include <memory>
+#include <mutex>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+
+namespace microcore { namespace core {
+
+/**
+ * @brief An IJobFactory that executes IJob in a thread pool
+ *
+ * This class decorates an IJobFactory. IJob created by this
+ * factory are executed in a QThreadPool, and the callbacks are
+ * invoked in the thread that called IJob::execute(), via the
+ * event loop of this thread.
+ *
+ * The thread pool is used to bound the number of IJob executed
+ * concurrently. IJob that cannot be executed immediately are
+ * queued by the thread pool.
+ *
+ * The decorated IJob is executed in a thread that do not have
+ * an event loop. It should perform it's task synchronously, and
+ * should not rely on objects that have thread affinity. This makes
+ * this factory suitable for CPU bound tasks, like parsing.
+ *
+ * If the IJob created by this factory is destroyed or cancelled
+ * before the decorated IJob finished it's execution, the result is
+ * discarded and callbacks are not invoked. If the decorated IJob
+ * was not started yet, it is not executed at all.
+ *
+ * ThreadedJobFactory do not handle the lifecycle of the decorated
+ * IJobFactory nor the lifecycle of the thread pool.
+ */
+template<class Request, class Result, class Error>
+class ThreadedJobFactory final : public IJobFactory<Request, Result, Error>
+{
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param factory factory to decorate.
+     * @param threadPool thread pool used to execute IJob.
+     */
+    explicit ThreadedJobFactory(const IJobFactory<Request, Result, Error> &factory, QThreadPool &threadPool)
+        : m_factory {factory}
+        , m_threadPool {threadPool}
+    {
+    }
+    DISABLE_COPY_DISABLE_MOVE(ThreadedJobFactory);
+    std::unique_ptr<IJob<Result, Error>> create(Request &&request) const override
+    {
+        return std::unique_ptr<IJob<Result, Error>>(new Job(m_threadPool, m_factory.create(std::move(request))));
+    }
+private:
+    class Job;
+    // Event used to invoke a callback in the thread that executed the job
+    class CallbackEvent : public QEvent
+    {
+    public:
+        static QEvent::Type eventType()
+        {
+            static const QEvent::Type type {static_cast<QEvent::Type>(QEvent::registerEventType())};
+            return type;
+        }
+        explicit CallbackEvent()
+            : QEvent(eventType())
+        {
+        }
+        virtual void invoke(Job &job) = 0;
+    };
+    class ResultEvent final : public CallbackEvent
+    {
+    public:
+        explicit ResultEvent(Result &&result)
+            : m_result {std::move(result)}
+        {
+        }
+        void invoke(Job &job) override
+        {
+            job.m_onResult(std::move(m_result));
+        }
+    private:
+        Result m_result;
+    };
+    class ErrorEvent final : public CallbackEvent
+    {
+    public:
+        explicit ErrorEvent(Error &&error)
+            : m_error {std::move(error)}
+        {
+        }
+        void invoke(Job &job) override
+        {
+            job.m_onError(std::move(m_error));
+        }
+    private:
+        Error m_error;
+    };
+    // Receiver for CallbackEvent, living in the thread that executed the job
+    //
+    // The receiver is deleted with deleteLater, as the job might be
+    // destroyed from a callback. It is detached from the job before,
+    // so that the remaining events are discarded.
+    class Receiver final : public QObject
+    {
+    public:
+        explicit Receiver(Job &job)
+            : m_job {&job}
+        {
+        }
+        void detach()
+        {
+            m_job = nullptr;
+        }
+    protected:
+        bool event(QEvent *e) override
+        {
+            if (e->type() == CallbackEvent::eventType()) {
+                if (m_job != nullptr) {
+                    static_cast<CallbackEvent *>(e)->invoke(*m_job);
+                }
+                return true;
+            }
+            return QObject::event(e);
+        }
+    private:
+        Job *m_job {nullptr};
+    };
+    // State shared between the job and the worker thread
+    //
+    // The receiver is detached when the job is destroyed, so that
+    // the worker thread stops posting events to it.
+    class State
+    {
+    public:
+        explicit State(std::unique_ptr<IJob<Result, Error>> &&job)
+            : m_job {std::move(job)}
+        {
+        }
+        void post(CallbackEvent *event)
+        {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            if (m_receiver == nullptr) {
+                delete event;
+                return;
+            }
+            QCoreApplication::postEvent(m_receiver, event);
+        }
+        void attach(Receiver *receiver)
+        {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            m_receiver = receiver;
+        }
+        bool attached()
+        {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            return m_receiver != nullptr;
+        }
+        std::unique_ptr<IJob<Result, Error>> m_job {};
+    private:
+        std::mutex m_mutex {};
+        Receiver *m_receiver {nullptr};
+    };
+    class Runnable final : public QRunnable
+    {
+    public:
+        explicit Runnable(const std::shared_ptr<State> &state)
+            : m_state {state}
+        {
+        }
+        void run() override
+        {
+            std::shared_ptr<State> state {m_state};
+            if (!state->attached()) {
+                return;
+            }
+            std::unique_ptr<IJob<Result, Error>> job {std::move(state->m_job)};
+            job->execute([state](Result &&result) {
+                state->post(new ResultEvent(std::move(result)));
+            }, [state](Error &&error) {
+                state->post(new ErrorEvent(std::move(error)));
+            });
+        }
+    private:
+        std::shared_ptr<State> m_state {};
+    };
+    class Job final : public IJob<Result, Error>
+    {
+    public:
+        explicit Job(QThreadPool &threadPool, std::unique_ptr<IJob<Result, Error>> &&job)
+            : m_threadPool {threadPool}
+            , m_state {std::make_shared<State>(std::move(job))}
+        {
+        }
+        DISABLE_COPY_DISABLE_MOVE(Job);
+        ~Job()
+        {
+            cancel();
+        }
+        void execute(typename IJob<Result, Error>::OnResult &&onResult,
+                     typename IJob<Result, Error>::OnError &&onError) override
+        {
+            Q_ASSERT(m_state->m_job);
+            m_onResult = std::move(onResult);
+            m_onError = std::move(onError);
+            m_receiver.reset(new Receiver(*this));
+            m_state->attach(m_receiver.get());
+            m_threadPool.start(new Runnable(m_state));
+        }
+        void cancel() override
+        {
+            m_state->attach(nullptr);
+            if (m_receiver) {
+                m_receiver->detach();
+            }
+        }
+    private:
+        friend class ResultEvent;
+        friend class ErrorEvent;
+        QThreadPool &m_threadPool;
+        std::shared_ptr<State> m_state {};
+        ::microcore::qt::QObjectPtr<Receiver> m_receiver {};
+        typename IJob<Result, Error>::OnResult m_onResult {};
+        typename IJob<Result, Error>::OnError m_onError {};
+    };
+    const IJobFactory<Request, Result, Error> &m_factory;
+    QThreadPool &m_threadPool;
+};
+
+}}
+
+#endif // MICROCORE_CORE_THREADEDJOBFACTORY_H
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_CORE_TRACING_H
+#define MICROCORE_CORE_TRACING_H
+
+#include <microcore/core/globals.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace microcore { namespace core {
+
+/**
+ * @brief A recorder of trace events
+ *
+ * This class records events in memory, and exports them in the
+ * Chrome trace-event JSON format, that can be loaded in
+ * chrome://tracing or in Perfetto.
+ *
+ * Pipe, IJob execution and Executor are traced using the global
+ * tracer. ListenerRepository notifications are only traced if
+ * ListenerTracingEnabled is set, as they are frequent and short.
+ * Each request sent to a Pipe
+ * gets a flow id, that links the stages of the pipeline processing
+ * the request. The execution of each IJob is also traced as an
+ * asynchronous slice, from IJob::execute() to the result.
+ *
+ * Recording is disabled by default. When it is disabled, tracing
+ * costs a relaxed atomic load per traced call.
+ *
+ * Events are kept in a ring buffer: once capacity() events are
+ * recorded, each new event replaces the oldest one, and is counted
+ * by droppedCount().
+ *
+ * Event names and categories are not copied, and should be string
+ * literals. Recording is thread safe.
+ */
+class Tracer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    explicit Tracer();
+    DISABLE_COPY_DISABLE_MOVE(Tracer);
+    /**
+     * @brief Global tracer
+     *
+     * @return the tracer used by the library.
+     */
+    static Tracer & global();
+    bool isEnabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+    /**
+     * @brief Start recording
+     */
+    void start();
+    /**
+     * @brief Stop recording
+     *
+     * Recorded events are kept until clear() is called.
+     */
+    void stop();
+    void clear();
+    std::size_t eventCount() const;
+    /**
+     * @brief Maximum number of recorded events
+     *
+     * @return the capacity of the ring buffer, or 0 if it is unbounded.
+     */
+    std::size_t capacity() const;
+    /**
+     * @brief Set the maximum number of recorded events
+     *
+     * If more events are recorded, only the most recent ones are kept.
+     *
+     * @param capacity capacity of the ring buffer, or 0 to keep all events.
+     */
+    void setCapacity(std::size_t capacity);
+    /**
+     * @brief Number of events replaced by newer events
+     *
+     * @return the number of dropped events since the last clear().
+     */
+    std::size_t droppedCount() const;
+    /**
+     * @brief Create a flow id
+     *
+     * @return a new flow id, or 0 if recording is disabled.
+     */
+    std::uint64_t createFlow();
+    /**
+     * @brief Record a complete event
+     *
+     * @param name name of the event.
+     * @param category category of the event.
+     * @param start start of the event.
+     */
+    void complete(const char *name, const char *category, Clock::time_point start);
+    /**
+     * @brief Record a flow event
+     *
+     * The event is bound to the enclosing slice.
+     *
+     * @param phase 's' to start a flow, 't' for a step and 'f' to finish it.
+     * @param category category of the event.
+     * @param flow flow id.
+     */
+    void flow(char phase, const char *category, std::uint64_t flow);
+    /**
+     * @brief Record the beginning of an asynchronous slice
+     */
+    void asyncBegin(const char *name, const char *category, std::uint64_t id);
+    /**
+     * @brief Record the end of an asynchronous slice
+     */
+    void asyncEnd(const char *name, const char *category, std::uint64_t id);
+    /**
+     * @brief Export the recorded events
+     *
+     * @return the recorded events, in Chrome trace-event JSON format.
+     */
+    std::string toJson() const;
+    /**
+     * @brief Export the recorded events to a file
+     *
+     * @param path path of the file.
+     * @return if the file was written.
+     */
+    bool save(const std::string &path) const;
+private:
+    class Event
+    {
+    public:
+        char phase {'X'};
+        const char *name {nullptr};
+        const char *category {nullptr};
+        std::uint64_t timestamp {0};
+        std::uint64_t duration {0};
+        std::uint64_t id {0};
+        std::uint32_t thread {0};
+    };
+    std::uint64_t timestamp(Clock::time_point time) const;
+    void record(Event &&event);
+    void linearize();
+    std::atomic<bool> m_enabled {false};
+    std::atomic<std::uint64_t> m_nextFlow {1};
+    Clock::time_point m_origin {Clock::now()};
+    mutable std::mutex m_mutex {};
+    // Once full, m_next is the oldest event, that is replaced next
+    std::vector<Event> m_events {};
+    std::size_t m_next {0};
+    std::size_t m_capacity {1 << 20};
+    std::size_t m_dropped {0};
+};
+
+/**
+ * @brief Trace a scope
+ *
+ * This class records a complete event, from its construction to
+ * its destruction, using the global Tracer. Nothing is recorded if
+ * the tracer was disabled at construction.
+ */
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name, const char *category)
+        : m_name {name}
+        , m_category {category}
+        , m_enabled {Tracer::global().isEnabled()}
+    {
+        if (m_enabled) {
+            m_start = Tracer::Clock::now();
+        }
+    }
+    DISABLE_COPY_DISABLE_MOVE(TraceScope);
+    ~TraceScope()
+    {
+        if (m_enabled) {
+            Tracer::global().complete(m_name, m_category, m_start);
+        }
+    }
+    /**
+     * @brief Bind a flow event to this scope
+     *
+     * @param phase 's' to start a flow, 't' for a step and 'f' to finish it.
+     * @param flow flow id, nothing is recorded if it is 0.
+     */
+    void flow(char phase, std::uint64_t flow)
+    {
+        if (m_enabled && flow != 0) {
+            Tracer::global().flow(phase, m_category, flow);
+        }
+    }
+private:
+    const char *m_name {nullptr};
+    const char *m_category {nullptr};
+    bool m_enabled {false};
+    Tracer::Clock::time_point m_start {};
+};
+
+/**
+ * @brief A TraceScope that records nothing
+ */
+class NullTraceScope
+{
+public:
+    explicit NullTraceScope(const char *, const char *)
+    {
+    }
+    DISABLE_COPY_DISABLE_MOVE(NullTraceScope);
+    void flow(char, std::uint64_t)
+    {
+    }
+};
+
+/**
+ * @brief If listener notifications are traced
+ *
+ * Tracing ListenerRepository notifications is enabled by defining
+ * MICROCORE_TRACE_LISTENERS, see the ENABLE_LISTENER_TRACING CMake
+ * option. When it is disabled, ListenerTraceScope is a NullTraceScope,
+ * and notify() does not check the tracer.
+ */
+#ifdef MICROCORE_TRACE_LISTENERS
+static constexpr bool ListenerTracingEnabled {true};
+#else
+static constexpr bool ListenerTracingEnabled {false};
+#endif
+
+using ListenerTraceScope = std::conditional<ListenerTracingEnabled, TraceScope, NullTraceScope>::type;
+
+}}
+
+#endif // MICROCORE_CORE_TRACING_H
@@ -0,0 +1,703 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_DATA_BTREESEQUENCE_H
+#define MICROCORE_DATA_BTREESEQUENCE_H
+
+#include <microcore/core/globals.h>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace microcore { namespace data {
+
+// A sequence container stored in a B+ tree
+//
+// Values are stored in chunks of up to LeafCapacity values, the leaves
+// of a B+ tree whose branches store the number of values of each of
+// their children. Accessing, inserting or removing a value at an index
+// is O(log n), instead of the O(n) shifting of a vector or a deque.
+//
+// Iterators are random access. Incrementing an iterator is O(1), while
+// jumping to an arbitrary position is O(log n). As with std::deque,
+// inserting or removing values invalidates the iterators.
+//
+// T should be default constructible, as chunks are arrays.
+template<class T, std::size_t LeafCapacity = 64, std::size_t BranchCapacity = 16>
+class BTreeSequence
+{
+    static_assert(LeafCapacity >= 4, "LeafCapacity should be at least 4");
+    static_assert(BranchCapacity >= 4, "BranchCapacity should be at least 4");
+    class Leaf;
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    template<class Value>
+    class Iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = typename std::remove_const<Value>::type;
+        using difference_type = std::ptrdiff_t;
+        using reference = Value &;
+        using pointer = Value *;
+        explicit Iterator() = default;
+        // iterator converts to const_iterator
+        template<class Other, class = typename std::enable_if<std::is_convertible<Other *, Value *>::value>::type>
+        Iterator(const Iterator<Other> &other)
+            : m_sequence {other.m_sequence}
+            , m_leaf {other.m_leaf}
+            , m_offset {other.m_offset}
+            , m_position {other.m_position}
+        {
+        }
+        reference operator*() const
+        {
+            return m_leaf->values[m_offset];
+        }
+        pointer operator->() const
+        {
+            return &m_leaf->values[m_offset];
+        }
+        reference operator[](difference_type offset) const
+        {
+            return *(*this + offset);
+        }
+        Iterator & operator++()
+        {
+            ++m_position;
+            ++m_offset;
+            if (m_offset == m_leaf->count && m_leaf->next != nullptr) {
+                m_leaf = m_leaf->next;
+                m_offset = 0;
+            }
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator result {*this};
+            ++(*this);
+            return result;
+        }
+        Iterator & operator--()
+        {
+            --m_position;
+            if (m_offset == 0) {
+                m_leaf = m_leaf->previous;
+                m_offset = m_leaf->count;
+            }
+            --m_offset;
+            return *this;
+        }
+        Iterator operator--(int)
+        {
+            Iterator result {*this};
+            --(*this);
+            return result;
+        }
+        Iterator & operator+=(difference_type offset)
+        {
+            size_type position = m_position + offset;
+            size_type leafOffset = m_offset + offset;
+            // Stay in the same leaf, or seek from the root
+            if (m_leaf != nullptr && leafOffset < m_leaf->count) {
+                m_offset = leafOffset;
+                m_position = position;
+            } else {
+                *this = Iterator(m_sequence, position);
+            }
+            return *this;
+        }
+        Iterator & operator-=(difference_type offset)
+        {
+            return *this += -offset;
+        }
+        Iterator operator+(difference_type offset) const
+        {
+            Iterator result {*this};
+            result += offset;
+            return result;
+        }
+        friend Iterator operator+(difference_type offset, const Iterator &iterator)
+        {
+            return iterator + offset;
+        }
+        Iterator operator-(difference_type offset) const
+        {
+            Iterator result {*this};
+            result -= offset;
+            return result;
+        }
+        template<class Other>
+        difference_type operator-(const Iterator<Other> &other) const
+        {
+            return static_cast<difference_type>(m_position) - static_cast<difference_type>(other.m_position);
+        }
+        template<class Other>
+        bool operator==(const Iterator<Other> &other) const
+        {
+            return m_position == other.m_position;
+        }
+        template<class Other>
+        bool operator!=(const Iterator<Other> &other) const
+        {
+            return m_position != other.m_position;
+        }
+        template<class Other>
+        bool operator<(const Iterator<Other> &other) const
+        {
+            return m_position < other.m_position;
+        }
+        template<class Other>
+        bool operator>(const Iterator<Other> &other) const
+        {
+            return m_position > other.m_position;
+        }
+        template<class Other>
+        bool operator<=(const Iterator<Other> &other) const
+        {
+            return m_position <= other.m_position;
+        }
+        template<class Other>
+        bool operator>=(const Iterator<Other> &other) const
+        {
+            return m_position >= other.m_position;
+        }
+    private:
+        friend class BTreeSequence<T, LeafCapacity, BranchCapacity>;
+        template<class Other>
+        friend class Iterator;
+        explicit Iterator(const BTreeSequence<T, LeafCapacity, BranchCapacity> *sequence, size_type position)
+            : m_sequence {sequence}
+            , m_position {position}
+        {
+            std::pair<Leaf *, size_type> location {sequence->locate(position)};
+            m_leaf = location.first;
+            m_offset = location.second;
+        }
+        const BTreeSequence<T, LeafCapacity, BranchCapacity> *m_sequence {nullptr};
+        Leaf *m_leaf {nullptr};
+        size_type m_offset {0};
+        size_type m_position {0};
+    };
+    using iterator = Iterator<T>;
+    using const_iterator = Iterator<const T>;
+    explicit BTreeSequence() = default;
+    BTreeSequence(const BTreeSequence &) = delete;
+    BTreeSequence & operator=(const BTreeSequence &) = delete;
+    BTreeSequence(BTreeSequence &&other) noexcept
+    {
+        swap(other);
+    }
+    BTreeSequence & operator=(BTreeSequence &&other) noexcept
+    {
+        BTreeSequence moved {std::move(other)};
+        swap(moved);
+        return *this;
+    }
+    ~BTreeSequence()
+    {
+        clear();
+    }
+    iterator begin() noexcept
+    {
+        return makeIterator<T>(m_first, 0, 0);
+    }
+    iterator end() noexcept
+    {
+        return makeIterator<T>(m_last, m_last != nullptr ? m_last->count : 0, m_size);
+    }
+    const_iterator begin() const noexcept
+    {
+        return makeIterator<const T>(m_first, 0, 0);
+    }
+    const_iterator end() const noexcept
+    {
+        return makeIterator<const T>(m_last, m_last != nullptr ? m_last->count : 0, m_size);
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+    bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+    size_type size() const noexcept
+    {
+        return m_size;
+    }
+    reference operator[](size_type index)
+    {
+        std::pair<Leaf *, size_type> location {locate(index)};
+        return location.first->values[location.second];
+    }
+    const_reference operator[](size_type index) const
+    {
+        std::pair<Leaf *, size_type> location {locate(index)};
+        return location.first->values[location.second];
+    }
+    reference front()
+    {
+        return m_first->values[0];
+    }
+    const_reference front() const
+    {
+        return m_first->values[0];
+    }
+    reference back()
+    {
+        return m_last->values[m_last->count - 1];
+    }
+    const_reference back() const
+    {
+        return m_last->values[m_last->count - 1];
+    }
+    iterator insert(const_iterator position, const T &value)
+    {
+        T copy (value);
+        insertAt(position.m_position, std::move(copy));
+        return iterator(this, position.m_position);
+    }
+    iterator insert(const_iterator position, T &&value)
+    {
+        insertAt(position.m_position, std::move(value));
+        return iterator(this, position.m_position);
+    }
+    template<class InputIterator>
+    iterator insert(const_iterator position, InputIterator first, InputIterator last)
+    {
+        size_type index {position.m_position};
+        for (; first != last; ++first) {
+            T value (*first);
+            insertAt(index, std::move(value));
+            ++index;
+        }
+        return iterator(this, position.m_position);
+    }
+    iterator erase(const_iterator position)
+    {
+        eraseAt(position.m_position);
+        return iterator(this, position.m_position);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        for (size_type i = first.m_position; i < last.m_position; ++i) {
+            eraseAt(first.m_position);
+        }
+        return iterator(this, first.m_position);
+    }
+    void push_back(const T &value)
+    {
+        T copy (value);
+        insertAt(m_size, std::move(copy));
+    }
+    void push_back(T &&value)
+    {
+        insertAt(m_size, std::move(value));
+    }
+    void push_front(const T &value)
+    {
+        T copy (value);
+        insertAt(0, std::move(copy));
+    }
+    void push_front(T &&value)
+    {
+        insertAt(0, std::move(value));
+    }
+    void pop_back()
+    {
+        eraseAt(m_size - 1);
+    }
+    void pop_front()
+    {
+        eraseAt(0);
+    }
+    void clear() noexcept
+    {
+        destroy(m_root);
+        m_root = nullptr;
+        m_first = nullptr;
+        m_last = nullptr;
+        m_size = 0;
+    }
+    void swap(BTreeSequence &other) noexcept
+    {
+        std::swap(m_root, other.m_root);
+        std::swap(m_first, other.m_first);
+        std::swap(m_last, other.m_last);
+        std::swap(m_size, other.m_size);
+    }
+private:
+    class Branch;
+    class Node
+    {
+    public:
+        explicit Node(bool isLeaf)
+            : leaf {isLeaf}
+        {
+        }
+        Branch *parent {nullptr};
+        size_type count {0};
+        bool leaf {false};
+    };
+    class Leaf: public Node
+    {
+    public:
+        explicit Leaf()
+            : Node(true)
+        {
+        }
+        T values[LeafCapacity] {};
+        Leaf *previous {nullptr};
+        Leaf *next {nullptr};
+    };
+    // sizes[i] is the number of values in children[i]
+    class Branch: public Node
+    {
+    public:
+        explicit Branch()
+            : Node(false)
+        {
+        }
+        Node *children[BranchCapacity] {};
+        size_type sizes[BranchCapacity] {};
+    };
+    template<class Value>
+    Iterator<Value> makeIterator(Leaf *leaf, size_type offset, size_type position) const noexcept
+    {
+        Iterator<Value> result {};
+        result.m_sequence = this;
+        result.m_leaf = leaf;
+        result.m_offset = offset;
+        result.m_position = position;
+        return result;
+    }
+    // Leaf and offset of a position, the end being past the last leaf
+    std::pair<Leaf *, size_type> locate(size_type position) const
+    {
+        if (position >= m_size) {
+            return std::make_pair(m_last, m_last != nullptr ? m_last->count : 0);
+        }
+        const Node *node {m_root};
+        while (!node->leaf) {
+            const Branch *branch {static_cast<const Branch *>(node)};
+            size_type i {0};
+            while (position >= branch->sizes[i]) {
+                position -= branch->sizes[i];
+                ++i;
+            }
+            node = branch->children[i];
+        }
+        return std::make_pair(static_cast<Leaf *>(const_cast<Node *>(node)), position);
+    }
+    void insertAt(size_type position, T &&value)
+    {
+        if (m_root == nullptr) {
+            Leaf *leaf {new Leaf()};
+            m_root = leaf;
+            m_first = leaf;
+            m_last = leaf;
+        }
+
+        // Values inserted at the end of a child go to that child, so
+        // that appending fills the last leaf
+        Node *node {m_root};
+        while (!node->leaf) {
+            Branch *branch {static_cast<Branch *>(node)};
+            size_type i {0};
+            while (i + 1 < branch->count && position > branch->sizes[i]) {
+                position -= branch->sizes[i];
+                ++i;
+            }
+            node = branch->children[i];
+        }
+
+        Leaf *leaf {static_cast<Leaf *>(node)};
+        if (leaf->count == LeafCapacity) {
+            Leaf *right {splitLeaf(leaf)};
+            if (position > leaf->count) {
+                position -= leaf->count;
+                leaf = right;
+            }
+        }
+        for (size_type i = leaf->count; i > position; --i) {
+            leaf->values[i] = std::move(leaf->values[i - 1]);
+        }
+        leaf->values[position] = std::move(value);
+        ++leaf->count;
+        ++m_size;
+        resize(leaf, 1);
+    }
+    void eraseAt(size_type position)
+    {
+        std::pair<Leaf *, size_type> location {locate(position)};
+        Leaf *leaf {location.first};
+        for (size_type i = location.second + 1; i < leaf->count; ++i) {
+            leaf->values[i - 1] = std::move(leaf->values[i]);
+        }
+        --leaf->count;
+        leaf->values[leaf->count] = T();
+        --m_size;
+        resize(leaf, -1);
+        rebalance(leaf);
+    }
+    // Update the sizes stored in the ancestors of a node
+    static void resize(Node *node, difference_type difference)
+    {
+        while (node->parent != nullptr) {
+            Branch *parent {node->parent};
+            parent->sizes[childIndex(parent, node)] += difference;
+            node = parent;
+        }
+    }
+    static size_type childIndex(const Branch *branch, const Node *child)
+    {
+        size_type i {0};
+        while (branch->children[i] != child) {
+            ++i;
+        }
+        return i;
+    }
+    static size_type valueCount(const Node *node)
+    {
+        if (node->leaf) {
+            return node->count;
+        }
+        const Branch *branch {static_cast<const Branch *>(node)};
+        size_type result {0};
+        for (size_type i = 0; i < branch->count; ++i) {
+            result += branch->sizes[i];
+        }
+        return result;
+    }
+    static size_type capacity(const Node *node)
+    {
+        return node->leaf ? LeafCapacity : BranchCapacity;
+    }
+    static void moveEntry(Leaf *source, size_type from, Leaf *target, size_type to)
+    {
+        target->values[to] = std::move(source->values[from]);
+    }
+    static void moveEntry(Branch *source, size_type from, Branch *target, size_type to)
+    {
+        target->children[to] = source->children[from];
+        target->sizes[to] = source->sizes[from];
+        target->children[to]->parent = target;
+    }
+    static void clearEntry(Leaf *leaf, size_type index)
+    {
+        leaf->values[index] = T();
+    }
+    static void clearEntry(Branch *branch, size_type index)
+    {
+        branch->children[index] = nullptr;
+        branch->sizes[index] = 0;
+    }
+    // Move the entries [first, last) of source to position in target
+    template<class N>
+    static void transfer(N *source, size_type first, size_type last, N *target, size_type position)
+    {
+        size_type count {last - first};
+        for (size_type i = target->count; i > position; --i) {
+            moveEntry(target, i - 1, target, i - 1 + count);
+        }
+        for (size_type i = 0; i < count; ++i) {
+            moveEntry(source, first + i, target, position + i);
+        }
+        for (size_type i = last; i < source->count; ++i) {
+            moveEntry(source, i, source, i - count);
+        }
+        for (size_type i = source->count - count; i < source->count; ++i) {
+            clearEntry(source, i);
+        }
+        source->count -= count;
+        target->count += count;
+    }
+    Leaf * splitLeaf(Leaf *leaf)
+    {
+        Leaf *right {new Leaf()};
+        transfer(leaf, leaf->count / 2, leaf->count, right, 0);
+        right->previous = leaf;
+        right->next = leaf->next;
+        if (leaf->next != nullptr) {
+            leaf->next->previous = right;
+        } else {
+            m_last = right;
+        }
+        leaf->next = right;
+        insertChild(leaf, right);
+        return right;
+    }
+    Branch * splitBranch(Branch *branch)
+    {
+        Branch *right {new Branch()};
+        transfer(branch, branch->count / 2, branch->count, right, 0);
+        insertChild(branch, right);
+        return right;
+    }
+    // Insert right after left in the parent of left, after left was split
+    void insertChild(Node *left, Node *right)
+    {
+        Branch *parent {left->parent};
+        if (parent == nullptr) {
+            parent = new Branch();
+            parent->children[0] = left;
+            parent->count = 1;
+            left->parent = parent;
+            m_root = parent;
+        } else if (parent->count == BranchCapacity) {
+            splitBranch(parent);
+            parent = left->parent;
+        }
+
+        size_type index {childIndex(parent, left)};
+        for (size_type i = parent->count; i > index + 1; --i) {
+            moveEntry(parent, i - 1, parent, i);
+        }
+        parent->children[index + 1] = right;
+        parent->sizes[index + 1] = valueCount(right);
+        parent->sizes[index] = valueCount(left);
+        right->parent = parent;
+        ++parent->count;
+    }
+    // Merge or refill a node that is less than half full
+    void rebalance(Node *node)
+    {
+        if (node == m_root) {
+            if (node->leaf && node->count == 0) {
+                clear();
+            } else if (!node->leaf && node->count == 1) {
+                Branch *branch {static_cast<Branch *>(node)};
+                m_root = branch->children[0];
+                m_root->parent = nullptr;
+                delete branch;
+            }
+            return;
+        }
+        if (node->count >= capacity(node) / 2) {
+            return;
+        }
+
+        Branch *parent {node->parent};
+        size_type index {childIndex(parent, node)};
+        if (index > 0) {
+            --index;
+        }
+        Node *left {parent->children[index]};
+        Node *right {parent->children[index + 1]};
+        if (left->count + right->count <= capacity(node)) {
+            merge(left, right);
+            for (size_type i = index + 2; i < parent->count; ++i) {
+                moveEntry(parent, i, parent, i - 1);
+            }
+            --parent->count;
+            clearEntry(parent, parent->count);
+            parent->sizes[index] = valueCount(left);
+            rebalance(parent);
+        } else {
+            redistribute(left, right);
+            parent->sizes[index] = valueCount(left);
+            parent->sizes[index + 1] = valueCount(right);
+        }
+    }
+    void merge(Node *left, Node *right)
+    {
+        if (left->leaf) {
+            Leaf *leftLeaf {static_cast<Leaf *>(left)};
+            Leaf *rightLeaf {static_cast<Leaf *>(right)};
+            transfer(rightLeaf, 0, rightLeaf->count, leftLeaf, leftLeaf->count);
+            leftLeaf->next = rightLeaf->next;
+            if (rightLeaf->next != nullptr) {
+                rightLeaf->next->previous = leftLeaf;
+            } else {
+                m_last = leftLeaf;
+            }
+            delete rightLeaf;
+        } else {
+            Branch *leftBranch {static_cast<Branch *>(left)};
+            Branch *rightBranch {static_cast<Branch *>(right)};
+            transfer(rightBranch, 0, rightBranch->count, leftBranch, leftBranch->count);
+            delete rightBranch;
+        }
+    }
+    template<class N>
+    static void redistribute(N *left, N *right)
+    {
+        size_type total {left->count + right->count};
+        if (left->count > total / 2) {
+            transfer(left, total / 2, left->count, right, 0);
+        } else {
+            transfer(right, 0, total / 2 - left->count, left, left->count);
+        }
+    }
+    static void redistribute(Node *left, Node *right)
+    {
+        if (left->leaf) {
+            redistribute(static_cast<Leaf *>(left), static_cast<Leaf *>(right));
+        } else {
+            redistribute(static_cast<Branch *>(left), static_cast<Branch *>(right));
+        }
+    }
+    static void destroy(Node *node)
+    {
+        if (node == nullptr) {
+            return;
+        }
+        if (node->leaf) {
+            delete static_cast<Leaf *>(node);
+            return;
+        }
+        Branch *branch {static_cast<Branch *>(node)};
+        for (size_type i = 0; i < branch->count; ++i) {
+            destroy(branch->children[i]);
+        }
+        delete branch;
+    }
+    Node *m_root {nullptr};
+    Leaf *m_first {nullptr};
+    Leaf *m_last {nullptr};
+    size_type m_size {0};
+};
+
+}}
+
+#endif // MICROCORE_DATA_BTREESEQUENCE_H
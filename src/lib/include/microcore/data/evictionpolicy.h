@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_DATA_EVICTIONPOLICY_H
+#define MICROCORE_DATA_EVICTIONPOLICY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <vector>
+
+namespace microcore { namespace data {
+
+// Eviction policies select the entries evicted by IndexedDataStore,
+// when the size of its values is over its budget
+//
+// A policy provides an Order alias template, for keys K stored with
+// the storage policy P. Order tracks the keys that can be evicted,
+// with add(), that also marks a tracked key as used, touch(), that
+// only marks a tracked key as used, and remove(). victim() returns
+// the key to evict next, or nullptr if no key is tracked. Pinned
+// entries are not tracked.
+
+// Size of a value, counted in the budget of IndexedDataStore
+//
+// Specialize this class for values owning memory.
+template<class V>
+class ValueSize
+{
+public:
+    static std::size_t size(const V &)
+    {
+        return sizeof(V);
+    }
+};
+
+// Counters of the evictions of a store
+class EvictionStatistics
+{
+public:
+    std::uint64_t evictions {0};
+    std::uint64_t evictedBytes {0};
+};
+
+// No eviction, the default
+class NoEviction
+{
+public:
+    static const bool Enabled = false;
+    template<class K, class P>
+    class Order
+    {
+    public:
+        void add(const K &)
+        {
+        }
+        void touch(const K &)
+        {
+        }
+        void remove(const K &)
+        {
+        }
+        const K * victim()
+        {
+            return nullptr;
+        }
+    };
+};
+
+// Evict the least recently added or updated entry
+//
+// Keys are kept in a list, from the least to the most recently used.
+class LruEviction
+{
+public:
+    static const bool Enabled = true;
+    template<class K, class P>
+    class Order
+    {
+    public:
+        void add(const K &key)
+        {
+            auto it = m_index.find(key);
+            if (it != std::end(m_index)) {
+                m_keys.splice(std::end(m_keys), m_keys, it->second);
+                return;
+            }
+            m_index.emplace(key, m_keys.insert(std::end(m_keys), key));
+        }
+        void touch(const K &key)
+        {
+            auto it = m_index.find(key);
+            if (it == std::end(m_index)) {
+                return;
+            }
+            m_keys.splice(std::end(m_keys), m_keys, it->second);
+        }
+        void remove(const K &key)
+        {
+            auto it = m_index.find(key);
+            if (it == std::end(m_index)) {
+                return;
+            }
+            m_keys.erase(it->second);
+            m_index.erase(key);
+        }
+        const K * victim()
+        {
+            return m_keys.empty() ? nullptr : &m_keys.front();
+        }
+    private:
+        std::list<K> m_keys {};
+        typename P::template Container<K, typename std::list<K>::iterator> m_index {};
+    };
+};
+
+// Evict an entry that was not used since the last sweep
+//
+// Keys are kept in a ring, where each key has a reference bit, set
+// when it is used. Looking for a victim sweeps the ring, clearing
+// the bits, and stops at the first key whose bit is cleared. Using
+// an entry only sets its bit, which is cheaper than LRU, for an
+// approximate order.
+class ClockEviction
+{
+public:
+    static const bool Enabled = true;
+    template<class K, class P>
+    class Order
+    {
+    public:
+        void add(const K &key)
+        {
+            auto it = m_index.find(key);
+            if (it != std::end(m_index)) {
+                m_entries[it->second].referenced = true;
+                return;
+            }
+            if (!m_free.empty()) {
+                m_index.emplace(key, m_free.back());
+                m_entries[m_free.back()] = Entry(key);
+                m_free.pop_back();
+            } else {
+                m_index.emplace(key, m_entries.size());
+                m_entries.emplace_back(key);
+            }
+        }
+        void touch(const K &key)
+        {
+            auto it = m_index.find(key);
+            if (it == std::end(m_index)) {
+                return;
+            }
+            m_entries[it->second].referenced = true;
+        }
+        void remove(const K &key)
+        {
+            auto it = m_index.find(key);
+            if (it == std::end(m_index)) {
+                return;
+            }
+            Entry &entry (m_entries[it->second]);
+            entry.used = false;
+            m_free.push_back(it->second);
+            m_index.erase(key);
+        }
+        const K * victim()
+        {
+            if (m_index.empty()) {
+                return nullptr;
+            }
+            while (true) {
+                if (m_hand >= m_entries.size()) {
+                    m_hand = 0;
+                }
+                Entry &entry (m_entries[m_hand]);
+                ++m_hand;
+                if (!entry.used) {
+                    continue;
+                }
+                if (entry.referenced) {
+                    entry.referenced = false;
+                    continue;
+                }
+                return &entry.key;
+            }
+        }
+    private:
+        class Entry
+        {
+        public:
+            explicit Entry(const K &k) : key {k} {}
+            K key;
+            bool referenced {true};
+            bool used {true};
+        };
+        std::vector<Entry> m_entries {};
+        std::vector<std::size_t> m_free {};
+        typename P::template Container<K, std::size_t> m_index {};
+        std::size_t m_hand {0};
+    };
+};
+
+}}
+
+#endif // MICROCORE_DATA_EVICTIONPOLICY_H
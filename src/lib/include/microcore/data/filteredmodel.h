@@ -0,0 +1,467 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_DATA_FILTEREDMODEL_H
+#define MICROCORE_DATA_FILTEREDMODEL_H
+
+#include <microcore/core/callback.h>
+#include <microcore/core/globals.h>
+#include <microcore/core/listenerrepository.h>
+#include <microcore/data/imodel.h>
+#include <microcore/data/positionindex.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <QtCore/QtGlobal>
+#include <QRunnable>
+#include <QThreadPool>
+
+namespace microcore { namespace data {
+
+// A model that filters the rows of a source model
+//
+// Rows of the source are kept if the predicate accepts them, in the
+// order of the source. An empty predicate accepts all rows.
+//
+// The filter is maintained incrementally: the predicate is only
+// evaluated for the rows touched by each event of the source. Rows
+// of the source are indexed with PositionIndex, where accepted rows
+// are selected, so that the row of the model matching a row of the
+// source is found in O(log n).
+//
+// Changing the predicate evaluates it again for all rows, and only
+// notifies the rows that are removed or inserted, grouped in runs.
+// Large models are evaluated on the global QThreadPool, so the
+// predicate must be thread safe: it is called concurrently, from
+// other threads than the one of the model.
+template<class V, class S = std::deque<const V *>>
+class FilteredModel: public IModel<V, S>
+{
+public:
+    using Predicate = ::microcore::core::Callback<bool (const V &)>;
+    // Number of rows from which the predicate is evaluated in parallel
+    static const std::size_t ParallelThreshold = 4096;
+    explicit FilteredModel(IModel<V, S> &source, Predicate &&predicate = Predicate())
+        : m_listener {new SourceListener(*this)}, m_source {&source}, m_predicate {std::move(predicate)}
+    {
+        m_source->addListener(m_listener);
+    }
+    DISABLE_COPY_DISABLE_MOVE(FilteredModel);
+    typename S::iterator begin() noexcept override final
+    {
+        return m_data.begin();
+    }
+    typename S::iterator end() noexcept override final
+    {
+        return m_data.end();
+    }
+    typename S::const_iterator begin() const noexcept override final
+    {
+        return m_data.begin();
+    }
+    typename S::const_iterator end() const noexcept override final
+    {
+        return m_data.end();
+    }
+    bool empty() const noexcept override final
+    {
+        return m_data.empty();
+    }
+    typename S::size_type size() const noexcept override final
+    {
+        return m_data.size();
+    }
+    const V * operator[](typename S::size_type index) const override final
+    {
+        if (index >= m_data.size()) {
+            return nullptr;
+        }
+        return m_data[index];
+    }
+    void addListener(const typename IModel<V, S>::IListener::Ptr &listener) override final
+    {
+        if (!listener) {
+            return;
+        }
+
+        m_listenerRepository.addListener(listener);
+        if (!m_data.empty()) {
+            listener->onAppend(std::vector<const V *>(std::begin(m_data), std::end(m_data)));
+        }
+    }
+    void removeListener(const typename IModel<V, S>::IListener::Ptr &listener) override final
+    {
+        m_listenerRepository.removeListener(listener);
+    }
+    // The predicate must be thread safe, see FilteredModel
+    void setPredicate(Predicate &&predicate)
+    {
+        m_predicate = std::move(predicate);
+
+        std::vector<const V *> rows {};
+        std::vector<char> wasAccepted {};
+        rows.reserve(m_rows.size());
+        wasAccepted.reserve(m_rows.size());
+        m_rows.forEach([&rows, &wasAccepted](const V *value, bool selected) {
+            rows.push_back(value);
+            wasAccepted.push_back(selected);
+        });
+        std::vector<char> accepted {evaluate(rows)};
+
+        // Walk the rows, grouping consecutive removed or inserted
+        // rows of the model in a single event
+        typename S::size_type position {0};
+        typename S::size_type removed {0};
+        std::vector<const V *> inserted {};
+        auto flush = [this, &position, &removed, &inserted]() {
+            insertRows(position, inserted);
+            position += inserted.size();
+            inserted.clear();
+            removeRows(position, removed);
+            removed = 0;
+        };
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            if (wasAccepted[i] == accepted[i]) {
+                if (accepted[i]) {
+                    flush();
+                    ++position;
+                }
+                continue;
+            }
+            m_rows.select(i, accepted[i]);
+            if (accepted[i]) {
+                if (removed != 0) {
+                    flush();
+                }
+                inserted.push_back(rows[i]);
+            } else {
+                if (!inserted.empty()) {
+                    flush();
+                }
+                ++removed;
+            }
+        }
+        flush();
+    }
+private:
+    using Listener = typename IModel<V, S>::IListener;
+    class SourceListener: public IModel<V, S>::IListener
+    {
+    public:
+        using Ptr = std::shared_ptr<SourceListener>;
+        explicit SourceListener(FilteredModel<V, S> &parent)
+            : m_parent {parent}
+        {
+        }
+        void onAppend(const std::vector<const V *> &values) override final
+        {
+            m_parent.insertSource(m_parent.m_rows.size(), values);
+        }
+        void onPrepend(const std::vector<const V *> &values) override final
+        {
+            m_parent.insertSource(0, values);
+        }
+        void onInsert(typename S::size_type index, const std::vector<const V *> &values) override final
+        {
+            m_parent.insertSource(index, values);
+        }
+        void onRemove(typename S::size_type index) override final
+        {
+            m_parent.removeSource(index, 1);
+        }
+        void onUpdate(typename S::size_type index, const V &value) override final
+        {
+            Q_UNUSED(value)
+            m_parent.updateSource(index);
+        }
+        void onMove(typename S::size_type oldIndex, typename S::size_type newIndex) override final
+        {
+            m_parent.moveSource(oldIndex, newIndex);
+        }
+        void onInvalidation() override final
+        {
+            m_parent.m_source = nullptr;
+            m_parent.m_rows.clear();
+            m_parent.m_data.clear();
+
+            m_parent.m_listenerRepository.notify([](Listener &listener) {
+                listener.onInvalidation();
+            });
+        }
+        void onRemoveRange(typename S::size_type index, typename S::size_type count) override final
+        {
+            m_parent.removeSource(index, count);
+        }
+        void onUpdateRange(typename S::size_type index, const std::vector<const V *> &values) override final
+        {
+            for (typename S::size_type i = 0; i < values.size(); ++i) {
+                m_parent.updateSource(index + i);
+            }
+        }
+    private:
+        FilteredModel<V, S> &m_parent;
+    };
+    // Evaluation of the predicate by chunks of rows
+    //
+    // Chunks are taken by the calling thread and by tasks of the
+    // thread pool. The calling thread evaluates the chunks that are
+    // not taken yet, so it only waits for the chunks being evaluated
+    // by the tasks, even if the pool is busy. Tasks that start late
+    // find no chunk, and do not access the rows.
+    class Evaluation
+    {
+    public:
+        explicit Evaluation(const Predicate &predicate, const std::vector<const V *> &rows, std::size_t chunkCount)
+            : accepted (rows.size(), 1)
+            , m_predicate {predicate}
+            , m_rows {rows}
+            , m_chunkCount {chunkCount}
+            , m_chunkSize {(rows.size() + chunkCount - 1) / chunkCount}
+        {
+        }
+        DISABLE_COPY_DISABLE_MOVE(Evaluation);
+        bool evaluateNext()
+        {
+            std::size_t chunk {m_nextChunk.fetch_add(1, std::memory_order_relaxed)};
+            if (chunk >= m_chunkCount) {
+                return false;
+            }
+            std::size_t begin {std::min(chunk * m_chunkSize, m_rows.size())};
+            std::size_t end {std::min(begin + m_chunkSize, m_rows.size())};
+            for (std::size_t i = begin; i < end; ++i) {
+                accepted[i] = m_predicate(*m_rows[i]);
+            }
+
+            std::lock_guard<std::mutex> lock {m_mutex};
+            if (++m_doneCount == m_chunkCount) {
+                m_done.notify_all();
+            }
+            return true;
+        }
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock {m_mutex};
+            m_done.wait(lock, [this]() {
+                return m_doneCount == m_chunkCount;
+            });
+        }
+        std::vector<char> accepted {};
+    private:
+        const Predicate &m_predicate;
+        const std::vector<const V *> &m_rows;
+        std::size_t m_chunkCount {0};
+        std::size_t m_chunkSize {0};
+        std::atomic<std::size_t> m_nextChunk {0};
+        std::size_t m_doneCount {0};
+        std::mutex m_mutex {};
+        std::condition_variable m_done {};
+    };
+    class EvaluationTask final : public QRunnable
+    {
+    public:
+        explicit EvaluationTask(const std::shared_ptr<Evaluation> &evaluation)
+            : m_evaluation {evaluation}
+        {
+        }
+        void run() override
+        {
+            while (m_evaluation->evaluateNext()) {
+            }
+        }
+    private:
+        std::shared_ptr<Evaluation> m_evaluation {};
+    };
+    bool accepts(const V &value) const
+    {
+        return !m_predicate || m_predicate(value);
+    }
+    // Evaluate the predicate for each row, on the thread pool for
+    // large models
+    std::vector<char> evaluate(const std::vector<const V *> &rows) const
+    {
+        if (!m_predicate) {
+            return std::vector<char>(rows.size(), 1);
+        }
+
+        QThreadPool *threadPool {QThreadPool::globalInstance()};
+        // The calling thread evaluates chunks too
+        std::size_t threadCount {static_cast<std::size_t>(std::max(threadPool->maxThreadCount(), 0)) + 1};
+        std::size_t chunkCount {std::max<std::size_t>(std::min(threadCount, rows.size() / ParallelThreshold), 1)};
+        std::shared_ptr<Evaluation> evaluation {std::make_shared<Evaluation>(m_predicate, rows, chunkCount)};
+        for (std::size_t i = 1; i < chunkCount; ++i) {
+            threadPool->start(new EvaluationTask(evaluation));
+        }
+        while (evaluation->evaluateNext()) {
+        }
+        evaluation->wait();
+        return std::move(evaluation->accepted);
+    }
+    void insertSource(typename S::size_type index, const std::vector<const V *> &values)
+    {
+        if (values.empty() || index > m_rows.size()) {
+            return;
+        }
+        std::vector<char> accepted {evaluate(values)};
+        typename S::size_type position {m_rows.selectedBefore(index)};
+        m_rows.insert(index, std::begin(values), std::end(values), [&accepted](std::size_t i) {
+            return accepted[i] != 0;
+        });
+
+        // Accepted rows are contiguous in the model
+        std::vector<const V *> inserted {};
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            if (accepted[i]) {
+                inserted.push_back(values[i]);
+            }
+        }
+        insertRows(position, inserted);
+    }
+    void removeSource(typename S::size_type index, typename S::size_type count)
+    {
+        if (index >= m_rows.size()) {
+            return;
+        }
+        count = std::min(count, m_rows.size() - index);
+        typename S::size_type position {m_rows.selectedBefore(index)};
+        typename S::size_type removed {m_rows.selectedBefore(index + count) - position};
+        m_rows.remove(index, count);
+        removeRows(position, removed);
+    }
+    void updateSource(typename S::size_type index)
+    {
+        if (index >= m_rows.size()) {
+            return;
+        }
+        const V *value {m_rows.key(index)};
+        bool wasAccepted {m_rows.isSelected(index)};
+        bool accepted {accepts(*value)};
+        typename S::size_type position {m_rows.selectedBefore(index)};
+        if (wasAccepted && accepted) {
+            m_listenerRepository.notify([position, value](Listener &listener) {
+                listener.onUpdate(position, *value);
+            });
+            return;
+        }
+        if (wasAccepted == accepted) {
+            return;
+        }
+
+        m_rows.select(index, accepted);
+        if (accepted) {
+            std::vector<const V *> inserted {value};
+            insertRows(position, inserted);
+        } else {
+            removeRows(position, 1);
+        }
+    }
+    void moveSource(typename S::size_type oldIndex, typename S::size_type newIndex)
+    {
+        if (oldIndex >= m_rows.size() || newIndex > m_rows.size()) {
+            return;
+        }
+        typename S::size_type toIndex = (newIndex < oldIndex) ? newIndex : newIndex - 1;
+        bool accepted {m_rows.isSelected(oldIndex)};
+        typename S::size_type oldPosition {m_rows.selectedBefore(oldIndex)};
+        m_rows.move(oldIndex, toIndex);
+        if (!accepted) {
+            return;
+        }
+
+        // The row only moves in the model if it moved past accepted rows
+        typename S::size_type toPosition {m_rows.selectedBefore(toIndex)};
+        if (toPosition == oldPosition) {
+            return;
+        }
+        const V *value {m_data[oldPosition]};
+        m_data.erase(std::begin(m_data) + oldPosition);
+        m_data.insert(std::begin(m_data) + toPosition, value);
+
+        typename S::size_type newPosition {toPosition < oldPosition ? toPosition : toPosition + 1};
+        m_listenerRepository.notify([oldPosition, newPosition](Listener &listener) {
+            listener.onMove(oldPosition, newPosition);
+        });
+    }
+    void insertRows(typename S::size_type position, const std::vector<const V *> &values)
+    {
+        if (values.empty()) {
+            return;
+        }
+        bool append {position == m_data.size()};
+        m_data.insert(std::begin(m_data) + position, std::begin(values), std::end(values));
+
+        if (append) {
+            m_listenerRepository.notify([&values](Listener &listener) {
+                listener.onAppend(values);
+            });
+        } else if (position == 0) {
+            m_listenerRepository.notify([&values](Listener &listener) {
+                listener.onPrepend(values);
+            });
+        } else {
+            m_listenerRepository.notify([position, &values](Listener &listener) {
+                listener.onInsert(position, values);
+            });
+        }
+    }
+    void removeRows(typename S::size_type position, typename S::size_type count)
+    {
+        if (count == 0) {
+            return;
+        }
+        m_data.erase(std::begin(m_data) + position, std::begin(m_data) + position + count);
+
+        if (count == 1) {
+            m_listenerRepository.notify([position](Listener &listener) {
+                listener.onRemove(position);
+            });
+        } else {
+            m_listenerRepository.notify([position, count](Listener &listener) {
+                listener.onRemoveRange(position, count);
+            });
+        }
+    }
+    typename SourceListener::Ptr m_listener;
+    IModel<V, S> *m_source {nullptr};
+    Predicate m_predicate {};
+    // Rows of the source, accepted rows are selected
+    PositionIndex<const V *> m_rows {};
+    // Accepted rows, in the order of the source
+    S m_data {};
+    ::microcore::core::ListenerRepository<Listener> m_listenerRepository {};
+};
+
+}}
+
+#endif // MICROCORE_DATA_FILTEREDMODEL_H
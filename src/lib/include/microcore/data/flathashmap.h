@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_DATA_FLATHASHMAP_H
+#define MICROCORE_DATA_FLATHASHMAP_H
+
+#include <microcore/core/globals.h>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace microcore { namespace data {
+
+// An open-addressing hash map with linear probing
+//
+// Entries are stored inline in a single array, next to an array of
+// control bytes, that holds 7 bits of the hash of each entry, so that
+// most mismatching keys are rejected without being compared. Removed
+// entries leave tombstones, that are reclaimed when the table is
+// rehashed.
+//
+// Unlike std::unordered_map, inserting might move entries, so
+// iterators and references are invalidated by emplace(). erase()
+// only invalidates iterators and references to the erased entry.
+template<class K, class T, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>>
+class FlatHashMap
+{
+    template<bool Const>
+    class Iterator;
+public:
+    using key_type = K;
+    using mapped_type = T;
+    using value_type = std::pair<K, T>;
+    using size_type = std::size_t;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+    explicit FlatHashMap() = default;
+    FlatHashMap(const FlatHashMap &) = delete;
+    FlatHashMap & operator=(const FlatHashMap &) = delete;
+    FlatHashMap(FlatHashMap &&other) noexcept
+    {
+        swap(other);
+    }
+    FlatHashMap & operator=(FlatHashMap &&other) noexcept
+    {
+        FlatHashMap moved {std::move(other)};
+        swap(moved);
+        return *this;
+    }
+    ~FlatHashMap()
+    {
+        clear();
+    }
+    iterator begin() noexcept
+    {
+        return iterator(this, next(0));
+    }
+    iterator end() noexcept
+    {
+        return iterator(this, m_capacity);
+    }
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(this, next(0));
+    }
+    const_iterator end() const noexcept
+    {
+        return const_iterator(this, m_capacity);
+    }
+    bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+    size_type size() const noexcept
+    {
+        return m_size;
+    }
+    size_type capacity() const noexcept
+    {
+        return m_capacity;
+    }
+    iterator find(const K &key)
+    {
+        return iterator(this, lookup(key));
+    }
+    const_iterator find(const K &key) const
+    {
+        return const_iterator(this, lookup(key));
+    }
+    size_type count(const K &key) const
+    {
+        return lookup(key) != m_capacity ? 1 : 0;
+    }
+    template<class Key, class... Args>
+    std::pair<iterator, bool> emplace(Key &&key, Args &&...args)
+    {
+        std::uint64_t hashed {mix(m_hash(key))};
+        std::size_t index {lookup(key, hashed)};
+        if (index != m_capacity) {
+            return std::make_pair(iterator(this, index), false);
+        }
+
+        if ((m_used + 1) * 8 > m_capacity * 7) {
+            // Grows when at least half of the table holds entries,
+            // and only drops tombstones otherwise
+            rehash(m_size * 2 >= m_capacity ? (m_capacity == 0 ? MinimumCapacity : m_capacity * 2) : capacityFor(m_size + 1));
+        }
+        index = insertionIndex(hashed);
+        if (m_control[index] == Empty) {
+            ++m_used;
+        }
+        new (&m_slots[index]) value_type(std::piecewise_construct,
+                                         std::forward_as_tuple(std::forward<Key>(key)),
+                                         std::forward_as_tuple(std::forward<Args>(args)...));
+        m_control[index] = fragment(hashed);
+        ++m_size;
+        return std::make_pair(iterator(this, index), true);
+    }
+    T & operator[](const K &key)
+    {
+        return emplace(key).first->second;
+    }
+    void erase(const_iterator it)
+    {
+        eraseAt(it.m_index);
+    }
+    size_type erase(const K &key)
+    {
+        std::size_t index {lookup(key)};
+        if (index == m_capacity) {
+            return 0;
+        }
+        eraseAt(index);
+        return 1;
+    }
+    void clear() noexcept
+    {
+        for (std::size_t i = 0; i < m_capacity; ++i) {
+            if (isFull(m_control[i])) {
+                slot(i).~value_type();
+            }
+            m_control[i] = Empty;
+        }
+        m_size = 0;
+        m_used = 0;
+    }
+    // Reserve space for count entries without rehashing
+    void reserve(size_type count)
+    {
+        if (count * 8 > m_capacity * 7) {
+            rehash(capacityFor(count));
+        }
+    }
+    void swap(FlatHashMap &other) noexcept
+    {
+        using std::swap;
+        swap(m_control, other.m_control);
+        swap(m_slots, other.m_slots);
+        swap(m_capacity, other.m_capacity);
+        swap(m_shift, other.m_shift);
+        swap(m_size, other.m_size);
+        swap(m_used, other.m_used);
+        swap(m_hash, other.m_hash);
+        swap(m_equal, other.m_equal);
+    }
+private:
+    using Storage = typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+    static const std::uint8_t Empty = 0;
+    static const std::uint8_t Deleted = 1;
+    static const std::size_t MinimumCapacity = 16;
+    template<bool Const>
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::conditional<Const, const value_type *, value_type *>::type;
+        using reference = typename std::conditional<Const, const value_type &, value_type &>::type;
+        using Map = typename std::conditional<Const, const FlatHashMap, FlatHashMap>::type;
+        Iterator() = default;
+        Iterator(const Iterator<false> &other)
+            : m_map {other.m_map}, m_index {other.m_index}
+        {
+        }
+        reference operator*() const
+        {
+            return m_map->slot(m_index);
+        }
+        pointer operator->() const
+        {
+            return &m_map->slot(m_index);
+        }
+        Iterator & operator++()
+        {
+            m_index = m_map->next(m_index + 1);
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator result {*this};
+            ++(*this);
+            return result;
+        }
+        bool operator==(const Iterator &other) const
+        {
+            return m_index == other.m_index;
+        }
+        bool operator!=(const Iterator &other) const
+        {
+            return m_index != other.m_index;
+        }
+    private:
+        friend class FlatHashMap;
+        template<bool> friend class Iterator;
+        explicit Iterator(Map *map, std::size_t index)
+            : m_map {map}, m_index {index}
+        {
+        }
+        Map *m_map {nullptr};
+        std::size_t m_index {0};
+    };
+    static bool isFull(std::uint8_t control)
+    {
+        return (control & 0x80) != 0;
+    }
+    // Fibonacci hashing spreads weak hashes, like the identity
+    // hash of integers: the home slot is taken from the high bits
+    static std::uint64_t mix(std::size_t hash)
+    {
+        return static_cast<std::uint64_t>(hash) * UINT64_C(0x9E3779B97F4A7C15);
+    }
+    static std::uint8_t fragment(std::uint64_t hashed)
+    {
+        return static_cast<std::uint8_t>(0x80 | ((hashed >> 24) & 0x7F));
+    }
+    std::size_t home(std::uint64_t hashed) const
+    {
+        return static_cast<std::size_t>(hashed >> m_shift);
+    }
+    value_type & slot(std::size_t index)
+    {
+        return *reinterpret_cast<value_type *>(&m_slots[index]);
+    }
+    const value_type & slot(std::size_t index) const
+    {
+        return *reinterpret_cast<const value_type *>(&m_slots[index]);
+    }
+    std::size_t next(std::size_t index) const
+    {
+        while (index < m_capacity && !isFull(m_control[index])) {
+            ++index;
+        }
+        return index;
+    }
+    std::size_t lookup(const K &key) const
+    {
+        return m_capacity == 0 ? 0 : lookup(key, mix(m_hash(key)));
+    }
+    std::size_t lookup(const K &key, std::uint64_t hashed) const
+    {
+        if (m_capacity == 0) {
+            return 0;
+        }
+        const std::uint8_t expected {fragment(hashed)};
+        for (std::size_t index = home(hashed);; index = (index + 1) & (m_capacity - 1)) {
+            const std::uint8_t control {m_control[index]};
+            if (control == Empty) {
+                return m_capacity;
+            }
+            if (control == expected && m_equal(slot(index).first, key)) {
+                return index;
+            }
+        }
+    }
+    // First empty or deleted slot of the probe sequence
+    std::size_t insertionIndex(std::uint64_t hashed) const
+    {
+        std::size_t index {home(hashed)};
+        while (isFull(m_control[index])) {
+            index = (index + 1) & (m_capacity - 1);
+        }
+        return index;
+    }
+    void eraseAt(std::size_t index)
+    {
+        slot(index).~value_type();
+        m_control[index] = Deleted;
+        --m_size;
+    }
+    // Smallest capacity holding count entries
+    static std::size_t capacityFor(std::size_t count)
+    {
+        std::size_t capacity {MinimumCapacity};
+        while (capacity * 7 < count * 8) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+    // Rebuild the table, dropping tombstones
+    void rehash(std::size_t capacity)
+    {
+        std::unique_ptr<std::uint8_t[]> control {new std::uint8_t[capacity]()};
+        std::unique_ptr<Storage[]> slots {new Storage[capacity]};
+        std::swap(control, m_control);
+        std::swap(slots, m_slots);
+        std::size_t oldCapacity {m_capacity};
+        m_capacity = capacity;
+        m_shift = 64;
+        for (std::size_t i = capacity; i > 1; i /= 2) {
+            --m_shift;
+        }
+        m_used = m_size;
+        for (std::size_t i = 0; i < oldCapacity; ++i) {
+            if (isFull(control[i])) {
+                value_type &value (*reinterpret_cast<value_type *>(&slots[i]));
+                std::uint64_t hashed {mix(m_hash(value.first))};
+                std::size_t index {insertionIndex(hashed)};
+                new (&m_slots[index]) value_type(std::move(value));
+                m_control[index] = fragment(hashed);
+                value.~value_type();
+            }
+        }
+    }
+    std::unique_ptr<std::uint8_t[]> m_control {};
+    std::unique_ptr<Storage[]> m_slots {};
+    std::size_t m_capacity {0};
+    unsigned int m_shift {64};
+    std::size_t m_size {0};
+    std::size_t m_used {0};
+    Hash m_hash {};
+    KeyEqual m_equal {};
+};
+
+}}
+
+#endif // MICROCORE_DATA_FLATHASHMAP_H
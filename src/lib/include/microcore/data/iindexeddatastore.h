@@ -34,6 +34,7 @@
 
 #include <microcore/data/type_helper.h>
 #include <memory>
+#include <QtCore/QtGlobal>
 
 namespace microcore { namespace data {
 
@@ -56,6 +57,10 @@ namespace microcore { namespace data {
  * to handle them
  * - addListener()
  * - removeListener()
+ *
+ * Stores that evict entries implement pin() and unpin(), so that
+ * entries referenced elsewhere, like by the rows of an IndexedModel,
+ * are not evicted.
  */
 template<class K, class V>
 class IIndexedDataStore
@@ -72,6 +77,12 @@ public:
         virtual void onRemove(arg_const_reference<K> key) = 0;
         virtual void onUpdate(arg_const_reference<K> key, const ValuePtr &value) = 0;
         virtual void onInvalidation() = 0;
+        // An entry was evicted to free memory, and was not removed
+        // from the data. By default, it is handled like a removal.
+        virtual void onEvict(arg_const_reference<K> key)
+        {
+            onRemove(key);
+        }
     };
     virtual ~IIndexedDataStore() {}
     virtual ValuePtr addUnique(arg_rvalue_reference<K> key, arg_rvalue_reference<V> value) = 0;
@@ -80,6 +91,16 @@ public:
     virtual bool remove(arg_const_reference<K> key) = 0;
     virtual void addListener(const typename IListener::Ptr &listener) = 0;
     virtual void removeListener(const typename IListener::Ptr &listener) = 0;
+    // Pinned entries are not evicted. Pins are counted, and removed
+    // with the entry. By default, entries are never evicted.
+    virtual void pin(arg_const_reference<K> key)
+    {
+        Q_UNUSED(key)
+    }
+    virtual void unpin(arg_const_reference<K> key)
+    {
+        Q_UNUSED(key)
+    }
 };
 
 }}
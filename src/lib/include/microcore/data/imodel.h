@@ -53,6 +53,20 @@ public:
         virtual void onUpdate(typename S::size_type index, const T &value) = 0;
         virtual void onMove(typename S::size_type oldIndex, typename S::size_type newIndex) = 0;
         virtual void onInvalidation() = 0;
+        // Range events are sent by operations on several rows. By
+        // default, they are sent as one event per row.
+        virtual void onRemoveRange(typename S::size_type index, typename S::size_type count)
+        {
+            for (typename S::size_type i = 0; i < count; ++i) {
+                onRemove(index);
+            }
+        }
+        virtual void onUpdateRange(typename S::size_type index, const std::vector<const T *> &values)
+        {
+            for (typename S::size_type i = 0; i < values.size(); ++i) {
+                onUpdate(index + i, *values[i]);
+            }
+        }
     };
     virtual ~IModel() {}
     virtual typename S::iterator begin() noexcept = 0;
@@ -32,6 +32,7 @@
 #ifndef IMUTABLEMODEL_H
 #define IMUTABLEMODEL_H
 
+#include <microcore/core/callback.h>
 #include <microcore/data/imodel.h>
 #include <microcore/data/type_helper.h>
 
@@ -47,6 +48,11 @@ public:
     virtual void remove(typename S::size_type index) = 0;
     virtual void update(typename S::size_type index, arg_rvalue_reference<T> value) = 0;
     virtual void move(typename S::size_type oldIndex, typename S::size_type newIndex) = 0;
+    virtual void removeRange(typename S::size_type index, typename S::size_type count) = 0;
+    virtual void removeIf(const ::microcore::core::Callback<bool (const T &)> &predicate) = 0;
+    virtual void updateMany(typename S::size_type index, std::vector<T> &&values) = 0;
+    virtual void clear() = 0;
+    virtual void replace(std::vector<T> &&values) = 0;
 };
 
 }}
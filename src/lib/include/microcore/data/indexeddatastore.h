@@ -32,71 +32,199 @@
 #ifndef INDEXEDDATASTORE_H
 #define INDEXEDDATASTORE_H
 
+#include <microcore/data/evictionpolicy.h>
 #include <microcore/data/iindexeddatastore.h>
+#include <microcore/data/secondaryindex.h>
+#include <microcore/data/snapshot.h>
+#include <microcore/data/storagepolicy.h>
 #include <microcore/core/globals.h>
 #include <microcore/core/listenerrepository.h>
 #include <algorithm>
+#include <cstdint>
 #include <functional>
-#include <map>
 #include <memory>
 #include <set>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <QtCore/QtGlobal>
 
 namespace microcore { namespace data {
 
-template<class K, class V>
+// A data store, indexing values by key
+//
+// The container of the entries is selected by the storage policy P.
+//
+// The eviction policy E bounds the memory used by the values. When
+// the total size of the values, reported by ValueSize, is over the
+// budget, entries are evicted in the order of E, and removed like
+// with remove(), but notified with onEvict(). Entries that are
+// pinned, like the rows of an IndexedModel, are never evicted, so the
+// budget can be exceeded if there are only pinned entries. With the
+// default NoEviction, sizes are not tracked.
+//
+// A store is saved with saveSnapshot(), and is restored with
+// openSnapshot(), that maps the snapshot and only reads its keys.
+// Values stay in the mapped file, and are checked and decoded on the
+// first access with value() or update(). Decoded values are not
+// notified to listeners, as they were already in the store. Adding a
+// value for a key of the snapshot with add() replaces its entry, while
+// addUnique() leaves it and returns null, like for any existing key.
+// Keys and values are serialized with SnapshotTraits.
+//
+// Values can be looked up by other keys with secondary indexes, that
+// are created with addIndex() or addUniqueIndex(), are owned by the
+// store, and are updated with the entries. As indexes need values,
+// snapshots are decoded when the store has indexes.
+template<class K, class V, class P = OrderedStorage, class E = NoEviction>
 class IndexedDataStore: public IIndexedDataStore<K, V>
 {
 public:
     using ValuePtr = std::shared_ptr<V>;
+    using Container = typename P::template Container<K, ValuePtr>;
     explicit IndexedDataStore() = default;
     DISABLE_COPY_DEFAULT_MOVE(IndexedDataStore);
     ValuePtr addUnique(arg_rvalue_reference<K> key, arg_rvalue_reference<V> value) override final
     {
-        auto it = m_data.find(key);
-        if (it != std::end(m_data)) {
+        if (!m_mapped.empty() && m_mapped.find(key) != std::end(m_mapped)) {
             return ValuePtr();
         }
-        it = m_data.emplace(std::move(key), ValuePtr(new V(std::move(value)))).first;
-        using namespace std::placeholders;
-        m_listenerRepository.notify(std::bind(&IndexedDataStore::IListener::onAdd, _1,
-                                              std::ref(it->first), std::ref(it->second)));
-        return it->second;
+        auto result = m_data.emplace(std::move(key), ValuePtr());
+        if (!result.second) {
+            return ValuePtr();
+        }
+        return add(result.first, std::move(value));
     }
     ValuePtr add(arg_rvalue_reference<K> key, arg_rvalue_reference<V> value) override final
     {
-        auto it = m_data.find(key);
-        if (it != std::end(m_data)) {
-            update(it, std::move(value));
-            return it->second;
+        if (!m_mapped.empty()) {
+            discard(key);
+        }
+        auto result = m_data.emplace(std::move(key), ValuePtr());
+        if (!result.second) {
+            return update(result.first, std::move(value));
         }
-        it = m_data.emplace(std::move(key), ValuePtr(new V(std::move(value)))).first;
-        using namespace std::placeholders;
-        m_listenerRepository.notify(std::bind(&IndexedDataStore::IListener::onAdd, _1,
-                                              std::ref(it->first), std::ref(it->second)));
-        return it->second;
+        return add(result.first, std::move(value));
     }
     ValuePtr update(arg_const_reference<K> key, arg_rvalue_reference<V> value) override final
     {
         auto it = m_data.find(key);
         if (it == std::end(m_data)) {
-            return nullptr;
+            return load(key) ? update(key, std::move(value)) : nullptr;
         }
-        update(it, std::move(value));
-        return it->second;
+        return update(it, std::move(value));
     }
     bool remove(arg_const_reference<K> key) override final
+    {
+        return remove(key, false);
+    }
+
+    // Get the value of a key, decoding it if it is in a snapshot,
+    // returns null if there is no value for the key
+    //
+    // The entry is marked as used, so that it is evicted later.
+    ValuePtr value(arg_const_reference<K> key)
     {
         auto it = m_data.find(key);
-        if (it == std::end(m_data)) {
+        if (it != std::end(m_data)) {
+            if (E::Enabled) {
+                m_order.touch(key);
+            }
+            return it->second;
+        }
+        return load(key);
+    }
+    bool contains(arg_const_reference<K> key) const
+    {
+        return m_data.find(key) != std::end(m_data)
+               || (!m_mapped.empty() && m_mapped.find(key) != std::end(m_mapped));
+    }
+    // Write the entries of the store to a snapshot
+    //
+    // The format is stored in the snapshot, and should be changed
+    // when the serialization of the keys or values changes.
+    bool saveSnapshot(const std::string &path, std::uint32_t format = 0) const
+    {
+        return SnapshotFile::write(path, format, snapshot());
+    }
+    // Serialize the entries of the store, to be written with
+    // SnapshotFile::write()
+    //
+    // The index lists the keys, with the offset, size and checksum of
+    // their value. Values that are not decoded are copied from the
+    // opened snapshot.
+    SnapshotPayload snapshot() const
+    {
+        SnapshotPayload payload {};
+        SnapshotTraits<std::uint64_t>::write(payload.index, m_data.size() + m_mapped.size());
+        for (const auto &entry : m_data) {
+            std::size_t offset {payload.values.size()};
+            SnapshotTraits<V>::write(payload.values, *entry.second);
+            std::size_t size {payload.values.size() - offset};
+            writeIndexEntry(payload, entry.first, offset, size, SnapshotFile::checksum(payload.values.data() + offset, size));
+        }
+        for (const auto &entry : m_mapped) {
+            std::size_t offset {payload.values.size()};
+            payload.values.append(entry.second.data, entry.second.size);
+            writeIndexEntry(payload, entry.first, offset, entry.second.size, entry.second.checksum);
+        }
+        return payload;
+    }
+    // Open a snapshot, returns false if it is missing, invalid, or
+    // was written with another format
+    //
+    // Entries of the snapshot are added to the entries of the store,
+    // except the keys that are already in the store. Entries of a
+    // previously opened snapshot, that are not decoded, are dropped.
+    // Entries that are not decoded are not counted in bytes().
+    bool openSnapshot(const std::string &path, std::uint32_t format = 0)
+    {
+        std::shared_ptr<SnapshotFile> snapshot {std::make_shared<SnapshotFile>()};
+        if (!snapshot->open(path, format)) {
             return false;
         }
-        using namespace std::placeholders;
-        m_listenerRepository.notify(std::bind(&IndexedDataStore::IListener::onRemove, _1, std::ref(key)));
-
-        m_data.erase(it);
+        const char *data {snapshot->index()};
+        const char *end {data + snapshot->indexSize()};
+        std::uint64_t count {0};
+        if (!SnapshotTraits<std::uint64_t>::read(data, end, count)) {
+            return false;
+        }
+        // Entries are stored in the order of the container of the saved
+        // store, that degrades hash containers that grow while being
+        // filled in this order. The count is bounded by the size of
+        // the index, as each entry holds at least its offset, size and
+        // checksum.
+        const std::size_t entrySize {2 * sizeof(std::uint64_t) + sizeof(std::uint32_t)};
+        MappedContainer mapped {};
+        P::reserve(mapped, static_cast<std::size_t>(std::min<std::uint64_t>(count, snapshot->indexSize() / entrySize)));
+        for (std::uint64_t i = 0; i < count; ++i) {
+            K key {};
+            std::uint64_t offset {0};
+            std::uint32_t size {0};
+            std::uint64_t checksum {0};
+            if (!SnapshotTraits<K>::read(data, end, key) || !SnapshotTraits<std::uint64_t>::read(data, end, offset)
+                || !SnapshotTraits<std::uint32_t>::read(data, end, size)
+                || !SnapshotTraits<std::uint64_t>::read(data, end, checksum)
+                || offset > snapshot->valuesSize() || snapshot->valuesSize() - offset < size) {
+                return false;
+            }
+            if (m_data.find(key) == std::end(m_data)) {
+                const char *value {snapshot->values() + static_cast<std::size_t>(offset)};
+                mapped.emplace(std::move(key), MappedValue {value, size, checksum});
+            }
+        }
+        if (data != end) {
+            return false;
+        }
+        m_mapped = std::move(mapped);
+        m_snapshot = m_mapped.empty() ? nullptr : std::move(snapshot);
+        m_decode = &IndexedDataStore::decode;
+        if (!m_indexes.empty()) {
+            loadAll();
+        }
         return true;
     }
-
     void addListener(const typename IndexedDataStore::IListener::Ptr &listener) override final
     {
         if (!listener) {
@@ -109,18 +237,401 @@ public:
     {
         m_listenerRepository.removeListener(listener);
     }
+    void pin(arg_const_reference<K> key) override final
+    {
+        if (!E::Enabled || m_data.find(key) == std::end(m_data)) {
+            return;
+        }
+        auto result = m_pins.emplace(key, 0);
+        if (result.first->second++ == 0) {
+            m_order.remove(key);
+        }
+    }
+    void unpin(arg_const_reference<K> key) override final
+    {
+        if (!E::Enabled) {
+            return;
+        }
+        auto it = m_pins.find(key);
+        if (it == std::end(m_pins) || --it->second != 0) {
+            return;
+        }
+        m_pins.erase(key);
+        m_order.add(key);
+        evict();
+    }
+    // Add an index of the values by the key extracted by the mapper M
+    template<class M>
+    MultiIndex<K, V, M, P> & addIndex(M mapper = M())
+    {
+        return attachIndex(new MultiIndex<K, V, M, P>(std::move(mapper)));
+    }
+    // Add an index of the values by a key extracted by the mapper M,
+    // that is unique to each value
+    template<class M>
+    UniqueIndex<K, V, M, P> & addUniqueIndex(M mapper = M())
+    {
+        return attachIndex(new UniqueIndex<K, V, M, P>(std::move(mapper)));
+    }
+    // Mark an entry as used, so that it is evicted later
+    void touch(arg_const_reference<K> key)
+    {
+        m_order.touch(key);
+    }
+    // Total size of the values, if E evicts entries
+    std::size_t bytes() const
+    {
+        return m_bytes;
+    }
+    std::size_t budget() const
+    {
+        return m_budget;
+    }
+    // Set the maximum total size of the values, 0 for no limit
+    void setBudget(std::size_t budget)
+    {
+        m_budget = budget;
+        evict();
+    }
+    const EvictionStatistics & evictionStatistics() const
+    {
+        return m_evictionStatistics;
+    }
 protected:
-    std::map<K, ValuePtr> m_data {};
+    Container m_data {};
 private:
-    void update(typename std::map<K, ValuePtr>::iterator &it, arg_rvalue_reference<V> value)
+    // Listeners might modify this store while being notified. Elements of
+    // containers without stable references are copied before notifying.
+    using NotifiedElement = typename std::conditional<P::StableReferences,
+                                                      const typename Container::value_type &,
+                                                      const std::pair<K, ValuePtr>>::type;
+    // A value of a snapshot, that is not decoded yet
+    class MappedValue
+    {
+    public:
+        const char *data;
+        std::size_t size;
+        std::uint64_t checksum;
+    };
+    using MappedContainer = typename P::template Container<K, MappedValue>;
+    // Values are decoded through a pointer, set when opening a
+    // snapshot, so that stores that do not use snapshots do not
+    // require SnapshotTraits for their values
+    using Decode = ValuePtr (*)(const MappedValue &mapped);
+    static ValuePtr decode(const MappedValue &mapped)
+    {
+        if (SnapshotFile::checksum(mapped.data, mapped.size) != mapped.checksum) {
+            return ValuePtr();
+        }
+        const char *data {mapped.data};
+        const char *end {data + mapped.size};
+        ValuePtr value {new V()};
+        if (!SnapshotTraits<V>::read(data, end, *value) || data != end) {
+            return ValuePtr();
+        }
+        return value;
+    }
+    static void writeIndexEntry(SnapshotPayload &payload, const K &key, std::size_t offset, std::size_t size,
+                                std::uint64_t checksum)
+    {
+        SnapshotTraits<K>::write(payload.index, key);
+        SnapshotTraits<std::uint64_t>::write(payload.index, offset);
+        SnapshotTraits<std::uint32_t>::write(payload.index, static_cast<std::uint32_t>(size));
+        SnapshotTraits<std::uint64_t>::write(payload.index, checksum);
+    }
+    // Remove an entry, notifying that it was evicted, or removed
+    bool remove(arg_const_reference<K> key, bool evicted)
+    {
+        auto it = m_data.find(key);
+        if (it == std::end(m_data)) {
+            if (m_mapped.empty() || !discard(key)) {
+                return false;
+            }
+            notifyRemove(key, evicted);
+            return true;
+        }
+        if (E::Enabled) {
+            m_bytes -= ValueSize<V>::size(*it->second);
+            m_order.remove(key);
+            m_pins.erase(key);
+        }
+        if (!m_indexes.empty()) {
+            indexRemove(it->first, *it->second);
+        }
+        if (::microcore::core::NotificationBatch::active() == nullptr) {
+            m_listenerRepository.notify([&key, evicted](typename IndexedDataStore::IListener &listener) {
+                if (evicted) {
+                    listener.onEvict(key);
+                } else {
+                    listener.onRemove(key);
+                }
+            });
+            erase(it, key, std::integral_constant<bool, P::StableReferences>());
+        } else {
+            // The removed value is kept alive until the notification is sent,
+            // as listeners might still reference it
+            K removedKey {it->first};
+            ValuePtr removedValue {it->second};
+            m_listenerRepository.post(removedKey, [removedKey, removedValue, evicted](typename IndexedDataStore::IListener &listener) {
+                if (evicted) {
+                    listener.onEvict(removedKey);
+                } else {
+                    listener.onRemove(removedKey);
+                }
+            });
+            m_data.erase(it);
+        }
+        return true;
+    }
+    // Decode the value of a key of the snapshot, and add it, without
+    // notifying listeners
+    //
+    // Values that are corrupted or fail to decode are dropped.
+    ValuePtr load(arg_const_reference<K> key)
     {
+        if (m_mapped.empty()) {
+            return ValuePtr();
+        }
+        auto mapped = m_mapped.find(key);
+        if (mapped == std::end(m_mapped)) {
+            return ValuePtr();
+        }
+        ValuePtr value {m_decode(mapped->second)};
+        K loadedKey {mapped->first};
+        m_mapped.erase(mapped);
+        if (m_mapped.empty()) {
+            m_snapshot.reset();
+        }
+        if (!value) {
+            return ValuePtr();
+        }
+        auto result = m_data.emplace(std::move(loadedKey), ValuePtr());
+        return add(result.first, std::move(value), false);
+    }
+    void loadAll()
+    {
+        std::vector<K> keys {};
+        keys.reserve(m_mapped.size());
+        for (const auto &entry : m_mapped) {
+            keys.push_back(entry.first);
+        }
+        for (const K &key : keys) {
+            load(key);
+        }
+    }
+    template<class I>
+    I & attachIndex(I *index)
+    {
+        std::unique_ptr<I> added {index};
+        loadAll();
+        for (const auto &entry : m_data) {
+            added->add(entry.first, *entry.second);
+        }
+        m_indexes.emplace_back(std::move(added));
+        return *index;
+    }
+    void indexAdd(const K &key, const V &value)
+    {
+        for (const auto &index : m_indexes) {
+            index->add(key, value);
+        }
+    }
+    void indexRemove(const K &key, const V &value)
+    {
+        for (const auto &index : m_indexes) {
+            index->remove(key, value);
+        }
+    }
+    bool discard(arg_const_reference<K> key)
+    {
+        auto mapped = m_mapped.find(key);
+        if (mapped == std::end(m_mapped)) {
+            return false;
+        }
+        m_mapped.erase(mapped);
+        if (m_mapped.empty()) {
+            m_snapshot.reset();
+        }
+        return true;
+    }
+    ValuePtr add(typename Container::iterator it, arg_rvalue_reference<V> value)
+    {
+        return add(it, ValuePtr(new V(std::move(value))));
+    }
+    ValuePtr add(typename Container::iterator it, ValuePtr &&addedValue, bool notify = true)
+    {
+        it->second = addedValue;
+        if (!m_indexes.empty()) {
+            indexAdd(it->first, *addedValue);
+        }
+        if (!E::Enabled) {
+            if (notify) {
+                notifyAdd(it);
+            }
+            return addedValue;
+        }
+
+        m_bytes += ValueSize<V>::size(*addedValue);
+        if (!overBudget()) {
+            track(it->first);
+            if (notify) {
+                notifyAdd(it);
+            }
+            return addedValue;
+        }
+        K key {it->first};
+        if (notify) {
+            notifyAdd(it);
+        }
+        admit(key);
+        return addedValue;
+    }
+    ValuePtr update(typename Container::iterator it, arg_rvalue_reference<V> value)
+    {
+        if (E::Enabled) {
+            m_bytes -= ValueSize<V>::size(*it->second);
+        }
+        if (!m_indexes.empty()) {
+            indexRemove(it->first, *it->second);
+        }
         *(it->second) = std::move(value);
+        if (!m_indexes.empty()) {
+            indexAdd(it->first, *it->second);
+        }
+        ValuePtr updatedValue {it->second};
+        if (!E::Enabled) {
+            notifyUpdate(it);
+            return updatedValue;
+        }
+
+        m_bytes += ValueSize<V>::size(*updatedValue);
+        if (!overBudget()) {
+            track(it->first);
+            notifyUpdate(it);
+            return updatedValue;
+        }
+        K key {it->first};
+        notifyUpdate(it);
+        admit(key);
+        return updatedValue;
+    }
+    void notifyUpdate(typename Container::iterator it)
+    {
+        if (m_listenerRepository.isEmpty()) {
+            return;
+        }
+
+        if (::microcore::core::NotificationBatch::active() == nullptr) {
+            NotifiedElement element {*it};
+            m_listenerRepository.notify([&element](typename IndexedDataStore::IListener &listener) {
+                listener.onUpdate(element.first, element.second);
+            });
+            return;
+        }
+
+        // Values are updated in place, so an update can be merged
+        // with a queued addition or update of the same key
+        K key {it->first};
+        ValuePtr updatedValue {it->second};
+        m_listenerRepository.coalesce(key, [key, updatedValue](typename IndexedDataStore::IListener &listener) {
+            listener.onUpdate(key, updatedValue);
+        });
+    }
+    bool overBudget() const
+    {
+        return m_budget != 0 && m_bytes > m_budget;
+    }
+    // Track an entry that was added or updated, as the most recently
+    // used one
+    void track(const K &key)
+    {
+        if (m_pins.empty() || m_pins.find(key) == std::end(m_pins)) {
+            m_order.add(key);
+        }
+    }
+    // Evict entries for an entry that was added or updated
+    //
+    // The entry is not evicted by itself, as it is returned to the
+    // caller. The key is a copy, as evicting entries might invalidate
+    // the references to the keys of the container.
+    void admit(const K &key)
+    {
+        m_order.remove(key);
+        evict();
+        if (m_data.find(key) != std::end(m_data)) {
+            track(key);
+        }
+    }
+    void evict()
+    {
+        while (overBudget()) {
+            const K *victim {m_order.victim()};
+            if (victim == nullptr) {
+                return;
+            }
+            K key {*victim};
+            auto it = m_data.find(key);
+            std::size_t size {ValueSize<V>::size(*it->second)};
+            remove(key, true);
+            ++m_evictionStatistics.evictions;
+            m_evictionStatistics.evictedBytes += size;
+        }
+    }
+    // Notify the removal of an entry that was not decoded from the
+    // snapshot, and that has no value
+    void notifyRemove(const K &key, bool evicted)
+    {
+        if (m_listenerRepository.isEmpty()) {
+            return;
+        }
+        K removedKey {key};
+        m_listenerRepository.post(removedKey, [removedKey, evicted](typename IndexedDataStore::IListener &listener) {
+            if (evicted) {
+                listener.onEvict(removedKey);
+            } else {
+                listener.onRemove(removedKey);
+            }
+        });
+    }
+    void notifyAdd(typename Container::iterator it)
+    {
+        if (m_listenerRepository.isEmpty()) {
+            return;
+        }
+        if (::microcore::core::NotificationBatch::active() == nullptr) {
+            NotifiedElement element {*it};
+            m_listenerRepository.notify([&element](typename IndexedDataStore::IListener &listener) {
+                listener.onAdd(element.first, element.second);
+            });
+            return;
+        }
 
-        using namespace std::placeholders;
-        m_listenerRepository.notify(std::bind(&IndexedDataStore::IListener::onUpdate, _1,
-                                              std::ref(it->first), std::ref(it->second)));
+        K key {it->first};
+        ValuePtr addedValue {it->second};
+        m_listenerRepository.coalesce(key, [key, addedValue](typename IndexedDataStore::IListener &listener) {
+            listener.onAdd(key, addedValue);
+        });
+    }
+    void erase(typename Container::iterator it, arg_const_reference<K> key, std::true_type)
+    {
+        Q_UNUSED(key)
+        m_data.erase(it);
+    }
+    void erase(typename Container::iterator it, arg_const_reference<K> key, std::false_type)
+    {
+        Q_UNUSED(it)
+        m_data.erase(key);
     }
     ::microcore::core::ListenerRepository<typename IndexedDataStore::IListener> m_listenerRepository {};
+    typename E::template Order<K, P> m_order {};
+    typename P::template Container<K, std::size_t> m_pins {};
+    std::size_t m_bytes {0};
+    std::size_t m_budget {0};
+    EvictionStatistics m_evictionStatistics {};
+    std::shared_ptr<SnapshotFile> m_snapshot {};
+    MappedContainer m_mapped {};
+    Decode m_decode {nullptr};
+    std::vector<std::unique_ptr<ISecondaryIndex<K, V>>> m_indexes {};
 };
 
 }}
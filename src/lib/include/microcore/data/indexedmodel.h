@@ -34,11 +34,13 @@
 
 #include <microcore/data/imutablemodel.h>
 #include <microcore/data/iindexeddatastore.h>
+#include <microcore/data/positionindex.h>
 #include <microcore/core/globals.h>
 #include <microcore/core/listenerrepository.h>
 #include <algorithm>
 #include <deque>
 #include <functional>
+#include <map>
 #include <memory>
 #include <set>
 #include <QtCore/QtGlobal>
@@ -55,6 +57,17 @@ public:
         m_dataStore->addListener(m_listener);
     }
     DISABLE_COPY_DEFAULT_MOVE(IndexedModel);
+    // Rows are pinned in the data store, and are unpinned, but kept,
+    // when the model is destroyed
+    ~IndexedModel()
+    {
+        if (m_dataStore == nullptr) {
+            return;
+        }
+        for (const V *value : m_data) {
+            m_dataStore->unpin(m_mapper(*value));
+        }
+    }
     typename S::iterator begin() noexcept override final
     {
         return m_data.begin();
@@ -103,20 +116,24 @@ public:
     }
     void append(std::vector<V> &&values) override final
     {
-        insert(std::end(m_data), std::move(values), &IModel<V, S>::IListener::onAppend);
+        insert(std::end(m_data), std::move(values), [](typename IModel<V, S>::IListener &listener, const std::vector<const V *> &buffer) {
+            listener.onAppend(buffer);
+        });
     }
     void prepend(std::vector<V> &&values) override final
     {
-        insert(std::begin(m_data), std::move(values), &IModel<V, S>::IListener::onPrepend);
+        insert(std::begin(m_data), std::move(values), [](typename IModel<V, S>::IListener &listener, const std::vector<const V *> &buffer) {
+            listener.onPrepend(buffer);
+        });
     }
     void insert(typename S::size_type index, std::vector<V> &&values) override final
     {
         if (index > m_data.size()) {
             return;
         }
-        using namespace std::placeholders;
-        insert(std::begin(m_data) + index, std::move(values),
-               std::bind(&IModel<V, S>::IListener::onInsert, _1, index, _2));
+        insert(std::begin(m_data) + index, std::move(values), [index](typename IModel<V, S>::IListener &listener, const std::vector<const V *> &buffer) {
+            listener.onInsert(index, buffer);
+        });
     }
     void remove(typename S::size_type index) override final
     {
@@ -125,17 +142,19 @@ public:
             return;
         }
 
-        if (index > m_data.size()) {
+        if (index >= m_data.size()) {
             return;
         }
 
         auto it = std::begin(m_data) + index;
         const V *value {*it};
         m_data.erase(it);
+        m_positions.remove(index);
         m_dataStore->remove(m_mapper(*value));
 
-        using namespace std::placeholders;
-        m_listenerRepository.notify(std::bind(&IModel<V, S>::IListener::onRemove, _1, index));
+        m_listenerRepository.notify([index](typename IModel<V, S>::IListener &listener) {
+            listener.onRemove(index);
+        });
     }
     void update(typename S::size_type index, arg_rvalue_reference<V> value) override final
     {
@@ -144,7 +163,7 @@ public:
             return;
         }
 
-        if (index > m_data.size()) {
+        if (index >= m_data.size()) {
             return;
         }
 
@@ -156,8 +175,9 @@ public:
 
         m_dataStore->update(key, std::move(value));
 
-        using namespace std::placeholders;
-        m_listenerRepository.notify(std::bind(&IModel<V, S>::IListener::onUpdate, _1, index, std::ref(*storedValue)));
+        m_listenerRepository.notify([index, storedValue](typename IModel<V, S>::IListener &listener) {
+            listener.onUpdate(index, *storedValue);
+        });
     }
     void move(typename S::size_type oldIndex, typename S::size_type newIndex) override final
     {
@@ -174,9 +194,157 @@ public:
         const V *storedValue {m_data[oldIndex]};
         m_data.erase(std::begin(m_data) + oldIndex);
         m_data.insert(std::begin(m_data) + toIndex, storedValue);
+        m_positions.move(oldIndex, toIndex);
+
+        m_listenerRepository.notify([oldIndex, newIndex](typename IModel<V, S>::IListener &listener) {
+            listener.onMove(oldIndex, newIndex);
+        });
+    }
+    void removeRange(typename S::size_type index, typename S::size_type count) override final
+    {
+        ListenBlockerLock lock {m_listeningDataStore};
+        if (m_dataStore == nullptr) {
+            return;
+        }
+
+        if (index >= m_data.size() || count == 0) {
+            return;
+        }
 
-        using namespace std::placeholders;
-        m_listenerRepository.notify(std::bind(&IModel<V, S>::IListener::onMove, _1, oldIndex, newIndex));
+        eraseRange(index, std::min(count, m_data.size() - index));
+    }
+    void removeIf(const ::microcore::core::Callback<bool (const V &)> &predicate) override final
+    {
+        ListenBlockerLock lock {m_listeningDataStore};
+        if (m_dataStore == nullptr) {
+            return;
+        }
+
+        removeRows(0, m_data.size(), predicate);
+    }
+    void updateMany(typename S::size_type index, std::vector<V> &&values) override final
+    {
+        ListenBlockerLock lock {m_listeningDataStore};
+        if (m_dataStore == nullptr) {
+            return;
+        }
+
+        if (index >= m_data.size() || values.empty()) {
+            return;
+        }
+
+        // Like update(), values changing the key of their row are
+        // ignored, and only the runs of updated rows are notified
+        typename S::size_type count {std::min(values.size(), m_data.size() - index)};
+        std::vector<std::pair<typename S::size_type, std::vector<const V *>>> runs {};
+        for (typename S::size_type i = 0; i < count; ++i) {
+            const V *storedValue {m_data[index + i]};
+            const typename M::KeyType &key {m_mapper(*storedValue)};
+            if (key != m_mapper(values[i])) {
+                continue;
+            }
+            m_dataStore->update(key, std::move(values[i]));
+            if (runs.empty() || runs.back().first + runs.back().second.size() != index + i) {
+                runs.emplace_back(index + i, std::vector<const V *>());
+            }
+            runs.back().second.emplace_back(storedValue);
+        }
+
+        for (const auto &run : runs) {
+            m_listenerRepository.notify([&run](typename IModel<V, S>::IListener &listener) {
+                listener.onUpdateRange(run.first, run.second);
+            });
+        }
+    }
+    void clear() override final
+    {
+        removeRange(0, m_data.size());
+    }
+    // Replace the rows with new values
+    //
+    // Only the differences are applied and notified: rows whose key is
+    // not in the values are removed, rows are moved and inserted to
+    // follow the order of the values, and rows are updated if their
+    // value changed. Rows are moved as little as possible, as the rows
+    // in the longest subsequence already ordered like the values are
+    // kept in place. Values are compared with operator== if V has one,
+    // otherwise every row that is kept is updated.
+    //
+    // Values with the same key as a previous value are ignored.
+    void replace(std::vector<V> &&values) override final
+    {
+        ListenBlockerLock lock {m_listeningDataStore};
+        if (m_dataStore == nullptr) {
+            return;
+        }
+
+        // Duplicated keys are dropped first, so that a value in the
+        // prefix or in the suffix cannot replace a previous one
+        removeDuplicates(values);
+
+        // Rows at the beginning and at the end that have the keys of
+        // the values are in place, only the rows between are diffed
+        typename S::size_type prefix {0};
+        while (prefix < m_data.size() && prefix < values.size()
+               && m_mapper(*m_data[prefix]) == m_mapper(values[prefix])) {
+            ++prefix;
+        }
+        typename S::size_type suffix {0};
+        while (suffix < m_data.size() - prefix && suffix < values.size() - prefix
+               && m_mapper(*m_data[m_data.size() - suffix - 1]) == m_mapper(values[values.size() - suffix - 1])) {
+            ++suffix;
+        }
+
+        Diff diff {};
+        diff.values.reserve(values.size() - prefix - suffix);
+        for (typename S::size_type i = prefix; i < values.size() - suffix; ++i) {
+            diff.indexes.emplace(m_mapper(values[i]), diff.values.size());
+            diff.values.emplace_back(std::move(values[i]));
+        }
+
+        removeRows(prefix, m_data.size() - suffix, [&diff, this](const V &value) {
+            return diff.indexes.find(m_mapper(value)) == std::end(diff.indexes);
+        });
+
+        std::vector<typename S::size_type> oldIndexes {};
+        diff.present.assign(diff.values.size(), false);
+        for (typename S::size_type i = prefix; i < m_data.size() - suffix; ++i) {
+            typename S::size_type index {diff.indexes.find(m_mapper(*m_data[i]))->second};
+            oldIndexes.emplace_back(index);
+            diff.present[index] = true;
+        }
+        std::vector<bool> kept {increasingSubsequence(oldIndexes, diff.values.size())};
+
+        // Each row is placed after the previous value, next being the
+        // position after it. Kept rows are already correctly ordered
+        // once all the other rows are placed.
+        typename S::size_type next {prefix};
+        typename S::size_type index {0};
+        while (index < diff.values.size()) {
+            if (!diff.present[index]) {
+                std::vector<V> inserted {};
+                while (index < diff.values.size() && !diff.present[index]) {
+                    inserted.emplace_back(std::move(diff.values[index]));
+                    ++index;
+                }
+                typename S::size_type size {m_data.size()};
+                insert(std::begin(m_data) + next, std::move(inserted), [next](typename IModel<V, S>::IListener &listener, const std::vector<const V *> &buffer) {
+                    listener.onInsert(next, buffer);
+                });
+                next += m_data.size() - size;
+                continue;
+            }
+
+            typename S::size_type position {m_positions.position(m_mapper(diff.values[index]))};
+            if (!kept[index] && position != next) {
+                move(position, next);
+                position = position < next ? next - 1 : next;
+            }
+            next = position + 1;
+            ++index;
+        }
+
+        updateRows(values, prefix, suffix, diff);
     }
 private:
     class DataStoreListener: public IIndexedDataStore<typename M::KeyType, V>::IListener
@@ -199,18 +367,16 @@ private:
                 return;
             }
 
-            auto it = std::find_if(std::begin(m_parent.m_data), std::end(m_parent.m_data), [&key, this](const V *v) {
-                return m_parent.m_mapper(*v) == key;
-            });
-
-            if (it == std::end(m_parent.m_data)) {
+            typename S::size_type index = m_parent.m_positions.position(key);
+            if (index == PositionIndex<typename M::KeyType>::npos) {
                 return;
             }
-            typename S::size_type index = it - std::begin(m_parent.m_data);
-            m_parent.m_data.erase(it);
+            m_parent.m_data.erase(std::begin(m_parent.m_data) + index);
+            m_parent.m_positions.remove(index);
 
-            using namespace std::placeholders;
-            m_parent.m_listenerRepository.notify(std::bind(&IModel<V, S>::IListener::onRemove, _1, index));
+            m_parent.m_listenerRepository.notify([index](typename IModel<V, S>::IListener &listener) {
+                listener.onRemove(index);
+            });
         }
         void onUpdate(arg_const_reference<typename M::KeyType> key,
                       const ValuePtr & value) override final
@@ -220,25 +386,25 @@ private:
                 return;
             }
 
-            auto it = std::find_if(std::begin(m_parent.m_data), std::end(m_parent.m_data), [&key, this](const V *v) {
-                return m_parent.m_mapper(*v) == key;
-            });
-
-            if (it == std::end(m_parent.m_data)) {
+            typename S::size_type index = m_parent.m_positions.position(key);
+            if (index == PositionIndex<typename M::KeyType>::npos) {
                 return;
             }
-            typename S::size_type index = it - std::begin(m_parent.m_data);
 
-            using namespace std::placeholders;
-            m_parent.m_listenerRepository.notify(std::bind(&IModel<V, S>::IListener::onUpdate, _1, index, std::ref(*(*it))));
+            const V &storedValue {*m_parent.m_data[index]};
+            m_parent.m_listenerRepository.notify([index, &storedValue](typename IModel<V, S>::IListener &listener) {
+                listener.onUpdate(index, storedValue);
+            });
         }
         void onInvalidation() override final
         {
             m_parent.m_dataStore = nullptr;
             m_parent.m_data.clear();
+            m_parent.m_positions.clear();
 
-            using namespace std::placeholders;
-            m_parent.m_listenerRepository.notify(std::bind(&IModel<V, S>::IListener::onInvalidation, _1));
+            m_parent.m_listenerRepository.notify([](typename IModel<V, S>::IListener &listener) {
+                listener.onInvalidation();
+            });
         }
     private:
         IndexedModel<V, M, S> &m_parent;
@@ -258,30 +424,196 @@ private:
     private:
         bool &m_listeningDataStore;
     };
-    void insert(typename S::iterator index, std::vector<V> &&values,
-                std::function<void (typename IModel<V, S>::IListener &, const std::vector<const V *> &)> &&function)
+    template<class F>
+    void insert(typename S::iterator index, std::vector<V> &&values, F &&function)
     {
         if (m_dataStore == nullptr) {
             return;
         }
 
         std::vector<const V *> buffer {};
+        std::vector<typename M::KeyType> keys {};
         buffer.reserve(values.size());
-        std::for_each(std::begin(values), std::end(values), [&buffer, this](V &value) {
-            const std::shared_ptr<V> &addedValue {m_dataStore->addUnique(m_mapper(value), std::move(value))};
+        keys.reserve(values.size());
+        std::for_each(std::begin(values), std::end(values), [&buffer, &keys, this](V &value) {
+            typename M::KeyType key {m_mapper(value)};
+            const std::shared_ptr<V> &addedValue {m_dataStore->addUnique(typename M::KeyType(key), std::move(value))};
             if (addedValue) {
+                m_dataStore->pin(key);
                 buffer.emplace_back(addedValue.get());
+                keys.emplace_back(std::move(key));
             }
         });
+        if (buffer.empty()) {
+            return;
+        }
+
+        typename S::size_type position = index - std::begin(m_data);
         m_data.insert(index, std::begin(buffer), std::end(buffer));
+        m_positions.insert(position, std::begin(keys), std::end(keys));
+
+        const std::vector<const V *> &addedValues {buffer};
+        m_listenerRepository.notify([&function, &addedValues](typename IModel<V, S>::IListener &listener) {
+            function(listener, addedValues);
+        });
+    }
+    // Values that replace the rows, between the rows that are in place
+    class Diff
+    {
+    public:
+        std::map<typename M::KeyType, typename S::size_type> indexes {};
+        std::vector<V> values {};
+        // If a value has a row in the model
+        std::vector<bool> present {};
+    };
+    // Drop the values with the same key as a previous value
+    void removeDuplicates(std::vector<V> &values) const
+    {
+        std::set<typename M::KeyType> keys {};
+        typename std::vector<V>::size_type size {0};
+        for (V &value : values) {
+            if (keys.insert(m_mapper(value)).second) {
+                if (&values[size] != &value) {
+                    values[size] = std::move(value);
+                }
+                ++size;
+            }
+        }
+        values.erase(std::begin(values) + size, std::end(values));
+    }
+    template<class Predicate>
+    void removeRows(typename S::size_type begin, typename S::size_type end, const Predicate &predicate)
+    {
+        // Runs of matching rows are removed starting from the last one,
+        // so that the indexes of the rows before stay valid
+        while (end > begin) {
+            typename S::size_type first {end};
+            while (first > begin && predicate(*m_data[first - 1])) {
+                --first;
+            }
+            if (first != end) {
+                eraseRange(first, end - first);
+            }
+            if (first == begin) {
+                break;
+            }
+            end = first - 1;
+        }
+    }
+    // Update the rows that changed, notifying runs of updated rows
+    // with one event
+    void updateRows(std::vector<V> &values, typename S::size_type prefix, typename S::size_type suffix, Diff &diff)
+    {
+        std::vector<const V *> updatedValues {};
+        typename S::size_type first {0};
+        auto notify = [&updatedValues, &first, this]() {
+            if (updatedValues.empty()) {
+                return;
+            }
+            const std::vector<const V *> &notifiedValues {updatedValues};
+            typename S::size_type index {first};
+            m_listenerRepository.notify([index, &notifiedValues](typename IModel<V, S>::IListener &listener) {
+                listener.onUpdateRange(index, notifiedValues);
+            });
+            updatedValues.clear();
+        };
 
-        using namespace std::placeholders;
-        m_listenerRepository.notify(std::bind(function, _1, std::ref(buffer)));
+        const typename S::size_type size {m_data.size()};
+        for (typename S::size_type i = 0; i < size; ++i) {
+            const V *storedValue {m_data[i]};
+            V *value {nullptr};
+            if (i < prefix) {
+                value = &values[i];
+            } else if (i >= size - suffix) {
+                value = &values[values.size() - (size - i)];
+            } else {
+                typename S::size_type index {diff.indexes.find(m_mapper(*storedValue))->second};
+                if (diff.present[index]) {
+                    value = &diff.values[index];
+                }
+            }
+            if (value == nullptr || !changed(*storedValue, *value)) {
+                notify();
+                continue;
+            }
+            m_dataStore->update(m_mapper(*storedValue), std::move(*value));
+            if (updatedValues.empty()) {
+                first = i;
+            }
+            updatedValues.emplace_back(storedValue);
+        }
+        notify();
+    }
+    template<class T = V>
+    static typename std::enable_if<is_equality_comparable<T>::value, bool>::type changed(const T &value, const T &newValue)
+    {
+        return !(value == newValue);
+    }
+    template<class T = V>
+    static typename std::enable_if<!is_equality_comparable<T>::value, bool>::type changed(const T &value, const T &newValue)
+    {
+        Q_UNUSED(value)
+        Q_UNUSED(newValue)
+        return true;
+    }
+    // Mark the indexes that are part of a longest increasing
+    // subsequence of indexes, that are all smaller than size
+    static std::vector<bool> increasingSubsequence(const std::vector<typename S::size_type> &indexes,
+                                                   typename S::size_type size)
+    {
+        // Patience sorting: tails[l] is the position in indexes of the
+        // smallest last element of an increasing subsequence of size l + 1
+        const std::size_t npos {static_cast<std::size_t>(-1)};
+        std::vector<std::size_t> tails {};
+        std::vector<std::size_t> previous (indexes.size(), npos);
+        for (std::size_t i = 0; i < indexes.size(); ++i) {
+            auto it = std::lower_bound(std::begin(tails), std::end(tails), indexes[i], [&indexes](std::size_t tail, typename S::size_type index) {
+                return indexes[tail] < index;
+            });
+            if (it != std::begin(tails)) {
+                previous[i] = *(it - 1);
+            }
+            if (it == std::end(tails)) {
+                tails.emplace_back(i);
+            } else {
+                *it = i;
+            }
+        }
+
+        std::vector<bool> result (size, false);
+        std::size_t i {tails.empty() ? npos : tails.back()};
+        while (i != npos) {
+            result[indexes[i]] = true;
+            i = previous[i];
+        }
+        return result;
+    }
+    void eraseRange(typename S::size_type index, typename S::size_type count)
+    {
+        auto first = std::begin(m_data) + index;
+        auto last = first + count;
+        std::vector<typename M::KeyType> keys {};
+        keys.reserve(count);
+        std::for_each(first, last, [&keys, this](const V *value) {
+            keys.emplace_back(m_mapper(*value));
+        });
+        m_data.erase(first, last);
+        m_positions.remove(index, count);
+        for (const typename M::KeyType &key : keys) {
+            m_dataStore->remove(key);
+        }
+
+        m_listenerRepository.notify([index, count](typename IModel<V, S>::IListener &listener) {
+            listener.onRemoveRange(index, count);
+        });
     }
     typename DataStoreListener::Ptr m_listener;
     IIndexedDataStore<typename M::KeyType, V> *m_dataStore {nullptr};
     M m_mapper {};
     S m_data {};
+    // Positions of the keys in m_data, to find the row of a key
+    // notified by the data store in O(log n)
+    PositionIndex<typename M::KeyType> m_positions {};
     std::unique_ptr<std::vector<const V *>> m_buffer {};
     bool m_listeningDataStore {true};
     ::microcore::core::ListenerRepository<typename IModel<V, S>::IListener> m_listenerRepository {};
@@ -53,9 +53,11 @@ public:
     }
     void setData(T &&data) override
     {
-        using namespace std::placeholders;
         m_data = std::move(data);
-        m_listenerRepository.notify(std::bind(&IItem<T>::IListener::onUpdate, _1, m_data));
+        const T &currentData {m_data};
+        m_listenerRepository.notify([&currentData](typename IItem<T>::IListener &listener) {
+            listener.onUpdate(currentData);
+        });
     }
     void addListener(const typename IItem<T>::IListener::Ptr &listener) override final
     {
@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_DATA_JOURNAL_H
+#define MICROCORE_DATA_JOURNAL_H
+
+#include <microcore/data/indexeddatastore.h>
+#include <microcore/data/snapshot.h>
+#include <microcore/core/globals.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <QtCore/QtGlobal>
+
+namespace microcore { namespace data {
+
+// A journal file, records being appended to it
+//
+// A journal starts with a header, holding a magic number, the version
+// of the file layout and the format of the records, set by the writer.
+// Records follow the header.
+class JournalFile
+{
+public:
+    static const std::uint32_t Version = 1;
+    explicit JournalFile() = default;
+    DISABLE_COPY_DISABLE_MOVE(JournalFile);
+    ~JournalFile();
+    // Read the records of a journal, returns false if it is missing,
+    // or has another version or format
+    static bool read(const std::string &path, std::uint32_t format, std::string &records);
+    // Open a journal for appending, keeping the first size bytes of
+    // its records, creating it if needed
+    bool open(const std::string &path, std::uint32_t format, std::size_t size);
+    void close();
+    bool isOpen() const;
+    // Append records and sync them to the disk
+    bool append(const std::string &records);
+    // Size of the records
+    std::size_t size() const;
+private:
+    int m_fd {-1};
+    std::size_t m_size {0};
+};
+
+// A write-ahead journal of the changes of an IndexedDataStore
+//
+// The journal listens to the store, and records the additions,
+// updates and removals of entries. Evictions are not recorded, as
+// evicted entries are still in the data, and values decoded from a
+// snapshot are not notified by the store. Records are buffered, and
+// are written and synced to the disk together by commit(), that is
+// called once commitSize() bytes are buffered. Buffered records are
+// lost if the application stops before they are committed, so
+// commit() should be called after a batch of changes, like a
+// synchronization.
+//
+// open() restores the store from the snapshot at path, and replays
+// the journal, at path with a ".journal" suffix, on top of it. Once
+// the journal is larger than compactionSize(), it is folded in a new
+// snapshot in a background thread, that replays the journal on top of
+// the previous snapshot, without reading the store, whose entries
+// might have been evicted. Records hold complete values, so
+// replaying a journal on top of a more recent snapshot gives the same
+// store, and an interrupted compaction is recovered by replaying the
+// previous journal, kept with a ".old" suffix until the snapshot is
+// written.
+//
+// Keys and values are serialized with SnapshotTraits. The format is
+// stored in the snapshot and the journal, and should be changed when
+// the serialization changes.
+template<class K, class V, class P = OrderedStorage, class E = NoEviction>
+class Journal
+{
+public:
+    using Store = IndexedDataStore<K, V, P, E>;
+    explicit Journal(Store &store, const std::string &path, std::uint32_t format = 0)
+        : m_listener {new StoreListener(*this)}, m_store {&store}, m_path {path}, m_format {format}
+    {
+    }
+    DISABLE_COPY_DISABLE_MOVE(Journal);
+    ~Journal()
+    {
+        if (m_store != nullptr) {
+            m_store->removeListener(m_listener);
+        }
+        commit();
+        waitForCompaction();
+    }
+    // Restore the store, and record its changes, returns false if
+    // the journal cannot be written
+    bool open()
+    {
+        if (m_store == nullptr || m_file.isOpen()) {
+            return false;
+        }
+        m_store->openSnapshot(m_path, m_format);
+        std::string records {};
+        if (JournalFile::read(oldJournalPath(), m_format, records)) {
+            replay(*m_store, records);
+        }
+        std::size_t size {0};
+        if (JournalFile::read(journalPath(), m_format, records)) {
+            size = replay(*m_store, records);
+        }
+        // Records after the last valid one, written partially, are dropped
+        if (!m_file.open(journalPath(), m_format, size)) {
+            return false;
+        }
+        m_store->addListener(m_listener);
+        return true;
+    }
+    // Write and sync the buffered records
+    bool commit()
+    {
+        if (!write()) {
+            return false;
+        }
+        if (m_compactionSize != 0 && m_file.size() >= m_compactionSize) {
+            compact();
+        }
+        return true;
+    }
+    // Fold the journal in a new snapshot, in a background thread
+    void compact()
+    {
+        waitForCompaction();
+        if (!m_file.isOpen() || !write()) {
+            return;
+        }
+        // A previous compaction failed: its journal is still needed, and
+        // the current journal is kept, as replaying it is harmless
+        std::string oldPath {oldJournalPath()};
+        if (!exists(oldPath)) {
+            m_file.close();
+            if (std::rename(journalPath().c_str(), oldPath.c_str()) != 0
+                || !m_file.open(journalPath(), m_format, 0)) {
+                m_file.open(journalPath(), m_format, journalSize());
+                return;
+            }
+        }
+        m_compaction = std::thread(&Journal::compactFiles, m_path, m_format, oldPath);
+    }
+    void waitForCompaction()
+    {
+        if (m_compaction.joinable()) {
+            m_compaction.join();
+        }
+    }
+    // Size of the records in the journal
+    std::size_t size() const
+    {
+        return m_file.size();
+    }
+    // Size of the buffered records
+    std::size_t pending() const
+    {
+        return m_buffer.size();
+    }
+    std::size_t commitSize() const
+    {
+        return m_commitSize;
+    }
+    void setCommitSize(std::size_t commitSize)
+    {
+        m_commitSize = commitSize;
+    }
+    std::size_t compactionSize() const
+    {
+        return m_compactionSize;
+    }
+    // Set the size of the journal that triggers a compaction, 0 to
+    // never compact automatically
+    void setCompactionSize(std::size_t compactionSize)
+    {
+        m_compactionSize = compactionSize;
+    }
+private:
+    enum class Type: std::uint8_t
+    {
+        Add,
+        Update,
+        Remove
+    };
+    class StoreListener: public Store::IListener
+    {
+    public:
+        using ValuePtr = typename Store::ValuePtr;
+        explicit StoreListener(Journal &parent)
+            : m_parent {parent}
+        {
+        }
+        void onAdd(arg_const_reference<K> key, const ValuePtr &value) override final
+        {
+            m_parent.record(Type::Add, key, value.get());
+        }
+        void onRemove(arg_const_reference<K> key) override final
+        {
+            m_parent.record(Type::Remove, key, nullptr);
+        }
+        void onUpdate(arg_const_reference<K> key, const ValuePtr &value) override final
+        {
+            m_parent.record(Type::Update, key, value.get());
+        }
+        void onEvict(arg_const_reference<K> key) override final
+        {
+            Q_UNUSED(key)
+        }
+        void onInvalidation() override final
+        {
+            m_parent.m_store = nullptr;
+        }
+    private:
+        Journal &m_parent;
+    };
+    // A record holds the size of its body, a checksum of the body,
+    // and the body: the type, the key and the value
+    static const std::size_t RecordHeaderSize {sizeof(std::uint32_t) + sizeof(std::uint64_t)};
+    std::string journalPath() const
+    {
+        return m_path + ".journal";
+    }
+    std::string oldJournalPath() const
+    {
+        return m_path + ".journal.old";
+    }
+    std::size_t journalSize() const
+    {
+        std::string records {};
+        return JournalFile::read(journalPath(), m_format, records) ? records.size() : 0;
+    }
+    static bool exists(const std::string &path)
+    {
+        std::FILE *file {std::fopen(path.c_str(), "rb")};
+        if (file == nullptr) {
+            return false;
+        }
+        std::fclose(file);
+        return true;
+    }
+    // Replay the previous journal on top of the snapshot, in a store
+    // of the compaction, that only decodes the changed values
+    static void compactFiles(const std::string &path, std::uint32_t format, const std::string &oldPath)
+    {
+        IndexedDataStore<K, V, P> store {};
+        store.openSnapshot(path, format);
+        std::string records {};
+        if (JournalFile::read(oldPath, format, records)) {
+            replay(store, records);
+        }
+        if (store.saveSnapshot(path, format)) {
+            std::remove(oldPath.c_str());
+        }
+    }
+    bool write()
+    {
+        if (m_buffer.empty()) {
+            return true;
+        }
+        if (!m_file.isOpen() || !m_file.append(m_buffer)) {
+            return false;
+        }
+        m_buffer.clear();
+        return true;
+    }
+    void record(Type type, arg_const_reference<K> key, const V *value)
+    {
+        std::size_t start {m_buffer.size()};
+        m_buffer.append(RecordHeaderSize, '\0');
+        SnapshotTraits<std::uint8_t>::write(m_buffer, static_cast<std::uint8_t>(type));
+        SnapshotTraits<K>::write(m_buffer, key);
+        if (value != nullptr) {
+            SnapshotTraits<V>::write(m_buffer, *value);
+        }
+        const char *body {m_buffer.data() + start + RecordHeaderSize};
+        std::uint32_t size {static_cast<std::uint32_t>(m_buffer.size() - start - RecordHeaderSize)};
+        std::uint64_t checksum {SnapshotFile::checksum(body, size)};
+        std::memcpy(&m_buffer[start], &size, sizeof(size));
+        std::memcpy(&m_buffer[start + sizeof(size)], &checksum, sizeof(checksum));
+        if (m_buffer.size() >= m_commitSize) {
+            commit();
+        }
+    }
+    // Apply records to a store, returns the size of the valid records
+    template<class S>
+    static std::size_t replay(S &store, const std::string &records)
+    {
+        const char *begin {records.data()};
+        const char *data {begin};
+        const char *end {begin + records.size()};
+        std::uint32_t size {0};
+        std::uint64_t checksum {0};
+        while (SnapshotTraits<std::uint32_t>::read(data, end, size)
+               && SnapshotTraits<std::uint64_t>::read(data, end, checksum)
+               && static_cast<std::size_t>(end - data) >= size
+               && SnapshotFile::checksum(data, size) == checksum
+               && apply(store, data, data + size)) {
+            data += size;
+            begin = data;
+        }
+        return static_cast<std::size_t>(begin - records.data());
+    }
+    template<class S>
+    static bool apply(S &store, const char *data, const char *end)
+    {
+        std::uint8_t type {0};
+        K key {};
+        if (!SnapshotTraits<std::uint8_t>::read(data, end, type) || !SnapshotTraits<K>::read(data, end, key)) {
+            return false;
+        }
+        if (type == static_cast<std::uint8_t>(Type::Remove)) {
+            if (data != end) {
+                return false;
+            }
+            store.remove(key);
+            return true;
+        }
+        V value {};
+        if (type > static_cast<std::uint8_t>(Type::Update) || !SnapshotTraits<V>::read(data, end, value)
+            || data != end) {
+            return false;
+        }
+        store.add(std::move(key), std::move(value));
+        return true;
+    }
+    std::shared_ptr<StoreListener> m_listener;
+    Store *m_store {nullptr};
+    std::string m_path {};
+    std::uint32_t m_format {0};
+    JournalFile m_file {};
+    std::string m_buffer {};
+    std::size_t m_commitSize {64 * 1024};
+    std::size_t m_compactionSize {4 * 1024 * 1024};
+    std::thread m_compaction {};
+};
+
+}}
+
+#endif // MICROCORE_DATA_JOURNAL_H
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_DATA_PAGEDMODEL_H
+#define MICROCORE_DATA_PAGEDMODEL_H
+
+#include <microcore/core/executor.h>
+#include <microcore/core/globals.h>
+#include <microcore/core/ijobfactory.h>
+#include <microcore/core/pipe.h>
+#include <microcore/data/iindexeddatastore.h>
+#include <microcore/data/imodel.h>
+#include <microcore/data/indexedmodel.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+namespace microcore { namespace data {
+
+// A page of rows, requested by PagedModel
+class PageRequest
+{
+public:
+    explicit PageRequest() = default;
+    explicit PageRequest(std::size_t o, std::size_t c) : offset {o}, count {c} {}
+    DEFAULT_COPY_DEFAULT_MOVE(PageRequest);
+    std::size_t offset {0};
+    std::size_t count {0};
+};
+
+// A model whose rows are loaded page by page
+//
+// Pages are fetched with a Pipe, built over a factory of jobs that
+// return the rows of a PageRequest. The rows of a page are appended
+// to the model. A page with less rows than requested is the last
+// one, and no more pages are fetched afterwards.
+//
+// Pages are fetched on demand, with fetchMore(), one page at a time.
+// setVisibleRow() fetches the next page in advance, when a visible
+// row is within prefetchDistance of the last row.
+//
+// Rows are added to the data store with addUnique(), like with
+// IndexedModel, so rows of overlapping pages, that are already in
+// the data store, are not added twice. The offset of the next page
+// counts all the received rows, duplicated or not.
+//
+// PagedModel is also an Executor, that is busy while a page is
+// fetched, and reports the errors of the fetch. A failed page is
+// fetched again by the next fetchMore().
+template<class V, class M, class Error, class S = std::deque<const V *>>
+class PagedModel: public IModel<V, S>, public ::microcore::core::Executor<Error>
+{
+public:
+    using Factory = ::microcore::core::IJobFactory<PageRequest, std::vector<V>, Error>;
+    using ::microcore::core::Executor<Error>::addListener;
+    using ::microcore::core::Executor<Error>::removeListener;
+    explicit PagedModel(IIndexedDataStore<typename M::KeyType, V> &dataStore, const Factory &factory,
+                        std::size_t pageSize = 20, std::size_t prefetchDistance = 10)
+        : m_model {dataStore}
+        , m_pipe {factory, [this](std::vector<V> &&values) {
+            onPage(std::move(values));
+        }, [this](Error &&error) {
+            this->doError(std::move(error));
+        }}
+        , m_pageSize {std::max<std::size_t>(pageSize, 1)}
+        , m_prefetchDistance {prefetchDistance}
+    {
+    }
+    DISABLE_COPY_DISABLE_MOVE(PagedModel);
+    typename S::iterator begin() noexcept override final
+    {
+        return m_model.begin();
+    }
+    typename S::iterator end() noexcept override final
+    {
+        return m_model.end();
+    }
+    typename S::const_iterator begin() const noexcept override final
+    {
+        return m_model.begin();
+    }
+    typename S::const_iterator end() const noexcept override final
+    {
+        return m_model.end();
+    }
+    bool empty() const noexcept override final
+    {
+        return m_model.empty();
+    }
+    typename S::size_type size() const noexcept override final
+    {
+        return m_model.size();
+    }
+    const V * operator[](typename S::size_type index) const override final
+    {
+        return m_model[index];
+    }
+    void addListener(const typename IModel<V, S>::IListener::Ptr &listener) override final
+    {
+        m_model.addListener(listener);
+    }
+    void removeListener(const typename IModel<V, S>::IListener::Ptr &listener) override final
+    {
+        m_model.removeListener(listener);
+    }
+    std::size_t pageSize() const
+    {
+        return m_pageSize;
+    }
+    std::size_t prefetchDistance() const
+    {
+        return m_prefetchDistance;
+    }
+    void setPrefetchDistance(std::size_t prefetchDistance)
+    {
+        m_prefetchDistance = prefetchDistance;
+    }
+    // If the last page is not fetched yet
+    bool canFetchMore() const
+    {
+        return !m_finished;
+    }
+    // Fetch the next page, if it is not being fetched already
+    void fetchMore()
+    {
+        if (!canFetchMore() || !this->canStart()) {
+            return;
+        }
+        if (m_appending) {
+            m_fetchDeferred = true;
+            return;
+        }
+        this->doStart();
+        m_pipe.send(PageRequest(m_offset, m_pageSize), this->token());
+    }
+    // Fetch the next page if the row is within prefetchDistance of
+    // the last row
+    void setVisibleRow(typename S::size_type index)
+    {
+        if (index + m_prefetchDistance + 1 >= m_model.size()) {
+            fetchMore();
+        }
+    }
+private:
+    void onPage(std::vector<V> &&values)
+    {
+        m_offset += values.size();
+        if (values.size() < m_pageSize) {
+            m_finished = true;
+        }
+
+        // Finished before the rows are appended, so that listeners
+        // can fetch the next page, but the fetch is deferred until the
+        // rows are appended, as a page can be received synchronously
+        m_appending = true;
+        this->doFinish();
+        m_model.append(std::move(values));
+        m_appending = false;
+        if (m_fetchDeferred) {
+            m_fetchDeferred = false;
+            fetchMore();
+        }
+    }
+    IndexedModel<V, M, S> m_model;
+    ::microcore::core::Pipe<PageRequest, std::vector<V>, Error> m_pipe;
+    std::size_t m_pageSize {0};
+    std::size_t m_prefetchDistance {0};
+    std::size_t m_offset {0};
+    bool m_finished {false};
+    bool m_appending {false};
+    bool m_fetchDeferred {false};
+};
+
+}}
+
+#endif // MICROCORE_DATA_PAGEDMODEL_H
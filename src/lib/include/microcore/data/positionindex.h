@@ -0,0 +1,345 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_DATA_POSITIONINDEX_H
+#define MICROCORE_DATA_POSITIONINDEX_H
+
+#include <microcore/core/globals.h>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <utility>
+
+namespace microcore { namespace data {
+
+// An index of the positions of unique keys in a sequence
+//
+// The sequence is mirrored by an implicit treap, an order-statistics
+// tree where each node stores the size of its subtree. Nodes are
+// stored in a std::map, so a key finds its node in O(log n), and the
+// position of a node is computed in O(log n) by walking up to the
+// root. Insertion, removal and moves are O(log n) per key.
+//
+// Keys can also be selected. Each node counts the selected keys of
+// its subtree, so that the number of selected keys before a position
+// is computed in O(log n).
+template<class K>
+class PositionIndex
+{
+public:
+    using size_type = std::size_t;
+    static const size_type npos = static_cast<size_type>(-1);
+    explicit PositionIndex() = default;
+    PositionIndex(const PositionIndex &) = delete;
+    PositionIndex & operator=(const PositionIndex &) = delete;
+    // Nodes are not moved by moving the map, only the root is reset
+    PositionIndex(PositionIndex &&other) noexcept
+        : m_nodes {std::move(other.m_nodes)}
+        , m_root {other.m_root}
+        , m_seed {other.m_seed}
+    {
+        other.clear();
+    }
+    PositionIndex & operator=(PositionIndex &&other) noexcept
+    {
+        m_nodes = std::move(other.m_nodes);
+        m_root = other.m_root;
+        m_seed = other.m_seed;
+        other.clear();
+        return *this;
+    }
+    size_type size() const
+    {
+        return size(m_root);
+    }
+    bool contains(const K &key) const
+    {
+        return m_nodes.find(key) != std::end(m_nodes);
+    }
+    // Position of a key, or npos if the key is not indexed
+    size_type position(const K &key) const
+    {
+        auto it = m_nodes.find(key);
+        if (it == std::end(m_nodes)) {
+            return npos;
+        }
+        const Node *node {&it->second};
+        size_type result {size(node->left)};
+        while (node->parent != nullptr) {
+            if (node->parent->right == node) {
+                result += size(node->parent->left) + 1;
+            }
+            node = node->parent;
+        }
+        return result;
+    }
+    // Key at a position
+    const K & key(size_type position) const
+    {
+        return *find(position)->key;
+    }
+    // Insert keys at a position
+    //
+    // Keys that are already indexed are not inserted.
+    template<class InputIterator>
+    void insert(size_type position, InputIterator first, InputIterator last)
+    {
+        insert(position, first, last, [](size_type) {
+            return false;
+        });
+    }
+    // Insert keys at a position, selecting the keys for which
+    // selected(i) is true, i being the index of the key in the range
+    template<class InputIterator, class Selected>
+    void insert(size_type position, InputIterator first, InputIterator last, const Selected &selected)
+    {
+        Node *inserted {nullptr};
+        for (size_type i = 0; first != last; ++first, ++i) {
+            auto result = m_nodes.emplace(std::piecewise_construct, std::forward_as_tuple(*first), std::forward_as_tuple());
+            if (!result.second) {
+                continue;
+            }
+            Node &node (result.first->second);
+            node.key = &result.first->first;
+            node.priority = nextPriority();
+            node.selected = selected(i);
+            node.selectedSize = node.selected ? 1 : 0;
+            inserted = merge(inserted, &node);
+        }
+        if (inserted == nullptr) {
+            return;
+        }
+        std::pair<Node *, Node *> parts {split(m_root, position)};
+        m_root = merge(merge(parts.first, inserted), parts.second);
+        m_root->parent = nullptr;
+    }
+    void insert(size_type position, const K &key)
+    {
+        insert(position, &key, &key + 1);
+    }
+    // Remove the keys at [position, position + count)
+    void remove(size_type position, size_type count = 1)
+    {
+        std::pair<Node *, Node *> parts {split(m_root, position)};
+        std::pair<Node *, Node *> removed {split(parts.second, count)};
+        m_root = merge(parts.first, removed.second);
+        if (m_root != nullptr) {
+            m_root->parent = nullptr;
+        }
+        erase(removed.first);
+    }
+    // Move the key at oldPosition, so that it is at newPosition once moved
+    void move(size_type oldPosition, size_type newPosition)
+    {
+        std::pair<Node *, Node *> parts {split(m_root, oldPosition)};
+        std::pair<Node *, Node *> moved {split(parts.second, 1)};
+        Node *root {merge(parts.first, moved.second)};
+        std::pair<Node *, Node *> target {split(root, newPosition)};
+        m_root = merge(merge(target.first, moved.first), target.second);
+        if (m_root != nullptr) {
+            m_root->parent = nullptr;
+        }
+    }
+    void clear()
+    {
+        m_root = nullptr;
+        m_nodes.clear();
+    }
+    bool isSelected(size_type position) const
+    {
+        return find(position)->selected;
+    }
+    void select(size_type position, bool selected)
+    {
+        Node *node {find(position)};
+        node->selected = selected;
+        for (; node != nullptr; node = node->parent) {
+            update(node);
+        }
+    }
+    // Number of selected keys
+    size_type selectedCount() const
+    {
+        return selectedSize(m_root);
+    }
+    // Number of selected keys before a position
+    size_type selectedBefore(size_type position) const
+    {
+        size_type result {0};
+        const Node *node {m_root};
+        while (node != nullptr) {
+            size_type leftSize {size(node->left)};
+            if (position <= leftSize) {
+                node = node->left;
+            } else {
+                result += selectedSize(node->left) + (node->selected ? 1 : 0);
+                position -= leftSize + 1;
+                node = node->right;
+            }
+        }
+        return result;
+    }
+    // Call function(key, selected) for each key, in order
+    template<class F>
+    void forEach(const F &function) const
+    {
+        forEach(m_root, function);
+    }
+private:
+    class Node
+    {
+    public:
+        const K *key {nullptr};
+        Node *parent {nullptr};
+        Node *left {nullptr};
+        Node *right {nullptr};
+        size_type size {1};
+        size_type selectedSize {0};
+        std::uint32_t priority {0};
+        bool selected {false};
+    };
+    static size_type size(const Node *node)
+    {
+        return node != nullptr ? node->size : 0;
+    }
+    static size_type selectedSize(const Node *node)
+    {
+        return node != nullptr ? node->selectedSize : 0;
+    }
+    static void update(Node *node)
+    {
+        node->size = size(node->left) + size(node->right) + 1;
+        node->selectedSize = selectedSize(node->left) + selectedSize(node->right) + (node->selected ? 1 : 0);
+        if (node->left != nullptr) {
+            node->left->parent = node;
+        }
+        if (node->right != nullptr) {
+            node->right->parent = node;
+        }
+    }
+    // Split a tree in the first count nodes and the others
+    static std::pair<Node *, Node *> split(Node *node, size_type count)
+    {
+        if (node == nullptr) {
+            return std::make_pair(nullptr, nullptr);
+        }
+        if (size(node->left) >= count) {
+            std::pair<Node *, Node *> parts {split(node->left, count)};
+            node->left = parts.second;
+            update(node);
+            if (parts.first != nullptr) {
+                parts.first->parent = nullptr;
+            }
+            return std::make_pair(parts.first, node);
+        }
+        std::pair<Node *, Node *> parts {split(node->right, count - size(node->left) - 1)};
+        node->right = parts.first;
+        update(node);
+        if (parts.second != nullptr) {
+            parts.second->parent = nullptr;
+        }
+        return std::make_pair(node, parts.second);
+    }
+    static Node * merge(Node *first, Node *second)
+    {
+        if (first == nullptr) {
+            return second;
+        }
+        if (second == nullptr) {
+            return first;
+        }
+        if (first->priority > second->priority) {
+            first->right = merge(first->right, second);
+            update(first);
+            return first;
+        }
+        second->left = merge(first, second->left);
+        update(second);
+        return second;
+    }
+    Node * find(size_type position) const
+    {
+        Node *node {m_root};
+        while (true) {
+            size_type leftSize {size(node->left)};
+            if (position < leftSize) {
+                node = node->left;
+            } else if (position == leftSize) {
+                return node;
+            } else {
+                position -= leftSize + 1;
+                node = node->right;
+            }
+        }
+    }
+    template<class F>
+    static void forEach(const Node *node, const F &function)
+    {
+        if (node == nullptr) {
+            return;
+        }
+        forEach(node->left, function);
+        function(*node->key, node->selected);
+        forEach(node->right, function);
+    }
+    // Erase the nodes of a detached tree
+    void erase(Node *node)
+    {
+        if (node == nullptr) {
+            return;
+        }
+        Node *left {node->left};
+        Node *right {node->right};
+        m_nodes.erase(*node->key);
+        erase(left);
+        erase(right);
+    }
+    std::uint32_t nextPriority()
+    {
+        // xorshift32
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        return m_seed;
+    }
+    std::map<K, Node> m_nodes {};
+    Node *m_root {nullptr};
+    std::uint32_t m_seed {2463534242u};
+};
+
+template<class K>
+const typename PositionIndex<K>::size_type PositionIndex<K>::npos;
+
+}}
+
+#endif // MICROCORE_DATA_POSITIONINDEX_H
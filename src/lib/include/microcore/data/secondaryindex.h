@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_DATA_SECONDARYINDEX_H
+#define MICROCORE_DATA_SECONDARYINDEX_H
+
+#include <microcore/data/type_helper.h>
+#include <microcore/core/globals.h>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <QtCore/QtGlobal>
+
+namespace microcore { namespace data {
+
+// A secondary index of an IndexedDataStore
+//
+// The store calls add() once a value is added or updated, and
+// remove() before a value is removed or updated, so that the index
+// sees the previous value.
+template<class K, class V>
+class ISecondaryIndex
+{
+public:
+    virtual ~ISecondaryIndex() {}
+    virtual void add(arg_const_reference<K> key, const V &value) = 0;
+    virtual void remove(arg_const_reference<K> key, const V &value) = 0;
+};
+
+// An iterator on the values of an index, from an iterator on pairs
+// of keys and pointers to values
+template<class I, class V>
+class IndexIterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = V;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const V *;
+    using reference = const V &;
+    explicit IndexIterator() = default;
+    explicit IndexIterator(I it)
+        : m_it {it}
+    {
+    }
+    reference operator*() const
+    {
+        return *m_it->second;
+    }
+    pointer operator->() const
+    {
+        return m_it->second;
+    }
+    IndexIterator & operator++()
+    {
+        ++m_it;
+        return *this;
+    }
+    IndexIterator operator++(int)
+    {
+        IndexIterator result {*this};
+        ++m_it;
+        return result;
+    }
+    bool operator==(const IndexIterator &other) const
+    {
+        return m_it == other.m_it;
+    }
+    bool operator!=(const IndexIterator &other) const
+    {
+        return m_it != other.m_it;
+    }
+private:
+    I m_it {};
+};
+
+// A range of values of an index, that does not own the values
+//
+// The range is invalidated when the index is modified, like when the
+// store adds, updates or removes values.
+template<class I, class V>
+class IndexRange
+{
+public:
+    using iterator = IndexIterator<I, V>;
+    explicit IndexRange(I begin, I end, std::size_t size)
+        : m_begin {begin}, m_end {end}, m_size {size}
+    {
+    }
+    iterator begin() const
+    {
+        return m_begin;
+    }
+    iterator end() const
+    {
+        return m_end;
+    }
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+    std::size_t size() const
+    {
+        return m_size;
+    }
+private:
+    iterator m_begin;
+    iterator m_end;
+    std::size_t m_size {0};
+};
+
+// An index of the values of a store, by a key that is unique
+//
+// The index key is extracted from values by the mapper M, like the
+// mappers of IndexedModel. Lookups are done in the container of the
+// storage policy P.
+//
+// Uniqueness is not enforced by the store. If values share an index
+// key, the index refers to the one that was added or updated last,
+// and falls back to the others when it is removed. These conflicts
+// are reported by count() and conflictCount().
+template<class K, class V, class M, class P>
+class UniqueIndex: public ISecondaryIndex<K, V>
+{
+public:
+    using IndexKey = typename M::KeyType;
+    explicit UniqueIndex(M mapper = M())
+        : m_mapper {std::move(mapper)}
+    {
+    }
+    DISABLE_COPY_DISABLE_MOVE(UniqueIndex);
+    // Get the value of an index key, or null
+    const V * find(arg_const_reference<IndexKey> indexKey) const
+    {
+        auto it = m_values.find(indexKey);
+        return it != std::end(m_values) ? it->second.back().second : nullptr;
+    }
+    std::size_t size() const
+    {
+        return m_values.size();
+    }
+    // Get the number of values sharing an index key
+    std::size_t count(arg_const_reference<IndexKey> indexKey) const
+    {
+        auto it = m_values.find(indexKey);
+        return it != std::end(m_values) ? it->second.size() : 0;
+    }
+    // Get the number of index keys shared by several values
+    std::size_t conflictCount() const
+    {
+        return m_conflictCount;
+    }
+    void add(arg_const_reference<K> key, const V &value) override final
+    {
+        Owners &owners = m_values[m_mapper(value)];
+        owners.emplace_back(key, &value);
+        if (owners.size() == 2) {
+            ++m_conflictCount;
+        }
+    }
+    void remove(arg_const_reference<K> key, const V &value) override final
+    {
+        auto it = m_values.find(m_mapper(value));
+        if (it == std::end(m_values)) {
+            return;
+        }
+        Owners &owners = it->second;
+        auto owner = std::find_if(std::begin(owners), std::end(owners), [&key](const Owner &owner) {
+            return owner.first == key;
+        });
+        if (owner != std::end(owners)) {
+            owners.erase(owner);
+            if (owners.size() == 1) {
+                --m_conflictCount;
+            }
+        }
+        if (owners.empty()) {
+            m_values.erase(it);
+        }
+    }
+private:
+    // Values sharing an index key, the last one being the indexed one
+    using Owner = std::pair<K, const V *>;
+    using Owners = std::vector<Owner>;
+    M m_mapper;
+    typename P::template Container<IndexKey, Owners> m_values {};
+    std::size_t m_conflictCount {0};
+};
+
+// An index of the values of a store, by a key that is shared by
+// values
+//
+// Like UniqueIndex, the index key is extracted by the mapper M. The
+// values of an index key are stored by key, in containers of the
+// storage policy P.
+template<class K, class V, class M, class P>
+class MultiIndex: public ISecondaryIndex<K, V>
+{
+public:
+    using IndexKey = typename M::KeyType;
+    using Values = typename P::template Container<K, const V *>;
+    using Range = IndexRange<typename Values::const_iterator, V>;
+    explicit MultiIndex(M mapper = M())
+        : m_mapper {std::move(mapper)}
+    {
+    }
+    DISABLE_COPY_DISABLE_MOVE(MultiIndex);
+    // Get the values of an index key
+    Range find(arg_const_reference<IndexKey> indexKey) const
+    {
+        auto it = m_values.find(indexKey);
+        const Values &values {it != std::end(m_values) ? it->second : m_empty};
+        return Range(std::begin(values), std::end(values), values.size());
+    }
+    std::size_t count(arg_const_reference<IndexKey> indexKey) const
+    {
+        auto it = m_values.find(indexKey);
+        return it != std::end(m_values) ? it->second.size() : 0;
+    }
+    void add(arg_const_reference<K> key, const V &value) override final
+    {
+        m_values[m_mapper(value)][key] = &value;
+    }
+    void remove(arg_const_reference<K> key, const V &value) override final
+    {
+        auto it = m_values.find(m_mapper(value));
+        if (it == std::end(m_values)) {
+            return;
+        }
+        it->second.erase(key);
+        if (it->second.empty()) {
+            m_values.erase(it);
+        }
+    }
+private:
+    M m_mapper;
+    typename P::template Container<IndexKey, Values> m_values {};
+    const Values m_empty {};
+};
+
+}}
+
+#endif // MICROCORE_DATA_SECONDARYINDEX_H
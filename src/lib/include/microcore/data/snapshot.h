@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_DATA_SNAPSHOT_H
+#define MICROCORE_DATA_SNAPSHOT_H
+
+#include <microcore/core/globals.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace microcore { namespace data {
+
+// Serialization of the keys and values of a snapshot
+//
+// write() appends a value to a buffer. read() reads a value at data,
+// advancing data, and returns false if the data, that ends at end,
+// is invalid. Snapshots are read from untrusted files, so read()
+// must not read past end.
+//
+// Arithmetic types and std::string are supported. Specialize this
+// class for other keys and values. Data is in native byte order.
+template<class T, class Enable = void>
+class SnapshotTraits;
+
+template<class T>
+class SnapshotTraits<T, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+{
+public:
+    static void write(std::string &buffer, T value)
+    {
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+    static bool read(const char *&data, const char *end, T &value)
+    {
+        if (static_cast<std::size_t>(end - data) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return true;
+    }
+};
+
+template<>
+class SnapshotTraits<std::string>
+{
+public:
+    static void write(std::string &buffer, const std::string &value)
+    {
+        SnapshotTraits<std::uint32_t>::write(buffer, static_cast<std::uint32_t>(value.size()));
+        buffer.append(value);
+    }
+    static bool read(const char *&data, const char *end, std::string &value)
+    {
+        std::uint32_t size {0};
+        if (!SnapshotTraits<std::uint32_t>::read(data, end, size)
+            || static_cast<std::size_t>(end - data) < size) {
+            return false;
+        }
+        value.assign(data, size);
+        data += size;
+        return true;
+    }
+};
+
+// The content of a snapshot
+//
+// The index is read when the snapshot is opened, and is checked by
+// the checksum of the snapshot. Values are read on demand, and
+// should be checked by the index, see SnapshotFile::checksum().
+class SnapshotPayload
+{
+public:
+    std::string index {};
+    std::string values {};
+};
+
+// A snapshot file, mapped in memory
+//
+// A snapshot starts with a header, holding a magic number, the
+// version of the file layout, the format of the payload, set by the
+// writer, like a version of the serialization of the values, the
+// sizes of the index and of the values, and the checksum of the
+// index. Files with another version or format, truncated, or with a
+// corrupted index, are rejected by open(), that only reads the index.
+//
+// Snapshots are written to a temporary file, that replaces the file
+// once complete, so that an interrupted write keeps the previous
+// snapshot, and that mapped snapshots stay valid.
+class SnapshotFile
+{
+public:
+    static const std::uint32_t Version = 1;
+    explicit SnapshotFile() = default;
+    DISABLE_COPY_DISABLE_MOVE(SnapshotFile);
+    ~SnapshotFile();
+    // Map a snapshot, returns false if it is missing or invalid
+    bool open(const std::string &path, std::uint32_t format);
+    void close();
+    const char * index() const;
+    std::size_t indexSize() const;
+    const char * values() const;
+    std::size_t valuesSize() const;
+    static bool write(const std::string &path, std::uint32_t format, const SnapshotPayload &payload);
+    static std::uint64_t checksum(const char *data, std::size_t size);
+private:
+    void *m_mapping {nullptr};
+    std::size_t m_mappingSize {0};
+    const char *m_index {nullptr};
+    std::size_t m_indexSize {0};
+    const char *m_values {nullptr};
+    std::size_t m_valuesSize {0};
+};
+
+}}
+
+#endif // MICROCORE_DATA_SNAPSHOT_H
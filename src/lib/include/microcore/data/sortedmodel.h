@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_DATA_SORTEDMODEL_H
+#define MICROCORE_DATA_SORTEDMODEL_H
+
+#include <microcore/core/globals.h>
+#include <microcore/core/listenerrepository.h>
+#include <microcore/data/imodel.h>
+#include <microcore/data/positionindex.h>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <QtCore/QtGlobal>
+
+namespace microcore { namespace data {
+
+// A model that sorts the rows of a source model
+//
+// The order is maintained incrementally: each event of the source is
+// applied as an insertion, a removal or a move of a row, found by a
+// binary search with Compare, and notified as such. Rows that compare
+// equal are kept in the order they were added.
+//
+// SortedModel mirrors the order of the source, to find which row is
+// removed or updated by the source. Positions of rows in the sorted
+// rows are found in O(log n) with PositionIndex. With the default
+// std::deque storage, inserting or removing a row still shifts the
+// storage, use BTreeSequence for large models.
+//
+// Values updated by the source are compared again, and moved if
+// their position changed.
+template<class V, class S = std::deque<const V *>, class Compare = std::less<V>>
+class SortedModel: public IModel<V, S>
+{
+public:
+    explicit SortedModel(IModel<V, S> &source, Compare compare = Compare())
+        : m_listener {new SourceListener(*this)}, m_source {&source}, m_compare {std::move(compare)}
+    {
+        m_source->addListener(m_listener);
+    }
+    DISABLE_COPY_DISABLE_MOVE(SortedModel);
+    typename S::iterator begin() noexcept override final
+    {
+        return m_data.begin();
+    }
+    typename S::iterator end() noexcept override final
+    {
+        return m_data.end();
+    }
+    typename S::const_iterator begin() const noexcept override final
+    {
+        return m_data.begin();
+    }
+    typename S::const_iterator end() const noexcept override final
+    {
+        return m_data.end();
+    }
+    bool empty() const noexcept override final
+    {
+        return m_data.empty();
+    }
+    typename S::size_type size() const noexcept override final
+    {
+        return m_data.size();
+    }
+    const V * operator[](typename S::size_type index) const override final
+    {
+        if (index >= m_data.size()) {
+            return nullptr;
+        }
+        return m_data[index];
+    }
+    void addListener(const typename IModel<V, S>::IListener::Ptr &listener) override final
+    {
+        if (!listener) {
+            return;
+        }
+
+        m_listenerRepository.addListener(listener);
+        if (!m_data.empty()) {
+            listener->onAppend(std::vector<const V *>(std::begin(m_data), std::end(m_data)));
+        }
+    }
+    void removeListener(const typename IModel<V, S>::IListener::Ptr &listener) override final
+    {
+        m_listenerRepository.removeListener(listener);
+    }
+private:
+    using Listener = typename IModel<V, S>::IListener;
+    class SourceListener: public IModel<V, S>::IListener
+    {
+    public:
+        using Ptr = std::shared_ptr<SourceListener>;
+        explicit SourceListener(SortedModel<V, S, Compare> &parent)
+            : m_parent {parent}
+        {
+        }
+        void onAppend(const std::vector<const V *> &values) override final
+        {
+            m_parent.insertSource(m_parent.m_sourceRows.size(), values);
+        }
+        void onPrepend(const std::vector<const V *> &values) override final
+        {
+            m_parent.insertSource(0, values);
+        }
+        void onInsert(typename S::size_type index, const std::vector<const V *> &values) override final
+        {
+            m_parent.insertSource(index, values);
+        }
+        void onRemove(typename S::size_type index) override final
+        {
+            m_parent.removeSource(index, 1);
+        }
+        void onUpdate(typename S::size_type index, const V &value) override final
+        {
+            Q_UNUSED(value)
+            m_parent.updateSource(index);
+        }
+        void onMove(typename S::size_type oldIndex, typename S::size_type newIndex) override final
+        {
+            // Only the order of the source changes
+            typename S::size_type toIndex = (newIndex < oldIndex) ? newIndex : newIndex - 1;
+            const V *value {m_parent.m_sourceRows[oldIndex]};
+            m_parent.m_sourceRows.erase(std::begin(m_parent.m_sourceRows) + oldIndex);
+            m_parent.m_sourceRows.insert(std::begin(m_parent.m_sourceRows) + toIndex, value);
+        }
+        void onInvalidation() override final
+        {
+            m_parent.m_source = nullptr;
+            m_parent.m_sourceRows.clear();
+            m_parent.m_data.clear();
+            m_parent.m_positions.clear();
+
+            m_parent.m_listenerRepository.notify([](Listener &listener) {
+                listener.onInvalidation();
+            });
+        }
+        void onRemoveRange(typename S::size_type index, typename S::size_type count) override final
+        {
+            m_parent.removeSource(index, count);
+        }
+        void onUpdateRange(typename S::size_type index, const std::vector<const V *> &values) override final
+        {
+            for (typename S::size_type i = 0; i < values.size(); ++i) {
+                m_parent.updateSource(index + i);
+            }
+        }
+    private:
+        SortedModel<V, S, Compare> &m_parent;
+    };
+    class PointerCompare
+    {
+    public:
+        explicit PointerCompare(const Compare &compare)
+            : m_compare {compare}
+        {
+        }
+        bool operator()(const V *first, const V *second) const
+        {
+            return m_compare(*first, *second);
+        }
+    private:
+        const Compare &m_compare;
+    };
+    void insertSource(typename S::size_type index, const std::vector<const V *> &values)
+    {
+        if (values.empty() || index > m_sourceRows.size()) {
+            return;
+        }
+        m_sourceRows.insert(std::begin(m_sourceRows) + index, std::begin(values), std::end(values));
+
+        if (m_data.empty()) {
+            // Rows are sorted at once, in a single event
+            std::vector<const V *> sorted (values);
+            std::stable_sort(std::begin(sorted), std::end(sorted), PointerCompare(m_compare));
+            m_data.insert(std::end(m_data), std::begin(sorted), std::end(sorted));
+            m_positions.insert(0, std::begin(sorted), std::end(sorted));
+
+            const std::vector<const V *> &appended {sorted};
+            m_listenerRepository.notify([&appended](Listener &listener) {
+                listener.onAppend(appended);
+            });
+            return;
+        }
+
+        for (const V *value : values) {
+            insertSorted(value);
+        }
+    }
+    void removeSource(typename S::size_type index, typename S::size_type count)
+    {
+        if (index >= m_sourceRows.size()) {
+            return;
+        }
+        count = std::min(count, m_sourceRows.size() - index);
+        std::vector<const V *> removed (std::begin(m_sourceRows) + index, std::begin(m_sourceRows) + index + count);
+        m_sourceRows.erase(std::begin(m_sourceRows) + index, std::begin(m_sourceRows) + index + count);
+
+        for (const V *value : removed) {
+            typename S::size_type position {m_positions.position(value)};
+            m_data.erase(std::begin(m_data) + position);
+            m_positions.remove(position);
+            m_listenerRepository.notify([position](Listener &listener) {
+                listener.onRemove(position);
+            });
+        }
+    }
+    void updateSource(typename S::size_type index)
+    {
+        if (index >= m_sourceRows.size()) {
+            return;
+        }
+        const V *value {m_sourceRows[index]};
+        typename S::size_type position {m_positions.position(value)};
+        bool ordered {(position == 0 || !m_compare(*value, *m_data[position - 1]))
+                      && (position + 1 == m_data.size() || !m_compare(*m_data[position + 1], *value))};
+        if (!ordered) {
+            m_data.erase(std::begin(m_data) + position);
+            m_positions.remove(position);
+            typename S::size_type toIndex {sortedPosition(value)};
+            m_data.insert(std::begin(m_data) + toIndex, value);
+            m_positions.insert(toIndex, value);
+
+            typename S::size_type newIndex {toIndex < position ? toIndex : toIndex + 1};
+            m_listenerRepository.notify([position, newIndex](Listener &listener) {
+                listener.onMove(position, newIndex);
+            });
+            position = toIndex;
+        }
+
+        m_listenerRepository.notify([position, value](Listener &listener) {
+            listener.onUpdate(position, *value);
+        });
+    }
+    void insertSorted(const V *value)
+    {
+        typename S::size_type position {sortedPosition(value)};
+        m_data.insert(std::begin(m_data) + position, value);
+        m_positions.insert(position, value);
+
+        std::vector<const V *> inserted {value};
+        m_listenerRepository.notify([position, &inserted](Listener &listener) {
+            listener.onInsert(position, inserted);
+        });
+    }
+    // Position after the rows that are not greater than value
+    typename S::size_type sortedPosition(const V *value) const
+    {
+        auto it = std::upper_bound(std::begin(m_data), std::end(m_data), value, PointerCompare(m_compare));
+        return it - std::begin(m_data);
+    }
+    typename SourceListener::Ptr m_listener;
+    IModel<V, S> *m_source {nullptr};
+    Compare m_compare {};
+    // Rows in the order of the source
+    S m_sourceRows {};
+    // Rows in sorted order
+    S m_data {};
+    PositionIndex<const V *> m_positions {};
+    ::microcore::core::ListenerRepository<Listener> m_listenerRepository {};
+};
+
+}}
+
+#endif // MICROCORE_DATA_SORTEDMODEL_H
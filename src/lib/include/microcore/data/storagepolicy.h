@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_DATA_STORAGEPOLICY_H
+#define MICROCORE_DATA_STORAGEPOLICY_H
+
+#include <microcore/data/flathashmap.h>
+#include <map>
+#include <QtCore/QtGlobal>
+
+namespace microcore { namespace data {
+
+// Storage policies select the container used by IndexedDataStore
+//
+// A policy provides a Container alias template, mapping keys to
+// values, and tells if references to the elements of the container
+// stay valid while other elements are inserted or erased. reserve()
+// prepares a container for a number of entries, if it supports it.
+
+// Ordered storage, using std::map
+class OrderedStorage
+{
+public:
+    template<class K, class T>
+    using Container = std::map<K, T>;
+    static const bool StableReferences = true;
+    template<class C>
+    static void reserve(C &container, std::size_t count)
+    {
+        Q_UNUSED(container)
+        Q_UNUSED(count)
+    }
+};
+
+// Hash storage, using FlatHashMap and std::hash
+//
+// Lookups are O(1), and entries are stored without a node allocation
+// per entry.
+class FlatHashStorage
+{
+public:
+    template<class K, class T>
+    using Container = FlatHashMap<K, T>;
+    static const bool StableReferences = false;
+    template<class C>
+    static void reserve(C &container, std::size_t count)
+    {
+        container.reserve(count);
+    }
+};
+
+}}
+
+#endif // MICROCORE_DATA_STORAGEPOLICY_H
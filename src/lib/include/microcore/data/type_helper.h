@@ -33,6 +33,7 @@
 #define TYPE_HELPER_H
 
 #include <type_traits>
+#include <utility>
 
 namespace microcore { namespace data {
 
@@ -42,6 +43,31 @@ using arg_const_reference = typename std::conditional<std::is_arithmetic<T>::val
 template<class T>
 using arg_rvalue_reference = typename std::conditional<std::is_arithmetic<T>::value || std::is_pointer<T>::value, T, T &&>::type;
 
+template<class T>
+class is_equality_comparable
+{
+private:
+    template<class U>
+    static auto test(int) -> decltype(std::declval<const U &>() == std::declval<const U &>(), std::true_type());
+    template<class U>
+    static std::false_type test(...);
+public:
+    static const bool value = decltype(test<T>(0))::value;
+};
+
+// If T loads its rows on demand, with canFetchMore() and fetchMore()
+template<class T>
+class is_fetchable
+{
+private:
+    template<class U>
+    static auto test(int) -> decltype(std::declval<const U &>().canFetchMore(), std::declval<U &>().fetchMore(), std::true_type());
+    template<class U>
+    static std::false_type test(...);
+public:
+    static const bool value = decltype(test<T>(0))::value;
+};
+
 }}
 
 #endif // TYPE_HELPER_H
@@ -43,6 +43,8 @@ public:
     explicit Error() = default;
     Error(std::string id, QString message, QByteArray data = QByteArray());
     DEFAULT_COPY_DEFAULT_MOVE(Error);
+    static Error cancelled();
+    static Error timeout();
     bool empty() const;
     std::string id() const;
     QString message() const;
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef MICROCORE_HTTP_HTTPCACHE_H
+#define MICROCORE_HTTP_HTTPCACHE_H
+
+#include <microcore/core/cachingjobfactory.h>
+#include <microcore/http/httprequest.h>
+#include <microcore/http/httptypes.h>
+
+namespace microcore { namespace core {
+
+/**
+ * @brief How HttpResult are cached
+ *
+ * The content of the device is read and stored, and each cache
+ * hit creates a new buffer over the stored content.
+ */
+template<>
+class CacheTraits<::microcore::http::HttpResult>
+{
+public:
+    using Stored = QByteArray;
+    static Stored store(::microcore::http::HttpResult &&result);
+    static ::microcore::http::HttpResult load(const Stored &stored);
+    static std::size_t size(const Stored &stored);
+};
+
+}}
+
+namespace microcore { namespace http {
+
+/**
+ * @brief A hash function for HttpRequest
+ *
+ * The type, the url, the raw headers and the posted data of the
+ * request are hashed.
+ */
+class HttpRequestHash
+{
+public:
+    std::size_t operator()(const HttpRequest &request) const;
+};
+
+/**
+ * @brief An equality function for HttpRequest
+ *
+ * Requests are equal if they have the same type and posted data, and
+ * if their QNetworkRequest, including headers and attributes, are
+ * equal.
+ */
+class HttpRequestEqual
+{
+public:
+    bool operator()(const HttpRequest &first, const HttpRequest &second) const;
+};
+
+using HttpCachingJobFactory = ::microcore::core::CachingJobFactory<HttpRequest, HttpResult, HttpError,
+                                                                   HttpRequestHash, HttpRequestEqual>;
+
+}}
+
+#endif // MICROCORE_HTTP_HTTPCACHE_H
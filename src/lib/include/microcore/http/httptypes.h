@@ -33,6 +33,7 @@
 #define MICROCORE_HTTP_HTTPTYPES_H
 
 #include <microcore/core/ijob.h>
+#include <microcore/core/instrumentation.h>
 #include <microcore/qt/qobjectptr.h>
 #include <microcore/error/error.h>
 #include <QIODevice>
@@ -45,4 +46,18 @@ using HttpJob = ::microcore::core::IJob<HttpResult, HttpError>;
 
 }}
 
+namespace microcore { namespace core {
+
+template<>
+class ResultSize< ::microcore::http::HttpResult>
+{
+public:
+    static std::uint64_t size(const ::microcore::http::HttpResult &result)
+    {
+        return result ? static_cast<std::uint64_t>(result->bytesAvailable()) : 0;
+    }
+};
+
+}}
+
 #endif // MICROCORE_HTTP_HTTPTYPES_H
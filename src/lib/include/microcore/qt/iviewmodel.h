@@ -50,6 +50,9 @@ public:
     virtual QObject * controller() const = 0;
     virtual void setController(QObject *controller) = 0;
     virtual int count() const = 0;
+    // Views report their visible rows, so that models loaded on
+    // demand can load the next rows in advance
+    Q_INVOKABLE virtual void setVisibleRow(int row) = 0;
 Q_SIGNALS:
     void controllerChanged();
     void countChanged();
@@ -35,9 +35,12 @@
 #include <microcore/core/globals.h>
 #include <QtCore/QObject>
 #include <QtQml/QQmlParserStatus>
+#include <microcore/core/callback.h>
 #include <microcore/core/executor.h>
 #include <microcore/error/error.h>
+#include <deque>
 #include <set>
+#include <type_traits>
 
 namespace microcore { namespace qt {
 
@@ -48,7 +51,10 @@ class ViewController
     Q_INTERFACES(QQmlParserStatus)
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
     Q_PROPERTY(QString errorMessage READ errorMessage NOTIFY errorMessageChanged)
+    Q_PROPERTY(StartPolicy startPolicy READ startPolicy WRITE setStartPolicy NOTIFY startPolicyChanged)
+    Q_PROPERTY(int queueLimit READ queueLimit WRITE setQueueLimit NOTIFY queueLimitChanged)
     Q_ENUMS(Status)
+    Q_ENUMS(StartPolicy)
 public:
     enum Status
     {
@@ -56,14 +62,40 @@ public:
         Busy,
         Error
     };
+    // What start() does when the controller is busy. With Queue, at
+    // most queueLimit requests wait (0 for no limit), with LatestWins,
+    // the running request is cancelled and only the latest one waits.
+    enum StartPolicy
+    {
+        Reject,
+        Queue,
+        LatestWins
+    };
+    class StartMetrics
+    {
+    public:
+        int started {0};
+        int queued {0};
+        int coalesced {0}; // Waiting requests replaced by a newer one
+        int dropped {0}; // Requests rejected, or dropped by cancel()
+        int superseded {0}; // Running requests cancelled by a newer one
+    };
     DISABLE_COPY_DISABLE_MOVE(ViewController);
     void classBegin() override;
     void componentComplete() override;
     Status status() const;
     QString errorMessage() const;
+    StartPolicy startPolicy() const;
+    void setStartPolicy(StartPolicy startPolicy);
+    int queueLimit() const;
+    void setQueueLimit(int queueLimit);
+    const StartMetrics & startMetrics() const;
+    Q_INVOKABLE void cancel();
 Q_SIGNALS:
     void statusChanged();
     void errorMessageChanged();
+    void startPolicyChanged();
+    void queueLimitChanged();
     void finished();
     void error();
 protected:
@@ -74,18 +106,43 @@ protected:
     template<class Executor, class Request>
     bool start(Executor &executor, Request &&request)
     {
-        if (m_executors.find(&executor) == std::end(m_executors)) {
+        if (!hasExecutor(executor)) {
             return false;
         }
 
-        if (m_status == Busy) {
-            return false;
+        if (m_status != Busy && !m_startScheduled) {
+            ++m_startMetrics.started;
+            executor.start(std::move(request));
+            return true;
         }
 
-        executor.start(std::move(request));
-        return true;
+        using RequestType = typename std::decay<Request>::type;
+        return enqueue(PendingStart<Executor, RequestType>(executor, std::move(request)));
     }
 private:
+    // A request waiting for the controller
+    template<class Executor, class Request>
+    class PendingStart
+    {
+    public:
+        explicit PendingStart(Executor &executor, Request &&request)
+            : m_executor {&executor}, m_request {std::move(request)}
+        {
+        }
+        void operator()()
+        {
+            m_executor->start(std::move(m_request));
+        }
+    private:
+        Executor *m_executor {nullptr};
+        Request m_request;
+    };
+    bool hasExecutor(const ExecutorType &executor) const;
+    bool enqueue(::microcore::core::Callback<void ()> &&pendingStart);
+    // Waiting requests are started from the event loop, not while
+    // executors are notifying their listeners
+    void scheduleStartPending();
+    Q_SLOT void startPending();
     class ExecutorListener: public ::microcore::core::Executor< ::microcore::error::Error>::IListener
     {
     public:
@@ -101,6 +158,13 @@ private:
     void setStatus(Status status);
     Status m_status {Idle};
     QString m_errorMessage {};
+    StartPolicy m_startPolicy {Reject};
+    int m_queueLimit {0};
+    StartMetrics m_startMetrics {};
+    std::deque< ::microcore::core::Callback<void ()>> m_pending {};
+    bool m_superseding {false};
+    bool m_restarting {false};
+    bool m_startScheduled {false};
     std::set<std::shared_ptr<ExecutorType>> m_executors {};
     ExecutorListener::Ptr m_listener {};
 };
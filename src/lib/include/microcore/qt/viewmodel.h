@@ -36,6 +36,7 @@
 #include <microcore/qt/viewmodelcontroller.h>
 #include <microcore/qt/qobjectptr.h>
 #include <microcore/data/imodel.h>
+#include <microcore/data/type_helper.h>
 #include <deque>
 
 namespace microcore { namespace qt {
@@ -86,6 +87,28 @@ public:
     {
         return rowCount();
     }
+    // Models loaded on demand, like PagedModel, are fetched by the view
+    bool canFetchMore(const QModelIndex &parent) const override
+    {
+        if (parent.isValid() || m_controller == nullptr) {
+            return false;
+        }
+        return canFetchMore(m_controller->model(), Fetchable());
+    }
+    void fetchMore(const QModelIndex &parent) override
+    {
+        if (parent.isValid() || m_controller == nullptr) {
+            return;
+        }
+        fetchMore(m_controller->model(), Fetchable());
+    }
+    void setVisibleRow(int row) override
+    {
+        if (row < 0 || m_controller == nullptr) {
+            return;
+        }
+        setVisibleRow(m_controller->model(), static_cast<std::size_t>(row), Fetchable());
+    }
 protected:
     explicit ViewModel(QObject *parent = nullptr)
         : IViewModel(parent)
@@ -93,6 +116,29 @@ protected:
     }
     std::deque<QObjectPtr<ObjectType>> m_items {};
 private:
+    using Fetchable = std::integral_constant<bool, ::microcore::data::is_fetchable<Model>::value>;
+    static bool canFetchMore(const Model &model, std::true_type)
+    {
+        return model.canFetchMore();
+    }
+    static bool canFetchMore(const Model &, std::false_type)
+    {
+        return false;
+    }
+    static void fetchMore(Model &model, std::true_type)
+    {
+        model.fetchMore();
+    }
+    static void fetchMore(Model &, std::false_type)
+    {
+    }
+    static void setVisibleRow(Model &model, std::size_t row, std::true_type)
+    {
+        model.setVisibleRow(row);
+    }
+    static void setVisibleRow(Model &, std::size_t, std::false_type)
+    {
+    }
     void onAppend(const std::vector<const typename Model::Type *> &items) override final
     {
         beginInsertRows(QModelIndex(), rowCount(), rowCount() + items.size() - 1);
@@ -138,6 +184,33 @@ private:
     {
         performMove(from, to);
     }
+    // Ranges are sent as a single Qt signal
+    void onRemoveRange(std::size_t index, std::size_t count) override final
+    {
+        if (count == 0 || index + count > m_items.size()) {
+            return;
+        }
+
+        int first = static_cast<int>(index);
+        int last = static_cast<int>(index + count - 1);
+        beginRemoveRows(QModelIndex(), first, last);
+        m_items.erase(std::begin(m_items) + index, std::begin(m_items) + index + count);
+        Q_EMIT countChanged();
+        endRemoveRows();
+    }
+    void onUpdateRange(std::size_t index, const std::vector<const typename Model::Type *> &items) override final
+    {
+        if (items.empty() || index + items.size() > m_items.size()) {
+            return;
+        }
+
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            m_items[index + i]->update(*items[i]);
+        }
+        int first = static_cast<int>(index);
+        int last = static_cast<int>(index + items.size() - 1);
+        Q_EMIT dataChanged(this->index(first), this->index(last));
+    }
     void onInvalidation() override final
     {
         if (m_controller != nullptr) {
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <microcore/core/cancellationtoken.h>
+#include <microcore/core/listenerrepository.h>
+#include <microcore/qt/qobjectptr.h>
+#include <QTimer>
+
+namespace microcore { namespace core {
+
+class CancellationToken::Data
+{
+public:
+    explicit Data() = default;
+    DISABLE_COPY_DISABLE_MOVE(Data);
+    void finish(State state)
+    {
+        if (m_state != State::Active) {
+            return;
+        }
+        m_state = state;
+        if (m_timer) {
+            m_timer->stop();
+        }
+
+        m_listenerRepository.notify([state](IListener &listener) {
+            listener.onCancel(state);
+        });
+    }
+    State m_state {State::Active};
+    // The timer is deleted with deleteLater, as the last reference
+    // to the token might be released when it times out
+    qt::QObjectPtr<QTimer> m_timer {};
+    ListenerRepository<IListener> m_listenerRepository {};
+};
+
+CancellationToken::CancellationToken(std::shared_ptr<Data> data)
+    : m_data {std::move(data)}
+{
+}
+
+CancellationToken CancellationToken::create()
+{
+    return CancellationToken(std::make_shared<Data>());
+}
+
+bool CancellationToken::isValid() const
+{
+    return static_cast<bool>(m_data);
+}
+
+CancellationToken::State CancellationToken::state() const
+{
+    return m_data ? m_data->m_state : State::Active;
+}
+
+bool CancellationToken::isCancelled() const
+{
+    return state() != State::Active;
+}
+
+void CancellationToken::cancel()
+{
+    if (!m_data) {
+        return;
+    }
+    // Listeners might release the last reference to this token
+    std::shared_ptr<Data> data {m_data};
+    data->finish(State::Cancelled);
+}
+
+void CancellationToken::setDeadline(int msecs)
+{
+    if (!m_data || m_data->m_state != State::Active) {
+        return;
+    }
+
+    if (!m_data->m_timer) {
+        std::weak_ptr<Data> weakData {m_data};
+        m_data->m_timer.reset(new QTimer());
+        m_data->m_timer->setSingleShot(true);
+        QObject::connect(m_data->m_timer.get(), &QTimer::timeout, [weakData]() {
+            std::shared_ptr<Data> data {weakData.lock()};
+            if (data) {
+                data->finish(State::TimedOut);
+            }
+        });
+    }
+    m_data->m_timer->start(msecs);
+}
+
+void CancellationToken::addListener(const IListener::Ptr &listener)
+{
+    if (!m_data || !listener) {
+        return;
+    }
+
+    m_data->m_listenerRepository.addListener(listener);
+    if (m_data->m_state != State::Active) {
+        listener->onCancel(m_data->m_state);
+    }
+}
+
+void CancellationToken::removeListener(const IListener::Ptr &listener)
+{
+    if (!m_data) {
+        return;
+    }
+    m_data->m_listenerRepository.removeListener(listener);
+}
+
+}}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <microcore/core/instrumentation.h>
+#include <cmath>
+#include <cstdio>
+#include <QDebug>
+#include <QTimer>
+
+namespace microcore { namespace core {
+
+// Values below 4 have their own bucket, and each power of two
+// above is split in 4 buckets, using the 2 bits after the highest one.
+std::size_t Histogram::bucket(std::uint64_t value)
+{
+    if (value < 4) {
+        return static_cast<std::size_t>(value);
+    }
+    std::size_t exponent {0};
+    for (std::uint64_t remaining = value; remaining > 1; remaining >>= 1) {
+        ++exponent;
+    }
+    std::size_t sub {static_cast<std::size_t>((value >> (exponent - 2)) & 3)};
+    return 4 + (exponent - 2) * 4 + sub;
+}
+
+// Middle of the bucket
+std::uint64_t Histogram::bucketValue(std::size_t bucket)
+{
+    if (bucket < 4) {
+        return bucket;
+    }
+    std::size_t exponent {(bucket - 4) / 4 + 2};
+    std::uint64_t sub {(bucket - 4) % 4};
+    std::uint64_t width {static_cast<std::uint64_t>(1) << (exponent - 2)};
+    std::uint64_t lower {(static_cast<std::uint64_t>(1) << exponent) + sub * width};
+    return lower + width / 2;
+}
+
+void Histogram::record(std::uint64_t value)
+{
+    m_buckets[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    std::uint64_t max {m_max.load(std::memory_order_relaxed)};
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+std::uint64_t Histogram::count() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::sum() const
+{
+    return m_sum.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::max() const
+{
+    return m_max.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::percentile(double percentile) const
+{
+    // Buckets are read one by one, so the total is computed from them
+    // rather than from m_count, that might be updated concurrently
+    std::array<std::uint64_t, BucketCount> buckets {};
+    std::uint64_t total {0};
+    for (std::size_t i = 0; i < BucketCount; ++i) {
+        buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    std::uint64_t rank {static_cast<std::uint64_t>(std::ceil(percentile / 100. * total))};
+    rank = std::max<std::uint64_t>(rank, 1);
+    std::uint64_t seen {0};
+    for (std::size_t i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucketValue(i), max());
+        }
+    }
+    return max();
+}
+
+void Histogram::reset()
+{
+    for (std::atomic<std::uint64_t> &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+static StageStatistics::Percentiles percentiles(const Histogram &histogram)
+{
+    StageStatistics::Percentiles result {};
+    result.p50 = histogram.percentile(50);
+    result.p95 = histogram.percentile(95);
+    result.p99 = histogram.percentile(99);
+    result.max = histogram.max();
+    return result;
+}
+
+StageStatistics::StageStatistics(const std::string &name)
+    : m_name {name}
+{
+}
+
+const std::string & StageStatistics::name() const
+{
+    return m_name;
+}
+
+StageStatistics::Summary StageStatistics::summary() const
+{
+    Summary summary {};
+    summary.name = m_name;
+    summary.results = results.load(std::memory_order_relaxed);
+    summary.errors = errors.load(std::memory_order_relaxed);
+    summary.queueTime = percentiles(queueTime);
+    summary.executeTime = percentiles(executeTime);
+    summary.resultSize = percentiles(resultSize);
+    return summary;
+}
+
+void StageStatistics::reset()
+{
+    queueTime.reset();
+    executeTime.reset();
+    resultSize.reset();
+    results.store(0, std::memory_order_relaxed);
+    errors.store(0, std::memory_order_relaxed);
+}
+
+Instrumentation::Instrumentation()
+{
+}
+
+Instrumentation::~Instrumentation()
+{
+}
+
+Instrumentation & Instrumentation::global()
+{
+    static Instrumentation instrumentation {};
+    return instrumentation;
+}
+
+StageStatistics & Instrumentation::stage(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    std::unique_ptr<StageStatistics> &stage (m_stages[name]);
+    if (!stage) {
+        stage.reset(new StageStatistics(name));
+    }
+    return *stage;
+}
+
+std::vector<StageStatistics::Summary> Instrumentation::summaries() const
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    std::vector<StageStatistics::Summary> summaries {};
+    for (const auto &stage : m_stages) {
+        summaries.push_back(stage.second->summary());
+    }
+    return summaries;
+}
+
+static std::string formatPercentiles(const char *name, const StageStatistics::Percentiles &percentiles, const char *unit)
+{
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), " %s p50=%llu%s p95=%llu%s p99=%llu%s max=%llu%s", name,
+                  static_cast<unsigned long long>(percentiles.p50), unit,
+                  static_cast<unsigned long long>(percentiles.p95), unit,
+                  static_cast<unsigned long long>(percentiles.p99), unit,
+                  static_cast<unsigned long long>(percentiles.max), unit);
+    return buffer;
+}
+
+std::string Instrumentation::dump() const
+{
+    std::string dump {};
+    for (const StageStatistics::Summary &summary : summaries()) {
+        dump += summary.name;
+        dump += " results=" + std::to_string(summary.results);
+        dump += " errors=" + std::to_string(summary.errors);
+        dump += formatPercentiles("queue", summary.queueTime, "us");
+        dump += formatPercentiles("execute", summary.executeTime, "us");
+        dump += formatPercentiles("size", summary.resultSize, "B");
+        dump += "\n";
+    }
+    return dump;
+}
+
+void Instrumentation::reset()
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    for (const auto &stage : m_stages) {
+        stage.second->reset();
+    }
+}
+
+void Instrumentation::startDump(int msecs, Callback<void (const std::string &)> &&output)
+{
+    m_output = std::move(output);
+    if (!m_output) {
+        m_output = [](const std::string &dump) {
+            qDebug().noquote() << QString::fromStdString(dump);
+        };
+    }
+    if (!m_timer) {
+        m_timer.reset(new QTimer());
+        QObject::connect(m_timer.get(), &QTimer::timeout, [this]() {
+            m_output(dump());
+        });
+    }
+    m_timer->start(msecs);
+}
+
+void Instrumentation::stopDump()
+{
+    if (m_timer) {
+        m_timer->stop();
+    }
+}
+
+}}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <microcore/core/notificationbatch.h>
+#include <algorithm>
+
+namespace microcore { namespace core {
+
+static thread_local NotificationBatch *currentBatch {nullptr};
+
+NotificationBatch::NotificationBatch()
+    : m_outer {currentBatch}
+{
+    if (m_outer == nullptr) {
+        currentBatch = this;
+    }
+}
+
+NotificationBatch::~NotificationBatch()
+{
+    if (m_outer != nullptr) {
+        return;
+    }
+    flush();
+    currentBatch = nullptr;
+}
+
+NotificationBatch * NotificationBatch::active()
+{
+    if (currentBatch == nullptr || currentBatch->m_flushing) {
+        return nullptr;
+    }
+    return currentBatch;
+}
+
+std::size_t NotificationBatch::pendingCount() const
+{
+    const NotificationBatch &batch {m_outer != nullptr ? *m_outer : *this};
+    return static_cast<std::size_t>(std::count_if(std::begin(batch.m_entries), std::end(batch.m_entries), [](const Entry &entry) {
+        return static_cast<bool>(entry.function);
+    }));
+}
+
+std::size_t NotificationBatch::coalescedCount() const
+{
+    return m_outer != nullptr ? m_outer->m_coalescedCount : m_coalescedCount;
+}
+
+void NotificationBatch::flush()
+{
+    NotificationBatch &batch {m_outer != nullptr ? *m_outer : *this};
+    if (batch.m_flushing) {
+        return;
+    }
+
+    // Entries might be discarded while flushing, so
+    // they are kept until all of them are sent
+    batch.m_flushing = true;
+    batch.m_candidates.clear();
+    batch.m_keys.clear();
+    for (std::size_t i = 0; i < batch.m_entries.size(); ++i) {
+        Callback<void ()> function {std::move(batch.m_entries[i].function)};
+        if (function) {
+            function();
+        }
+    }
+    batch.m_entries.clear();
+    batch.m_flushing = false;
+}
+
+void NotificationBatch::post(const void *source, Callback<void ()> &&function)
+{
+    removeCandidates(source);
+    m_entries.emplace_back(source, std::move(function));
+}
+
+void NotificationBatch::discard(const void *source)
+{
+    NotificationBatch *batch {currentBatch};
+    if (batch == nullptr) {
+        return;
+    }
+    for (Entry &entry : batch->m_entries) {
+        if (entry.source == source) {
+            entry.function = Callback<void ()>();
+        }
+    }
+    batch->removeCandidates(source);
+}
+
+void NotificationBatch::removeCandidates(const void *source)
+{
+    for (auto it = std::begin(m_candidates); it != std::end(m_candidates);) {
+        if ((*it)->source == source) {
+            it = m_candidates.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+}}
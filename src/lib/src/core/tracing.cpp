@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <microcore/core/tracing.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace microcore { namespace core {
+
+// Small thread ids are easier to read in a trace
+static std::uint32_t currentThread()
+{
+    static std::atomic<std::uint32_t> nextThread {1};
+    static thread_local std::uint32_t thread {nextThread++};
+    return thread;
+}
+
+// Append a JSON string, escaping quotes, backslashes and control characters
+static void appendString(std::string &json, const char *value)
+{
+    json += '"';
+    for (const char *c = value != nullptr ? value : ""; *c != '\0'; ++c) {
+        switch (*c) {
+        case '"':
+            json += "\\\"";
+            break;
+        case '\\':
+            json += "\\\\";
+            break;
+        default:
+            if (static_cast<unsigned char>(*c) < 0x20) {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned int>(*c));
+                json += buffer;
+            } else {
+                json += *c;
+            }
+            break;
+        }
+    }
+    json += '"';
+}
+
+Tracer::Tracer()
+{
+}
+
+Tracer & Tracer::global()
+{
+    static Tracer tracer {};
+    return tracer;
+}
+
+void Tracer::start()
+{
+    m_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop()
+{
+    m_enabled.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::clear()
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    m_events.clear();
+    m_next = 0;
+    m_dropped = 0;
+}
+
+std::size_t Tracer::eventCount() const
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    return m_events.size();
+}
+
+std::size_t Tracer::capacity() const
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    return m_capacity;
+}
+
+void Tracer::setCapacity(std::size_t capacity)
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    linearize();
+    if (capacity > 0 && m_events.size() > capacity) {
+        std::size_t dropped {m_events.size() - capacity};
+        m_events.erase(std::begin(m_events), std::begin(m_events) + static_cast<std::ptrdiff_t>(dropped));
+        m_events.shrink_to_fit();
+        m_dropped += dropped;
+    }
+    m_capacity = capacity;
+}
+
+std::size_t Tracer::droppedCount() const
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    return m_dropped;
+}
+
+std::uint64_t Tracer::createFlow()
+{
+    if (!isEnabled()) {
+        return 0;
+    }
+    return m_nextFlow.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Tracer::complete(const char *name, const char *category, Clock::time_point start)
+{
+    Event event {};
+    event.phase = 'X';
+    event.name = name;
+    event.category = category;
+    event.timestamp = timestamp(start);
+    event.duration = timestamp(Clock::now()) - event.timestamp;
+    record(std::move(event));
+}
+
+void Tracer::flow(char phase, const char *category, std::uint64_t flow)
+{
+    Event event {};
+    event.phase = phase;
+    event.name = "request";
+    event.category = category;
+    event.timestamp = timestamp(Clock::now());
+    event.id = flow;
+    record(std::move(event));
+}
+
+void Tracer::asyncBegin(const char *name, const char *category, std::uint64_t id)
+{
+    Event event {};
+    event.phase = 'b';
+    event.name = name;
+    event.category = category;
+    event.timestamp = timestamp(Clock::now());
+    event.id = id;
+    record(std::move(event));
+}
+
+void Tracer::asyncEnd(const char *name, const char *category, std::uint64_t id)
+{
+    Event event {};
+    event.phase = 'e';
+    event.name = name;
+    event.category = category;
+    event.timestamp = timestamp(Clock::now());
+    event.id = id;
+    record(std::move(event));
+}
+
+std::string Tracer::toJson() const
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    std::string json {"{\"traceEvents\":["};
+    // Names and categories are appended directly, as they are not
+    // bounded, and only numbers are formatted in the buffer
+    char buffer[128];
+    bool first {true};
+    for (std::size_t i = 0; i < m_events.size(); ++i) {
+        const Event &event (m_events[(m_next + i) % m_events.size()]);
+        json += first ? "\n{\"name\":" : ",\n{\"name\":";
+        appendString(json, event.name);
+        json += ",\"cat\":";
+        appendString(json, event.category);
+        int size {std::snprintf(buffer, sizeof(buffer), ",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%u",
+                                event.phase, static_cast<unsigned long long>(event.timestamp), event.thread)};
+        json.append(buffer, static_cast<std::size_t>(size));
+        switch (event.phase) {
+        case 'X':
+            size = std::snprintf(buffer, sizeof(buffer), ",\"dur\":%llu}", static_cast<unsigned long long>(event.duration));
+            break;
+        case 'f':
+            size = std::snprintf(buffer, sizeof(buffer), ",\"id\":%llu,\"bp\":\"e\"}", static_cast<unsigned long long>(event.id));
+            break;
+        default:
+            size = std::snprintf(buffer, sizeof(buffer), ",\"id\":%llu}", static_cast<unsigned long long>(event.id));
+            break;
+        }
+        json.append(buffer, static_cast<std::size_t>(size));
+        first = false;
+    }
+    json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return json;
+}
+
+bool Tracer::save(const std::string &path) const
+{
+    std::ofstream file {path, std::ios::out | std::ios::trunc};
+    if (!file) {
+        return false;
+    }
+    file << toJson();
+    return static_cast<bool>(file);
+}
+
+std::uint64_t Tracer::timestamp(Clock::time_point time) const
+{
+    using namespace std::chrono;
+    return static_cast<std::uint64_t>(duration_cast<microseconds>(time - m_origin).count());
+}
+
+void Tracer::record(Event &&event)
+{
+    event.thread = currentThread();
+    std::lock_guard<std::mutex> lock {m_mutex};
+    if (m_capacity == 0 || m_events.size() < m_capacity) {
+        m_events.push_back(std::move(event));
+        return;
+    }
+    m_events[m_next] = std::move(event);
+    m_next = (m_next + 1) % m_events.size();
+    ++m_dropped;
+}
+
+// Move the oldest event first, so that the buffer can be resized
+void Tracer::linearize()
+{
+    std::rotate(std::begin(m_events), std::begin(m_events) + static_cast<std::ptrdiff_t>(m_next), std::end(m_events));
+    m_next = 0;
+}
+
+}}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <microcore/data/journal.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace microcore { namespace data {
+
+namespace {
+
+const char Magic[4] {'M', 'C', 'J', 'N'};
+
+class Header
+{
+public:
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t format;
+    std::uint32_t reserved;
+};
+
+bool writeAll(int fd, const char *data, std::size_t size)
+{
+    while (size > 0) {
+        ssize_t written {::write(fd, data, size)};
+        if (written < 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+}
+
+JournalFile::~JournalFile()
+{
+    close();
+}
+
+bool JournalFile::read(const std::string &path, std::uint32_t format, std::string &records)
+{
+    records.clear();
+    int fd {::open(path.c_str(), O_RDONLY)};
+    if (fd < 0) {
+        return false;
+    }
+    Header header {};
+    bool valid {::read(fd, &header, sizeof(Header)) == static_cast<ssize_t>(sizeof(Header))
+                && std::memcmp(header.magic, Magic, sizeof(Magic)) == 0
+                && header.version == Version && header.format == format};
+    char buffer[64 * 1024];
+    ssize_t count {0};
+    while (valid && (count = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        records.append(buffer, static_cast<std::size_t>(count));
+    }
+    ::close(fd);
+    return valid && count == 0;
+}
+
+bool JournalFile::open(const std::string &path, std::uint32_t format, std::size_t size)
+{
+    close();
+    int fd {::open(path.c_str(), O_RDWR | O_CREAT, 0644)};
+    if (fd < 0) {
+        return false;
+    }
+    Header header {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.format = format;
+    off_t end {static_cast<off_t>(sizeof(Header) + size)};
+    if (::ftruncate(fd, end) != 0 || ::lseek(fd, 0, SEEK_SET) != 0
+        || !writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(Header))
+        || ::lseek(fd, end, SEEK_SET) != end || ::fsync(fd) != 0) {
+        ::close(fd);
+        return false;
+    }
+    m_fd = fd;
+    m_size = size;
+    return true;
+}
+
+void JournalFile::close()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_fd = -1;
+    m_size = 0;
+}
+
+bool JournalFile::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+bool JournalFile::append(const std::string &records)
+{
+    if (m_fd < 0) {
+        return false;
+    }
+    if (!writeAll(m_fd, records.data(), records.size()) || ::fdatasync(m_fd) != 0) {
+        // Partially written records are dropped
+        ::ftruncate(m_fd, static_cast<off_t>(sizeof(Header) + m_size));
+        ::lseek(m_fd, static_cast<off_t>(sizeof(Header) + m_size), SEEK_SET);
+        return false;
+    }
+    m_size += records.size();
+    return true;
+}
+
+std::size_t JournalFile::size() const
+{
+    return m_size;
+}
+
+}}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <microcore/data/snapshot.h>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace microcore { namespace data {
+
+namespace {
+
+const char Magic[4] {'M', 'C', 'S', 'N'};
+
+class Header
+{
+public:
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t format;
+    std::uint32_t reserved;
+    std::uint64_t indexSize;
+    std::uint64_t valuesSize;
+    std::uint64_t checksum;
+};
+
+const std::uint64_t Multiplier {0x9e3779b97f4a7c15ULL};
+
+std::uint64_t mix(std::uint64_t hash, std::uint64_t word)
+{
+    hash = (hash ^ word) * Multiplier;
+    return hash ^ (hash >> 32);
+}
+
+bool writeAll(std::FILE *file, const std::string &data)
+{
+    return data.empty() || std::fwrite(data.data(), data.size(), 1, file) == 1;
+}
+
+}
+
+SnapshotFile::~SnapshotFile()
+{
+    close();
+}
+
+bool SnapshotFile::open(const std::string &path, std::uint32_t format)
+{
+    close();
+    int fd {::open(path.c_str(), O_RDONLY)};
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status {};
+    if (::fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return false;
+    }
+    std::size_t mappingSize {static_cast<std::size_t>(status.st_size)};
+    void *mapping {::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0)};
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    m_mapping = mapping;
+    m_mappingSize = mappingSize;
+
+    // Only the index is read, values are checked when they are read
+    Header header {};
+    std::memcpy(&header, mapping, sizeof(Header));
+    const char *index {static_cast<const char *>(mapping) + sizeof(Header)};
+    std::size_t payloadSize {mappingSize - sizeof(Header)};
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version
+        || header.format != format || header.indexSize > payloadSize
+        || header.valuesSize != payloadSize - header.indexSize
+        || header.checksum != checksum(index, static_cast<std::size_t>(header.indexSize))) {
+        close();
+        return false;
+    }
+    m_index = index;
+    m_indexSize = static_cast<std::size_t>(header.indexSize);
+    m_values = index + m_indexSize;
+    m_valuesSize = static_cast<std::size_t>(header.valuesSize);
+    return true;
+}
+
+void SnapshotFile::close()
+{
+    if (m_mapping != nullptr) {
+        ::munmap(m_mapping, m_mappingSize);
+    }
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_index = nullptr;
+    m_indexSize = 0;
+    m_values = nullptr;
+    m_valuesSize = 0;
+}
+
+const char * SnapshotFile::index() const
+{
+    return m_index;
+}
+
+std::size_t SnapshotFile::indexSize() const
+{
+    return m_indexSize;
+}
+
+const char * SnapshotFile::values() const
+{
+    return m_values;
+}
+
+std::size_t SnapshotFile::valuesSize() const
+{
+    return m_valuesSize;
+}
+
+bool SnapshotFile::write(const std::string &path, std::uint32_t format, const SnapshotPayload &payload)
+{
+    Header header {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.format = format;
+    header.indexSize = payload.index.size();
+    header.valuesSize = payload.values.size();
+    header.checksum = checksum(payload.index.data(), payload.index.size());
+
+    std::string temporaryPath {path + ".tmp"};
+    std::FILE *file {std::fopen(temporaryPath.c_str(), "wb")};
+    if (file == nullptr) {
+        return false;
+    }
+    bool written {std::fwrite(&header, sizeof(Header), 1, file) == 1
+                  && writeAll(file, payload.index) && writeAll(file, payload.values)
+                  && std::fflush(file) == 0 && ::fsync(::fileno(file)) == 0};
+    if (std::fclose(file) != 0 || !written || std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t SnapshotFile::checksum(const char *data, std::size_t size)
+{
+    std::uint64_t hash {size};
+    std::size_t i {0};
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+        std::uint64_t word {0};
+        std::memcpy(&word, data + i, sizeof(std::uint64_t));
+        hash = mix(hash, word);
+    }
+    std::uint64_t tail {0};
+    std::memcpy(&tail, data + i, size - i);
+    return mix(hash, tail);
+}
+
+}}
@@ -38,6 +38,16 @@ Error::Error(std::string id, QString message, QByteArray data)
 {
 }
 
+Error Error::cancelled()
+{
+    return Error("cancelled", QLatin1String("The operation was cancelled"));
+}
+
+Error Error::timeout()
+{
+    return Error("timeout", QLatin1String("The operation timed out"));
+}
+
 bool Error::empty() const
 {
     return m_id.empty() && m_message.isEmpty() && m_data.isEmpty();
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <microcore/http/httpcache.h>
+#include <QBuffer>
+#include <QHash>
+
+namespace microcore { namespace core {
+
+using namespace ::microcore::http;
+
+QByteArray CacheTraits<HttpResult>::store(HttpResult &&result)
+{
+    return result ? result->readAll() : QByteArray();
+}
+
+HttpResult CacheTraits<HttpResult>::load(const QByteArray &stored)
+{
+    QBuffer *buffer {new QBuffer()};
+    buffer->setData(stored);
+    buffer->open(QIODevice::ReadOnly);
+    return HttpResult(buffer);
+}
+
+std::size_t CacheTraits<HttpResult>::size(const QByteArray &stored)
+{
+    return sizeof(QByteArray) + static_cast<std::size_t>(stored.size());
+}
+
+}}
+
+namespace microcore { namespace http {
+
+namespace {
+
+// Mix a 32 bits hash into a hash of the size of std::size_t
+void combine(std::size_t &hash, uint value)
+{
+    hash ^= static_cast<std::size_t>(value) + static_cast<std::size_t>(0x9e3779b97f4a7c15ULL)
+            + (hash << 6) + (hash >> 2);
+}
+
+}
+
+std::size_t HttpRequestHash::operator()(const HttpRequest &request) const
+{
+    const QNetworkRequest networkRequest {request.request()};
+    std::size_t hash {0};
+    combine(hash, qHash(static_cast<int>(request.type())));
+    combine(hash, qHash(networkRequest.url()));
+    for (const QByteArray &header : networkRequest.rawHeaderList()) {
+        combine(hash, qHash(header));
+        combine(hash, qHash(networkRequest.rawHeader(header)));
+    }
+    combine(hash, qHash(request.postData()));
+    return hash;
+}
+
+bool HttpRequestEqual::operator()(const HttpRequest &first, const HttpRequest &second) const
+{
+    return first.type() == second.type() && first.postData() == second.postData()
+            && first.request() == second.request();
+}
+
+}}
@@ -65,19 +65,36 @@ public:
 
         reply->setParent(nullptr);
         m_result.reset(reply);
+        m_onResult = std::move(onResult);
+        m_onError = std::move(onError);
 
-        QObject::connect(reply, &QNetworkReply::finished, [this, reply, onResult, onError]() {
+        m_connection = QObject::connect(reply, &QNetworkReply::finished, [this, reply]() {
             if (reply->error() != QNetworkReply::NoError) {
-                onError(Error("http", reply->errorString(), reply->readAll()));
+                m_onError(Error("http", reply->errorString(), reply->readAll()));
             } else {
-                onResult(std::move(m_result));
+                m_onResult(std::move(m_result));
             }
         });
     }
+    void cancel() override
+    {
+        if (!m_result) {
+            return;
+        }
+
+        // Abort the reply right away, to release the socket and the buffers
+        QObject::disconnect(m_connection);
+        QNetworkReply *reply {static_cast<QNetworkReply *>(m_result.get())};
+        reply->abort();
+        m_result.reset();
+    }
 private:
     QNetworkAccessManager &m_network;
     HttpRequest m_request {};
     HttpResult m_result {};
+    OnResult m_onResult {};
+    OnError m_onError {};
+    QMetaObject::Connection m_connection {};
 };
 
 HttpRequestFactory::HttpRequestFactory(QNetworkAccessManager &network)
@@ -56,6 +56,46 @@ QString ViewController::errorMessage() const
     return m_errorMessage;
 }
 
+ViewController::StartPolicy ViewController::startPolicy() const
+{
+    return m_startPolicy;
+}
+
+void ViewController::setStartPolicy(StartPolicy startPolicy)
+{
+    if (m_startPolicy != startPolicy) {
+        m_startPolicy = startPolicy;
+        Q_EMIT startPolicyChanged();
+    }
+}
+
+int ViewController::queueLimit() const
+{
+    return m_queueLimit;
+}
+
+void ViewController::setQueueLimit(int queueLimit)
+{
+    if (m_queueLimit != queueLimit) {
+        m_queueLimit = queueLimit;
+        Q_EMIT queueLimitChanged();
+    }
+}
+
+const ViewController::StartMetrics & ViewController::startMetrics() const
+{
+    return m_startMetrics;
+}
+
+void ViewController::cancel()
+{
+    m_startMetrics.dropped += static_cast<int>(m_pending.size());
+    m_pending.clear();
+    for (const std::shared_ptr<ExecutorType> &executor : m_executors) {
+        executor->cancel();
+    }
+}
+
 ViewController::ExecutorType & ViewController::addExecutor(std::shared_ptr<ExecutorType> executor)
 {
     Q_ASSERT(executor);
@@ -65,6 +105,76 @@ ViewController::ExecutorType & ViewController::addExecutor(std::shared_ptr<Execu
     return *executor;
 }
 
+bool ViewController::hasExecutor(const ExecutorType &executor) const
+{
+    for (const std::shared_ptr<ExecutorType> &registered : m_executors) {
+        if (registered.get() == &executor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ViewController::enqueue(core::Callback<void ()> &&pendingStart)
+{
+    switch (m_startPolicy) {
+    case Queue:
+        if (m_queueLimit > 0 && static_cast<int>(m_pending.size()) >= m_queueLimit) {
+            ++m_startMetrics.dropped;
+            return false;
+        }
+        ++m_startMetrics.queued;
+        m_pending.push_back(std::move(pendingStart));
+        return true;
+    case LatestWins:
+        m_startMetrics.coalesced += static_cast<int>(m_pending.size());
+        m_pending.clear();
+        ++m_startMetrics.queued;
+        m_pending.push_back(std::move(pendingStart));
+        if (!m_superseding) {
+            m_superseding = true;
+            ++m_startMetrics.superseded;
+            for (const std::shared_ptr<ExecutorType> &executor : m_executors) {
+                executor->cancel();
+            }
+        }
+        return true;
+    default:
+        ++m_startMetrics.dropped;
+        return false;
+    }
+}
+
+void ViewController::scheduleStartPending()
+{
+    if (m_pending.empty()) {
+        m_superseding = false;
+        return;
+    }
+    if (!m_startScheduled) {
+        m_startScheduled = true;
+        QMetaObject::invokeMethod(this, "startPending", Qt::QueuedConnection);
+    }
+}
+
+void ViewController::startPending()
+{
+    m_startScheduled = false;
+    m_superseding = false;
+    if (!m_pending.empty() && (m_status != Busy || m_restarting)) {
+        core::Callback<void ()> pendingStart {std::move(m_pending.front())};
+        m_pending.pop_front();
+        ++m_startMetrics.started;
+        pendingStart();
+    }
+
+    // The superseded request was not replaced, eg. after cancel()
+    if (m_restarting) {
+        m_restarting = false;
+        setStatus(Idle);
+    }
+}
+
 void ViewController::setStatus(ViewController::Status status)
 {
     if (m_status != status) {
@@ -80,6 +190,10 @@ ViewController::ExecutorListener::ExecutorListener(ViewController &parent)
 
 void ViewController::ExecutorListener::onStart()
 {
+    if (m_parent.m_restarting) {
+        m_parent.m_restarting = false;
+        return;
+    }
     Q_ASSERT(m_parent.m_status != Busy);
     m_parent.setStatus(Busy);
 }
@@ -89,17 +203,27 @@ void ViewController::ExecutorListener::onFinish()
     Q_ASSERT(m_parent.m_status == Busy);
     m_parent.setStatus(Idle);
     Q_EMIT m_parent.finished();
+    m_parent.scheduleStartPending();
 }
 
 void ViewController::ExecutorListener::onError(const ViewController::ErrorType &errorValue)
 {
     Q_ASSERT(m_parent.m_status == Busy);
+    if (m_parent.m_superseding && !m_parent.m_pending.empty() && errorValue.id() == ErrorType::cancelled().id()) {
+        // The request was superseded by a newer one, that is started
+        // next, so the status stays Busy
+        m_parent.m_restarting = true;
+        m_parent.scheduleStartPending();
+        return;
+    }
+
     m_parent.setStatus(Error);
     if (m_parent.m_errorMessage != errorValue.message()) {
         m_parent.m_errorMessage = errorValue.message();
         Q_EMIT m_parent.errorMessageChanged();
     }
     Q_EMIT m_parent.error();
+    m_parent.scheduleStartPending();
 }
 
 void ViewController::ExecutorListener::onInvalidation()
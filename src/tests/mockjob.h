@@ -46,8 +46,8 @@ public:
     {
         executeImpl(onResult, onError);
     }
-    MOCK_METHOD2_T(executeImpl, void (typename IJob<Result, Error>::OnResult onResult,
-                                      typename IJob<Result, Error>::OnError onError));
+    MOCK_METHOD2_T(executeImpl, void (typename IJob<Result, Error>::OnResult &onResult,
+                                      typename IJob<Result, Error>::OnError &onError));
 
 };
 
@@ -48,6 +48,8 @@ public:
     MOCK_METHOD2_T(onUpdate, void (std::size_t index, const V &value));
     MOCK_METHOD2_T(onMove, void (std::size_t oldIndex, std::size_t newIndex));
     MOCK_METHOD0_T(onInvalidation, void ());
+    MOCK_METHOD2_T(onRemoveRange, void (std::size_t index, std::size_t count));
+    MOCK_METHOD2_T(onUpdateRange, void (std::size_t index, const std::vector<const V *> &values));
 };
 
 }}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/data/btreesequence.h>
+#include <microcore/data/indexeddatastore.h>
+#include <microcore/data/indexedmodel.h>
+#include <algorithm>
+#include <deque>
+#include <random>
+
+using namespace ::testing;
+using namespace ::microcore::data;
+
+namespace {
+
+// Small capacities, to split and merge often
+using SmallSequence = BTreeSequence<int, 4, 4>;
+
+template<class S>
+void expectEqual(const S &sequence, const std::deque<int> &reference)
+{
+    ASSERT_EQ(sequence.size(), reference.size());
+    EXPECT_TRUE(std::equal(std::begin(sequence), std::end(sequence), std::begin(reference)));
+    for (std::size_t i = 0; i < reference.size(); ++i) {
+        ASSERT_EQ(sequence[i], reference[i]);
+        ASSERT_EQ(*(std::begin(sequence) + i), reference[i]);
+    }
+    std::size_t i = reference.size();
+    for (auto it = std::end(sequence); it != std::begin(sequence);) {
+        --it;
+        --i;
+        ASSERT_EQ(*it, reference[i]);
+    }
+}
+
+class IdentityMapper
+{
+public:
+    using KeyType = int;
+    int operator()(int value) const
+    {
+        return value;
+    }
+};
+
+}
+
+TEST(TstBTreeSequence, Empty)
+{
+    BTreeSequence<int> sequence {};
+    EXPECT_TRUE(sequence.empty());
+    EXPECT_EQ(sequence.size(), static_cast<std::size_t>(0));
+    EXPECT_TRUE(std::begin(sequence) == std::end(sequence));
+}
+
+TEST(TstBTreeSequence, InsertErase)
+{
+    SmallSequence sequence {};
+    std::deque<int> reference {};
+    for (int i = 0; i < 100; ++i) {
+        sequence.push_back(i);
+        reference.push_back(i);
+    }
+    expectEqual(sequence, reference);
+
+    std::vector<int> values {-1, -2, -3};
+    auto it = sequence.insert(std::begin(sequence) + 50, std::begin(values), std::end(values));
+    reference.insert(std::begin(reference) + 50, std::begin(values), std::end(values));
+    EXPECT_EQ(it - std::begin(sequence), 50);
+    EXPECT_EQ(*it, -1);
+    expectEqual(sequence, reference);
+
+    it = sequence.erase(std::begin(sequence) + 10, std::begin(sequence) + 60);
+    reference.erase(std::begin(reference) + 10, std::begin(reference) + 60);
+    EXPECT_EQ(*it, reference[10]);
+    expectEqual(sequence, reference);
+
+    while (!sequence.empty()) {
+        sequence.erase(std::begin(sequence));
+    }
+    EXPECT_TRUE(std::begin(sequence) == std::end(sequence));
+}
+
+TEST(TstBTreeSequence, Move)
+{
+    SmallSequence sequence {};
+    for (int i = 0; i < 10; ++i) {
+        sequence.push_back(i);
+    }
+    SmallSequence moved {std::move(sequence)};
+    EXPECT_TRUE(sequence.empty());
+    EXPECT_EQ(moved.size(), static_cast<std::size_t>(10));
+    EXPECT_EQ(moved.back(), 9);
+}
+
+// Compare with a deque, on random operations
+TEST(TstBTreeSequence, Random)
+{
+    SmallSequence sequence {};
+    std::deque<int> reference {};
+    std::mt19937 generator {1};
+    int nextValue {0};
+    for (int i = 0; i < 5000; ++i) {
+        int operation = generator() % 4;
+        if (operation <= 1 || reference.empty()) {
+            std::size_t position = generator() % (reference.size() + 1);
+            std::vector<int> values {};
+            int count = generator() % 5 + 1;
+            for (int j = 0; j < count; ++j) {
+                values.push_back(nextValue++);
+            }
+            sequence.insert(std::begin(sequence) + position, std::begin(values), std::end(values));
+            reference.insert(std::begin(reference) + position, std::begin(values), std::end(values));
+        } else if (operation == 2) {
+            std::size_t position = generator() % reference.size();
+            sequence.erase(std::begin(sequence) + position);
+            reference.erase(std::begin(reference) + position);
+        } else {
+            std::size_t position = generator() % reference.size();
+            sequence[position] = -sequence[position];
+            reference[position] = -reference[position];
+        }
+        if (i % 100 == 0) {
+            expectEqual(sequence, reference);
+        }
+    }
+    expectEqual(sequence, reference);
+}
+
+TEST(TstBTreeSequence, Model)
+{
+    IndexedDataStore<int, int> store {};
+    IndexedModel<int, IdentityMapper, BTreeSequence<const int *, 4, 4>> model {store};
+    std::vector<int> values {};
+    for (int i = 0; i < 20; ++i) {
+        values.push_back(i);
+    }
+    model.append(std::move(values));
+    model.insert(5, {100, 101});
+    model.move(0, 22);
+    model.remove(3);
+    store.remove(10);
+
+    std::deque<int> reference {};
+    std::transform(std::begin(model), std::end(model), std::back_inserter(reference), [](const int *value) {
+        return *value;
+    });
+    std::deque<int> expected {1, 2, 3, 100, 101, 5, 6, 7, 8, 9, 11, 12, 13, 14, 15, 16, 17, 18, 19, 0};
+    EXPECT_EQ(reference, expected);
+    EXPECT_EQ(*model[3], 100);
+}
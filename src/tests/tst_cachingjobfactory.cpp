@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/core/cachingjobfactory.h>
+#include <map>
+#include <string>
+#include <thread>
+
+using namespace ::testing;
+using namespace ::microcore::core;
+
+namespace {
+
+class Error
+{
+public:
+    explicit Error(int v) : value {v} {}
+    int value {0};
+};
+
+// Jobs are finished from the test
+class DeferredJobFactory final : public IJobFactory<int, std::string, Error>
+{
+public:
+    std::unique_ptr<IJob<std::string, Error>> create(int &&request) const override
+    {
+        DeferredJobFactory &factory {const_cast<DeferredJobFactory &>(*this)};
+        ++factory.m_created;
+        return std::unique_ptr<IJob<std::string, Error>>(new Job(factory, request));
+    }
+    int created() const
+    {
+        return m_created;
+    }
+    const std::vector<int> & cancelled() const
+    {
+        return m_cancelled;
+    }
+    void finish(int value, const std::string &result)
+    {
+        auto it = m_running.find(value);
+        ASSERT_FALSE(it == std::end(m_running));
+        IJob<std::string, Error>::OnResult onResult {std::move(it->second.first)};
+        m_running.erase(it);
+        onResult(std::string(result));
+    }
+    void fail(int value)
+    {
+        auto it = m_running.find(value);
+        ASSERT_FALSE(it == std::end(m_running));
+        IJob<std::string, Error>::OnError onError {std::move(it->second.second)};
+        m_running.erase(it);
+        onError(Error(value));
+    }
+private:
+    class Job final : public IJob<std::string, Error>
+    {
+    public:
+        explicit Job(DeferredJobFactory &factory, int value) : m_factory {factory}, m_value {value} {}
+        void execute(OnResult &&onResult, OnError &&onError) override
+        {
+            m_factory.m_running.emplace(m_value, std::make_pair(std::move(onResult), std::move(onError)));
+        }
+        void cancel() override
+        {
+            m_factory.m_running.erase(m_value);
+            m_factory.m_cancelled.push_back(m_value);
+        }
+    private:
+        DeferredJobFactory &m_factory;
+        int m_value {0};
+    };
+    std::map<int, std::pair<IJob<std::string, Error>::OnResult, IJob<std::string, Error>::OnError>> m_running {};
+    std::vector<int> m_cancelled {};
+    int m_created {0};
+};
+
+class StringTraits : public CacheTraits<std::string>
+{
+public:
+    static std::size_t size(const std::string &stored)
+    {
+        return stored.size();
+    }
+};
+
+class ConstantHash
+{
+public:
+    std::size_t operator()(int) const
+    {
+        return 0;
+    }
+};
+
+using Factory = CachingJobFactory<int, std::string, Error>;
+using Job = IJob<std::string, Error>;
+
+}
+
+class TstCachingJobFactory: public Test
+{
+protected:
+    std::unique_ptr<Job> execute(const IJobFactory<int, std::string, Error> &factory, int request)
+    {
+        std::unique_ptr<Job> job {factory.create(std::move(request))};
+        job->execute([this](std::string &&result) {
+            m_results.push_back(std::move(result));
+        }, [this](Error &&error) {
+            m_errors.push_back(error.value);
+        });
+        return job;
+    }
+    DeferredJobFactory m_deferred {};
+    std::vector<std::string> m_results {};
+    std::vector<int> m_errors {};
+};
+
+TEST_F(TstCachingJobFactory, Hit)
+{
+    Factory factory {m_deferred, 0, 10};
+    std::unique_ptr<Job> job1 {execute(factory, 1)};
+    m_deferred.finish(1, "one");
+    EXPECT_EQ(m_results, std::vector<std::string>({"one"}));
+    EXPECT_EQ(factory.misses(), static_cast<std::size_t>(1));
+    EXPECT_EQ(factory.count(), static_cast<std::size_t>(1));
+
+    std::unique_ptr<Job> job2 {execute(factory, 1)};
+    EXPECT_EQ(m_results, std::vector<std::string>({"one", "one"}));
+    EXPECT_EQ(m_deferred.created(), 1);
+    EXPECT_EQ(factory.hits(), static_cast<std::size_t>(1));
+    EXPECT_EQ(factory.misses(), static_cast<std::size_t>(1));
+}
+
+TEST_F(TstCachingJobFactory, Error)
+{
+    Factory factory {m_deferred, 0, 10};
+    std::unique_ptr<Job> job1 {execute(factory, 1)};
+    m_deferred.fail(1);
+    std::unique_ptr<Job> job2 {execute(factory, 1)};
+    EXPECT_EQ(m_errors, std::vector<int>({1}));
+    EXPECT_EQ(m_deferred.created(), 2);
+    EXPECT_EQ(factory.count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(factory.misses(), static_cast<std::size_t>(2));
+}
+
+TEST_F(TstCachingJobFactory, Ttl)
+{
+    Factory factory {m_deferred, 20, 10};
+    std::unique_ptr<Job> job1 {execute(factory, 1)};
+    m_deferred.finish(1, "one");
+    std::unique_ptr<Job> job2 {execute(factory, 1)};
+    EXPECT_EQ(factory.hits(), static_cast<std::size_t>(1));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    std::unique_ptr<Job> job3 {execute(factory, 1)};
+    EXPECT_EQ(factory.hits(), static_cast<std::size_t>(1));
+    EXPECT_EQ(factory.misses(), static_cast<std::size_t>(2));
+    EXPECT_EQ(m_deferred.created(), 2);
+}
+
+TEST_F(TstCachingJobFactory, EntryBudget)
+{
+    Factory factory {m_deferred, 0, 2};
+    std::vector<std::unique_ptr<Job>> jobs {};
+    for (int i = 1; i <= 2; ++i) {
+        jobs.push_back(execute(factory, i));
+        m_deferred.finish(i, std::to_string(i));
+    }
+    jobs.push_back(execute(factory, 1)); // 1 is now the most recently used
+    jobs.push_back(execute(factory, 3));
+    m_deferred.finish(3, "3");
+    EXPECT_EQ(factory.count(), static_cast<std::size_t>(2));
+
+    jobs.push_back(execute(factory, 1));
+    EXPECT_EQ(factory.hits(), static_cast<std::size_t>(2));
+    jobs.push_back(execute(factory, 2));
+    EXPECT_EQ(factory.hits(), static_cast<std::size_t>(2));
+    EXPECT_EQ(m_deferred.created(), 4);
+}
+
+TEST_F(TstCachingJobFactory, ByteBudget)
+{
+    CachingJobFactory<int, std::string, Error, std::hash<int>, std::equal_to<int>, StringTraits> factory {m_deferred, 0, 0, 10};
+    std::vector<std::unique_ptr<Job>> jobs {};
+    jobs.push_back(execute(factory, 1));
+    m_deferred.finish(1, "aaaa");
+    jobs.push_back(execute(factory, 2));
+    m_deferred.finish(2, "bbbb");
+    EXPECT_EQ(factory.bytes(), static_cast<std::size_t>(8));
+
+    jobs.push_back(execute(factory, 3));
+    m_deferred.finish(3, "cccc");
+    EXPECT_EQ(factory.count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(factory.bytes(), static_cast<std::size_t>(8));
+
+    jobs.push_back(execute(factory, 4));
+    m_deferred.finish(4, "too large to be cached");
+    EXPECT_EQ(factory.count(), static_cast<std::size_t>(2));
+    EXPECT_EQ(m_results.back(), "too large to be cached");
+
+    factory.remove(3);
+    EXPECT_EQ(factory.bytes(), static_cast<std::size_t>(4));
+    factory.clear();
+    EXPECT_EQ(factory.count(), static_cast<std::size_t>(0));
+    EXPECT_EQ(factory.bytes(), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstCachingJobFactory, HashCollision)
+{
+    CachingJobFactory<int, std::string, Error, ConstantHash> factory {m_deferred, 0, 10};
+    std::vector<std::unique_ptr<Job>> jobs {};
+    jobs.push_back(execute(factory, 1));
+    m_deferred.finish(1, "one");
+    jobs.push_back(execute(factory, 2));
+    EXPECT_EQ(factory.hits(), static_cast<std::size_t>(0));
+    m_deferred.finish(2, "two");
+    EXPECT_EQ(factory.count(), static_cast<std::size_t>(2));
+
+    jobs.push_back(execute(factory, 1));
+    jobs.push_back(execute(factory, 2));
+    EXPECT_EQ(m_results, std::vector<std::string>({"one", "two", "one", "two"}));
+    EXPECT_EQ(factory.hits(), static_cast<std::size_t>(2));
+
+    factory.remove(1);
+    EXPECT_EQ(factory.count(), static_cast<std::size_t>(1));
+    jobs.push_back(execute(factory, 2));
+    EXPECT_EQ(factory.hits(), static_cast<std::size_t>(3));
+}
+
+TEST_F(TstCachingJobFactory, Cancel)
+{
+    Factory factory {m_deferred, 0, 10};
+    std::unique_ptr<Job> job1 {execute(factory, 1)};
+    job1->cancel();
+    std::unique_ptr<Job> job2 {execute(factory, 2)};
+    job2.reset();
+    EXPECT_EQ(m_deferred.cancelled(), std::vector<int>({1, 2}));
+    EXPECT_TRUE(m_results.empty());
+    EXPECT_EQ(factory.count(), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstCachingJobFactory, DestroyedFromCallback)
+{
+    Factory factory {m_deferred, 0, 10};
+    std::unique_ptr<Job> job {factory.create(1)};
+    job->execute([&job](std::string &&) {
+        job.reset();
+    }, [](Error &&) {});
+    m_deferred.finish(1, "one");
+    EXPECT_FALSE(job);
+    EXPECT_EQ(factory.count(), static_cast<std::size_t>(1));
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/core/callback.h>
+#include <array>
+#include <functional>
+#include <memory>
+
+using namespace ::testing;
+using namespace ::microcore::core;
+
+namespace {
+
+class Counter
+{
+public:
+    explicit Counter(int &destroyed)
+        : m_destroyed(&destroyed)
+    {
+    }
+    Counter(Counter &&other) noexcept
+        : m_destroyed(other.m_destroyed)
+    {
+        other.m_destroyed = nullptr;
+    }
+    ~Counter()
+    {
+        if (m_destroyed != nullptr) {
+            ++(*m_destroyed);
+        }
+    }
+    int operator()(int value) const
+    {
+        return value + 1;
+    }
+private:
+    int *m_destroyed {nullptr};
+};
+
+class Large
+{
+public:
+    int operator()(int value) const
+    {
+        return value + static_cast<int>(m_data.size());
+    }
+private:
+    std::array<void *, 8> m_data {};
+};
+
+}
+
+TEST(TstCallback, Empty)
+{
+    Callback<int (int)> callback {};
+    EXPECT_FALSE(callback);
+    Callback<int (int)> null {nullptr};
+    EXPECT_FALSE(null);
+}
+
+TEST(TstCallback, Inline)
+{
+    int value {1};
+    Callback<int (int)> callback {[&value](int other) { return value + other; }};
+    EXPECT_TRUE(callback);
+    EXPECT_EQ(callback(2), 3);
+
+    using Small = std::pair<void *, void *>;
+    EXPECT_TRUE(Callback<void ()>::isInline<Small>());
+    EXPECT_FALSE(Callback<void ()>::isInline<Large>());
+}
+
+TEST(TstCallback, Allocated)
+{
+    Callback<int (int)> callback {Large()};
+    EXPECT_EQ(callback(2), 10);
+    Callback<int (int)> moved {std::move(callback)};
+    EXPECT_FALSE(callback);
+    EXPECT_EQ(moved(3), 11);
+}
+
+TEST(TstCallback, MoveOnlyCapture)
+{
+    std::unique_ptr<int> value {new int(42)};
+    int *raw {value.get()};
+    auto lambda = [raw](std::unique_ptr<int> &&other) { return *raw + *other; };
+    Callback<int (std::unique_ptr<int> &&)> callback {lambda};
+    EXPECT_EQ(callback(std::unique_ptr<int>(new int(1))), 43);
+
+    std::unique_ptr<int> owned {new int(5)};
+    Callback<int ()> owning {std::bind([](const std::unique_ptr<int> &data) { return *data; }, std::move(owned))};
+    Callback<int ()> moved {std::move(owning)};
+    EXPECT_EQ(moved(), 5);
+}
+
+TEST(TstCallback, Destroy)
+{
+    int destroyed {0};
+    {
+        Callback<int (int)> callback {Counter(destroyed)};
+        EXPECT_EQ(callback(1), 2);
+        Callback<int (int)> moved {std::move(callback)};
+        EXPECT_EQ(destroyed, 0);
+        moved = nullptr;
+        EXPECT_EQ(destroyed, 1);
+        EXPECT_FALSE(moved);
+    }
+    EXPECT_EQ(destroyed, 1);
+}
+
+TEST(TstCallback, MoveAssign)
+{
+    int first {0};
+    int second {0};
+    Callback<int (int)> callback {Counter(first)};
+    Callback<int (int)> other {Counter(second)};
+    callback = std::move(other);
+    EXPECT_EQ(first, 1);
+    EXPECT_EQ(second, 0);
+    EXPECT_EQ(callback(2), 3);
+}
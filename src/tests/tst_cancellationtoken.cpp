@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <QtTest/QTest>
+#include <microcore/core/cancellationtoken.h>
+
+using namespace ::testing;
+using namespace ::microcore::core;
+
+namespace {
+
+class MockCancellationTokenListener: public CancellationToken::IListener
+{
+public:
+    MOCK_METHOD1(onCancel, void (CancellationToken::State state));
+    MOCK_METHOD0(onInvalidation, void ());
+};
+
+class CancellableError
+{
+public:
+    static CancellableError cancelled()
+    {
+        return CancellableError();
+    }
+    static CancellableError timeout()
+    {
+        return CancellableError();
+    }
+};
+
+class PlainError
+{
+};
+
+class SpecializedError
+{
+};
+
+}
+
+namespace microcore { namespace core {
+
+template<>
+class CancellationError<SpecializedError>
+{
+public:
+    static SpecializedError create(CancellationToken::State)
+    {
+        return SpecializedError();
+    }
+};
+
+}}
+
+TEST(TstCancellationToken, IsCancellable)
+{
+    EXPECT_TRUE(IsCancellable<CancellableError>::value);
+    EXPECT_TRUE(IsCancellable<SpecializedError>::value);
+    EXPECT_FALSE(IsCancellable<PlainError>::value);
+    EXPECT_FALSE(IsCancellable<int>::value);
+}
+
+TEST(TstCancellationToken, Invalid)
+{
+    CancellationToken token {};
+    std::shared_ptr<MockCancellationTokenListener> listener {new MockCancellationTokenListener()};
+    EXPECT_CALL(*listener, onCancel(_)).Times(0);
+
+    token.addListener(listener);
+    EXPECT_FALSE(token.isValid());
+    token.cancel();
+    EXPECT_FALSE(token.isCancelled());
+    EXPECT_EQ(token.state(), CancellationToken::State::Active);
+}
+
+TEST(TstCancellationToken, Cancel)
+{
+    CancellationToken token {CancellationToken::create()};
+    CancellationToken copy {token};
+    std::shared_ptr<MockCancellationTokenListener> listener {new MockCancellationTokenListener()};
+    EXPECT_CALL(*listener, onCancel(_)).Times(0);
+    EXPECT_CALL(*listener, onCancel(CancellationToken::State::Cancelled)).Times(1);
+
+    token.addListener(listener);
+    EXPECT_TRUE(token.isValid());
+    EXPECT_FALSE(token.isCancelled());
+    copy.cancel();
+    token.cancel();
+    EXPECT_TRUE(token.isCancelled());
+    EXPECT_EQ(token.state(), CancellationToken::State::Cancelled);
+}
+
+TEST(TstCancellationToken, AddListenerAfterCancel)
+{
+    CancellationToken token {CancellationToken::create()};
+    std::shared_ptr<MockCancellationTokenListener> listener {new MockCancellationTokenListener()};
+    EXPECT_CALL(*listener, onCancel(_)).Times(0);
+    EXPECT_CALL(*listener, onCancel(CancellationToken::State::Cancelled)).Times(1);
+
+    token.cancel();
+    token.addListener(listener);
+}
+
+TEST(TstCancellationToken, RemoveListener)
+{
+    CancellationToken token {CancellationToken::create()};
+    std::shared_ptr<MockCancellationTokenListener> listener {new MockCancellationTokenListener()};
+    EXPECT_CALL(*listener, onCancel(_)).Times(0);
+
+    token.addListener(listener);
+    token.removeListener(listener);
+    token.cancel();
+}
+
+TEST(TstCancellationToken, Deadline)
+{
+    CancellationToken token {CancellationToken::create()};
+    std::shared_ptr<MockCancellationTokenListener> listener {new MockCancellationTokenListener()};
+    EXPECT_CALL(*listener, onCancel(_)).Times(0);
+    EXPECT_CALL(*listener, onCancel(CancellationToken::State::TimedOut)).Times(1);
+
+    token.addListener(listener);
+    token.setDeadline(10);
+    EXPECT_FALSE(token.isCancelled());
+    QTest::qWait(100);
+    EXPECT_EQ(token.state(), CancellationToken::State::TimedOut);
+}
+
+TEST(TstCancellationToken, CancelBeforeDeadline)
+{
+    CancellationToken token {CancellationToken::create()};
+    std::shared_ptr<MockCancellationTokenListener> listener {new MockCancellationTokenListener()};
+    EXPECT_CALL(*listener, onCancel(_)).Times(0);
+    EXPECT_CALL(*listener, onCancel(CancellationToken::State::Cancelled)).Times(1);
+
+    token.addListener(listener);
+    token.setDeadline(10);
+    token.cancel();
+    QTest::qWait(100);
+    EXPECT_EQ(token.state(), CancellationToken::State::Cancelled);
+}
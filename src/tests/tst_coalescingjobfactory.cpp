@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/core/coalescingjobfactory.h>
+#include <map>
+#include <string>
+
+using namespace ::testing;
+using namespace ::microcore::core;
+
+namespace {
+
+class Error
+{
+public:
+    explicit Error(int v) : value {v} {}
+    int value {0};
+};
+
+// Jobs are finished from the test
+class DeferredJobFactory final : public IJobFactory<int, std::string, Error>
+{
+public:
+    std::unique_ptr<IJob<std::string, Error>> create(int &&request) const override
+    {
+        DeferredJobFactory &factory {const_cast<DeferredJobFactory &>(*this)};
+        ++factory.m_created;
+        return std::unique_ptr<IJob<std::string, Error>>(new Job(factory, request));
+    }
+    int created() const
+    {
+        return m_created;
+    }
+    const std::vector<int> & cancelled() const
+    {
+        return m_cancelled;
+    }
+    void finish(int value)
+    {
+        auto it = m_running.find(value);
+        ASSERT_FALSE(it == std::end(m_running));
+        IJob<std::string, Error>::OnResult onResult {std::move(it->second.first)};
+        m_running.erase(it);
+        onResult(std::to_string(value));
+    }
+    void fail(int value)
+    {
+        auto it = m_running.find(value);
+        ASSERT_FALSE(it == std::end(m_running));
+        IJob<std::string, Error>::OnError onError {std::move(it->second.second)};
+        m_running.erase(it);
+        onError(Error(value));
+    }
+private:
+    class Job final : public IJob<std::string, Error>
+    {
+    public:
+        explicit Job(DeferredJobFactory &factory, int value) : m_factory {factory}, m_value {value} {}
+        void execute(OnResult &&onResult, OnError &&onError) override
+        {
+            m_factory.m_running.emplace(m_value, std::make_pair(std::move(onResult), std::move(onError)));
+        }
+        void cancel() override
+        {
+            m_factory.m_running.erase(m_value);
+            m_factory.m_cancelled.push_back(m_value);
+        }
+    private:
+        DeferredJobFactory &m_factory;
+        int m_value {0};
+    };
+    std::map<int, std::pair<IJob<std::string, Error>::OnResult, IJob<std::string, Error>::OnError>> m_running {};
+    std::vector<int> m_cancelled {};
+    int m_created {0};
+};
+
+class ImmediateJobFactory final : public IJobFactory<int, std::string, Error>
+{
+public:
+    std::unique_ptr<IJob<std::string, Error>> create(int &&request) const override
+    {
+        return std::unique_ptr<IJob<std::string, Error>>(new Job(request));
+    }
+private:
+    class Job final : public IJob<std::string, Error>
+    {
+    public:
+        explicit Job(int value) : m_value {value} {}
+        void execute(OnResult &&onResult, OnError &&) override
+        {
+            onResult(std::to_string(m_value));
+        }
+    private:
+        int m_value {0};
+    };
+};
+
+class TensHash
+{
+public:
+    std::size_t operator()(int value) const
+    {
+        return static_cast<std::size_t>(value / 10);
+    }
+};
+
+class TensEqual
+{
+public:
+    bool operator()(int first, int second) const
+    {
+        return first / 10 == second / 10;
+    }
+};
+
+class ConstantHash
+{
+public:
+    std::size_t operator()(int) const
+    {
+        return 0;
+    }
+};
+
+using Factory = CoalescingJobFactory<int, std::string, Error>;
+using Job = IJob<Factory::SharedResult, Error>;
+
+}
+
+class TstCoalescingJobFactory: public Test
+{
+protected:
+    std::unique_ptr<Job> execute(const IJobFactory<int, Factory::SharedResult, Error> &factory, int request)
+    {
+        std::unique_ptr<Job> job {factory.create(std::move(request))};
+        job->execute([this](Factory::SharedResult &&result) {
+            m_results.push_back(std::move(result));
+        }, [this](Error &&error) {
+            m_errors.push_back(error.value);
+        });
+        return job;
+    }
+    DeferredJobFactory m_deferred {};
+    std::vector<Factory::SharedResult> m_results {};
+    std::vector<int> m_errors {};
+};
+
+TEST_F(TstCoalescingJobFactory, Coalesce)
+{
+    Factory factory {m_deferred};
+    std::unique_ptr<Job> job1 {execute(factory, 1)};
+    std::unique_ptr<Job> job2 {execute(factory, 1)};
+    std::unique_ptr<Job> job3 {execute(factory, 2)};
+    EXPECT_EQ(m_deferred.created(), 2);
+    EXPECT_EQ(factory.inFlightCount(), static_cast<std::size_t>(2));
+
+    m_deferred.finish(1);
+    ASSERT_EQ(m_results.size(), static_cast<std::size_t>(2));
+    EXPECT_EQ(*m_results[0], "1");
+    EXPECT_EQ(m_results[0].get(), m_results[1].get());
+    EXPECT_EQ(factory.inFlightCount(), static_cast<std::size_t>(1));
+
+    m_deferred.finish(2);
+    ASSERT_EQ(m_results.size(), static_cast<std::size_t>(3));
+    EXPECT_EQ(*m_results[2], "2");
+    EXPECT_EQ(factory.inFlightCount(), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstCoalescingJobFactory, OnlyInFlight)
+{
+    Factory factory {m_deferred};
+    std::unique_ptr<Job> job1 {execute(factory, 1)};
+    m_deferred.finish(1);
+    std::unique_ptr<Job> job2 {execute(factory, 1)};
+    EXPECT_EQ(m_deferred.created(), 2);
+    m_deferred.finish(1);
+    ASSERT_EQ(m_results.size(), static_cast<std::size_t>(2));
+    EXPECT_NE(m_results[0].get(), m_results[1].get());
+}
+
+TEST_F(TstCoalescingJobFactory, Error)
+{
+    Factory factory {m_deferred};
+    std::unique_ptr<Job> job1 {execute(factory, 1)};
+    std::unique_ptr<Job> job2 {execute(factory, 1)};
+    m_deferred.fail(1);
+    EXPECT_TRUE(m_results.empty());
+    EXPECT_EQ(m_errors, std::vector<int>({1, 1}));
+}
+
+TEST_F(TstCoalescingJobFactory, Cancel)
+{
+    Factory factory {m_deferred};
+    std::unique_ptr<Job> job1 {execute(factory, 1)};
+    std::unique_ptr<Job> job2 {execute(factory, 1)};
+    job1->cancel();
+    EXPECT_TRUE(m_deferred.cancelled().empty());
+
+    m_deferred.finish(1);
+    ASSERT_EQ(m_results.size(), static_cast<std::size_t>(1));
+
+    std::unique_ptr<Job> job3 {execute(factory, 2)};
+    std::unique_ptr<Job> job4 {execute(factory, 2)};
+    job3.reset();
+    job4->cancel();
+    EXPECT_EQ(m_deferred.cancelled(), std::vector<int>({2}));
+    EXPECT_EQ(factory.inFlightCount(), static_cast<std::size_t>(0));
+    EXPECT_EQ(m_results.size(), static_cast<std::size_t>(1));
+}
+
+TEST_F(TstCoalescingJobFactory, DestroyedFromCallback)
+{
+    Factory factory {m_deferred};
+    std::unique_ptr<Job> job1 {factory.create(1)};
+    std::unique_ptr<Job> job2 {factory.create(1)};
+    job1->execute([&job1, &job2](Factory::SharedResult &&) {
+        job1.reset();
+        job2.reset();
+    }, [](Error &&) {});
+    job2->execute([this](Factory::SharedResult &&result) {
+        m_results.push_back(std::move(result));
+    }, [](Error &&) {});
+
+    m_deferred.finish(1);
+    EXPECT_FALSE(job1);
+    EXPECT_FALSE(job2);
+    EXPECT_TRUE(m_results.empty());
+}
+
+TEST_F(TstCoalescingJobFactory, Synchronous)
+{
+    ImmediateJobFactory immediate {};
+    Factory factory {immediate};
+    std::unique_ptr<Job> job1 {execute(factory, 1)};
+    std::unique_ptr<Job> job2 {execute(factory, 1)};
+    ASSERT_EQ(m_results.size(), static_cast<std::size_t>(2));
+    EXPECT_EQ(*m_results[1], "1");
+    EXPECT_EQ(factory.inFlightCount(), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstCoalescingJobFactory, Hash)
+{
+    CoalescingJobFactory<int, std::string, Error, TensHash, TensEqual> factory {m_deferred};
+    std::unique_ptr<Job> job1 {execute(factory, 11)};
+    std::unique_ptr<Job> job2 {execute(factory, 12)};
+    std::unique_ptr<Job> job3 {execute(factory, 21)};
+    EXPECT_EQ(m_deferred.created(), 2);
+
+    m_deferred.finish(11);
+    ASSERT_EQ(m_results.size(), static_cast<std::size_t>(2));
+    EXPECT_EQ(*m_results[1], "11");
+}
+
+TEST_F(TstCoalescingJobFactory, HashCollision)
+{
+    CoalescingJobFactory<int, std::string, Error, ConstantHash> factory {m_deferred};
+    std::unique_ptr<Job> job1 {execute(factory, 1)};
+    std::unique_ptr<Job> job2 {execute(factory, 2)};
+    std::unique_ptr<Job> job3 {execute(factory, 1)};
+    EXPECT_EQ(m_deferred.created(), 2);
+    EXPECT_EQ(factory.inFlightCount(), static_cast<std::size_t>(2));
+
+    m_deferred.finish(2);
+    ASSERT_EQ(m_results.size(), static_cast<std::size_t>(1));
+    EXPECT_EQ(*m_results[0], "2");
+    EXPECT_EQ(factory.inFlightCount(), static_cast<std::size_t>(1));
+
+    m_deferred.finish(1);
+    ASSERT_EQ(m_results.size(), static_cast<std::size_t>(3));
+    EXPECT_EQ(*m_results[1], "1");
+    EXPECT_EQ(m_results[1].get(), m_results[2].get());
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/core/concurrentlistenerrepository.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace ::testing;
+using namespace ::microcore::core;
+
+namespace {
+
+class CountingListener
+{
+public:
+    using Ptr = std::shared_ptr<CountingListener>;
+    void onEvent(int value)
+    {
+        sum += value;
+    }
+    void onInvalidation()
+    {
+        invalidated = true;
+    }
+    std::atomic<int> sum {0};
+    bool invalidated {false};
+};
+
+using Repository = ConcurrentListenerRepository<CountingListener>;
+
+}
+
+TEST(TstConcurrentListenerRepository, AddRemove)
+{
+    Repository repository {};
+    CountingListener::Ptr listener1 {std::make_shared<CountingListener>()};
+    CountingListener::Ptr listener2 {std::make_shared<CountingListener>()};
+    EXPECT_TRUE(repository.isEmpty());
+
+    repository.addListener(listener1);
+    repository.addListener(listener2);
+    EXPECT_EQ(repository.count(), static_cast<std::size_t>(2));
+    repository.notify([](CountingListener &listener) {
+        listener.onEvent(1);
+    });
+    EXPECT_EQ(listener1->sum, 1);
+    EXPECT_EQ(listener2->sum, 1);
+
+    repository.removeListener(listener1);
+    EXPECT_EQ(repository.count(), static_cast<std::size_t>(1));
+    repository.notify([](CountingListener &listener) {
+        listener.onEvent(1);
+    });
+    EXPECT_EQ(listener1->sum, 1);
+    EXPECT_EQ(listener2->sum, 2);
+}
+
+TEST(TstConcurrentListenerRepository, PurgeExpired)
+{
+    Repository repository {};
+    CountingListener::Ptr listener1 {std::make_shared<CountingListener>()};
+    CountingListener::Ptr listener2 {std::make_shared<CountingListener>()};
+    repository.addListener(listener1);
+    repository.addListener(listener2);
+
+    listener1.reset();
+    repository.notify([](CountingListener &listener) {
+        listener.onEvent(1);
+    });
+    EXPECT_EQ(repository.count(), static_cast<std::size_t>(1));
+    EXPECT_EQ(listener2->sum, 1);
+}
+
+TEST(TstConcurrentListenerRepository, Invalidation)
+{
+    CountingListener::Ptr listener {std::make_shared<CountingListener>()};
+    {
+        Repository repository {};
+        repository.addListener(listener);
+    }
+    EXPECT_TRUE(listener->invalidated);
+}
+
+TEST(TstConcurrentListenerRepository, ModifyWhileNotifying)
+{
+    Repository repository {};
+    CountingListener::Ptr listener1 {std::make_shared<CountingListener>()};
+    CountingListener::Ptr listener2 {std::make_shared<CountingListener>()};
+    CountingListener::Ptr added {std::make_shared<CountingListener>()};
+    repository.addListener(listener1);
+    repository.addListener(listener2);
+
+    // Modifications apply to the next notification
+    repository.notify([&](CountingListener &listener) {
+        listener.onEvent(1);
+        if (&listener == listener1.get()) {
+            repository.removeListener(listener2);
+            repository.addListener(added);
+        }
+    });
+    EXPECT_EQ(listener1->sum, 1);
+    EXPECT_EQ(listener2->sum, 1);
+    EXPECT_EQ(added->sum, 0);
+
+    repository.notify([](CountingListener &listener) {
+        listener.onEvent(1);
+    });
+    EXPECT_EQ(listener1->sum, 2);
+    EXPECT_EQ(listener2->sum, 1);
+    EXPECT_EQ(added->sum, 1);
+
+    // A listener can remove itself, and release the last reference to it
+    repository.notify([&](CountingListener &listener) {
+        if (&listener == listener1.get()) {
+            repository.removeListener(listener1);
+            listener1.reset();
+        }
+    });
+    EXPECT_EQ(repository.count(), static_cast<std::size_t>(1));
+}
+
+TEST(TstConcurrentListenerRepository, StressNotify)
+{
+    Repository repository {};
+    CountingListener::Ptr listener {std::make_shared<CountingListener>()};
+    repository.addListener(listener);
+
+    const int threadCount {4};
+    const int iterations {10000};
+    std::vector<std::thread> threads {};
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&repository, iterations]() {
+            for (int j = 0; j < iterations; ++j) {
+                repository.notify([](CountingListener &listener) {
+                    listener.onEvent(1);
+                });
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(listener->sum, threadCount * iterations);
+}
+
+TEST(TstConcurrentListenerRepository, StressAddRemove)
+{
+    Repository repository {};
+    CountingListener::Ptr stable {std::make_shared<CountingListener>()};
+    repository.addListener(stable);
+
+    const int threadCount {4};
+    const int iterations {2000};
+    std::atomic<bool> running {true};
+    std::atomic<int> notifications {0};
+    std::vector<std::thread> notifiers {};
+    for (int i = 0; i < threadCount; ++i) {
+        notifiers.emplace_back([&]() {
+            while (running) {
+                repository.notify([](CountingListener &listener) {
+                    listener.onEvent(1);
+                });
+                ++notifications;
+            }
+        });
+    }
+
+    std::vector<std::thread> writers {};
+    std::vector<std::vector<CountingListener::Ptr>> kept (threadCount);
+    for (int i = 0; i < threadCount; ++i) {
+        writers.emplace_back([&, i]() {
+            for (int j = 0; j < iterations; ++j) {
+                CountingListener::Ptr listener {std::make_shared<CountingListener>()};
+                repository.addListener(listener);
+                if (j % 2 == 0) {
+                    repository.removeListener(listener);
+                } else if (j % 3 == 0) {
+                    kept[i].push_back(listener);
+                }
+                // Other listeners expire here
+            }
+        });
+    }
+    for (std::thread &thread : writers) {
+        thread.join();
+    }
+    running = false;
+    for (std::thread &thread : notifiers) {
+        thread.join();
+    }
+
+    // Every notification reached the stable listener
+    EXPECT_EQ(stable->sum, notifications);
+
+    // Concurrent writes are not lost, and expired listeners are purged
+    std::size_t keptCount {0};
+    for (const std::vector<CountingListener::Ptr> &listeners : kept) {
+        keptCount += listeners.size();
+    }
+    repository.notify([](CountingListener &listener) {
+        listener.onEvent(1);
+    });
+    EXPECT_EQ(repository.count(), keptCount + 1);
+}
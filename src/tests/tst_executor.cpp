@@ -63,6 +63,10 @@ public:
     {
         doFinish();
     }
+    const CancellationToken & testToken() const
+    {
+        return token();
+    }
 };
 
 class ListenerData
@@ -234,3 +238,19 @@ TEST_F(TstExecutor, TestListenerInvalidation)
     EXPECT_EQ(m_listenerData.type, ListenerData::Type::Invalidation);
     m_invalidated = true;
 }
+
+TEST_F(TstExecutor, TestCancel)
+{
+    m_executor->testStart();
+    CancellationToken token {m_executor->testToken()};
+    EXPECT_TRUE(token.isValid());
+    EXPECT_FALSE(token.isCancelled());
+
+    m_executor->cancel();
+    EXPECT_EQ(token.state(), CancellationToken::State::Cancelled);
+
+    // A new token is used for the next execution
+    m_executor->testError(Error::cancelled());
+    m_executor->testStart();
+    EXPECT_FALSE(m_executor->testToken().isCancelled());
+}
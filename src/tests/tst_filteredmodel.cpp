@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/data/btreesequence.h>
+#include <microcore/data/filteredmodel.h>
+#include <microcore/data/indexeddatastore.h>
+#include <microcore/data/indexedmodel.h>
+#include <algorithm>
+#include <random>
+
+using namespace ::testing;
+using namespace ::microcore::data;
+
+namespace {
+
+class Score
+{
+public:
+    explicit Score() = default;
+    explicit Score(int k, int v) : key {k}, value {v} {}
+    DEFAULT_COPY_DEFAULT_MOVE(Score);
+    int key {0};
+    int value {0};
+};
+
+class ScoreMapper
+{
+public:
+    using KeyType = int;
+    int operator()(const Score &score) const
+    {
+        return score.key;
+    }
+};
+
+// Mirrors the rows of a model by replaying its events
+template<class S>
+class Mirror: public IModel<Score, S>::IListener
+{
+public:
+    void onAppend(const std::vector<const Score *> &values) override
+    {
+        rows.insert(std::end(rows), std::begin(values), std::end(values));
+        events.emplace_back("append");
+    }
+    void onPrepend(const std::vector<const Score *> &values) override
+    {
+        rows.insert(std::begin(rows), std::begin(values), std::end(values));
+        events.emplace_back("prepend");
+    }
+    void onInsert(typename S::size_type index, const std::vector<const Score *> &values) override
+    {
+        rows.insert(std::begin(rows) + index, std::begin(values), std::end(values));
+        events.emplace_back("insert " + std::to_string(index));
+    }
+    void onRemove(typename S::size_type index) override
+    {
+        rows.erase(std::begin(rows) + index);
+        events.emplace_back("remove " + std::to_string(index));
+    }
+    void onUpdate(typename S::size_type index, const Score &value) override
+    {
+        EXPECT_EQ(rows[index], &value);
+        events.emplace_back("update " + std::to_string(index));
+    }
+    void onMove(typename S::size_type oldIndex, typename S::size_type newIndex) override
+    {
+        const Score *value {rows[oldIndex]};
+        rows.erase(std::begin(rows) + oldIndex);
+        rows.insert(std::begin(rows) + (newIndex < oldIndex ? newIndex : newIndex - 1), value);
+        events.emplace_back("move " + std::to_string(oldIndex) + " " + std::to_string(newIndex));
+    }
+    void onInvalidation() override
+    {
+        rows.clear();
+        events.emplace_back("invalidation");
+    }
+    void onRemoveRange(typename S::size_type index, typename S::size_type count) override
+    {
+        rows.erase(std::begin(rows) + index, std::begin(rows) + index + count);
+        events.emplace_back("remove " + std::to_string(index) + " " + std::to_string(count));
+    }
+    std::vector<const Score *> rows {};
+    std::vector<std::string> events {};
+};
+
+using Store = IndexedDataStore<int, Score>;
+using Source = IndexedModel<Score, ScoreMapper>;
+using Filtered = FilteredModel<Score>;
+
+std::vector<int> keys(const IModel<Score, std::deque<const Score *>> &model)
+{
+    std::vector<int> result {};
+    for (const Score *score : model) {
+        result.emplace_back(score->key);
+    }
+    return result;
+}
+
+bool isEven(const Score &score)
+{
+    return score.value % 2 == 0;
+}
+
+}
+
+class TstFilteredModel: public Test
+{
+protected:
+    void SetUp()
+    {
+        m_source.reset(new Source(m_store));
+        m_source->append({Score(1, 10), Score(2, 11), Score(3, 12), Score(4, 13)});
+        m_filtered.reset(new Filtered(*m_source, &isEven));
+        m_filtered->addListener(m_mirror);
+        m_mirror->events.clear();
+    }
+    void checkMirror()
+    {
+        EXPECT_EQ(m_mirror->rows, std::vector<const Score *>(std::begin(*m_filtered), std::end(*m_filtered)));
+    }
+    Store m_store {};
+    std::unique_ptr<Source> m_source {};
+    std::unique_ptr<Filtered> m_filtered {};
+    std::shared_ptr<Mirror<std::deque<const Score *>>> m_mirror {std::make_shared<Mirror<std::deque<const Score *>>>()};
+};
+
+TEST_F(TstFilteredModel, Initial)
+{
+    EXPECT_EQ(keys(*m_filtered), std::vector<int>({1, 3}));
+    EXPECT_EQ((*m_filtered)[1]->value, 12);
+    EXPECT_EQ((*m_filtered)[2], nullptr);
+    checkMirror();
+}
+
+TEST_F(TstFilteredModel, Insert)
+{
+    m_source->append({Score(5, 14), Score(6, 15)});
+    m_source->insert(1, {Score(7, 21), Score(8, 22), Score(9, 24)});
+    m_source->prepend({Score(10, 1)});
+    m_source->prepend({Score(11, 2)});
+    EXPECT_EQ(keys(*m_filtered), std::vector<int>({11, 1, 8, 9, 3, 5}));
+    // Accepted rows are inserted at once
+    EXPECT_EQ(m_mirror->events, std::vector<std::string>({"append", "insert 1", "prepend"}));
+    checkMirror();
+}
+
+TEST_F(TstFilteredModel, Remove)
+{
+    m_source->remove(1);
+    m_source->remove(1);
+    EXPECT_EQ(keys(*m_filtered), std::vector<int>({1}));
+    m_source->append({Score(5, 14), Score(6, 16), Score(7, 17)});
+    m_source->removeRange(0, 3);
+    EXPECT_EQ(keys(*m_filtered), std::vector<int>({6}));
+    EXPECT_EQ(m_mirror->events, std::vector<std::string>({"remove 1", "append", "remove 0 2"}));
+    checkMirror();
+}
+
+TEST_F(TstFilteredModel, Update)
+{
+    m_source->update(0, Score(1, 20));
+    m_source->update(1, Score(2, 22));
+    m_source->update(2, Score(3, 23));
+    m_source->update(3, Score(4, 25));
+    EXPECT_EQ(keys(*m_filtered), std::vector<int>({1, 2}));
+    EXPECT_EQ(m_mirror->events, std::vector<std::string>({"update 0", "insert 1", "remove 2"}));
+    checkMirror();
+}
+
+TEST_F(TstFilteredModel, SourceMove)
+{
+    m_source->move(0, 2);
+    EXPECT_EQ(keys(*m_filtered), std::vector<int>({1, 3}));
+    m_source->move(1, 4);
+    EXPECT_EQ(keys(*m_filtered), std::vector<int>({3, 1}));
+    m_source->move(3, 0);
+    EXPECT_EQ(keys(*m_filtered), std::vector<int>({1, 3}));
+    EXPECT_EQ(m_mirror->events, std::vector<std::string>({"move 0 2", "move 1 0"}));
+    checkMirror();
+}
+
+TEST_F(TstFilteredModel, SetPredicate)
+{
+    m_source->append({Score(5, 14), Score(6, 15), Score(7, 17), Score(8, 18)});
+    m_mirror->events.clear();
+    m_filtered->setPredicate([](const Score &score) {
+        return score.value % 2 != 0 || score.value == 14;
+    });
+    EXPECT_EQ(keys(*m_filtered), std::vector<int>({2, 4, 5, 6, 7}));
+    EXPECT_EQ(m_mirror->events, std::vector<std::string>({"remove 0", "prepend", "remove 1", "insert 1",
+                                                          "insert 3", "remove 5"}));
+    checkMirror();
+
+    m_mirror->events.clear();
+    m_filtered->setPredicate(nullptr);
+    EXPECT_EQ(keys(*m_filtered), std::vector<int>({1, 2, 3, 4, 5, 6, 7, 8}));
+    EXPECT_EQ(m_mirror->events, std::vector<std::string>({"prepend", "insert 2", "append"}));
+    checkMirror();
+}
+
+TEST_F(TstFilteredModel, Invalidation)
+{
+    m_source.reset();
+    EXPECT_TRUE(m_filtered->empty());
+    EXPECT_EQ(m_mirror->events.back(), "invalidation");
+}
+
+// Changing the predicate of a large model, evaluated on several threads
+TEST(TstFilteredModelLarge, SetPredicate)
+{
+    IndexedDataStore<int, Score> store {};
+    IndexedModel<Score, ScoreMapper> source {store};
+    std::vector<Score> values {};
+    for (int i = 0; i < 20000; ++i) {
+        values.emplace_back(i, i);
+    }
+    source.append(std::move(values));
+    FilteredModel<Score> filtered {source, &isEven};
+    std::shared_ptr<Mirror<std::deque<const Score *>>> mirror {std::make_shared<Mirror<std::deque<const Score *>>>()};
+    filtered.addListener(mirror);
+    EXPECT_EQ(filtered.size(), 10000);
+
+    filtered.setPredicate([](const Score &score) {
+        return score.value % 4 == 0 || score.value < 100;
+    });
+    EXPECT_EQ(filtered.size(), 5075);
+    EXPECT_EQ(mirror->rows, std::vector<const Score *>(std::begin(filtered), std::end(filtered)));
+}
+
+// Random operations on the source, and changes of the predicate
+TEST(TstFilteredModelRandom, Random)
+{
+    using Sequence = BTreeSequence<const Score *, 4, 4>;
+    IndexedDataStore<int, Score> store {};
+    IndexedModel<Score, ScoreMapper, Sequence> source {store};
+    FilteredModel<Score, Sequence> filtered {source, &isEven};
+    std::shared_ptr<Mirror<Sequence>> mirror {std::make_shared<Mirror<Sequence>>()};
+    filtered.addListener(mirror);
+
+    std::mt19937 generator {1};
+    int nextKey {0};
+    int modulo {2};
+    for (int i = 0; i < 2000; ++i) {
+        int operation = generator() % 6;
+        if (operation == 0 || source.empty()) {
+            std::vector<Score> values {};
+            int count = generator() % 3 + 1;
+            for (int j = 0; j < count; ++j) {
+                values.emplace_back(nextKey++, static_cast<int>(generator() % 50));
+            }
+            source.insert(generator() % (source.size() + 1), std::move(values));
+        } else if (operation == 1) {
+            source.remove(generator() % source.size());
+        } else if (operation == 2) {
+            std::size_t index = generator() % source.size();
+            source.update(index, Score(source[index]->key, static_cast<int>(generator() % 50)));
+        } else if (operation == 3) {
+            source.move(generator() % source.size(), generator() % (source.size() + 1));
+        } else if (operation == 4) {
+            std::size_t index = generator() % source.size();
+            source.removeRange(index, generator() % 3);
+        } else if (generator() % 4 == 0) {
+            modulo = generator() % 3 + 2;
+            int m = modulo;
+            filtered.setPredicate([m](const Score &score) {
+                return score.value % m == 0;
+            });
+        }
+
+        std::vector<const Score *> expected {};
+        std::copy_if(std::begin(source), std::end(source), std::back_inserter(expected), [modulo](const Score *score) {
+            return score->value % modulo == 0;
+        });
+        ASSERT_EQ(std::vector<const Score *>(std::begin(filtered), std::end(filtered)), expected);
+        ASSERT_EQ(mirror->rows, expected);
+    }
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/data/flathashmap.h>
+#include <map>
+#include <random>
+#include <string>
+
+using namespace ::testing;
+using namespace ::microcore::data;
+
+namespace {
+
+// Hash mapping every key to the same slot
+class CollidingHash
+{
+public:
+    std::size_t operator()(int) const
+    {
+        return 0;
+    }
+};
+
+}
+
+TEST(TstFlatHashMap, Empty)
+{
+    FlatHashMap<int, int> map {};
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.size(), static_cast<std::size_t>(0));
+    EXPECT_TRUE(map.find(1) == std::end(map));
+    EXPECT_EQ(map.erase(1), static_cast<std::size_t>(0));
+    EXPECT_TRUE(std::begin(map) == std::end(map));
+}
+
+TEST(TstFlatHashMap, EmplaceFindErase)
+{
+    FlatHashMap<std::string, int> map {};
+    auto result = map.emplace(std::string("a"), 1);
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(result.first->first, "a");
+    EXPECT_EQ(result.first->second, 1);
+
+    result = map.emplace(std::string("a"), 2);
+    EXPECT_FALSE(result.second);
+    EXPECT_EQ(result.first->second, 1);
+    EXPECT_EQ(map.size(), static_cast<std::size_t>(1));
+
+    map["b"] = 2;
+    EXPECT_EQ(map.size(), static_cast<std::size_t>(2));
+    EXPECT_EQ(map.find("b")->second, 2);
+    EXPECT_EQ(map.count("b"), static_cast<std::size_t>(1));
+
+    map.erase(map.find("a"));
+    EXPECT_TRUE(map.find("a") == std::end(map));
+    EXPECT_EQ(map.erase("b"), static_cast<std::size_t>(1));
+    EXPECT_TRUE(map.empty());
+}
+
+TEST(TstFlatHashMap, Collisions)
+{
+    FlatHashMap<int, int, CollidingHash> map {};
+    for (int i = 0; i < 100; ++i) {
+        map.emplace(i, i);
+    }
+    // Tombstones keep the probe sequence of the other keys
+    for (int i = 0; i < 100; i += 2) {
+        EXPECT_EQ(map.erase(i), static_cast<std::size_t>(1));
+    }
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(map.find(i) != std::end(map), i % 2 == 1);
+    }
+    map.emplace(0, 0);
+    EXPECT_EQ(map.size(), static_cast<std::size_t>(51));
+    EXPECT_EQ(map.find(0)->second, 0);
+}
+
+TEST(TstFlatHashMap, Iteration)
+{
+    FlatHashMap<int, int> map {};
+    for (int i = 0; i < 1000; ++i) {
+        map.emplace(i, i * 2);
+    }
+    int sum {0};
+    std::size_t count {0};
+    const FlatHashMap<int, int> &constMap (map);
+    for (const std::pair<int, int> &entry : constMap) {
+        EXPECT_EQ(entry.second, entry.first * 2);
+        sum += entry.first;
+        ++count;
+    }
+    EXPECT_EQ(count, static_cast<std::size_t>(1000));
+    EXPECT_EQ(sum, 999 * 1000 / 2);
+}
+
+TEST(TstFlatHashMap, Move)
+{
+    FlatHashMap<int, std::unique_ptr<int>> map {};
+    map.emplace(1, std::unique_ptr<int>(new int(1)));
+    FlatHashMap<int, std::unique_ptr<int>> moved {std::move(map)};
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(*moved.find(1)->second, 1);
+
+    map = std::move(moved);
+    EXPECT_EQ(*map.find(1)->second, 1);
+    map.clear();
+    EXPECT_TRUE(map.empty());
+}
+
+TEST(TstFlatHashMap, Reserve)
+{
+    FlatHashMap<int, int> map {};
+    map.reserve(1000);
+    std::size_t capacity {map.capacity()};
+    for (int i = 0; i < 1000; ++i) {
+        map.emplace(i, i);
+    }
+    EXPECT_EQ(map.capacity(), capacity);
+}
+
+TEST(TstFlatHashMap, RandomOperations)
+{
+    FlatHashMap<int, int> map {};
+    std::map<int, int> reference {};
+    std::mt19937 random {42};
+    for (int i = 0; i < 100000; ++i) {
+        int key {static_cast<int>(random() % 2000)};
+        if (random() % 2 == 0) {
+            EXPECT_EQ(map.emplace(key, i).second, reference.emplace(key, i).second);
+        } else {
+            EXPECT_EQ(map.erase(key), reference.erase(key));
+        }
+    }
+    ASSERT_EQ(map.size(), reference.size());
+    for (const std::pair<const int, int> &entry : reference) {
+        auto it = map.find(entry.first);
+        ASSERT_FALSE(it == std::end(map));
+        EXPECT_EQ(it->second, entry.second);
+    }
+}
@@ -35,6 +35,7 @@
 #include <QElapsedTimer>
 #include <microcore/core/globals.h>
 #include <microcore/core/pipe.h>
+#include <microcore/http/httpcache.h>
 #include <microcore/http/httprequestfactory.h>
 #include "mockjob.h"
 
@@ -194,4 +195,62 @@ TEST_F(TstHttp, TestDeleteError)
     EXPECT_TRUE(called);
 }
 
+TEST_F(TstHttp, TestCancel)
+{
+    // Mock
+    bool called {false};
+    EXPECT_CALL(*this, mockOnResult(_)).Times(0);
+    EXPECT_CALL(*this, mockOnError(_)).Times(1).WillRepeatedly(Invoke([&called](const HttpError &error) {
+        called = true;
+        EXPECT_EQ(error.id(), "cancelled");
+    }));
+    CancellationToken token {CancellationToken::create()};
+
+    // Test
+    m_pipe->send(HttpRequest(HttpRequest::Type::Get, QNetworkRequest(QUrl("http://localhost:8080/api/get"))), token);
+    token.cancel();
+    EXPECT_TRUE(called);
+    QTest::qWait(300);
+}
+
+TEST_F(TstHttp, TestTimeout)
+{
+    // Mock
+    bool called {false};
+    EXPECT_CALL(*this, mockOnResult(_)).Times(0);
+    EXPECT_CALL(*this, mockOnError(_)).Times(1).WillRepeatedly(Invoke([&called](const HttpError &error) {
+        called = true;
+        EXPECT_EQ(error.id(), "timeout");
+    }));
+    CancellationToken token {CancellationToken::create()};
+    QElapsedTimer timer {};
+
+    // Test
+    m_pipe->send(HttpRequest(HttpRequest::Type::Get, QNetworkRequest(QUrl("http://localhost:8080/api/get"))), token);
+    token.setDeadline(0);
+    timer.start();
+    while (!called && !timer.hasExpired(5000)) {
+        QTest::qWait(300);
+    }
+    EXPECT_TRUE(called);
+}
+
 #endif // ENABLE_MOCK_SERVER
+
+TEST(TstHttpCache, TestRequestHeaders)
+{
+    QNetworkRequest json {QUrl("http://localhost:8080/api/get")};
+    json.setRawHeader("Accept", "application/json");
+    QNetworkRequest xml {QUrl("http://localhost:8080/api/get")};
+    xml.setRawHeader("Accept", "application/xml");
+
+    HttpRequestHash hash {};
+    HttpRequestEqual equal {};
+    HttpRequest jsonRequest {HttpRequest::Type::Get, json};
+    HttpRequest xmlRequest {HttpRequest::Type::Get, xml};
+    EXPECT_TRUE(equal(jsonRequest, HttpRequest(HttpRequest::Type::Get, json)));
+    EXPECT_EQ(hash(jsonRequest), hash(HttpRequest(HttpRequest::Type::Get, json)));
+    EXPECT_FALSE(equal(jsonRequest, xmlRequest));
+    EXPECT_NE(hash(jsonRequest), hash(xmlRequest));
+    EXPECT_FALSE(equal(jsonRequest, HttpRequest(HttpRequest::Type::Post, json)));
+}
@@ -49,13 +49,14 @@ public:
     int value {0};
 };
 
-class ResultDataStore: public IndexedDataStore<int, Result>
+template<class P>
+class ResultDataStore: public IndexedDataStore<int, Result, P>
 {
 public:
     explicit ResultDataStore() = default;
-    const std::map<int, std::shared_ptr<Result>> & internalStorage() const
+    const typename IndexedDataStore<int, Result, P>::Container & internalStorage() const
     {
-        return m_data;
+        return this->m_data;
     }
 };
 
@@ -135,8 +136,56 @@ public:
     MOCK_METHOD0_T(onInvalidation, void ());
 };
 
+// Watches the removals of a store
+class RemoveListener: public IIndexedDataStore<int, Result>::IListener
+{
+public:
+    void onAdd(int key, const ValuePtr &value) override
+    {
+        Q_UNUSED(key)
+        Q_UNUSED(value)
+    }
+    void onRemove(int key) override
+    {
+        removed.push_back(key);
+    }
+    void onUpdate(int key, const ValuePtr &value) override
+    {
+        Q_UNUSED(key)
+        Q_UNUSED(value)
+    }
+    void onInvalidation() override
+    {
+    }
+    std::vector<int> removed {};
+};
+
+template<class P, class E>
+class Policies
+{
+public:
+    using Storage = P;
+    using Eviction = E;
+};
+
 }
 
+namespace microcore { namespace data {
+
+// The size of a Result is its value, for eviction tests
+template<>
+class ValueSize<Result>
+{
+public:
+    static std::size_t size(const Result &result)
+    {
+        return static_cast<std::size_t>(result.value);
+    }
+};
+
+}}
+
+template<class P>
 class TstDataStore: public Test
 {
 public:
@@ -147,183 +196,296 @@ public:
 protected:
     void SetUp()
     {
-        m_dataStore.reset(new ResultDataStore());
+        m_dataStore.reset(new ResultDataStore<P>());
         ON_CALL(*m_listener, onAdd(_, _)).WillByDefault(Invoke(&m_watcher, &ListenerWatcher::onAdd));
         ON_CALL(*m_listener, onRemove(_)).WillByDefault(Invoke(&m_watcher, &ListenerWatcher::onRemove));
         ON_CALL(*m_listener, onUpdate(_, _)).WillByDefault(Invoke(&m_watcher, &ListenerWatcher::onUpdate));
         ON_CALL(*m_listener, onInvalidation()).WillByDefault(Invoke(&m_watcher, &ListenerWatcher::onInvalidation));
         m_dataStore->addListener(m_listener);
-        m_dataStore->addListener(ResultDataStore::IListener::Ptr());
+        m_dataStore->addListener(typename ResultDataStore<P>::IListener::Ptr());
     }
-    std::unique_ptr<ResultDataStore> m_dataStore;
+    std::unique_ptr<ResultDataStore<P>> m_dataStore;
     std::shared_ptr<NiceMock<MockIDataStoreListener<int, Result>>> m_listener {};
     ListenerWatcher m_watcher {};
     bool m_invalidated {false};
 };
 
-TEST_F(TstDataStore, AddUnique)
+using StoragePolicies = Types<OrderedStorage, FlatHashStorage>;
+TYPED_TEST_CASE(TstDataStore, StoragePolicies);
+
+TYPED_TEST(TstDataStore, AddUnique)
 {
-    const Result::ConstPtr &result1 {m_dataStore->addUnique(1, Result(1))};
+    const Result::ConstPtr &result1 {this->m_dataStore->addUnique(1, Result(1))};
     {
         EXPECT_NE(result1, nullptr);
-        EXPECT_EQ(m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
-        EXPECT_EQ(m_watcher.count(), 1);
-        EXPECT_EQ(m_watcher[0].type, ListenerData::Type::Add);
-        EXPECT_EQ(m_watcher[0].key, 1);
-        EXPECT_FALSE(m_dataStore->internalStorage().find(1) == std::end(m_dataStore->internalStorage()));
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, m_watcher[0].value);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, result1);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second->value, 1);
+        EXPECT_EQ(this->m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
+        EXPECT_EQ(this->m_watcher.count(), 1);
+        EXPECT_EQ(this->m_watcher[0].type, ListenerData::Type::Add);
+        EXPECT_EQ(this->m_watcher[0].key, 1);
+        EXPECT_FALSE(this->m_dataStore->internalStorage().find(1) == std::end(this->m_dataStore->internalStorage()));
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, this->m_watcher[0].value);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, result1);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second->value, 1);
     }
-    const Result::ConstPtr &result2 {m_dataStore->addUnique(2, Result(2))};
+    const Result::ConstPtr &result2 {this->m_dataStore->addUnique(2, Result(2))};
     {
         EXPECT_NE(result2, nullptr);
-        EXPECT_EQ(m_dataStore->internalStorage().size(), static_cast<std::size_t>(2));
-        EXPECT_EQ(m_watcher.count(), 2);
-        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::Add);
-        EXPECT_EQ(m_watcher[1].key, 2);
-        EXPECT_FALSE(m_dataStore->internalStorage().find(2) == std::end(m_dataStore->internalStorage()));
-        EXPECT_EQ(m_dataStore->internalStorage().find(2)->second, m_watcher[1].value);
-        EXPECT_EQ(m_dataStore->internalStorage().find(2)->second, result2);
-        EXPECT_EQ(m_dataStore->internalStorage().find(2)->second->value, 2);
+        EXPECT_EQ(this->m_dataStore->internalStorage().size(), static_cast<std::size_t>(2));
+        EXPECT_EQ(this->m_watcher.count(), 2);
+        EXPECT_EQ(this->m_watcher[1].type, ListenerData::Type::Add);
+        EXPECT_EQ(this->m_watcher[1].key, 2);
+        EXPECT_FALSE(this->m_dataStore->internalStorage().find(2) == std::end(this->m_dataStore->internalStorage()));
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(2)->second, this->m_watcher[1].value);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(2)->second, result2);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(2)->second->value, 2);
     }
 }
 
-TEST_F(TstDataStore, AddUniqueExisting)
+TYPED_TEST(TstDataStore, AddUniqueExisting)
 {
-    const Result::ConstPtr &result1 {m_dataStore->addUnique(1, Result(1))};
+    const Result::ConstPtr &result1 {this->m_dataStore->addUnique(1, Result(1))};
     {
         EXPECT_NE(result1, nullptr);
-        EXPECT_EQ(m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
-        EXPECT_EQ(m_watcher.count(), 1);
-        EXPECT_EQ(m_watcher[0].type, ListenerData::Type::Add);
-        EXPECT_EQ(m_watcher[0].key, 1);
-        EXPECT_FALSE(m_dataStore->internalStorage().find(1) == std::end(m_dataStore->internalStorage()));
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, m_watcher[0].value);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second->value, 1);
+        EXPECT_EQ(this->m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
+        EXPECT_EQ(this->m_watcher.count(), 1);
+        EXPECT_EQ(this->m_watcher[0].type, ListenerData::Type::Add);
+        EXPECT_EQ(this->m_watcher[0].key, 1);
+        EXPECT_FALSE(this->m_dataStore->internalStorage().find(1) == std::end(this->m_dataStore->internalStorage()));
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, this->m_watcher[0].value);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second->value, 1);
     }
-    const Result::ConstPtr &result2 {m_dataStore->addUnique(1, Result(2))};
+    const Result::ConstPtr &result2 {this->m_dataStore->addUnique(1, Result(2))};
     {
         EXPECT_EQ(result2, nullptr);
-        EXPECT_EQ(m_watcher.count(), 1);
-        EXPECT_FALSE(m_dataStore->internalStorage().find(1) == std::end(m_dataStore->internalStorage()));
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second->value, 1);
+        EXPECT_EQ(this->m_watcher.count(), 1);
+        EXPECT_FALSE(this->m_dataStore->internalStorage().find(1) == std::end(this->m_dataStore->internalStorage()));
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second->value, 1);
     }
 }
 
-TEST_F(TstDataStore, Add)
+TYPED_TEST(TstDataStore, Add)
 {
-    const Result::ConstPtr &result1 {m_dataStore->add(1, Result(1))};
-    {
-        EXPECT_EQ(m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
-        EXPECT_EQ(m_watcher.count(), 1);
-        EXPECT_EQ(m_watcher[0].type, ListenerData::Type::Add);
-        EXPECT_EQ(m_watcher[0].key, 1);
-        EXPECT_FALSE(m_dataStore->internalStorage().find(1) == std::end(m_dataStore->internalStorage()));
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, m_watcher[0].value);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, result1);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second->value, 1);
+    const Result::ConstPtr &result1 {this->m_dataStore->add(1, Result(1))};
+    {
+        EXPECT_EQ(this->m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
+        EXPECT_EQ(this->m_watcher.count(), 1);
+        EXPECT_EQ(this->m_watcher[0].type, ListenerData::Type::Add);
+        EXPECT_EQ(this->m_watcher[0].key, 1);
+        EXPECT_FALSE(this->m_dataStore->internalStorage().find(1) == std::end(this->m_dataStore->internalStorage()));
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, this->m_watcher[0].value);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, result1);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second->value, 1);
     }
-    const Result::ConstPtr &result2 {m_dataStore->add(2, Result(2))};
-    {
-        EXPECT_EQ(m_dataStore->internalStorage().size(), static_cast<std::size_t>(2));
-        EXPECT_EQ(m_watcher.count(), 2);
-        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::Add);
-        EXPECT_EQ(m_watcher[1].key, 2);
-        EXPECT_FALSE(m_dataStore->internalStorage().find(2) == std::end(m_dataStore->internalStorage()));
-        EXPECT_EQ(m_dataStore->internalStorage().find(2)->second, m_watcher[1].value);
-        EXPECT_EQ(m_dataStore->internalStorage().find(2)->second, result2);
-        EXPECT_EQ(m_dataStore->internalStorage().find(2)->second->value, 2);
+    const Result::ConstPtr &result2 {this->m_dataStore->add(2, Result(2))};
+    {
+        EXPECT_EQ(this->m_dataStore->internalStorage().size(), static_cast<std::size_t>(2));
+        EXPECT_EQ(this->m_watcher.count(), 2);
+        EXPECT_EQ(this->m_watcher[1].type, ListenerData::Type::Add);
+        EXPECT_EQ(this->m_watcher[1].key, 2);
+        EXPECT_FALSE(this->m_dataStore->internalStorage().find(2) == std::end(this->m_dataStore->internalStorage()));
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(2)->second, this->m_watcher[1].value);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(2)->second, result2);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(2)->second->value, 2);
     }
 }
 
-TEST_F(TstDataStore, AddAsUpdate)
+TYPED_TEST(TstDataStore, AddAsUpdate)
 {
-    const Result::ConstPtr &result1 {m_dataStore->add(1, Result(1))};
-    {
-        EXPECT_EQ(m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
-        EXPECT_EQ(m_watcher.count(), 1);
-        EXPECT_EQ(m_watcher[0].type, ListenerData::Type::Add);
-        EXPECT_EQ(m_watcher[0].key, 1);
-        EXPECT_FALSE(m_dataStore->internalStorage().find(1) == std::end(m_dataStore->internalStorage()));
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, m_watcher[0].value);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, result1);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second->value, 1);
+    const Result::ConstPtr &result1 {this->m_dataStore->add(1, Result(1))};
+    {
+        EXPECT_EQ(this->m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
+        EXPECT_EQ(this->m_watcher.count(), 1);
+        EXPECT_EQ(this->m_watcher[0].type, ListenerData::Type::Add);
+        EXPECT_EQ(this->m_watcher[0].key, 1);
+        EXPECT_FALSE(this->m_dataStore->internalStorage().find(1) == std::end(this->m_dataStore->internalStorage()));
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, this->m_watcher[0].value);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, result1);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second->value, 1);
     }
-    const Result::ConstPtr &result2 {m_dataStore->add(1, Result(2))};
-    {
-        EXPECT_EQ(m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
-        EXPECT_EQ(m_watcher.count(), 2);
-        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::Update);
-        EXPECT_EQ(m_watcher[1].key, 1);
-        EXPECT_FALSE(m_dataStore->internalStorage().find(1) == std::end(m_dataStore->internalStorage()));
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, m_watcher[0].value);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, m_watcher[1].value);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, result1);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, result2);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second->value, 2);
+    const Result::ConstPtr &result2 {this->m_dataStore->add(1, Result(2))};
+    {
+        EXPECT_EQ(this->m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
+        EXPECT_EQ(this->m_watcher.count(), 2);
+        EXPECT_EQ(this->m_watcher[1].type, ListenerData::Type::Update);
+        EXPECT_EQ(this->m_watcher[1].key, 1);
+        EXPECT_FALSE(this->m_dataStore->internalStorage().find(1) == std::end(this->m_dataStore->internalStorage()));
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, this->m_watcher[0].value);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, this->m_watcher[1].value);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, result1);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, result2);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second->value, 2);
     }
 }
 
-TEST_F(TstDataStore, Update)
+TYPED_TEST(TstDataStore, Update)
 {
-    m_dataStore->add(1, Result(1));
-    const Result::ConstPtr &result2 {m_dataStore->update(1, Result(2))};
+    this->m_dataStore->add(1, Result(1));
+    const Result::ConstPtr &result2 {this->m_dataStore->update(1, Result(2))};
     {
         EXPECT_NE(result2, nullptr);
-        EXPECT_EQ(m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
-        EXPECT_EQ(m_watcher.count(), 2);
-        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::Update);
-        EXPECT_EQ(m_watcher[1].key, 1);
-        EXPECT_FALSE(m_dataStore->internalStorage().find(1) == std::end(m_dataStore->internalStorage()));
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, m_watcher[0].value);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, m_watcher[1].value);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second, result2);
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second->value, 2);
+        EXPECT_EQ(this->m_dataStore->internalStorage().size(), static_cast<std::size_t>(1));
+        EXPECT_EQ(this->m_watcher.count(), 2);
+        EXPECT_EQ(this->m_watcher[1].type, ListenerData::Type::Update);
+        EXPECT_EQ(this->m_watcher[1].key, 1);
+        EXPECT_FALSE(this->m_dataStore->internalStorage().find(1) == std::end(this->m_dataStore->internalStorage()));
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, this->m_watcher[0].value);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, this->m_watcher[1].value);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second, result2);
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second->value, 2);
     }
 }
 
-TEST_F(TstDataStore, UpdateInexisting)
+TYPED_TEST(TstDataStore, UpdateInexisting)
 {
-    m_dataStore->add(1, Result(1));
-    const Result::ConstPtr &result2 {m_dataStore->update(2, Result(2))};
+    this->m_dataStore->add(1, Result(1));
+    const Result::ConstPtr &result2 {this->m_dataStore->update(2, Result(2))};
     {
         EXPECT_EQ(result2, nullptr);
-        EXPECT_EQ(m_watcher.count(), 1);
-        EXPECT_FALSE(m_dataStore->internalStorage().find(1) == std::end(m_dataStore->internalStorage()));
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second->value, 1);
+        EXPECT_EQ(this->m_watcher.count(), 1);
+        EXPECT_FALSE(this->m_dataStore->internalStorage().find(1) == std::end(this->m_dataStore->internalStorage()));
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second->value, 1);
     }
 }
 
-TEST_F(TstDataStore, Remove)
+TYPED_TEST(TstDataStore, Remove)
 {
-    m_dataStore->add(1, Result(1));
-    EXPECT_TRUE(m_dataStore->remove(1));
+    this->m_dataStore->add(1, Result(1));
+    EXPECT_TRUE(this->m_dataStore->remove(1));
     {
-        EXPECT_EQ(m_dataStore->internalStorage().size(), static_cast<std::size_t>(0));
-        EXPECT_EQ(m_watcher.count(), 2);
-        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::Remove);
-        EXPECT_EQ(m_watcher[1].key, 1);
+        EXPECT_EQ(this->m_dataStore->internalStorage().size(), static_cast<std::size_t>(0));
+        EXPECT_EQ(this->m_watcher.count(), 2);
+        EXPECT_EQ(this->m_watcher[1].type, ListenerData::Type::Remove);
+        EXPECT_EQ(this->m_watcher[1].key, 1);
     }
 }
 
-TEST_F(TstDataStore, RemoveInexisting)
+TYPED_TEST(TstDataStore, RemoveInexisting)
 {
-    m_dataStore->add(1, Result(1));
-    EXPECT_FALSE(m_dataStore->remove(2));
+    this->m_dataStore->add(1, Result(1));
+    EXPECT_FALSE(this->m_dataStore->remove(2));
     {
-        EXPECT_EQ(m_watcher.count(), 1);
-        EXPECT_FALSE(m_dataStore->internalStorage().find(1) == std::end(m_dataStore->internalStorage()));
-        EXPECT_EQ(m_dataStore->internalStorage().find(1)->second->value, 1);
+        EXPECT_EQ(this->m_watcher.count(), 1);
+        EXPECT_FALSE(this->m_dataStore->internalStorage().find(1) == std::end(this->m_dataStore->internalStorage()));
+        EXPECT_EQ(this->m_dataStore->internalStorage().find(1)->second->value, 1);
     }
 }
 
-TEST_F(TstDataStore, ListenerInvalidation)
+template<class T>
+class TstDataStoreEviction: public Test
+{
+protected:
+    void SetUp()
+    {
+        m_dataStore.addListener(m_listener);
+        m_dataStore.setBudget(12);
+    }
+    IndexedDataStore<int, Result, typename T::Storage, typename T::Eviction> m_dataStore {};
+    std::shared_ptr<RemoveListener> m_listener {std::make_shared<RemoveListener>()};
+};
+
+using EvictionPolicies = Types<Policies<OrderedStorage, LruEviction>, Policies<OrderedStorage, ClockEviction>,
+                               Policies<FlatHashStorage, LruEviction>, Policies<FlatHashStorage, ClockEviction>>;
+TYPED_TEST_CASE(TstDataStoreEviction, EvictionPolicies);
+
+TYPED_TEST(TstDataStoreEviction, Budget)
+{
+    this->m_dataStore.add(1, Result(4));
+    this->m_dataStore.add(2, Result(4));
+    this->m_dataStore.add(3, Result(4));
+    EXPECT_EQ(this->m_dataStore.bytes(), static_cast<std::size_t>(12));
+    EXPECT_TRUE(this->m_listener->removed.empty());
+
+    this->m_dataStore.add(4, Result(4));
+    EXPECT_EQ(this->m_listener->removed, std::vector<int>({1}));
+    EXPECT_EQ(this->m_dataStore.bytes(), static_cast<std::size_t>(12));
+    EXPECT_EQ(this->m_dataStore.evictionStatistics().evictions, static_cast<std::uint64_t>(1));
+    EXPECT_EQ(this->m_dataStore.evictionStatistics().evictedBytes, static_cast<std::uint64_t>(4));
+
+    // Removed entries are not evicted anymore
+    this->m_dataStore.remove(2);
+    this->m_dataStore.setBudget(4);
+    EXPECT_EQ(this->m_listener->removed, std::vector<int>({1, 2, 3}));
+    EXPECT_EQ(this->m_dataStore.bytes(), static_cast<std::size_t>(4));
+}
+
+TYPED_TEST(TstDataStoreEviction, Touch)
+{
+    this->m_dataStore.add(1, Result(4));
+    this->m_dataStore.add(2, Result(4));
+    this->m_dataStore.add(3, Result(4));
+    this->m_dataStore.add(4, Result(4));
+    this->m_dataStore.touch(2);
+    this->m_dataStore.add(5, Result(4));
+    EXPECT_EQ(this->m_listener->removed, std::vector<int>({1, 3}));
+}
+
+TYPED_TEST(TstDataStoreEviction, ValueTouches)
+{
+    this->m_dataStore.add(1, Result(4));
+    this->m_dataStore.add(2, Result(4));
+    this->m_dataStore.add(3, Result(4));
+    this->m_dataStore.add(4, Result(4));
+    EXPECT_NE(this->m_dataStore.value(2), nullptr);
+    this->m_dataStore.add(5, Result(4));
+    EXPECT_EQ(this->m_listener->removed, std::vector<int>({1, 3}));
+}
+
+TYPED_TEST(TstDataStoreEviction, Update)
+{
+    this->m_dataStore.add(1, Result(4));
+    this->m_dataStore.add(2, Result(4));
+    this->m_dataStore.add(3, Result(4));
+
+    // The updated entry is kept
+    this->m_dataStore.update(1, Result(10));
+    EXPECT_EQ(this->m_listener->removed, std::vector<int>({2, 3}));
+    EXPECT_EQ(this->m_dataStore.bytes(), static_cast<std::size_t>(10));
+    this->m_dataStore.add(1, Result(20));
+    EXPECT_EQ(this->m_dataStore.bytes(), static_cast<std::size_t>(20));
+}
+
+TYPED_TEST(TstDataStoreEviction, Pin)
+{
+    this->m_dataStore.add(1, Result(4));
+    this->m_dataStore.add(2, Result(4));
+    this->m_dataStore.add(3, Result(4));
+    this->m_dataStore.pin(1);
+    this->m_dataStore.pin(1);
+    this->m_dataStore.pin(2);
+    this->m_dataStore.add(4, Result(4));
+    EXPECT_EQ(this->m_listener->removed, std::vector<int>({3}));
+
+    // Pinned entries exceed the budget
+    this->m_dataStore.pin(4);
+    this->m_dataStore.add(5, Result(4));
+    EXPECT_EQ(this->m_dataStore.bytes(), static_cast<std::size_t>(16));
+    this->m_dataStore.add(6, Result(4));
+    EXPECT_EQ(this->m_listener->removed, std::vector<int>({3, 5}));
+
+    // 1 is pinned twice
+    this->m_dataStore.unpin(1);
+    this->m_dataStore.unpin(2);
+    EXPECT_EQ(this->m_listener->removed.size(), static_cast<std::size_t>(3));
+    EXPECT_EQ(this->m_dataStore.bytes(), static_cast<std::size_t>(12));
+    this->m_dataStore.unpin(1);
+    this->m_dataStore.setBudget(4);
+    EXPECT_EQ(this->m_listener->removed.size(), static_cast<std::size_t>(5));
+    EXPECT_EQ(this->m_listener->removed.back(), 1);
+
+    // Pins are removed with the entry
+    this->m_dataStore.remove(4);
+    this->m_dataStore.add(4, Result(4));
+    this->m_dataStore.setBudget(1);
+    EXPECT_EQ(this->m_listener->removed.back(), 4);
+    EXPECT_EQ(this->m_dataStore.bytes(), static_cast<std::size_t>(0));
+}
+
+TYPED_TEST(TstDataStore, ListenerInvalidation)
 {
-    EXPECT_EQ(m_watcher.count(), 0);
+    EXPECT_EQ(this->m_watcher.count(), 0);
 
-    m_dataStore.reset();
-    EXPECT_EQ(m_watcher.count(), 1);
-    EXPECT_EQ(m_watcher[0].type, ListenerData::Type::Invalidation);
-    m_invalidated = true;
+    this->m_dataStore.reset();
+    EXPECT_EQ(this->m_watcher.count(), 1);
+    EXPECT_EQ(this->m_watcher[0].type, ListenerData::Type::Invalidation);
+    this->m_invalidated = true;
 }
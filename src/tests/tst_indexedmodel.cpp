@@ -32,6 +32,8 @@
 #include <gtest/gtest.h>
 #include <microcore/data/indexeddatastore.h>
 #include <microcore/data/indexedmodel.h>
+#include <algorithm>
+#include <random>
 #include "mockmodellistener.h"
 
 using namespace ::testing;
@@ -46,6 +48,10 @@ public:
     explicit Result(int v) : key {v}, value {v} {}
     explicit Result (int k, int v) : key {k}, value {v} {}
     DEFAULT_COPY_DEFAULT_MOVE(Result);
+    bool operator==(const Result &other) const
+    {
+        return key == other.key && value == other.value;
+    }
     int key {0};
     int value {0};
 };
@@ -82,7 +88,9 @@ public:
         Remove,
         Update,
         Move,
-        Invalidation
+        Invalidation,
+        RemoveRange,
+        UpdateRange
     };
     explicit ListenerData() = default;
     explicit ListenerData(Type t)
@@ -160,6 +168,14 @@ public:
     {
         m_data.emplace_back(ListenerData::Type::Invalidation);
     }
+    void onRemoveRange(std::size_t index, std::size_t count)
+    {
+        m_data.emplace_back(ListenerData::Type::RemoveRange, static_cast<int>(index), static_cast<int>(count));
+    }
+    void onUpdateRange(std::size_t index, const std::vector<const Result *> &values)
+    {
+        m_data.emplace_back(ListenerData::Type::UpdateRange, static_cast<int>(index), values);
+    }
 private:
     std::vector<ListenerData> m_data {};
 };
@@ -188,6 +204,8 @@ protected:
         ON_CALL(*m_listener, onUpdate(_, _)).WillByDefault(Invoke(&m_watcher, &ListenerWatcher::onUpdate));
         ON_CALL(*m_listener, onMove(_, _)).WillByDefault(Invoke(&m_watcher, &ListenerWatcher::onMove));
         ON_CALL(*m_listener, onInvalidation()).WillByDefault(Invoke(&m_watcher, &ListenerWatcher::onInvalidation));
+        ON_CALL(*m_listener, onRemoveRange(_, _)).WillByDefault(Invoke(&m_watcher, &ListenerWatcher::onRemoveRange));
+        ON_CALL(*m_listener, onUpdateRange(_, _)).WillByDefault(Invoke(&m_watcher, &ListenerWatcher::onUpdateRange));
         m_model->addListener(m_listener);
         m_model->addListener(ResultModel::IListener::Ptr());
     }
@@ -606,6 +624,291 @@ TEST_F(TstIndexedModel, MoveFailed)
     }
 }
 
+TEST_F(TstIndexedModel, RemoveRange)
+{
+    m_model->append({Result(1), Result(2), Result(3), Result(4)});
+    m_model->removeRange(1, 2);
+    {
+        EXPECT_EQ(m_model->size(), static_cast<std::size_t>(2));
+        EXPECT_EQ(m_watcher.count(), 2);
+        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::RemoveRange);
+        EXPECT_EQ(m_watcher[1].index1, 1);
+        EXPECT_EQ(m_watcher[1].index2, 2);
+        EXPECT_EQ(m_dataStore->data().size(), static_cast<std::size_t>(2));
+
+        EXPECT_EQ((*m_model)[0]->key, 1);
+        EXPECT_EQ((*m_model)[1]->key, 4);
+    }
+
+    // The range is truncated to the model
+    m_model->removeRange(1, 10);
+    {
+        EXPECT_EQ(m_model->size(), static_cast<std::size_t>(1));
+        EXPECT_EQ(m_watcher.count(), 3);
+        EXPECT_EQ(m_watcher[2].index1, 1);
+        EXPECT_EQ(m_watcher[2].index2, 1);
+    }
+
+    // An external remove still finds the remaining row
+    m_dataStore->remove(1);
+    {
+        EXPECT_TRUE(m_model->empty());
+        EXPECT_EQ(m_watcher.count(), 4);
+        EXPECT_EQ(m_watcher[3].type, ListenerData::Type::Remove);
+        EXPECT_EQ(m_watcher[3].index1, 0);
+    }
+}
+
+TEST_F(TstIndexedModel, RemoveRangeFailed)
+{
+    m_model->append({Result(1), Result(2)});
+    m_model->removeRange(2, 1);
+    m_model->removeRange(0, 0);
+    {
+        EXPECT_EQ(m_model->size(), static_cast<std::size_t>(2));
+        EXPECT_EQ(m_watcher.count(), 1);
+    }
+}
+
+TEST_F(TstIndexedModel, RemoveIf)
+{
+    m_model->append({Result(1), Result(2), Result(3), Result(4), Result(5), Result(6)});
+    int calls {0};
+    m_model->removeIf([&calls](const Result &result) {
+        ++calls;
+        return result.key != 3 && result.key != 4;
+    });
+    {
+        EXPECT_EQ(calls, 6);
+        EXPECT_EQ(m_model->size(), static_cast<std::size_t>(2));
+        // Runs are removed starting from the last one
+        EXPECT_EQ(m_watcher.count(), 3);
+        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::RemoveRange);
+        EXPECT_EQ(m_watcher[1].index1, 4);
+        EXPECT_EQ(m_watcher[1].index2, 2);
+        EXPECT_EQ(m_watcher[2].type, ListenerData::Type::RemoveRange);
+        EXPECT_EQ(m_watcher[2].index1, 0);
+        EXPECT_EQ(m_watcher[2].index2, 2);
+
+        EXPECT_EQ((*m_model)[0]->key, 3);
+        EXPECT_EQ((*m_model)[1]->key, 4);
+    }
+}
+
+TEST_F(TstIndexedModel, UpdateMany)
+{
+    m_model->append({Result(1), Result(2), Result(3)});
+    m_model->updateMany(1, {Result(2, 4), Result(4, 5)});
+    {
+        EXPECT_EQ(m_watcher.count(), 2);
+        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::UpdateRange);
+        EXPECT_EQ(m_watcher[1].index1, 1);
+        ASSERT_EQ(m_watcher[1].values.size(), static_cast<std::size_t>(1));
+        EXPECT_EQ(m_watcher[1].values[0], (*m_model)[1]);
+
+        // The key of the last row would change, it is not updated
+        EXPECT_EQ((*m_model)[1]->value, 4);
+        EXPECT_EQ((*m_model)[2]->key, 3);
+        EXPECT_EQ((*m_model)[2]->value, 3);
+    }
+}
+
+TEST_F(TstIndexedModel, UpdateManyRuns)
+{
+    m_model->append({Result(1), Result(2), Result(3), Result(4), Result(5)});
+    m_model->updateMany(0, {Result(1, 6), Result(9, 9), Result(3, 7), Result(4, 8)});
+    {
+        // The skipped row splits the notification
+        EXPECT_EQ(m_watcher.count(), 3);
+        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::UpdateRange);
+        EXPECT_EQ(m_watcher[1].index1, 0);
+        ASSERT_EQ(m_watcher[1].values.size(), static_cast<std::size_t>(1));
+        EXPECT_EQ(m_watcher[1].values[0], (*m_model)[0]);
+        EXPECT_EQ(m_watcher[2].type, ListenerData::Type::UpdateRange);
+        EXPECT_EQ(m_watcher[2].index1, 2);
+        ASSERT_EQ(m_watcher[2].values.size(), static_cast<std::size_t>(2));
+        EXPECT_EQ(m_watcher[2].values[0], (*m_model)[2]);
+        EXPECT_EQ(m_watcher[2].values[1], (*m_model)[3]);
+        EXPECT_EQ((*m_model)[1]->value, 2);
+        EXPECT_EQ((*m_model)[3]->value, 8);
+    }
+
+    // No row is updated
+    m_model->updateMany(1, {Result(9, 9)});
+    EXPECT_EQ(m_watcher.count(), 3);
+}
+
+TEST_F(TstIndexedModel, Clear)
+{
+    m_model->clear();
+    EXPECT_EQ(m_watcher.count(), 0);
+
+    m_model->append({Result(1), Result(2), Result(3)});
+    m_model->clear();
+    {
+        EXPECT_TRUE(m_model->empty());
+        EXPECT_TRUE(m_dataStore->data().empty());
+        EXPECT_EQ(m_watcher.count(), 2);
+        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::RemoveRange);
+        EXPECT_EQ(m_watcher[1].index1, 0);
+        EXPECT_EQ(m_watcher[1].index2, 3);
+    }
+}
+
+TEST_F(TstIndexedModel, Replace)
+{
+    m_model->append({Result(1), Result(2), Result(3), Result(4), Result(5)});
+    m_model->replace({Result(1), Result(3), Result(2, 7), Result(6), Result(5), Result(3, 8)});
+    {
+        EXPECT_EQ(m_model->size(), static_cast<std::size_t>(5));
+        EXPECT_EQ(m_watcher.count(), 5);
+        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::RemoveRange);
+        EXPECT_EQ(m_watcher[1].index1, 3);
+        EXPECT_EQ(m_watcher[1].index2, 1);
+        // 1, 3 and 5 are kept in place, only 2 is moved
+        EXPECT_EQ(m_watcher[2].type, ListenerData::Type::Move);
+        EXPECT_EQ(m_watcher[2].index1, 1);
+        EXPECT_EQ(m_watcher[2].index2, 3);
+        EXPECT_EQ(m_watcher[3].type, ListenerData::Type::Insert);
+        EXPECT_EQ(m_watcher[3].index1, 3);
+        ASSERT_EQ(m_watcher[3].values.size(), static_cast<std::size_t>(1));
+        EXPECT_EQ(m_watcher[3].values[0]->key, 6);
+        EXPECT_EQ(m_watcher[4].type, ListenerData::Type::UpdateRange);
+        EXPECT_EQ(m_watcher[4].index1, 2);
+        ASSERT_EQ(m_watcher[4].values.size(), static_cast<std::size_t>(1));
+        EXPECT_EQ(m_watcher[4].values[0]->value, 7);
+
+        std::vector<int> keys {1, 3, 2, 6, 5};
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ((*m_model)[i]->key, keys[i]);
+            EXPECT_EQ((*m_model)[i], m_dataStore->data().at(keys[i]).get());
+        }
+        EXPECT_EQ((*m_model)[1]->value, 3);
+        EXPECT_EQ(m_dataStore->data().size(), static_cast<std::size_t>(5));
+    }
+
+    // An external update still finds the moved row
+    m_dataStore->update(2, Result(2, 9));
+    {
+        EXPECT_EQ(m_watcher.count(), 6);
+        EXPECT_EQ(m_watcher[5].type, ListenerData::Type::Update);
+        EXPECT_EQ(m_watcher[5].index1, 2);
+    }
+}
+
+TEST_F(TstIndexedModel, ReplaceDuplicates)
+{
+    m_model->append({Result(1), Result(2), Result(3)});
+    // The last value would be in place, but its key is already used
+    m_model->replace({Result(1), Result(3, 5), Result(2), Result(3, 9)});
+    {
+        std::vector<int> keys {1, 3, 2};
+        ASSERT_EQ(m_model->size(), keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ((*m_model)[i]->key, keys[i]);
+        }
+        EXPECT_EQ((*m_model)[1]->value, 5);
+        EXPECT_EQ(m_dataStore->data().at(3)->value, 5);
+    }
+}
+
+TEST_F(TstIndexedModel, ReplaceUnchanged)
+{
+    m_model->append({Result(1), Result(2), Result(3)});
+    m_model->replace({Result(1), Result(2), Result(3)});
+    {
+        EXPECT_EQ(m_model->size(), static_cast<std::size_t>(3));
+        EXPECT_EQ(m_watcher.count(), 1);
+    }
+}
+
+TEST_F(TstIndexedModel, ReplaceReversed)
+{
+    m_model->append({Result(1), Result(2), Result(3), Result(4)});
+    m_model->replace({Result(4), Result(3), Result(2), Result(1)});
+    {
+        // Only one row can be kept in place
+        EXPECT_EQ(m_watcher.count(), 4);
+        for (int i = 1; i < 4; ++i) {
+            EXPECT_EQ(m_watcher[i].type, ListenerData::Type::Move);
+        }
+        for (std::size_t i = 0; i < 4; ++i) {
+            EXPECT_EQ((*m_model)[i]->key, static_cast<int>(4 - i));
+        }
+    }
+}
+
+TEST_F(TstIndexedModel, ReplaceEmpty)
+{
+    m_model->replace({Result(1), Result(2)});
+    {
+        EXPECT_EQ(m_model->size(), static_cast<std::size_t>(2));
+        EXPECT_EQ(m_watcher.count(), 1);
+        EXPECT_EQ(m_watcher[0].type, ListenerData::Type::Insert);
+        EXPECT_EQ(m_watcher[0].index1, 0);
+        EXPECT_EQ(m_watcher[0].values.size(), static_cast<std::size_t>(2));
+    }
+    m_model->replace({});
+    {
+        EXPECT_TRUE(m_model->empty());
+        EXPECT_EQ(m_watcher.count(), 2);
+        EXPECT_EQ(m_watcher[1].type, ListenerData::Type::RemoveRange);
+    }
+}
+
+// Replace with random values, checking that the listener can follow
+TEST_F(TstIndexedModel, ReplaceRandom)
+{
+    std::mt19937 generator {1};
+    std::vector<int> rows {};
+    for (int i = 0; i < 100; ++i) {
+        std::vector<Result> values {};
+        std::vector<int> keys {};
+        for (int key = 0; key < 30; ++key) {
+            if (generator() % 3 != 0) {
+                keys.emplace_back(key);
+            }
+        }
+        std::shuffle(std::begin(keys), std::end(keys), generator);
+        for (int key : keys) {
+            values.emplace_back(key, static_cast<int>(generator() % 2));
+        }
+
+        m_watcher.clear();
+        m_model->replace(std::move(values));
+
+        // Replay the events
+        for (int j = 0; j < m_watcher.count(); ++j) {
+            const ListenerData &data {m_watcher[j]};
+            switch (data.type) {
+            case ListenerData::Type::RemoveRange:
+                rows.erase(std::begin(rows) + data.index1, std::begin(rows) + data.index1 + data.index2);
+                break;
+            case ListenerData::Type::Move: {
+                int key {rows[data.index1]};
+                rows.erase(std::begin(rows) + data.index1);
+                rows.insert(std::begin(rows) + (data.index2 < data.index1 ? data.index2 : data.index2 - 1), key);
+                break;
+            }
+            case ListenerData::Type::Insert:
+                for (std::size_t k = 0; k < data.values.size(); ++k) {
+                    rows.insert(std::begin(rows) + data.index1 + k, data.values[k]->key);
+                }
+                break;
+            case ListenerData::Type::UpdateRange:
+                break;
+            default:
+                FAIL();
+            }
+        }
+        ASSERT_EQ(rows, keys);
+        ASSERT_EQ(m_model->size(), keys.size());
+        for (std::size_t j = 0; j < keys.size(); ++j) {
+            ASSERT_EQ((*m_model)[j]->key, keys[j]);
+        }
+    }
+}
+
 TEST_F(TstIndexedModel, ExternalUpdate)
 {
     m_model->append({Result(1), Result(2)});
@@ -666,6 +969,31 @@ TEST_F(TstIndexedModel, ExternalRemoveFailed)
     }
 }
 
+TEST_F(TstIndexedModel, ExternalAfterMoves)
+{
+    m_model->append({Result(1), Result(2), Result(3)});
+    m_model->prepend({Result(4)});
+    m_model->insert(2, {Result(5)});
+    m_model->move(0, 5);
+    m_model->remove(1);
+    // Model is now 1, 2, 3, 4
+    m_dataStore->update(4, Result(4, 6));
+    m_dataStore->remove(2);
+    {
+        EXPECT_EQ(m_model->size(), static_cast<std::size_t>(3));
+        EXPECT_EQ(m_watcher.count(), 7);
+        EXPECT_EQ(m_watcher[5].type, ListenerData::Type::Update);
+        EXPECT_EQ(m_watcher[5].index1, 3);
+        EXPECT_EQ(m_watcher[5].value->value, 6);
+        EXPECT_EQ(m_watcher[6].type, ListenerData::Type::Remove);
+        EXPECT_EQ(m_watcher[6].index1, 1);
+
+        EXPECT_EQ((*m_model)[0]->key, 1);
+        EXPECT_EQ((*m_model)[1]->key, 3);
+        EXPECT_EQ((*m_model)[2]->key, 4);
+    }
+}
+
 TEST_F(TstIndexedModel, Accessors)
 {
     m_model->append({Result(1), Result(2)});
@@ -713,6 +1041,24 @@ TEST_F(TstIndexedModel, ListenerDelayAdd)
     }
 }
 
+// Rows of a model are not evicted from the data store
+TEST(TstIndexedModelEviction, Pinned)
+{
+    IndexedDataStore<int, Result, OrderedStorage, LruEviction> dataStore {};
+    dataStore.setBudget(3 * sizeof(Result));
+    std::unique_ptr<IndexedModel<Result, ResultMapper>> model {new IndexedModel<Result, ResultMapper>(dataStore)};
+    model->append({Result(1), Result(2), Result(3), Result(4)});
+    dataStore.add(5, Result(5));
+    dataStore.add(6, Result(6));
+    EXPECT_EQ(model->size(), static_cast<std::size_t>(4));
+    EXPECT_EQ(dataStore.evictionStatistics().evictions, static_cast<std::uint64_t>(1));
+
+    // Rows are unpinned, and evicted, once the model is destroyed
+    model.reset();
+    EXPECT_EQ(dataStore.bytes(), 3 * sizeof(Result));
+    EXPECT_EQ(dataStore.evictionStatistics().evictions, static_cast<std::uint64_t>(3));
+}
+
 TEST_F(TstIndexedModel, ListenerInvalidation)
 {
     EXPECT_EQ(m_watcher.count(), 0);
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <QtTest/QTest>
+#include <microcore/core/instrumentation.h>
+#include <microcore/core/executor.h>
+#include <microcore/core/pipe.h>
+#include <limits>
+#include <thread>
+#include <type_traits>
+
+using namespace ::testing;
+using namespace ::microcore::core;
+
+namespace {
+
+class Error
+{
+public:
+    explicit Error() = default;
+    explicit Error(int v) : value {v} {}
+    bool empty() const
+    {
+        return value == 0;
+    }
+    static Error cancelled()
+    {
+        return Error(-1);
+    }
+    static Error timeout()
+    {
+        return Error(-2);
+    }
+    int value {0};
+};
+
+class TestExecutor : public Executor<Error>
+{
+public:
+    void start()
+    {
+        doStart();
+    }
+    void finish()
+    {
+        doFinish();
+    }
+    void fail()
+    {
+        doError(Error(1));
+    }
+};
+
+class EchoJobFactory final : public IJobFactory<int, QByteArray, Error>
+{
+public:
+    std::unique_ptr<IJob<QByteArray, Error>> create(int &&request) const override
+    {
+        return std::unique_ptr<IJob<QByteArray, Error>>(new Job(request));
+    }
+private:
+    class Job final : public IJob<QByteArray, Error>
+    {
+    public:
+        explicit Job(int request) : m_request {request} {}
+        void execute(OnResult &&onResult, OnError &&onError) override
+        {
+            if (m_request < 0) {
+                onError(Error(m_request));
+            } else {
+                onResult(QByteArray(m_request, 'a'));
+            }
+        }
+    private:
+        int m_request {0};
+    };
+};
+
+}
+
+TEST(TstInstrumentation, HistogramEmpty)
+{
+    Histogram histogram {};
+    EXPECT_EQ(histogram.count(), static_cast<std::uint64_t>(0));
+    EXPECT_EQ(histogram.percentile(50), static_cast<std::uint64_t>(0));
+}
+
+TEST(TstInstrumentation, HistogramPercentiles)
+{
+    Histogram histogram {};
+    for (std::uint64_t i = 1; i <= 1000; ++i) {
+        histogram.record(i);
+    }
+    EXPECT_EQ(histogram.count(), static_cast<std::uint64_t>(1000));
+    EXPECT_EQ(histogram.sum(), static_cast<std::uint64_t>(500500));
+    EXPECT_EQ(histogram.max(), static_cast<std::uint64_t>(1000));
+    EXPECT_NEAR(static_cast<double>(histogram.percentile(50)), 500., 125.);
+    EXPECT_NEAR(static_cast<double>(histogram.percentile(95)), 950., 240.);
+    EXPECT_NEAR(static_cast<double>(histogram.percentile(99)), 990., 250.);
+    EXPECT_LE(histogram.percentile(100), static_cast<std::uint64_t>(1000));
+
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), static_cast<std::uint64_t>(0));
+    EXPECT_EQ(histogram.max(), static_cast<std::uint64_t>(0));
+}
+
+TEST(TstInstrumentation, HistogramLargeValues)
+{
+    Histogram histogram {};
+    histogram.record(0);
+    histogram.record(std::numeric_limits<std::uint64_t>::max());
+    EXPECT_EQ(histogram.percentile(50), static_cast<std::uint64_t>(0));
+    EXPECT_GE(histogram.percentile(100), static_cast<std::uint64_t>(1) << 63);
+    EXPECT_EQ(histogram.max(), std::numeric_limits<std::uint64_t>::max());
+}
+
+TEST(TstInstrumentation, HistogramConcurrent)
+{
+    Histogram histogram {};
+    std::vector<std::thread> threads {};
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&histogram, i]() {
+            for (std::uint64_t j = 0; j < 10000; ++j) {
+                histogram.record(j + static_cast<std::uint64_t>(i));
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(histogram.count(), static_cast<std::uint64_t>(40000));
+    EXPECT_EQ(histogram.max(), static_cast<std::uint64_t>(10002));
+}
+
+TEST(TstInstrumentation, Stages)
+{
+    Instrumentation instrumentation {};
+    StageStatistics &http {instrumentation.stage("http")};
+    EXPECT_EQ(&http, &instrumentation.stage("http"));
+    instrumentation.stage("json").results += 2;
+    http.executeTime.record(100);
+
+    std::vector<StageStatistics::Summary> summaries {instrumentation.summaries()};
+    ASSERT_EQ(summaries.size(), static_cast<std::size_t>(2));
+    EXPECT_EQ(summaries[0].name, "http");
+    EXPECT_EQ(summaries[0].executeTime.max, static_cast<std::uint64_t>(100));
+    EXPECT_EQ(summaries[1].name, "json");
+    EXPECT_EQ(summaries[1].results, static_cast<std::uint64_t>(2));
+
+    std::string dump {instrumentation.dump()};
+    EXPECT_NE(dump.find("http results=0 errors=0"), std::string::npos);
+    EXPECT_NE(dump.find("json results=2"), std::string::npos);
+
+    instrumentation.reset();
+    EXPECT_EQ(instrumentation.summaries()[1].results, static_cast<std::uint64_t>(0));
+}
+
+TEST(TstInstrumentation, PeriodicDump)
+{
+    Instrumentation instrumentation {};
+    instrumentation.stage("http");
+    std::vector<std::string> dumps {};
+    instrumentation.startDump(10, [&dumps](const std::string &dump) {
+        dumps.push_back(dump);
+    });
+    QTest::qWait(50);
+    instrumentation.stopDump();
+    ASSERT_FALSE(dumps.empty());
+    EXPECT_EQ(dumps.front().find("http"), static_cast<std::size_t>(0));
+}
+
+TEST(TstInstrumentation, Disabled)
+{
+    // Stages do not pay for instrumentation when it is disabled
+    static_assert(InstrumentationEnabled || std::is_empty<Stopwatch>::value, "Stopwatch");
+    static_assert(InstrumentationEnabled || std::is_empty<InstrumentedStage>::value, "InstrumentedStage");
+    Stopwatch stopwatch {};
+    EXPECT_EQ(stopwatch.elapsed(), static_cast<std::uint64_t>(0));
+}
+
+TEST(TstInstrumentation, Pipe)
+{
+    Instrumentation instrumentation {};
+    StageStatistics &statistics {instrumentation.stage("echo")};
+    EchoJobFactory factory {};
+    Pipe<int, QByteArray, Error> pipe {factory, [](QByteArray &&) {}, [](Error &&) {}};
+    pipe.setStatistics(&statistics);
+    pipe.send(10);
+    pipe.send(20);
+    pipe.send(-1);
+
+    if (InstrumentationEnabled) {
+        EXPECT_EQ(statistics.results.load(), static_cast<std::uint64_t>(2));
+        EXPECT_EQ(statistics.errors.load(), static_cast<std::uint64_t>(1));
+        EXPECT_EQ(statistics.queueTime.count(), static_cast<std::uint64_t>(3));
+        EXPECT_EQ(statistics.executeTime.count(), static_cast<std::uint64_t>(3));
+        EXPECT_EQ(statistics.resultSize.max(), static_cast<std::uint64_t>(20));
+    } else {
+        EXPECT_EQ(statistics.results.load(), static_cast<std::uint64_t>(0));
+        EXPECT_EQ(statistics.executeTime.count(), static_cast<std::uint64_t>(0));
+    }
+}
+
+TEST(TstInstrumentation, Executor)
+{
+    Instrumentation instrumentation {};
+    StageStatistics &statistics {instrumentation.stage("executor")};
+    TestExecutor executor {};
+    executor.setStatistics(&statistics);
+    executor.start();
+    executor.finish();
+    executor.start();
+    executor.fail();
+
+    std::uint64_t expected {InstrumentationEnabled ? static_cast<std::uint64_t>(1) : 0};
+    EXPECT_EQ(statistics.results.load(), expected);
+    EXPECT_EQ(statistics.errors.load(), expected);
+    EXPECT_EQ(statistics.executeTime.count(), 2 * expected);
+}
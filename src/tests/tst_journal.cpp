@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/data/journal.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace ::testing;
+using namespace ::microcore::data;
+
+namespace {
+
+using Store = IndexedDataStore<int, std::string>;
+using StoreJournal = Journal<int, std::string>;
+
+std::string read(const std::string &path)
+{
+    std::ifstream file {path, std::ios::binary};
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void write(const std::string &path, const std::string &data)
+{
+    std::ofstream file {path, std::ios::binary | std::ios::trunc};
+    file << data;
+}
+
+bool exists(const std::string &path)
+{
+    return std::ifstream(path).good();
+}
+
+}
+
+class TstJournal: public Test
+{
+protected:
+    void SetUp()
+    {
+        TearDown();
+    }
+    void TearDown()
+    {
+        std::remove(m_path.c_str());
+        std::remove((m_path + ".journal").c_str());
+        std::remove((m_path + ".journal.old").c_str());
+    }
+    std::string value(Store &store, int key)
+    {
+        Store::ValuePtr value {store.value(key)};
+        return value ? *value : std::string("none");
+    }
+    std::string m_path {TempDir() + "tst_journal"};
+};
+
+TEST_F(TstJournal, Replay)
+{
+    {
+        Store store {};
+        StoreJournal journal {store, m_path};
+        EXPECT_TRUE(journal.open());
+        store.add(1, std::string("one"));
+        store.add(2, std::string("two"));
+        store.add(3, std::string("three"));
+        store.update(2, std::string("updated"));
+        store.remove(3);
+        EXPECT_TRUE(journal.commit());
+    }
+    Store store {};
+    StoreJournal journal {store, m_path};
+    EXPECT_TRUE(journal.open());
+    EXPECT_EQ(value(store, 1), std::string("one"));
+    EXPECT_EQ(value(store, 2), std::string("updated"));
+    EXPECT_EQ(value(store, 3), std::string("none"));
+}
+
+TEST_F(TstJournal, ReplayOnSnapshot)
+{
+    {
+        Store store {};
+        store.add(1, std::string("one"));
+        store.add(2, std::string("two"));
+        EXPECT_TRUE(store.saveSnapshot(m_path));
+        StoreJournal journal {store, m_path};
+        EXPECT_TRUE(journal.open());
+        store.update(1, std::string("updated"));
+        store.remove(2);
+        store.add(3, std::string("three"));
+    }
+    Store store {};
+    StoreJournal journal {store, m_path};
+    EXPECT_TRUE(journal.open());
+    EXPECT_EQ(value(store, 1), std::string("updated"));
+    EXPECT_EQ(value(store, 2), std::string("none"));
+    EXPECT_EQ(value(store, 3), std::string("three"));
+}
+
+TEST_F(TstJournal, RemoveFromSnapshot)
+{
+    {
+        Store store {};
+        store.add(1, std::string("one"));
+        store.add(2, std::string("two"));
+        EXPECT_TRUE(store.saveSnapshot(m_path));
+    }
+    {
+        // The removed key is still in the snapshot, and not decoded
+        Store store {};
+        StoreJournal journal {store, m_path};
+        EXPECT_TRUE(journal.open());
+        EXPECT_TRUE(store.remove(2));
+        EXPECT_FALSE(store.contains(2));
+    }
+    Store store {};
+    StoreJournal journal {store, m_path};
+    EXPECT_TRUE(journal.open());
+    EXPECT_FALSE(store.contains(2));
+    EXPECT_EQ(value(store, 1), std::string("one"));
+    EXPECT_EQ(value(store, 2), std::string("none"));
+}
+
+TEST_F(TstJournal, GroupCommit)
+{
+    Store store {};
+    StoreJournal journal {store, m_path};
+    EXPECT_TRUE(journal.open());
+    store.add(1, std::string("one"));
+    store.add(2, std::string("two"));
+    EXPECT_GT(journal.pending(), static_cast<std::size_t>(0));
+    EXPECT_EQ(journal.size(), static_cast<std::size_t>(0));
+    std::size_t pending {journal.pending()};
+    EXPECT_TRUE(journal.commit());
+    EXPECT_EQ(journal.pending(), static_cast<std::size_t>(0));
+    EXPECT_EQ(journal.size(), pending);
+
+    journal.setCommitSize(1);
+    store.add(3, std::string("three"));
+    EXPECT_EQ(journal.pending(), static_cast<std::size_t>(0));
+    EXPECT_GT(journal.size(), pending);
+}
+
+TEST_F(TstJournal, PartialRecord)
+{
+    {
+        Store store {};
+        StoreJournal journal {store, m_path};
+        EXPECT_TRUE(journal.open());
+        store.add(1, std::string("one"));
+        EXPECT_TRUE(journal.commit());
+        store.add(2, std::string("two"));
+    }
+    std::string data {read(m_path + ".journal")};
+    write(m_path + ".journal", data.substr(0, data.size() - 2));
+    {
+        Store store {};
+        StoreJournal journal {store, m_path};
+        EXPECT_TRUE(journal.open());
+        EXPECT_EQ(value(store, 1), std::string("one"));
+        EXPECT_EQ(value(store, 2), std::string("none"));
+        store.add(3, std::string("three"));
+    }
+    Store store {};
+    StoreJournal journal {store, m_path};
+    EXPECT_TRUE(journal.open());
+    EXPECT_EQ(value(store, 1), std::string("one"));
+    EXPECT_EQ(value(store, 3), std::string("three"));
+}
+
+TEST_F(TstJournal, OtherFormat)
+{
+    {
+        Store store {};
+        StoreJournal journal {store, m_path, 1};
+        EXPECT_TRUE(journal.open());
+        store.add(1, std::string("one"));
+    }
+    Store store {};
+    StoreJournal journal {store, m_path, 2};
+    EXPECT_TRUE(journal.open());
+    EXPECT_FALSE(store.contains(1));
+    EXPECT_EQ(journal.size(), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstJournal, Compaction)
+{
+    {
+        Store store {};
+        StoreJournal journal {store, m_path};
+        journal.setCompactionSize(64);
+        EXPECT_TRUE(journal.open());
+        for (int i = 0; i < 10; ++i) {
+            store.add(i, std::to_string(i));
+        }
+        EXPECT_TRUE(journal.commit());
+        journal.waitForCompaction();
+        EXPECT_EQ(journal.size(), static_cast<std::size_t>(0));
+        EXPECT_TRUE(exists(m_path));
+        EXPECT_FALSE(exists(m_path + ".journal.old"));
+        store.remove(0);
+    }
+    Store store {};
+    EXPECT_TRUE(store.openSnapshot(m_path));
+    EXPECT_EQ(value(store, 0), std::string("0"));
+
+    Store journaled {};
+    StoreJournal journal {journaled, m_path};
+    EXPECT_TRUE(journal.open());
+    EXPECT_EQ(value(journaled, 0), std::string("none"));
+    EXPECT_EQ(value(journaled, 9), std::string("9"));
+}
+
+TEST_F(TstJournal, InterruptedCompaction)
+{
+    {
+        Store store {};
+        StoreJournal journal {store, m_path};
+        EXPECT_TRUE(journal.open());
+        store.add(1, std::string("one"));
+        store.add(2, std::string("two"));
+        EXPECT_TRUE(journal.commit());
+    }
+    // The journal was rotated, but the snapshot was not written
+    EXPECT_EQ(std::rename((m_path + ".journal").c_str(), (m_path + ".journal.old").c_str()), 0);
+    {
+        Store store {};
+        StoreJournal journal {store, m_path};
+        EXPECT_TRUE(journal.open());
+        EXPECT_EQ(value(store, 1), std::string("one"));
+        store.remove(1);
+        journal.compact();
+        journal.waitForCompaction();
+        EXPECT_FALSE(exists(m_path + ".journal.old"));
+    }
+    Store store {};
+    StoreJournal journal {store, m_path};
+    EXPECT_TRUE(journal.open());
+    EXPECT_EQ(value(store, 1), std::string("none"));
+    EXPECT_EQ(value(store, 2), std::string("two"));
+}
+
+TEST_F(TstJournal, DecodeNotRecorded)
+{
+    {
+        Store store {};
+        for (int i = 0; i < 100; ++i) {
+            store.add(i, std::to_string(i));
+        }
+        EXPECT_TRUE(store.saveSnapshot(m_path));
+    }
+    Store store {};
+    StoreJournal journal {store, m_path};
+    EXPECT_TRUE(journal.open());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(value(store, i), std::to_string(i));
+    }
+    EXPECT_EQ(journal.pending(), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstJournal, EvictionNotRecorded)
+{
+    using EvictingStore = IndexedDataStore<int, std::string, OrderedStorage, LruEviction>;
+    {
+        EvictingStore store {};
+        store.setBudget(3 * sizeof(std::string));
+        Journal<int, std::string, OrderedStorage, LruEviction> journal {store, m_path};
+        journal.setCompactionSize(0);
+        EXPECT_TRUE(journal.open());
+        for (int i = 0; i < 5; ++i) {
+            store.add(i, std::to_string(i));
+        }
+        EXPECT_EQ(store.evictionStatistics().evictions, static_cast<std::size_t>(2));
+        EXPECT_TRUE(journal.commit());
+        journal.compact();
+        journal.waitForCompaction();
+    }
+    Store store {};
+    StoreJournal journal {store, m_path};
+    EXPECT_TRUE(journal.open());
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(value(store, i), std::to_string(i));
+    }
+}
@@ -52,6 +52,7 @@ public:
 };
 
 using MockListenerRepository = ::microcore::core::ListenerRepository<MockListener>;
+using StrongMockListenerRepository = ::microcore::core::ListenerRepository<MockListener, ::microcore::core::ListenerReference::Strong>;
 
 TEST(TstListenerRepository, EmptySize)
 {
@@ -193,3 +194,90 @@ TEST(TstListenerRepository, Invalidation)
 
     EXPECT_TRUE(listener->invalidated);
 }
+
+TEST(TstListenerRepository, NotifyLambda)
+{
+    // Mock
+    MockListenerRepository listenerRepository {};
+    MockListener::Ptr listener {MockListener::create()};
+    EXPECT_CALL(*listener, onEvent(_)).Times(0);
+    EXPECT_CALL(*listener, onEvent(123)).Times(1);
+
+    // Test
+    listenerRepository.addListener(listener);
+    int value {123};
+    listenerRepository.notify([&value](MockListener &listener) {
+        listener.onEvent(value);
+    });
+}
+
+TEST(TstListenerRepository, ModifyWhileNotifying)
+{
+    // Mock
+    MockListenerRepository listenerRepository {};
+    MockListener::Ptr listener1 {MockListener::create()};
+    MockListener::Ptr listener2 {MockListener::create()};
+    MockListener::Ptr listener3 {MockListener::create()};
+    EXPECT_CALL(*listener1, onEvent(_)).Times(0);
+    EXPECT_CALL(*listener1, onEvent(123)).Times(1);
+    EXPECT_CALL(*listener1, onEvent(234)).Times(1);
+    EXPECT_CALL(*listener2, onEvent(_)).Times(0);
+    EXPECT_CALL(*listener3, onEvent(_)).Times(0);
+    EXPECT_CALL(*listener3, onEvent(234)).Times(1);
+
+    // Test
+    listenerRepository.addListener(listener1);
+    listenerRepository.addListener(listener2);
+    listenerRepository.notify([&](MockListener &listener) {
+        listener.onEvent(123);
+        listenerRepository.removeListener(listener2);
+        listenerRepository.addListener(listener3);
+    });
+    EXPECT_EQ(listenerRepository.count(), static_cast<std::size_t>(2));
+    listenerRepository.notify([](MockListener &listener) {
+        listener.onEvent(234);
+    });
+}
+
+TEST(TstListenerRepository, StrongReference)
+{
+    // Mock
+    StrongMockListenerRepository listenerRepository {};
+    MockListener::Ptr listener {MockListener::create()};
+    std::weak_ptr<MockListener> weakListener {listener};
+    EXPECT_CALL(*listener, onEvent(_)).Times(0);
+    EXPECT_CALL(*listener, onEvent(123)).Times(1);
+
+    // Test
+    listenerRepository.addListener(listener);
+    listener.reset();
+    EXPECT_FALSE(weakListener.expired());
+    listenerRepository.notify([](MockListener &listener) {
+        listener.onEvent(123);
+    });
+    EXPECT_EQ(listenerRepository.count(), static_cast<std::size_t>(1));
+
+    listenerRepository.removeListener(weakListener.lock());
+    EXPECT_EQ(listenerRepository.count(), static_cast<std::size_t>(0));
+    EXPECT_TRUE(weakListener.expired());
+}
+
+TEST(TstListenerRepository, StrongReferenceRemoveWhileNotifying)
+{
+    // Mock
+    StrongMockListenerRepository listenerRepository {};
+    MockListener::Ptr listener {MockListener::create()};
+    std::weak_ptr<MockListener> weakListener {listener};
+    EXPECT_CALL(*listener, onEvent(123)).Times(1);
+
+    // Test
+    listenerRepository.addListener(listener);
+    listener.reset();
+    // The listener is kept alive until the notification is done
+    listenerRepository.notify([&](MockListener &listener) {
+        listenerRepository.removeListener(weakListener.lock());
+        listener.onEvent(123);
+    });
+    EXPECT_TRUE(weakListener.expired());
+    EXPECT_EQ(listenerRepository.count(), static_cast<std::size_t>(0));
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/core/listenerrepository.h>
+#include <microcore/core/notificationbatch.h>
+#include <microcore/data/indexeddatastore.h>
+#include <microcore/data/indexedmodel.h>
+#include <QtCore/QtGlobal>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using namespace ::microcore::core;
+using namespace ::microcore::data;
+
+namespace {
+
+class EventListener
+{
+public:
+    using Ptr = std::shared_ptr<EventListener>;
+    void onEvent(const std::string &event)
+    {
+        events.push_back(event);
+    }
+    void onInvalidation()
+    {
+    }
+    std::vector<std::string> events {};
+};
+
+using EventRepository = ListenerRepository<EventListener>;
+
+class StoreListener final : public IIndexedDataStore<int, int>::IListener
+{
+public:
+    void onAdd(arg_const_reference<int> key, const ValuePtr &value) override
+    {
+        events.push_back("add " + std::to_string(key) + " " + std::to_string(*value));
+    }
+    void onRemove(arg_const_reference<int> key) override
+    {
+        events.push_back("remove " + std::to_string(key));
+    }
+    void onUpdate(arg_const_reference<int> key, const ValuePtr &value) override
+    {
+        events.push_back("update " + std::to_string(key) + " " + std::to_string(*value));
+    }
+    void onInvalidation() override
+    {
+    }
+    std::vector<std::string> events {};
+};
+
+class IdentityMapper
+{
+public:
+    using KeyType = int;
+    int operator()(int value) const
+    {
+        return value;
+    }
+};
+
+std::function<void (EventListener &)> event(const std::string &name)
+{
+    return [name](EventListener &listener) {
+        listener.onEvent(name);
+    };
+}
+
+}
+
+TEST(TstNotificationBatch, NoBatch)
+{
+    EventRepository repository {};
+    EventListener::Ptr listener {std::make_shared<EventListener>()};
+    repository.addListener(listener);
+
+    EXPECT_EQ(NotificationBatch::active(), nullptr);
+    repository.post(event("a"));
+    repository.coalesce(1, event("b"));
+    repository.coalesce(1, event("c"));
+    EXPECT_EQ(listener->events, std::vector<std::string>({"a", "b", "c"}));
+}
+
+TEST(TstNotificationBatch, Deferred)
+{
+    EventRepository repository {};
+    EventListener::Ptr listener {std::make_shared<EventListener>()};
+    repository.addListener(listener);
+    {
+        NotificationBatch batch {};
+        EXPECT_EQ(NotificationBatch::active(), &batch);
+        repository.post(event("a"));
+        repository.notify(event("immediate"));
+        repository.post(1, event("b"));
+        EXPECT_EQ(listener->events, std::vector<std::string>({"immediate"}));
+        EXPECT_EQ(batch.pendingCount(), static_cast<std::size_t>(2));
+    }
+    EXPECT_EQ(NotificationBatch::active(), nullptr);
+    EXPECT_EQ(listener->events, std::vector<std::string>({"immediate", "a", "b"}));
+}
+
+TEST(TstNotificationBatch, Coalesce)
+{
+    EventRepository repository1 {};
+    EventRepository repository2 {};
+    EventListener::Ptr listener {std::make_shared<EventListener>()};
+    repository1.addListener(listener);
+    repository2.addListener(listener);
+    {
+        NotificationBatch batch {};
+        repository1.coalesce(1, event("1a"));
+        repository1.coalesce(2, event("2a"));
+        repository1.coalesce(1, event("1b"));
+        repository2.coalesce(1, event("other"));
+        // A keyed notification ends the merging of it's key
+        repository1.post(1, event("1c"));
+        repository1.coalesce(1, event("1d"));
+        repository1.coalesce(2, event("2b"));
+        // A notification without key ends all merging
+        repository1.post(event("all"));
+        repository1.coalesce(2, event("2c"));
+        repository1.coalesce(std::string("key"), event("s1"));
+        repository1.coalesce(std::string("key"), event("s2"));
+        EXPECT_EQ(batch.coalescedCount(), static_cast<std::size_t>(3));
+    }
+    EXPECT_EQ(listener->events, std::vector<std::string>({"1a", "2a", "other", "1c", "1d", "all", "2c", "s1"}));
+}
+
+TEST(TstNotificationBatch, Nested)
+{
+    EventRepository repository {};
+    EventListener::Ptr listener {std::make_shared<EventListener>()};
+    repository.addListener(listener);
+    {
+        NotificationBatch batch {};
+        {
+            NotificationBatch inner {};
+            EXPECT_EQ(NotificationBatch::active(), &batch);
+            repository.coalesce(1, event("a"));
+        }
+        EXPECT_TRUE(listener->events.empty());
+        repository.coalesce(1, event("b"));
+    }
+    EXPECT_EQ(listener->events, std::vector<std::string>({"a"}));
+}
+
+TEST(TstNotificationBatch, PostWhileFlushing)
+{
+    EventRepository repository {};
+    EventListener::Ptr listener {std::make_shared<EventListener>()};
+    repository.addListener(listener);
+    {
+        NotificationBatch batch {};
+        repository.post([&repository](EventListener &listener) {
+            listener.onEvent("a");
+            repository.post(event("b"));
+        });
+        repository.post(event("c"));
+    }
+    EXPECT_EQ(listener->events, std::vector<std::string>({"a", "b", "c"}));
+}
+
+TEST(TstNotificationBatch, Discard)
+{
+    EventListener::Ptr listener {std::make_shared<EventListener>()};
+    EventRepository repository {};
+    repository.addListener(listener);
+    {
+        NotificationBatch batch {};
+        {
+            EventRepository destroyed {};
+            destroyed.addListener(listener);
+            destroyed.post(event("destroyed"));
+        }
+        repository.post(event("a"));
+        EXPECT_EQ(batch.pendingCount(), static_cast<std::size_t>(1));
+    }
+    EXPECT_EQ(listener->events, std::vector<std::string>({"a"}));
+}
+
+TEST(TstNotificationBatch, DataStore)
+{
+    IndexedDataStore<int, int> store {};
+    std::shared_ptr<StoreListener> listener {std::make_shared<StoreListener>()};
+    store.addListener(listener);
+    {
+        NotificationBatch batch {};
+        store.add(1, 10);
+        store.add(1, 11);
+        store.update(1, 12);
+        store.add(2, 20);
+        store.update(2, 21);
+        store.update(2, 22);
+        store.add(3, 30);
+        store.remove(3);
+        store.add(3, 31);
+        store.update(3, 32);
+        EXPECT_TRUE(listener->events.empty());
+    }
+    EXPECT_EQ(listener->events, std::vector<std::string>({"add 1 12", "add 2 22", "add 3 30", "remove 3", "add 3 32"}));
+
+    listener->events.clear();
+    {
+        NotificationBatch batch {};
+        store.update(1, 13);
+        store.update(1, 14);
+        store.update(2, 23);
+    }
+    EXPECT_EQ(listener->events, std::vector<std::string>({"update 1 14", "update 2 23"}));
+}
+
+TEST(TstNotificationBatch, Model)
+{
+    IndexedDataStore<int, int> store {};
+    IndexedModel<int, IdentityMapper> model {store};
+    model.append({1, 2, 3});
+    {
+        NotificationBatch batch {};
+        // The removed value is still referenced by the model until the batch is flushed
+        store.remove(2);
+        EXPECT_EQ(model.size(), static_cast<std::size_t>(3));
+        EXPECT_EQ(*model[1], 2);
+    }
+    ASSERT_EQ(model.size(), static_cast<std::size_t>(2));
+    EXPECT_EQ(*model[1], 3);
+}
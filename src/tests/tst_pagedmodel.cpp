@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/data/indexeddatastore.h>
+#include <microcore/data/pagedmodel.h>
+#include <map>
+#include <string>
+
+using namespace ::testing;
+using namespace ::microcore::core;
+using namespace ::microcore::data;
+
+namespace {
+
+class Item
+{
+public:
+    explicit Item() = default;
+    explicit Item(int k) : key {k} {}
+    DEFAULT_COPY_DEFAULT_MOVE(Item);
+    int key {0};
+};
+
+class ItemMapper
+{
+public:
+    using KeyType = int;
+    int operator()(const Item &item) const
+    {
+        return item.key;
+    }
+};
+
+class Error
+{
+public:
+    explicit Error() = default;
+    explicit Error(const std::string &m) : message {m} {}
+    DEFAULT_COPY_DEFAULT_MOVE(Error);
+    static Error cancelled()
+    {
+        return Error("cancelled");
+    }
+    static Error timeout()
+    {
+        return Error("timeout");
+    }
+    bool empty() const
+    {
+        return message.empty();
+    }
+    std::string message {};
+};
+
+// Serves pages of a list of keys, when finish() is called
+class PageJobFactory: public IJobFactory<PageRequest, std::vector<Item>, Error>
+{
+public:
+    using Job = IJob<std::vector<Item>, Error>;
+    class DeferredJob: public Job
+    {
+    public:
+        explicit DeferredJob(PageJobFactory &factory, const PageRequest &request)
+            : m_factory {factory}, m_request {request}
+        {
+        }
+        void execute(Job::OnResult &&onResult, Job::OnError &&onError) override
+        {
+            m_factory.m_requests.push_back(m_request);
+            m_factory.m_onResult = std::move(onResult);
+            m_factory.m_onError = std::move(onError);
+        }
+        void cancel() override
+        {
+            m_factory.m_onResult = nullptr;
+            m_factory.m_onError = nullptr;
+        }
+    private:
+        PageJobFactory &m_factory;
+        PageRequest m_request {};
+    };
+    std::unique_ptr<Job> create(PageRequest &&request) const override
+    {
+        PageJobFactory &factory {const_cast<PageJobFactory &>(*this)};
+        return std::unique_ptr<Job>(new DeferredJob(factory, request));
+    }
+    bool running() const
+    {
+        return static_cast<bool>(m_onResult);
+    }
+    void finish()
+    {
+        ASSERT_TRUE(running());
+        const PageRequest &request (m_requests.back());
+        std::vector<Item> items {};
+        for (std::size_t i = request.offset; i < std::min(request.offset + request.count, keys.size()); ++i) {
+            items.emplace_back(keys[i]);
+        }
+        Job::OnResult onResult {std::move(m_onResult)};
+        m_onError = nullptr;
+        onResult(std::move(items));
+    }
+    void fail()
+    {
+        ASSERT_TRUE(running());
+        Job::OnError onError {std::move(m_onError)};
+        m_onResult = nullptr;
+        onError(Error("failed"));
+    }
+    std::vector<int> keys {};
+    std::vector<PageRequest> m_requests {};
+private:
+    Job::OnResult m_onResult {};
+    Job::OnError m_onError {};
+};
+
+// Serves pages of a list of keys synchronously
+class SyncPageJobFactory: public IJobFactory<PageRequest, std::vector<Item>, Error>
+{
+public:
+    using Job = IJob<std::vector<Item>, Error>;
+    class SyncJob: public Job
+    {
+    public:
+        explicit SyncJob(const SyncPageJobFactory &factory, const PageRequest &request)
+            : m_factory {factory}, m_request {request}
+        {
+        }
+        void execute(Job::OnResult &&onResult, Job::OnError &&onError) override
+        {
+            Q_UNUSED(onError)
+            std::vector<Item> items {};
+            for (std::size_t i = m_request.offset; i < std::min(m_request.offset + m_request.count, m_factory.keys.size()); ++i) {
+                items.emplace_back(m_factory.keys[i]);
+            }
+            onResult(std::move(items));
+        }
+        void cancel() override
+        {
+        }
+    private:
+        const SyncPageJobFactory &m_factory;
+        PageRequest m_request {};
+    };
+    std::unique_ptr<Job> create(PageRequest &&request) const override
+    {
+        return std::unique_ptr<Job>(new SyncJob(*this, request));
+    }
+    std::vector<int> keys {};
+};
+
+class ExecutorListener: public Executor<Error>::IListener
+{
+public:
+    void onStart() override
+    {
+        events.emplace_back("start");
+    }
+    void onFinish() override
+    {
+        events.emplace_back("finish");
+    }
+    void onError(const Error &error) override
+    {
+        events.emplace_back("error " + error.message);
+    }
+    void onInvalidation() override
+    {
+    }
+    std::vector<std::string> events {};
+};
+
+// Fetches the next page when a page is received
+class FetchingListener: public Executor<Error>::IListener
+{
+public:
+    void onStart() override
+    {
+    }
+    void onFinish() override
+    {
+        model->fetchMore();
+    }
+    void onError(const Error &error) override
+    {
+        Q_UNUSED(error)
+    }
+    void onInvalidation() override
+    {
+    }
+    PagedModel<Item, ItemMapper, Error> *model {nullptr};
+};
+
+using Paged = PagedModel<Item, ItemMapper, Error>;
+
+std::vector<int> keys(const Paged &model)
+{
+    std::vector<int> result {};
+    for (const Item *item : model) {
+        result.emplace_back(item->key);
+    }
+    return result;
+}
+
+}
+
+class TstPagedModel: public Test
+{
+protected:
+    void SetUp()
+    {
+        for (int i = 0; i < 7; ++i) {
+            m_factory.keys.push_back(i);
+        }
+        m_model.reset(new Paged(m_store, m_factory, 3, 1));
+        m_model->addListener(m_listener);
+    }
+    IndexedDataStore<int, Item> m_store {};
+    PageJobFactory m_factory {};
+    std::unique_ptr<Paged> m_model {};
+    std::shared_ptr<ExecutorListener> m_listener {std::make_shared<ExecutorListener>()};
+};
+
+TEST_F(TstPagedModel, FetchMore)
+{
+    EXPECT_TRUE(m_model->empty());
+    EXPECT_TRUE(m_model->canFetchMore());
+    m_model->fetchMore();
+    EXPECT_TRUE(m_model->busy());
+    // Already fetching
+    m_model->fetchMore();
+    EXPECT_EQ(m_factory.m_requests.size(), static_cast<std::size_t>(1));
+
+    m_factory.finish();
+    EXPECT_FALSE(m_model->busy());
+    EXPECT_EQ(keys(*m_model), std::vector<int>({0, 1, 2}));
+    m_model->fetchMore();
+    m_factory.finish();
+    m_model->fetchMore();
+    m_factory.finish();
+    EXPECT_EQ(keys(*m_model), std::vector<int>({0, 1, 2, 3, 4, 5, 6}));
+    EXPECT_FALSE(m_model->canFetchMore());
+    m_model->fetchMore();
+    EXPECT_FALSE(m_factory.running());
+
+    EXPECT_EQ(m_factory.m_requests[2].offset, static_cast<std::size_t>(6));
+    EXPECT_EQ(m_factory.m_requests[2].count, static_cast<std::size_t>(3));
+    EXPECT_EQ(m_listener->events, std::vector<std::string>({"start", "finish", "start", "finish", "start", "finish"}));
+}
+
+TEST_F(TstPagedModel, Prefetch)
+{
+    m_model->fetchMore();
+    m_factory.finish();
+    m_model->setVisibleRow(0);
+    EXPECT_FALSE(m_factory.running());
+    m_model->setVisibleRow(1);
+    EXPECT_TRUE(m_factory.running());
+    m_factory.finish();
+    EXPECT_EQ(m_model->size(), static_cast<std::size_t>(6));
+}
+
+TEST_F(TstPagedModel, OverlappingPages)
+{
+    // Rows are shifted between two pages
+    m_model->fetchMore();
+    m_factory.finish();
+    m_factory.keys.insert(std::begin(m_factory.keys), 10);
+    m_model->fetchMore();
+    m_factory.finish();
+    EXPECT_EQ(keys(*m_model), std::vector<int>({0, 1, 2, 3, 4}));
+    m_model->fetchMore();
+    m_factory.finish();
+    EXPECT_EQ(keys(*m_model), std::vector<int>({0, 1, 2, 3, 4, 5, 6}));
+    EXPECT_FALSE(m_model->canFetchMore());
+}
+
+TEST_F(TstPagedModel, Error)
+{
+    m_model->fetchMore();
+    m_factory.fail();
+    EXPECT_TRUE(m_model->empty());
+    EXPECT_TRUE(m_model->canFetchMore());
+
+    // The page is fetched again
+    m_model->fetchMore();
+    EXPECT_EQ(m_factory.m_requests.back().offset, static_cast<std::size_t>(0));
+    m_factory.finish();
+    EXPECT_EQ(keys(*m_model), std::vector<int>({0, 1, 2}));
+    EXPECT_EQ(m_listener->events, std::vector<std::string>({"start", "error failed", "start", "finish"}));
+}
+
+TEST_F(TstPagedModel, Cancel)
+{
+    m_model->fetchMore();
+    m_model->cancel();
+    EXPECT_FALSE(m_factory.running());
+    EXPECT_FALSE(m_model->busy());
+    EXPECT_EQ(m_listener->events, std::vector<std::string>({"start", "error cancelled"}));
+}
+
+TEST_F(TstPagedModel, SynchronousPages)
+{
+    // The next page is fetched when a page is received, before the
+    // rows of the page are appended
+    SyncPageJobFactory factory {};
+    for (int i = 0; i < 7; ++i) {
+        factory.keys.push_back(i);
+    }
+    Paged model {m_store, factory, 3, 1};
+    std::shared_ptr<FetchingListener> listener {std::make_shared<FetchingListener>()};
+    listener->model = &model;
+    model.addListener(listener);
+    model.fetchMore();
+    EXPECT_EQ(keys(model), std::vector<int>({0, 1, 2, 3, 4, 5, 6}));
+    EXPECT_FALSE(model.canFetchMore());
+    EXPECT_FALSE(model.busy());
+}
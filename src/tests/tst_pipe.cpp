@@ -86,6 +86,14 @@ public:
     explicit Error() = default;
     explicit Error(int v) : value {v} {}
     DEFAULT_COPY_DEFAULT_MOVE(Error);
+    static Error cancelled()
+    {
+        return Error(1000);
+    }
+    static Error timeout()
+    {
+        return Error(1001);
+    }
     bool operator==(const Error &other) const
     {
         return other.value == value;
@@ -136,7 +144,7 @@ TEST_F(TstPipe, TestSuccess)
     EXPECT_CALL(m_abFactory, mockCreate(_)).Times(0);
     EXPECT_CALL(m_abFactory, mockCreate(ResultA(1))).Times(1).WillRepeatedly(Invoke([](const ResultA &) {
         std::unique_ptr<BJob> returned (new BJob);
-        EXPECT_CALL(*returned, executeImpl(_, _)).Times(1).WillRepeatedly(Invoke([](BJob::OnResult onResult, BJob::OnError) {
+        EXPECT_CALL(*returned, executeImpl(_, _)).Times(1).WillRepeatedly(Invoke([](BJob::OnResult &onResult, BJob::OnError &) {
            onResult(ResultB(2));
         }));
         return returned;
@@ -144,7 +152,7 @@ TEST_F(TstPipe, TestSuccess)
     EXPECT_CALL(m_bcFactory, mockCreate(_)).Times(0);
     EXPECT_CALL(m_bcFactory, mockCreate(ResultB(2))).Times(1).WillRepeatedly(Invoke([](const ResultB &) {
         std::unique_ptr<CJob> returned (new CJob);
-        EXPECT_CALL(*returned, executeImpl(_, _)).Times(1).WillRepeatedly(Invoke([](CJob::OnResult onResult, CJob::OnError) {
+        EXPECT_CALL(*returned, executeImpl(_, _)).Times(1).WillRepeatedly(Invoke([](CJob::OnResult &onResult, CJob::OnError &) {
            onResult(ResultC(3));
         }));
         return returned;
@@ -163,7 +171,7 @@ TEST_F(TstPipe, TestError1)
     EXPECT_CALL(m_abFactory, mockCreate(_)).Times(0);
     EXPECT_CALL(m_abFactory, mockCreate(ResultA(1))).Times(1).WillRepeatedly(Invoke([](const ResultA &) {
         std::unique_ptr<BJob> returned (new BJob);
-        EXPECT_CALL(*returned, executeImpl(_, _)).Times(1).WillRepeatedly(Invoke([](BJob::OnResult onResult, BJob::OnError) {
+        EXPECT_CALL(*returned, executeImpl(_, _)).Times(1).WillRepeatedly(Invoke([](BJob::OnResult &onResult, BJob::OnError &) {
            onResult(ResultB(2));
         }));
         return returned;
@@ -171,7 +179,7 @@ TEST_F(TstPipe, TestError1)
     EXPECT_CALL(m_bcFactory, mockCreate(_)).Times(0);
     EXPECT_CALL(m_bcFactory, mockCreate(ResultB(2))).Times(1).WillRepeatedly(Invoke([](const ResultB &) {
         std::unique_ptr<CJob> returned (new CJob);
-        EXPECT_CALL(*returned, executeImpl(_, _)).Times(1).WillRepeatedly(Invoke([](CJob::OnResult, CJob::OnError onError) {
+        EXPECT_CALL(*returned, executeImpl(_, _)).Times(1).WillRepeatedly(Invoke([](CJob::OnResult &, CJob::OnError &onError) {
            onError(Error(3));
         }));
         return returned;
@@ -190,7 +198,7 @@ TEST_F(TstPipe, TestError2)
     EXPECT_CALL(m_abFactory, mockCreate(_)).Times(0);
     EXPECT_CALL(m_abFactory, mockCreate(ResultA(1))).Times(1).WillRepeatedly(Invoke([](const ResultA &) {
         std::unique_ptr<BJob> returned (new BJob);
-        EXPECT_CALL(*returned, executeImpl(_, _)).Times(1).WillRepeatedly(Invoke([](BJob::OnResult, BJob::OnError onError) {
+        EXPECT_CALL(*returned, executeImpl(_, _)).Times(1).WillRepeatedly(Invoke([](BJob::OnResult &, BJob::OnError &onError) {
            onError(Error(2));
         }));
         return returned;
@@ -226,7 +234,8 @@ public:
     int value {0};
 };
 
-static void testOnResult(TestOnlyMovable &&) {}
+static int testResult {0};
+static void testOnResult(TestOnlyMovable &&result) { testResult = result.value; }
 static void testOnError(TestOnlyMovable &&) {}
 
 class TestOnlyMovableResultJob final : public IJob<TestOnlyMovable, TestOnlyMovable>
@@ -286,7 +295,7 @@ TEST_F(TstPipe, OnlyMovableConstructible)
     IJob<TestOnlyMovable, TestOnlyMovable>::OnResult onResult {testOnResult};
     IJob<TestOnlyMovable, TestOnlyMovable>::OnError onError {testOnError};
 
-    std::unique_ptr<TestOnlyMovablePipe> pipe3 {new TestOnlyMovablePipe(factory, onResult, onError)};
+    std::unique_ptr<TestOnlyMovablePipe> pipe3 {new TestOnlyMovablePipe(factory, std::move(onResult), std::move(onError))};
     std::unique_ptr<TestOnlyMovablePipe> pipe2 {pipe3->prepend<TestOnlyMovable>(factory)};
     std::unique_ptr<TestOnlyMovablePipe> pipe1 {pipe2->prepend<TestOnlyMovable>(factory)};
 
@@ -300,9 +309,321 @@ TEST_F(TstPipe, OnlyMovableConstructibleWithError)
     IJob<TestOnlyMovable, TestOnlyMovable>::OnResult onResult {testOnResult};
     IJob<TestOnlyMovable, TestOnlyMovable>::OnError onError {testOnError};
 
-    std::unique_ptr<TestOnlyMovablePipe> pipe3 {new TestOnlyMovablePipe(factory, onResult, onError)};
+    std::unique_ptr<TestOnlyMovablePipe> pipe3 {new TestOnlyMovablePipe(factory, std::move(onResult), std::move(onError))};
     std::unique_ptr<TestOnlyMovablePipe> pipe2 {pipe3->prepend<TestOnlyMovable>(errorFactory)};
     std::unique_ptr<TestOnlyMovablePipe> pipe1 {pipe2->prepend<TestOnlyMovable>(factory)};
 
     pipe1->send(TestOnlyMovable(123));
 }
+
+TEST_F(TstPipe, OnlyMovableIgnoresToken)
+{
+    // TestOnlyMovable cannot report cancellations, so tokens are ignored
+    static_assert(!IsCancellable<TestOnlyMovable>::value, "TestOnlyMovable should not be cancellable");
+    TestOnlyMovableResultJobFactory factory;
+    IJob<TestOnlyMovable, TestOnlyMovable>::OnResult onResult {testOnResult};
+    IJob<TestOnlyMovable, TestOnlyMovable>::OnError onError {testOnError};
+    TestOnlyMovablePipe pipe {factory, std::move(onResult), std::move(onError)};
+
+    CancellationToken token {CancellationToken::create()};
+    token.cancel();
+    testResult = 0;
+    pipe.send(TestOnlyMovable(123), token);
+    EXPECT_EQ(testResult, 123);
+}
+
+namespace {
+
+// Factory for jobs that are finished by the test
+template<class Request, class Result>
+class DeferredJobFactory final : public IJobFactory<Request, Result, Error>
+{
+public:
+    class Job final : public IJob<Result, Error>
+    {
+    public:
+        explicit Job(DeferredJobFactory &factory, int value)
+            : m_factory {factory}, m_value {value}
+        {
+        }
+        ~Job()
+        {
+            m_factory.m_destroyed.push_back(m_value);
+        }
+        void execute(typename IJob<Result, Error>::OnResult &&onResult,
+                     typename IJob<Result, Error>::OnError &&onError) override
+        {
+            m_factory.m_running.emplace(m_value, std::make_pair(std::move(onResult), std::move(onError)));
+        }
+        void cancel() override
+        {
+            m_factory.m_running.erase(m_value);
+            m_factory.m_cancelled.push_back(m_value);
+        }
+    private:
+        DeferredJobFactory &m_factory;
+        int m_value {0};
+    };
+    std::unique_ptr<IJob<Result, Error>> create(Request &&request) const override
+    {
+        DeferredJobFactory &factory {const_cast<DeferredJobFactory &>(*this)};
+        return std::unique_ptr<IJob<Result, Error>>(new Job(factory, request.value));
+    }
+    std::size_t running() const
+    {
+        return m_running.size();
+    }
+    const std::vector<int> & cancelled() const
+    {
+        return m_cancelled;
+    }
+    const std::vector<int> & destroyed() const
+    {
+        return m_destroyed;
+    }
+    void finish(int value)
+    {
+        auto it = m_running.find(value);
+        ASSERT_FALSE(it == std::end(m_running));
+        typename IJob<Result, Error>::OnResult onResult {std::move(it->second.first)};
+        m_running.erase(it);
+        onResult(Result(value));
+    }
+    void fail(int value)
+    {
+        auto it = m_running.find(value);
+        ASSERT_FALSE(it == std::end(m_running));
+        typename IJob<Result, Error>::OnError onError {std::move(it->second.second)};
+        m_running.erase(it);
+        onError(Error(value));
+    }
+private:
+    std::map<int, std::pair<typename IJob<Result, Error>::OnResult, typename IJob<Result, Error>::OnError>> m_running {};
+    std::vector<int> m_cancelled {};
+    std::vector<int> m_destroyed {};
+};
+
+}
+
+class TstPipeWindow: public Test
+{
+protected:
+    void create(std::size_t abWindow, std::size_t bcWindow, PipeOrder order)
+    {
+        m_bcPipe.reset(new BCPipe(m_bcFactory, [this](ResultC &&result) {
+            m_results.push_back(result.value);
+        }, [this](Error &&error) {
+            m_results.push_back(-error.value);
+        }, bcWindow, order));
+        m_abPipe = m_bcPipe->prepend<ResultA>(m_abFactory, abWindow, order);
+    }
+    DeferredJobFactory<ResultA, ResultB> m_abFactory {};
+    DeferredJobFactory<ResultB, ResultC> m_bcFactory {};
+    std::unique_ptr<ABPipe> m_abPipe {};
+    std::unique_ptr<BCPipe> m_bcPipe {};
+    std::vector<int> m_results {};
+};
+
+TEST_F(TstPipeWindow, Backpressure)
+{
+    create(2, 2, PipeOrder::Sequential);
+
+    EXPECT_TRUE(m_abPipe->canSend());
+    EXPECT_TRUE(m_abPipe->send(ResultA(1)));
+    EXPECT_TRUE(m_abPipe->send(ResultA(2)));
+    EXPECT_FALSE(m_abPipe->canSend());
+    EXPECT_FALSE(m_abPipe->send(ResultA(3)));
+    EXPECT_EQ(m_abFactory.running(), static_cast<std::size_t>(2));
+
+    m_abFactory.finish(1);
+    EXPECT_TRUE(m_abPipe->canSend());
+    EXPECT_TRUE(m_abPipe->send(ResultA(3)));
+    EXPECT_EQ(m_abFactory.running(), static_cast<std::size_t>(2));
+    EXPECT_EQ(m_bcFactory.running(), static_cast<std::size_t>(1));
+}
+
+TEST_F(TstPipeWindow, BackpressureFromNextPipe)
+{
+    create(2, 1, PipeOrder::Sequential);
+
+    EXPECT_TRUE(m_abPipe->send(ResultA(1)));
+    EXPECT_TRUE(m_abPipe->send(ResultA(2)));
+    m_abFactory.finish(1);
+    m_abFactory.finish(2);
+
+    // 1 is processed by the next pipe, 2 is queued
+    EXPECT_EQ(m_abFactory.running(), static_cast<std::size_t>(0));
+    EXPECT_EQ(m_bcFactory.running(), static_cast<std::size_t>(1));
+    EXPECT_FALSE(m_abPipe->canSend());
+    EXPECT_FALSE(m_abPipe->send(ResultA(3)));
+
+    m_bcFactory.finish(1);
+    EXPECT_EQ(m_bcFactory.running(), static_cast<std::size_t>(1));
+    EXPECT_TRUE(m_abPipe->canSend());
+    m_bcFactory.finish(2);
+
+    EXPECT_EQ(m_results, std::vector<int>({1, 2}));
+}
+
+TEST_F(TstPipeWindow, SequentialOrder)
+{
+    create(3, 3, PipeOrder::Sequential);
+
+    m_abPipe->send(ResultA(1));
+    m_abPipe->send(ResultA(2));
+    m_abPipe->send(ResultA(3));
+    m_abFactory.finish(3);
+    m_abFactory.finish(2);
+    EXPECT_EQ(m_bcFactory.running(), static_cast<std::size_t>(0));
+    m_abFactory.finish(1);
+    EXPECT_EQ(m_bcFactory.running(), static_cast<std::size_t>(3));
+
+    m_bcFactory.finish(2);
+    m_bcFactory.finish(3);
+    EXPECT_TRUE(m_results.empty());
+    m_bcFactory.finish(1);
+    EXPECT_EQ(m_results, std::vector<int>({1, 2, 3}));
+}
+
+TEST_F(TstPipeWindow, SequentialOrderWithErrors)
+{
+    create(3, 3, PipeOrder::Sequential);
+
+    m_abPipe->send(ResultA(1));
+    m_abPipe->send(ResultA(2));
+    m_abPipe->send(ResultA(3));
+    m_abFactory.fail(2);
+    m_abFactory.finish(3);
+    m_abFactory.finish(1);
+
+    m_bcFactory.finish(3);
+    m_bcFactory.finish(1);
+    EXPECT_EQ(m_results, std::vector<int>({1, -2, 3}));
+}
+
+TEST_F(TstPipeWindow, CompletionOrder)
+{
+    create(3, 3, PipeOrder::Completion);
+
+    m_abPipe->send(ResultA(1));
+    m_abPipe->send(ResultA(2));
+    m_abPipe->send(ResultA(3));
+    m_abFactory.finish(3);
+    m_bcFactory.finish(3);
+    EXPECT_EQ(m_results, std::vector<int>({3}));
+
+    m_abFactory.fail(2);
+    m_abFactory.finish(1);
+    m_bcFactory.finish(1);
+    EXPECT_EQ(m_results, std::vector<int>({3, -2, 1}));
+}
+
+TEST_F(TstPipeWindow, SendAgainFromCallback)
+{
+    TestOnlyMovableResultJobFactory factory;
+    int count {0};
+    std::unique_ptr<TestOnlyMovablePipe> pipe {};
+    pipe.reset(new TestOnlyMovablePipe(factory, [&pipe, &count](TestOnlyMovable &&value) {
+        ++count;
+        if (value.value < 3) {
+            EXPECT_TRUE(pipe->send(TestOnlyMovable(value.value + 1)));
+        }
+    }, testOnError));
+
+    EXPECT_TRUE(pipe->send(TestOnlyMovable(1)));
+    EXPECT_EQ(count, 3);
+    EXPECT_TRUE(pipe->send(TestOnlyMovable(1)));
+    EXPECT_EQ(count, 6);
+}
+
+TEST_F(TstPipeWindow, ReleaseFinishedJobs)
+{
+    create(2, 2, PipeOrder::Sequential);
+
+    // Jobs are destroyed after their callback, without waiting
+    // for the next request
+    m_abPipe->send(ResultA(1));
+    m_abFactory.finish(1);
+    EXPECT_EQ(m_abFactory.destroyed(), std::vector<int>({1}));
+    EXPECT_TRUE(m_bcFactory.destroyed().empty());
+    m_bcFactory.finish(1);
+    EXPECT_EQ(m_bcFactory.destroyed(), std::vector<int>({1}));
+    EXPECT_EQ(m_results, std::vector<int>({1}));
+}
+
+TEST_F(TstPipeWindow, Cancel)
+{
+    create(2, 2, PipeOrder::Sequential);
+    CancellationToken token1 {CancellationToken::create()};
+    CancellationToken token2 {CancellationToken::create()};
+
+    m_abPipe->send(ResultA(1), token1);
+    m_abPipe->send(ResultA(2), token2);
+    token1.cancel();
+    EXPECT_EQ(m_abFactory.cancelled(), std::vector<int>({1}));
+    EXPECT_EQ(m_abFactory.running(), static_cast<std::size_t>(1));
+    EXPECT_EQ(m_results, std::vector<int>({-1000}));
+    EXPECT_TRUE(m_abPipe->canSend());
+
+    m_abFactory.finish(2);
+    m_bcFactory.finish(2);
+    EXPECT_EQ(m_results, std::vector<int>({-1000, 2}));
+}
+
+TEST_F(TstPipeWindow, CancelPropagates)
+{
+    create(2, 2, PipeOrder::Sequential);
+    CancellationToken token {CancellationToken::create()};
+
+    m_abPipe->send(ResultA(1), token);
+    m_abFactory.finish(1);
+    EXPECT_EQ(m_bcFactory.running(), static_cast<std::size_t>(1));
+
+    token.cancel();
+    EXPECT_TRUE(m_abFactory.cancelled().empty());
+    EXPECT_EQ(m_bcFactory.cancelled(), std::vector<int>({1}));
+    EXPECT_EQ(m_results, std::vector<int>({-1000}));
+}
+
+TEST_F(TstPipeWindow, CancelQueued)
+{
+    create(2, 1, PipeOrder::Sequential);
+    CancellationToken token {CancellationToken::create()};
+
+    m_abPipe->send(ResultA(1));
+    m_abPipe->send(ResultA(2), token);
+    m_abFactory.finish(1);
+    m_abFactory.finish(2);
+    token.cancel();
+
+    // The queued request is not started
+    m_bcFactory.finish(1);
+    EXPECT_EQ(m_bcFactory.running(), static_cast<std::size_t>(0));
+    EXPECT_EQ(m_results, std::vector<int>({1, -1000}));
+}
+
+TEST_F(TstPipeWindow, CancelSequentialOrder)
+{
+    create(2, 2, PipeOrder::Sequential);
+    CancellationToken token {CancellationToken::create()};
+
+    m_abPipe->send(ResultA(1));
+    m_abPipe->send(ResultA(2), token);
+    token.cancel();
+    EXPECT_TRUE(m_results.empty());
+
+    m_abFactory.finish(1);
+    m_bcFactory.finish(1);
+    EXPECT_EQ(m_results, std::vector<int>({1, -1000}));
+}
+
+TEST_F(TstPipeWindow, SendCancelled)
+{
+    create(2, 2, PipeOrder::Sequential);
+    CancellationToken token {CancellationToken::create()};
+    token.cancel();
+
+    EXPECT_TRUE(m_abPipe->send(ResultA(1), token));
+    EXPECT_EQ(m_abFactory.running(), static_cast<std::size_t>(0));
+    EXPECT_EQ(m_results, std::vector<int>({-1000}));
+}
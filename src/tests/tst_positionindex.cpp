@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/data/positionindex.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace ::testing;
+using namespace ::microcore::data;
+
+TEST(TstPositionIndex, Empty)
+{
+    PositionIndex<int> index {};
+    EXPECT_EQ(index.size(), static_cast<std::size_t>(0));
+    EXPECT_FALSE(index.contains(1));
+    EXPECT_EQ(index.position(1), PositionIndex<int>::npos);
+}
+
+TEST(TstPositionIndex, Insert)
+{
+    PositionIndex<int> index {};
+    std::vector<int> keys {1, 2, 3};
+    index.insert(0, std::begin(keys), std::end(keys));
+    index.insert(0, 4);
+    index.insert(2, 5);
+    index.insert(5, 6);
+    // Already indexed
+    index.insert(0, 1);
+    EXPECT_EQ(index.size(), static_cast<std::size_t>(6));
+
+    std::vector<int> expected {4, 1, 5, 2, 3, 6};
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(index.key(i), expected[i]);
+        EXPECT_EQ(index.position(expected[i]), i);
+    }
+}
+
+TEST(TstPositionIndex, RemoveMove)
+{
+    PositionIndex<int> index {};
+    std::vector<int> keys {1, 2, 3, 4};
+    index.insert(0, std::begin(keys), std::end(keys));
+
+    index.move(0, 3);
+    EXPECT_EQ(index.position(1), static_cast<std::size_t>(3));
+    EXPECT_EQ(index.position(2), static_cast<std::size_t>(0));
+
+    index.remove(1);
+    EXPECT_FALSE(index.contains(3));
+    EXPECT_EQ(index.size(), static_cast<std::size_t>(3));
+    EXPECT_EQ(index.position(2), static_cast<std::size_t>(0));
+    EXPECT_EQ(index.position(4), static_cast<std::size_t>(1));
+    EXPECT_EQ(index.position(1), static_cast<std::size_t>(2));
+
+    std::vector<int> others {5, 6, 7};
+    index.insert(1, std::begin(others), std::end(others));
+    index.remove(1, 4);
+    EXPECT_EQ(index.size(), static_cast<std::size_t>(2));
+    EXPECT_FALSE(index.contains(5));
+    EXPECT_FALSE(index.contains(4));
+    EXPECT_EQ(index.position(1), static_cast<std::size_t>(1));
+
+    index.clear();
+    EXPECT_EQ(index.size(), static_cast<std::size_t>(0));
+    EXPECT_FALSE(index.contains(1));
+}
+
+TEST(TstPositionIndex, Move)
+{
+    PositionIndex<int> index {};
+    std::vector<int> keys {1, 2, 3};
+    index.insert(0, std::begin(keys), std::end(keys));
+
+    PositionIndex<int> moved {std::move(index)};
+    EXPECT_EQ(index.size(), static_cast<std::size_t>(0));
+    EXPECT_EQ(moved.size(), static_cast<std::size_t>(3));
+    EXPECT_EQ(moved.position(3), static_cast<std::size_t>(2));
+}
+
+TEST(TstPositionIndex, Select)
+{
+    PositionIndex<int> index {};
+    std::vector<int> keys {1, 2, 3, 4, 5};
+    index.insert(0, std::begin(keys), std::end(keys), [](std::size_t i) {
+        return i % 2 == 0;
+    });
+    EXPECT_EQ(index.selectedCount(), static_cast<std::size_t>(3));
+    EXPECT_TRUE(index.isSelected(2));
+    EXPECT_FALSE(index.isSelected(3));
+
+    index.select(1, true);
+    index.select(4, false);
+    EXPECT_EQ(index.selectedCount(), static_cast<std::size_t>(3));
+    EXPECT_EQ(index.selectedBefore(0), static_cast<std::size_t>(0));
+    EXPECT_EQ(index.selectedBefore(3), static_cast<std::size_t>(3));
+    EXPECT_EQ(index.selectedBefore(5), static_cast<std::size_t>(3));
+
+    // Selection follows keys
+    index.move(0, 4);
+    index.remove(0);
+    EXPECT_EQ(index.selectedCount(), static_cast<std::size_t>(2));
+    std::vector<int> selected {};
+    index.forEach([&selected](int key, bool isSelected) {
+        if (isSelected) {
+            selected.push_back(key);
+        }
+    });
+    EXPECT_EQ(selected, std::vector<int>({3, 1}));
+}
+
+// Compare with a vector, on random operations
+TEST(TstPositionIndex, Random)
+{
+    PositionIndex<int> index {};
+    std::vector<int> reference {};
+    std::mt19937 generator {3};
+    int nextKey {0};
+    for (int i = 0; i < 10000; ++i) {
+        int operation = generator() % 4;
+        if (operation == 0 || reference.empty()) {
+            std::size_t position = generator() % (reference.size() + 1);
+            std::vector<int> keys {};
+            int count = generator() % 4 + 1;
+            for (int j = 0; j < count; ++j) {
+                keys.push_back(nextKey++);
+            }
+            index.insert(position, std::begin(keys), std::end(keys));
+            reference.insert(std::begin(reference) + position, std::begin(keys), std::end(keys));
+        } else if (operation == 1) {
+            std::size_t position = generator() % reference.size();
+            std::size_t count = std::min<std::size_t>(generator() % 3 + 1, reference.size() - position);
+            index.remove(position, count);
+            reference.erase(std::begin(reference) + position, std::begin(reference) + position + count);
+        } else if (operation == 2) {
+            std::size_t oldPosition = generator() % reference.size();
+            std::size_t newPosition = generator() % reference.size();
+            index.move(oldPosition, newPosition);
+            int key {reference[oldPosition]};
+            reference.erase(std::begin(reference) + oldPosition);
+            reference.insert(std::begin(reference) + newPosition, key);
+        } else {
+            std::size_t position = generator() % reference.size();
+            ASSERT_EQ(index.position(reference[position]), position);
+            ASSERT_EQ(index.key(position), reference[position]);
+        }
+        ASSERT_EQ(index.size(), reference.size());
+    }
+    for (std::size_t i = 0; i < reference.size(); ++i) {
+        EXPECT_EQ(index.position(reference[i]), i);
+    }
+}
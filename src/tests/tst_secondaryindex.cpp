@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/data/indexeddatastore.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using namespace ::microcore::data;
+
+namespace {
+
+class Post
+{
+public:
+    explicit Post() = default;
+    explicit Post(int id, int thread, std::string author)
+        : id {id}, thread {thread}, author {std::move(author)}
+    {
+    }
+    int id {0};
+    int thread {0};
+    std::string author {};
+};
+
+class ThreadMapper
+{
+public:
+    using KeyType = int;
+    int operator()(const Post &post) const
+    {
+        return post.thread;
+    }
+};
+
+class AuthorMapper
+{
+public:
+    using KeyType = std::string;
+    std::string operator()(const Post &post) const
+    {
+        return post.author;
+    }
+};
+
+template<class R>
+std::vector<int> ids(const R &range)
+{
+    std::vector<int> result {};
+    for (const Post &post : range) {
+        result.push_back(post.id);
+    }
+    std::sort(std::begin(result), std::end(result));
+    return result;
+}
+
+}
+
+namespace microcore { namespace data {
+
+template<>
+class SnapshotTraits<Post>
+{
+public:
+    static void write(std::string &buffer, const Post &post)
+    {
+        SnapshotTraits<int>::write(buffer, post.id);
+        SnapshotTraits<int>::write(buffer, post.thread);
+        SnapshotTraits<std::string>::write(buffer, post.author);
+    }
+    static bool read(const char *&data, const char *end, Post &post)
+    {
+        return SnapshotTraits<int>::read(data, end, post.id)
+               && SnapshotTraits<int>::read(data, end, post.thread)
+               && SnapshotTraits<std::string>::read(data, end, post.author);
+    }
+};
+
+}}
+
+template<class P>
+class TstSecondaryIndex: public Test
+{
+protected:
+    using Store = IndexedDataStore<int, Post, P>;
+    void add(int id, int thread, const std::string &author)
+    {
+        m_store.add(id, Post(id, thread, author));
+    }
+    Store m_store {};
+};
+
+using StoragePolicies = Types<OrderedStorage, FlatHashStorage>;
+TYPED_TEST_CASE(TstSecondaryIndex, StoragePolicies);
+
+TYPED_TEST(TstSecondaryIndex, Find)
+{
+    auto &byThread = this->m_store.template addIndex<ThreadMapper>();
+    auto &byAuthor = this->m_store.template addUniqueIndex<AuthorMapper>();
+    this->add(1, 10, "alice");
+    this->add(2, 10, "bob");
+    this->add(3, 20, "carol");
+
+    EXPECT_EQ(ids(byThread.find(10)), std::vector<int>({1, 2}));
+    EXPECT_EQ(ids(byThread.find(20)), std::vector<int>({3}));
+    EXPECT_TRUE(byThread.find(30).empty());
+    EXPECT_EQ(byThread.count(10), static_cast<std::size_t>(2));
+    EXPECT_EQ(byThread.find(10).size(), static_cast<std::size_t>(2));
+
+    ASSERT_NE(byAuthor.find("bob"), nullptr);
+    EXPECT_EQ(byAuthor.find("bob")->id, 2);
+    EXPECT_EQ(byAuthor.find("dave"), nullptr);
+    EXPECT_EQ(byAuthor.size(), static_cast<std::size_t>(3));
+}
+
+TYPED_TEST(TstSecondaryIndex, Existing)
+{
+    this->add(1, 10, "alice");
+    this->add(2, 10, "bob");
+    auto &byThread = this->m_store.addIndex(ThreadMapper());
+    auto &byAuthor = this->m_store.addUniqueIndex(AuthorMapper());
+    EXPECT_EQ(ids(byThread.find(10)), std::vector<int>({1, 2}));
+    EXPECT_EQ(byAuthor.find("alice")->id, 1);
+}
+
+TYPED_TEST(TstSecondaryIndex, Update)
+{
+    auto &byThread = this->m_store.template addIndex<ThreadMapper>();
+    auto &byAuthor = this->m_store.template addUniqueIndex<AuthorMapper>();
+    this->add(1, 10, "alice");
+    this->add(2, 10, "bob");
+    this->m_store.update(1, Post(1, 20, "alicia"));
+    this->add(2, 10, "bobby");
+
+    EXPECT_EQ(ids(byThread.find(10)), std::vector<int>({2}));
+    EXPECT_EQ(ids(byThread.find(20)), std::vector<int>({1}));
+    EXPECT_EQ(byAuthor.find("alice"), nullptr);
+    EXPECT_EQ(byAuthor.find("alicia")->id, 1);
+    EXPECT_EQ(byAuthor.find("bob"), nullptr);
+    EXPECT_EQ(byAuthor.find("bobby")->id, 2);
+}
+
+TYPED_TEST(TstSecondaryIndex, Remove)
+{
+    auto &byThread = this->m_store.template addIndex<ThreadMapper>();
+    auto &byAuthor = this->m_store.template addUniqueIndex<AuthorMapper>();
+    this->add(1, 10, "alice");
+    this->add(2, 10, "bob");
+    this->m_store.remove(1);
+    EXPECT_EQ(ids(byThread.find(10)), std::vector<int>({2}));
+    EXPECT_EQ(byAuthor.find("alice"), nullptr);
+    this->m_store.remove(2);
+    EXPECT_TRUE(byThread.find(10).empty());
+    EXPECT_EQ(byAuthor.size(), static_cast<std::size_t>(0));
+}
+
+TYPED_TEST(TstSecondaryIndex, RemoveInBatch)
+{
+    auto &byThread = this->m_store.template addIndex<ThreadMapper>();
+    this->add(1, 10, "alice");
+    {
+        ::microcore::core::NotificationBatch batch {};
+        this->m_store.remove(1);
+        EXPECT_TRUE(byThread.find(10).empty());
+    }
+}
+
+TYPED_TEST(TstSecondaryIndex, SharedUniqueKey)
+{
+    auto &byAuthor = this->m_store.template addUniqueIndex<AuthorMapper>();
+    EXPECT_EQ(byAuthor.conflictCount(), static_cast<std::size_t>(0));
+    this->add(1, 10, "alice");
+    this->add(2, 10, "alice");
+    EXPECT_EQ(byAuthor.find("alice")->id, 2);
+    EXPECT_EQ(byAuthor.count("alice"), static_cast<std::size_t>(2));
+    EXPECT_EQ(byAuthor.conflictCount(), static_cast<std::size_t>(1));
+    this->m_store.remove(1);
+    EXPECT_EQ(byAuthor.find("alice")->id, 2);
+    EXPECT_EQ(byAuthor.count("alice"), static_cast<std::size_t>(1));
+    EXPECT_EQ(byAuthor.count("bob"), static_cast<std::size_t>(0));
+    EXPECT_EQ(byAuthor.conflictCount(), static_cast<std::size_t>(0));
+}
+
+TYPED_TEST(TstSecondaryIndex, RemoveSharedUniqueKey)
+{
+    auto &byAuthor = this->m_store.template addUniqueIndex<AuthorMapper>();
+    this->add(1, 10, "alice");
+    this->add(2, 10, "alice");
+    this->m_store.remove(2);
+    ASSERT_NE(byAuthor.find("alice"), nullptr);
+    EXPECT_EQ(byAuthor.find("alice")->id, 1);
+    EXPECT_EQ(byAuthor.size(), static_cast<std::size_t>(1));
+
+    // Moving the indexed value to another index key also falls back
+    this->add(3, 10, "alice");
+    EXPECT_EQ(byAuthor.conflictCount(), static_cast<std::size_t>(1));
+    this->add(3, 10, "bob");
+    EXPECT_EQ(byAuthor.find("alice")->id, 1);
+    EXPECT_EQ(byAuthor.find("bob")->id, 3);
+    EXPECT_EQ(byAuthor.conflictCount(), static_cast<std::size_t>(0));
+
+    this->m_store.remove(1);
+    EXPECT_EQ(byAuthor.find("alice"), nullptr);
+    EXPECT_EQ(byAuthor.size(), static_cast<std::size_t>(1));
+}
+
+TYPED_TEST(TstSecondaryIndex, Snapshot)
+{
+    std::string path {TempDir() + "tst_secondaryindex"};
+    this->add(1, 10, "alice");
+    this->add(2, 10, "bob");
+    ASSERT_TRUE(this->m_store.saveSnapshot(path));
+
+    typename TestFixture::Store store {};
+    auto &byThread = store.template addIndex<ThreadMapper>();
+    EXPECT_TRUE(store.openSnapshot(path));
+    EXPECT_EQ(ids(byThread.find(10)), std::vector<int>({1, 2}));
+
+    typename TestFixture::Store indexedLater {};
+    EXPECT_TRUE(indexedLater.openSnapshot(path));
+    auto &byAuthor = indexedLater.template addUniqueIndex<AuthorMapper>();
+    EXPECT_EQ(byAuthor.find("bob")->id, 2);
+    std::remove(path.c_str());
+}
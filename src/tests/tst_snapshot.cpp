@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/data/indexeddatastore.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <QtCore/QtGlobal>
+
+using namespace ::testing;
+using namespace ::microcore::data;
+
+namespace {
+
+// A value, serialized as its text
+class Note
+{
+public:
+    explicit Note() = default;
+    explicit Note(std::string text) : text {std::move(text)} {}
+    std::string text {};
+};
+
+std::string read(const std::string &path)
+{
+    std::ifstream file {path, std::ios::binary};
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void write(const std::string &path, const std::string &data)
+{
+    std::ofstream file {path, std::ios::binary | std::ios::trunc};
+    file << data;
+}
+
+class CountingListener: public IIndexedDataStore<int, Note>::IListener
+{
+public:
+    void onAdd(int key, const ValuePtr &value) override
+    {
+        Q_UNUSED(key)
+        Q_UNUSED(value)
+        ++count;
+    }
+    void onRemove(int key) override
+    {
+        Q_UNUSED(key)
+        ++count;
+    }
+    void onUpdate(int key, const ValuePtr &value) override
+    {
+        Q_UNUSED(key)
+        Q_UNUSED(value)
+        ++count;
+    }
+    void onInvalidation() override
+    {
+    }
+    int count {0};
+};
+
+}
+
+namespace microcore { namespace data {
+
+template<>
+class SnapshotTraits<Note>
+{
+public:
+    static void write(std::string &buffer, const Note &note)
+    {
+        SnapshotTraits<std::string>::write(buffer, note.text);
+    }
+    static bool read(const char *&data, const char *end, Note &note)
+    {
+        return SnapshotTraits<std::string>::read(data, end, note.text);
+    }
+};
+
+}}
+
+class TstSnapshotFile: public Test
+{
+protected:
+    void SetUp()
+    {
+        m_payload.index = "index";
+        m_payload.values = "values";
+    }
+    void TearDown()
+    {
+        std::remove(m_path.c_str());
+    }
+    std::string m_path {TempDir() + "tst_snapshotfile"};
+    SnapshotPayload m_payload {};
+};
+
+TEST_F(TstSnapshotFile, Write)
+{
+    EXPECT_TRUE(SnapshotFile::write(m_path, 3, m_payload));
+    SnapshotFile snapshot {};
+    EXPECT_TRUE(snapshot.open(m_path, 3));
+    EXPECT_EQ(std::string(snapshot.index(), snapshot.indexSize()), std::string("index"));
+    EXPECT_EQ(std::string(snapshot.values(), snapshot.valuesSize()), std::string("values"));
+    snapshot.close();
+    EXPECT_EQ(snapshot.indexSize(), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstSnapshotFile, Empty)
+{
+    EXPECT_TRUE(SnapshotFile::write(m_path, 0, SnapshotPayload()));
+    SnapshotFile snapshot {};
+    EXPECT_TRUE(snapshot.open(m_path, 0));
+    EXPECT_EQ(snapshot.indexSize(), static_cast<std::size_t>(0));
+    EXPECT_EQ(snapshot.valuesSize(), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstSnapshotFile, Missing)
+{
+    SnapshotFile snapshot {};
+    EXPECT_FALSE(snapshot.open(m_path, 0));
+}
+
+TEST_F(TstSnapshotFile, OtherFormat)
+{
+    EXPECT_TRUE(SnapshotFile::write(m_path, 1, m_payload));
+    SnapshotFile snapshot {};
+    EXPECT_FALSE(snapshot.open(m_path, 2));
+}
+
+TEST_F(TstSnapshotFile, OtherVersion)
+{
+    EXPECT_TRUE(SnapshotFile::write(m_path, 0, m_payload));
+    std::string data {read(m_path)};
+    ++data[4];
+    write(m_path, data);
+    SnapshotFile snapshot {};
+    EXPECT_FALSE(snapshot.open(m_path, 0));
+}
+
+TEST_F(TstSnapshotFile, Corrupted)
+{
+    EXPECT_TRUE(SnapshotFile::write(m_path, 0, m_payload));
+    std::string data {read(m_path)};
+    ++data[data.size() - 7];
+    write(m_path, data);
+    SnapshotFile snapshot {};
+    EXPECT_FALSE(snapshot.open(m_path, 0));
+}
+
+TEST_F(TstSnapshotFile, Truncated)
+{
+    EXPECT_TRUE(SnapshotFile::write(m_path, 0, m_payload));
+    std::string data {read(m_path)};
+    write(m_path, data.substr(0, data.size() - 1));
+    SnapshotFile snapshot {};
+    EXPECT_FALSE(snapshot.open(m_path, 0));
+    write(m_path, data.substr(0, 4));
+    EXPECT_FALSE(snapshot.open(m_path, 0));
+}
+
+template<class P>
+class TstDataStoreSnapshot: public Test
+{
+protected:
+    using Store = IndexedDataStore<int, Note, P>;
+    void SetUp()
+    {
+        m_store.add(1, Note("one"));
+        m_store.add(2, Note("two"));
+        m_store.add(3, Note("three"));
+        ASSERT_TRUE(m_store.saveSnapshot(m_path, 1));
+    }
+    void TearDown()
+    {
+        std::remove(m_path.c_str());
+    }
+    Store m_store {};
+    std::string m_path {TempDir() + "tst_datastoresnapshot"};
+};
+
+using StoragePolicies = Types<OrderedStorage, FlatHashStorage>;
+TYPED_TEST_CASE(TstDataStoreSnapshot, StoragePolicies);
+
+TYPED_TEST(TstDataStoreSnapshot, Open)
+{
+    typename TestFixture::Store store {};
+    EXPECT_TRUE(store.openSnapshot(this->m_path, 1));
+    EXPECT_TRUE(store.contains(1));
+    EXPECT_TRUE(store.contains(3));
+    EXPECT_FALSE(store.contains(4));
+    EXPECT_EQ(store.value(2)->text, std::string("two"));
+    EXPECT_EQ(store.value(3)->text, std::string("three"));
+    EXPECT_EQ(store.value(2), store.value(2));
+    EXPECT_FALSE(store.value(4));
+}
+
+TYPED_TEST(TstDataStoreSnapshot, OpenInvalid)
+{
+    typename TestFixture::Store store {};
+    store.add(4, Note("four"));
+    EXPECT_FALSE(store.openSnapshot(this->m_path, 2));
+    EXPECT_FALSE(store.contains(1));
+    EXPECT_TRUE(store.contains(4));
+
+    // Corrupts the first key of the index, after the header
+    std::string data {read(this->m_path)};
+    ++data[48];
+    write(this->m_path, data);
+    EXPECT_FALSE(store.openSnapshot(this->m_path, 1));
+    EXPECT_FALSE(store.contains(1));
+}
+
+TYPED_TEST(TstDataStoreSnapshot, CorruptedValue)
+{
+    std::string data {read(this->m_path)};
+    data[data.size() - 1] = 'x';
+    write(this->m_path, data);
+
+    typename TestFixture::Store store {};
+    EXPECT_TRUE(store.openSnapshot(this->m_path, 1));
+    int corrupted {0};
+    for (int key = 1; key <= 3; ++key) {
+        if (!store.value(key)) {
+            ++corrupted;
+            EXPECT_FALSE(store.contains(key));
+        }
+    }
+    EXPECT_EQ(corrupted, 1);
+}
+
+TYPED_TEST(TstDataStoreSnapshot, DecodeNotNotified)
+{
+    typename TestFixture::Store store {};
+    std::shared_ptr<CountingListener> listener {std::make_shared<CountingListener>()};
+    store.addListener(listener);
+    EXPECT_TRUE(store.openSnapshot(this->m_path, 1));
+    EXPECT_EQ(store.value(1)->text, std::string("one"));
+    EXPECT_EQ(listener->count, 0);
+    store.update(2, Note("updated"));
+    EXPECT_EQ(listener->count, 1);
+}
+
+TYPED_TEST(TstDataStoreSnapshot, OpenExisting)
+{
+    typename TestFixture::Store store {};
+    store.add(1, Note("new"));
+    EXPECT_TRUE(store.openSnapshot(this->m_path, 1));
+    EXPECT_EQ(store.value(1)->text, std::string("new"));
+    EXPECT_EQ(store.value(2)->text, std::string("two"));
+}
+
+TYPED_TEST(TstDataStoreSnapshot, Replace)
+{
+    typename TestFixture::Store store {};
+    EXPECT_TRUE(store.openSnapshot(this->m_path, 1));
+    EXPECT_FALSE(static_cast<bool>(store.addUnique(1, Note("new"))));
+    EXPECT_EQ(store.value(1)->text, std::string("one"));
+    EXPECT_EQ(store.add(1, Note("new"))->text, std::string("new"));
+    EXPECT_EQ(store.value(1)->text, std::string("new"));
+    EXPECT_EQ(store.update(2, Note("updated"))->text, std::string("updated"));
+    EXPECT_EQ(store.value(2)->text, std::string("updated"));
+    EXPECT_TRUE(store.remove(3));
+    EXPECT_FALSE(store.contains(3));
+    EXPECT_FALSE(store.remove(3));
+}
+
+TYPED_TEST(TstDataStoreSnapshot, Save)
+{
+    typename TestFixture::Store store {};
+    EXPECT_TRUE(store.openSnapshot(this->m_path, 1));
+    store.value(1);
+    store.add(4, Note("four"));
+    EXPECT_TRUE(store.saveSnapshot(this->m_path, 1));
+
+    typename TestFixture::Store saved {};
+    EXPECT_TRUE(saved.openSnapshot(this->m_path, 1));
+    EXPECT_EQ(saved.value(1)->text, std::string("one"));
+    EXPECT_EQ(saved.value(2)->text, std::string("two"));
+    EXPECT_EQ(saved.value(3)->text, std::string("three"));
+    EXPECT_EQ(saved.value(4)->text, std::string("four"));
+    EXPECT_EQ(store.value(2)->text, std::string("two"));
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/data/btreesequence.h>
+#include <microcore/data/indexeddatastore.h>
+#include <microcore/data/indexedmodel.h>
+#include <microcore/data/sortedmodel.h>
+#include <algorithm>
+#include <random>
+
+using namespace ::testing;
+using namespace ::microcore::data;
+
+namespace {
+
+class Score
+{
+public:
+    explicit Score() = default;
+    explicit Score(int k, int v) : key {k}, value {v} {}
+    DEFAULT_COPY_DEFAULT_MOVE(Score);
+    int key {0};
+    int value {0};
+};
+
+class ScoreMapper
+{
+public:
+    using KeyType = int;
+    int operator()(const Score &score) const
+    {
+        return score.key;
+    }
+};
+
+class ScoreCompare
+{
+public:
+    bool operator()(const Score &first, const Score &second) const
+    {
+        return first.value < second.value;
+    }
+};
+
+// Mirrors the rows of a model by replaying its events
+template<class S>
+class Mirror: public IModel<Score, S>::IListener
+{
+public:
+    void onAppend(const std::vector<const Score *> &values) override
+    {
+        rows.insert(std::end(rows), std::begin(values), std::end(values));
+        events.emplace_back("append");
+    }
+    void onPrepend(const std::vector<const Score *> &values) override
+    {
+        rows.insert(std::begin(rows), std::begin(values), std::end(values));
+        events.emplace_back("prepend");
+    }
+    void onInsert(typename S::size_type index, const std::vector<const Score *> &values) override
+    {
+        rows.insert(std::begin(rows) + index, std::begin(values), std::end(values));
+        events.emplace_back("insert " + std::to_string(index));
+    }
+    void onRemove(typename S::size_type index) override
+    {
+        rows.erase(std::begin(rows) + index);
+        events.emplace_back("remove " + std::to_string(index));
+    }
+    void onUpdate(typename S::size_type index, const Score &value) override
+    {
+        EXPECT_EQ(rows[index], &value);
+        events.emplace_back("update " + std::to_string(index));
+    }
+    void onMove(typename S::size_type oldIndex, typename S::size_type newIndex) override
+    {
+        const Score *value {rows[oldIndex]};
+        rows.erase(std::begin(rows) + oldIndex);
+        rows.insert(std::begin(rows) + (newIndex < oldIndex ? newIndex : newIndex - 1), value);
+        events.emplace_back("move " + std::to_string(oldIndex) + " " + std::to_string(newIndex));
+    }
+    void onInvalidation() override
+    {
+        rows.clear();
+        events.emplace_back("invalidation");
+    }
+    std::vector<const Score *> rows {};
+    std::vector<std::string> events {};
+};
+
+using Store = IndexedDataStore<int, Score>;
+using Source = IndexedModel<Score, ScoreMapper>;
+using Sorted = SortedModel<Score, std::deque<const Score *>, ScoreCompare>;
+
+std::vector<int> keys(const IModel<Score, std::deque<const Score *>> &model)
+{
+    std::vector<int> result {};
+    for (const Score *score : model) {
+        result.emplace_back(score->key);
+    }
+    return result;
+}
+
+}
+
+class TstSortedModel: public Test
+{
+protected:
+    void SetUp()
+    {
+        m_source.reset(new Source(m_store));
+        m_source->append({Score(1, 30), Score(2, 10), Score(3, 20)});
+        m_sorted.reset(new Sorted(*m_source));
+        m_sorted->addListener(m_mirror);
+        m_mirror->events.clear();
+    }
+    Store m_store {};
+    std::unique_ptr<Source> m_source {};
+    std::unique_ptr<Sorted> m_sorted {};
+    std::shared_ptr<Mirror<std::deque<const Score *>>> m_mirror {std::make_shared<Mirror<std::deque<const Score *>>>()};
+};
+
+TEST_F(TstSortedModel, Initial)
+{
+    EXPECT_EQ(keys(*m_sorted), std::vector<int>({2, 3, 1}));
+    EXPECT_EQ(m_mirror->rows, std::vector<const Score *>(std::begin(*m_sorted), std::end(*m_sorted)));
+    EXPECT_EQ((*m_sorted)[0]->value, 10);
+    EXPECT_EQ((*m_sorted)[3], nullptr);
+}
+
+TEST_F(TstSortedModel, Insert)
+{
+    m_source->append({Score(4, 25), Score(5, 5)});
+    m_source->insert(1, {Score(6, 20)});
+    EXPECT_EQ(keys(*m_sorted), std::vector<int>({5, 2, 3, 6, 4, 1}));
+    // Rows that compare equal are in the order they were added
+    EXPECT_EQ(m_mirror->events, std::vector<std::string>({"insert 2", "insert 0", "insert 3"}));
+    EXPECT_EQ(m_mirror->rows, std::vector<const Score *>(std::begin(*m_sorted), std::end(*m_sorted)));
+}
+
+TEST_F(TstSortedModel, Remove)
+{
+    m_source->remove(2);
+    m_store.remove(1);
+    EXPECT_EQ(keys(*m_sorted), std::vector<int>({2}));
+    EXPECT_EQ(m_mirror->events, std::vector<std::string>({"remove 1", "remove 1"}));
+}
+
+TEST_F(TstSortedModel, Update)
+{
+    m_source->update(1, Score(2, 40));
+    EXPECT_EQ(keys(*m_sorted), std::vector<int>({3, 1, 2}));
+    m_source->update(1, Score(2, 35));
+    EXPECT_EQ(keys(*m_sorted), std::vector<int>({3, 1, 2}));
+    EXPECT_EQ(m_mirror->events, std::vector<std::string>({"move 0 3", "update 2", "update 2"}));
+    EXPECT_EQ(m_mirror->rows, std::vector<const Score *>(std::begin(*m_sorted), std::end(*m_sorted)));
+}
+
+TEST_F(TstSortedModel, SourceMove)
+{
+    m_source->move(0, 3);
+    m_source->remove(0);
+    EXPECT_EQ(keys(*m_sorted), std::vector<int>({3, 1}));
+    EXPECT_EQ(m_mirror->events, std::vector<std::string>({"remove 0"}));
+}
+
+TEST_F(TstSortedModel, Ranges)
+{
+    m_source->updateMany(0, {Score(1, 0), Score(2, 50)});
+    EXPECT_EQ(keys(*m_sorted), std::vector<int>({1, 3, 2}));
+    m_source->clear();
+    EXPECT_TRUE(m_sorted->empty());
+    EXPECT_TRUE(m_mirror->rows.empty());
+}
+
+TEST_F(TstSortedModel, Invalidation)
+{
+    m_source.reset();
+    EXPECT_TRUE(m_sorted->empty());
+    EXPECT_EQ(m_mirror->events.back(), "invalidation");
+}
+
+// Random operations on the source, the sorted model staying sorted
+TEST(TstSortedModelRandom, Random)
+{
+    using Sequence = BTreeSequence<const Score *, 4, 4>;
+    IndexedDataStore<int, Score> store {};
+    IndexedModel<Score, ScoreMapper, Sequence> source {store};
+    SortedModel<Score, Sequence, ScoreCompare> sorted {source};
+    std::shared_ptr<Mirror<Sequence>> mirror {std::make_shared<Mirror<Sequence>>()};
+    sorted.addListener(mirror);
+
+    std::mt19937 generator {1};
+    int nextKey {0};
+    for (int i = 0; i < 2000; ++i) {
+        int operation = generator() % 5;
+        if (operation == 0 || source.empty()) {
+            std::vector<Score> values {};
+            int count = generator() % 3 + 1;
+            for (int j = 0; j < count; ++j) {
+                values.emplace_back(nextKey++, static_cast<int>(generator() % 50));
+            }
+            source.insert(generator() % (source.size() + 1), std::move(values));
+        } else if (operation == 1) {
+            source.remove(generator() % source.size());
+        } else if (operation == 2) {
+            std::size_t index = generator() % source.size();
+            source.update(index, Score(source[index]->key, static_cast<int>(generator() % 50)));
+        } else if (operation == 3) {
+            source.move(generator() % source.size(), generator() % (source.size() + 1));
+        } else {
+            std::size_t index = generator() % source.size();
+            source.removeRange(index, generator() % 3);
+        }
+
+        ASSERT_EQ(sorted.size(), source.size());
+        ASSERT_TRUE(std::is_sorted(std::begin(sorted), std::end(sorted), [](const Score *first, const Score *second) {
+            return first->value < second->value;
+        }));
+        ASSERT_TRUE(std::is_permutation(std::begin(sorted), std::end(sorted), std::begin(source)));
+        ASSERT_EQ(mirror->rows, std::vector<const Score *>(std::begin(sorted), std::end(sorted)));
+    }
+}
@@ -0,0 +1,348 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <microcore/core/staticpipeline.h>
+#include <map>
+#include <string>
+
+using namespace ::testing;
+using namespace ::microcore::core;
+
+namespace {
+
+static const int CancelledValue {-1000};
+static const int TimeoutValue {-2000};
+
+class Error
+{
+public:
+    explicit Error(int v) : value {v} {}
+    static Error cancelled()
+    {
+        return Error(CancelledValue);
+    }
+    static Error timeout()
+    {
+        return Error(TimeoutValue);
+    }
+    int value {0};
+};
+
+// Adds a constant to the request, fails on negative requests
+class AddJobFactory final : public IJobFactory<int, int, Error>
+{
+public:
+    explicit AddJobFactory(int add) : m_add {add} {}
+    std::unique_ptr<IJob<int, Error>> create(int &&request) const override
+    {
+        return std::unique_ptr<IJob<int, Error>>(new Job(request, m_add));
+    }
+private:
+    class Job final : public IJob<int, Error>
+    {
+    public:
+        explicit Job(int request, int add) : m_request {request}, m_add {add} {}
+        void execute(OnResult &&onResult, OnError &&onError) override
+        {
+            if (m_request < 0) {
+                onError(Error(m_request));
+            } else {
+                onResult(m_request + m_add);
+            }
+        }
+    private:
+        int m_request {0};
+        int m_add {0};
+    };
+    int m_add {0};
+};
+
+class ToStringJobFactory final : public IJobFactory<int, std::string, Error>
+{
+public:
+    std::unique_ptr<IJob<std::string, Error>> create(int &&request) const override
+    {
+        return std::unique_ptr<IJob<std::string, Error>>(new Job(request));
+    }
+private:
+    class Job final : public IJob<std::string, Error>
+    {
+    public:
+        explicit Job(int request) : m_request {request} {}
+        void execute(OnResult &&onResult, OnError &&) override
+        {
+            onResult(std::to_string(m_request));
+        }
+    private:
+        int m_request {0};
+    };
+};
+
+// Doubles the request, with jobs that have a concrete type
+class DoubleJobFactory final : public IJobFactory<int, int, Error>
+{
+public:
+    class Job final : public IJob<int, Error>
+    {
+    public:
+        explicit Job(const DoubleJobFactory &factory, int request) : m_factory {factory}, m_request {request} {}
+        void execute(OnResult &&onResult, OnError &&) override
+        {
+            onResult(m_request * 2);
+        }
+        // Used by StaticPipe, without type erasure
+        template<class R, class E>
+        void execute(R &&onResult, E &&)
+        {
+            ++m_factory.inlined;
+            onResult(m_request * 2);
+        }
+    private:
+        const DoubleJobFactory &m_factory;
+        int m_request {0};
+    };
+    std::unique_ptr<IJob<int, Error>> create(int &&request) const override
+    {
+        return createJob(std::move(request));
+    }
+    std::unique_ptr<Job> createJob(int &&request) const
+    {
+        return std::unique_ptr<Job>(new Job(*this, request));
+    }
+    mutable int inlined {0};
+};
+
+// Jobs are finished from the test
+class DeferredJobFactory final : public IJobFactory<int, int, Error>
+{
+public:
+    std::unique_ptr<IJob<int, Error>> create(int &&request) const override
+    {
+        DeferredJobFactory &factory {const_cast<DeferredJobFactory &>(*this)};
+        return std::unique_ptr<IJob<int, Error>>(new Job(factory, request));
+    }
+    std::size_t running() const
+    {
+        return m_running.size();
+    }
+    const std::vector<int> & cancelled() const
+    {
+        return m_cancelled;
+    }
+    void finish(int value)
+    {
+        auto it = m_running.find(value);
+        ASSERT_FALSE(it == std::end(m_running));
+        IJob<int, Error>::OnResult onResult {std::move(it->second.first)};
+        m_running.erase(it);
+        onResult(int(value));
+    }
+    void fail(int value)
+    {
+        auto it = m_running.find(value);
+        ASSERT_FALSE(it == std::end(m_running));
+        IJob<int, Error>::OnError onError {std::move(it->second.second)};
+        m_running.erase(it);
+        onError(Error(value));
+    }
+private:
+    class Job final : public IJob<int, Error>
+    {
+    public:
+        explicit Job(DeferredJobFactory &factory, int value) : m_factory {factory}, m_value {value} {}
+        void execute(OnResult &&onResult, OnError &&onError) override
+        {
+            m_factory.m_running.emplace(m_value, std::make_pair(std::move(onResult), std::move(onError)));
+        }
+        void cancel() override
+        {
+            m_factory.m_running.erase(m_value);
+            m_factory.m_cancelled.push_back(m_value);
+        }
+    private:
+        DeferredJobFactory &m_factory;
+        int m_value {0};
+    };
+    std::map<int, std::pair<IJob<int, Error>::OnResult, IJob<int, Error>::OnError>> m_running {};
+    std::vector<int> m_cancelled {};
+};
+
+}
+
+class TstStaticPipeline: public Test
+{
+protected:
+    std::vector<std::string> m_results {};
+    std::vector<int> m_errors {};
+    IJob<std::string, Error>::OnResult onResult()
+    {
+        return [this](std::string &&result) {
+            m_results.push_back(std::move(result));
+        };
+    }
+    IJob<std::string, Error>::OnError onError()
+    {
+        return [this](Error &&error) {
+            m_errors.push_back(error.value);
+        };
+    }
+};
+
+TEST_F(TstStaticPipeline, Types)
+{
+    AddJobFactory add {1};
+    ToStringJobFactory toString {};
+    using Pipeline = StaticPipeline<AddJobFactory, AddJobFactory, ToStringJobFactory>;
+    static_assert(std::is_same<decltype(makePipeline(add, add, toString)), Pipeline>::value, "makePipeline");
+    static_assert(std::is_same<decltype(makePipeline(add) | add | toString), Pipeline>::value, "operator|");
+    static_assert(std::is_same<Pipeline::Request, int>::value, "Request");
+    static_assert(std::is_same<Pipeline::Result, std::string>::value, "Result");
+    static_assert(IsChained<AddJobFactory, ToStringJobFactory>::value, "Chained");
+    static_assert(!IsChained<ToStringJobFactory, AddJobFactory>::value, "Not chained");
+}
+
+TEST_F(TstStaticPipeline, Result)
+{
+    AddJobFactory addOne {1};
+    AddJobFactory addTen {10};
+    ToStringJobFactory toString {};
+    auto pipe = (makePipeline(addOne) | addTen | toString).create(onResult(), onError());
+
+    pipe->send(1);
+    pipe->send(5);
+    EXPECT_EQ(m_results, std::vector<std::string>({"12", "16"}));
+    EXPECT_TRUE(m_errors.empty());
+    EXPECT_EQ(pipe->activeCount(), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstStaticPipeline, ConcreteJobs)
+{
+    static_assert(std::is_same<FactoryTraits<AddJobFactory>::Job, IJob<int, Error>>::value, "IJob");
+    static_assert(std::is_same<FactoryTraits<DoubleJobFactory>::Job, DoubleJobFactory::Job>::value, "Concrete job");
+    AddJobFactory addOne {1};
+    DoubleJobFactory twice {};
+    ToStringJobFactory toString {};
+    auto pipe = makePipeline(addOne, twice, twice, toString).create(onResult(), onError());
+
+    pipe->send(1);
+    EXPECT_EQ(m_results, std::vector<std::string>({"8"}));
+    EXPECT_EQ(twice.inlined, 2);
+
+    // Pipe still uses the virtual IJob::execute()
+    Pipe<int, int, Error> dynamicPipe {twice, [this](int &&result) {
+        m_results.push_back(std::to_string(result));
+    }, onError()};
+    dynamicPipe.send(4);
+    EXPECT_EQ(m_results, std::vector<std::string>({"8", "8"}));
+    EXPECT_EQ(twice.inlined, 2);
+}
+
+TEST_F(TstStaticPipeline, Error)
+{
+    AddJobFactory addOne {1};
+    AddJobFactory addMinusTen {-10};
+    AddJobFactory addTen {10};
+    ToStringJobFactory toString {};
+    auto pipe = makePipeline(addOne, addMinusTen, addTen, toString).create(onResult(), onError());
+
+    pipe->send(3);
+    pipe->send(20);
+    EXPECT_EQ(m_results, std::vector<std::string>({"21"}));
+    EXPECT_EQ(m_errors, std::vector<int>({-6}));
+}
+
+TEST_F(TstStaticPipeline, Deferred)
+{
+    DeferredJobFactory deferred {};
+    AddJobFactory addOne {1};
+    ToStringJobFactory toString {};
+    auto pipe = makePipeline(addOne, deferred, toString).create(onResult(), onError());
+
+    pipe->send(1);
+    pipe->send(2);
+    pipe->send(3);
+    EXPECT_EQ(deferred.running(), static_cast<std::size_t>(3));
+    EXPECT_EQ(pipe->activeCount(), static_cast<std::size_t>(3));
+
+    deferred.finish(3);
+    deferred.fail(2);
+    EXPECT_EQ(m_results, std::vector<std::string>({"3"}));
+    EXPECT_EQ(m_errors, std::vector<int>({2}));
+    EXPECT_EQ(pipe->activeCount(), static_cast<std::size_t>(1));
+
+    deferred.finish(4);
+    EXPECT_EQ(m_results, std::vector<std::string>({"3", "4"}));
+    EXPECT_EQ(pipe->activeCount(), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstStaticPipeline, Cancel)
+{
+    DeferredJobFactory deferred {};
+    ToStringJobFactory toString {};
+    auto pipe = makePipeline(deferred, toString).create(onResult(), onError());
+
+    CancellationToken token {CancellationToken::create()};
+    pipe->send(1, token);
+    pipe->send(2);
+    token.cancel();
+    EXPECT_EQ(deferred.cancelled(), std::vector<int>({1}));
+    EXPECT_EQ(m_errors, std::vector<int>({CancelledValue}));
+
+    pipe->send(3, token);
+    EXPECT_EQ(m_errors, std::vector<int>({CancelledValue, CancelledValue}));
+    EXPECT_EQ(deferred.running(), static_cast<std::size_t>(1));
+
+    deferred.finish(2);
+    EXPECT_EQ(m_results, std::vector<std::string>({"2"}));
+}
+
+TEST_F(TstStaticPipeline, Pipe)
+{
+    AddJobFactory addOne {1};
+    DeferredJobFactory deferred {};
+    ToStringJobFactory toString {};
+    Pipe<int, std::string, Error> pipe {toString, onResult(), onError()};
+    std::unique_ptr<Pipe<int, int, Error>> deferredPipe {pipe.prepend(deferred)};
+    auto staticPipe = makePipeline(addOne, addOne) | *deferredPipe;
+
+    staticPipe->send(1);
+    staticPipe->send(2);
+    staticPipe->send(-1);
+    EXPECT_EQ(deferred.running(), static_cast<std::size_t>(1));
+    EXPECT_FALSE(deferredPipe->canSend());
+
+    deferred.finish(3);
+    EXPECT_EQ(m_results, std::vector<std::string>({"3"}));
+    deferred.finish(4);
+    EXPECT_EQ(m_results, std::vector<std::string>({"3", "4"}));
+    EXPECT_EQ(m_errors, std::vector<int>({-1}));
+}
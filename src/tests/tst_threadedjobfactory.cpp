@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <QtTest/QTest>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSemaphore>
+#include <QThread>
+#include <atomic>
+#include <microcore/core/globals.h>
+#include <microcore/core/pipe.h>
+#include <microcore/core/threadedjobfactory.h>
+#include <microcore/json/jsonrequestfactory.h>
+
+using namespace ::testing;
+using namespace ::microcore::core;
+using namespace ::microcore::json;
+
+namespace {
+
+class Result
+{
+public:
+    explicit Result() = default;
+    explicit Result(int v) : value {v} {}
+    DISABLE_COPY_DEFAULT_MOVE(Result);
+    int value {0};
+};
+
+class Error
+{
+public:
+    explicit Error() = default;
+    explicit Error(int v) : value {v} {}
+    DISABLE_COPY_DEFAULT_MOVE(Error);
+    int value {0};
+};
+
+class ThreadJobFactory;
+
+// Job that records the thread it is executed in
+//
+// If a semaphore is provided, the job waits for it
+// to be released before reporting it's result.
+class ThreadJob final : public IJob<Result, Error>
+{
+public:
+    explicit ThreadJob(int request, const ThreadJobFactory &factory)
+        : m_request {request}, m_factory (factory)
+    {
+    }
+    void execute(OnResult &&onResult, OnError &&onError) override;
+private:
+    int m_request {0};
+    const ThreadJobFactory &m_factory;
+};
+
+class ThreadJobFactory final : public IJobFactory<int, Result, Error>
+{
+public:
+    std::unique_ptr<IJob<Result, Error>> create(int &&request) const override
+    {
+        return std::unique_ptr<IJob<Result, Error>>(new ThreadJob(request, *this));
+    }
+    mutable std::atomic<QThread *> thread {nullptr};
+    mutable std::atomic<int> running {0};
+    mutable std::atomic<int> maxRunning {0};
+    QSemaphore *semaphore {nullptr};
+};
+
+void ThreadJob::execute(OnResult &&onResult, OnError &&onError)
+{
+    m_factory.thread = QThread::currentThread();
+    int running {++m_factory.running};
+    int maxRunning {m_factory.maxRunning};
+    while (running > maxRunning && !m_factory.maxRunning.compare_exchange_weak(maxRunning, running)) {
+    }
+
+    bool acquired {m_factory.semaphore == nullptr || m_factory.semaphore->tryAcquire(1, 5000)};
+    --m_factory.running;
+    if (!acquired) {
+        onError(Error(-1));
+    } else if (m_request < 0) {
+        onError(Error(m_request));
+    } else {
+        onResult(Result(m_request));
+    }
+}
+
+using TestThreadedJobFactory = ThreadedJobFactory<int, Result, Error>;
+
+template<class T>
+bool wait(const T &condition)
+{
+    QElapsedTimer timer {};
+    timer.start();
+    while (!condition() && !timer.hasExpired(5000)) {
+        QTest::qWait(10);
+    }
+    return condition();
+}
+
+}
+
+class TstThreadedJobFactory: public Test
+{
+protected:
+    void SetUp() override final
+    {
+        m_threadPool.setMaxThreadCount(2);
+        m_factory.reset(new TestThreadedJobFactory(m_jobFactory, m_threadPool));
+    }
+    void TearDown() override final
+    {
+        m_threadPool.waitForDone();
+    }
+    QThreadPool m_threadPool {};
+    ThreadJobFactory m_jobFactory {};
+    std::unique_ptr<TestThreadedJobFactory> m_factory {};
+};
+
+TEST_F(TstThreadedJobFactory, TestResult)
+{
+    int result {0};
+    QThread *callbackThread {nullptr};
+    std::unique_ptr<IJob<Result, Error>> job {m_factory->create(123)};
+    job->execute([&result, &callbackThread](Result &&value) {
+        result = value.value;
+        callbackThread = QThread::currentThread();
+    }, [](Error &&) {
+        ADD_FAILURE();
+    });
+    EXPECT_EQ(result, 0); // Not invoked synchronously
+
+    EXPECT_TRUE(wait([&result]() { return result != 0; }));
+    EXPECT_EQ(result, 123);
+    EXPECT_EQ(callbackThread, QThread::currentThread());
+    EXPECT_NE(m_jobFactory.thread.load(), nullptr);
+    EXPECT_NE(m_jobFactory.thread.load(), QThread::currentThread());
+}
+
+TEST_F(TstThreadedJobFactory, TestError)
+{
+    int error {0};
+    QThread *callbackThread {nullptr};
+    std::unique_ptr<IJob<Result, Error>> job {m_factory->create(-123)};
+    job->execute([](Result &&) {
+        ADD_FAILURE();
+    }, [&error, &callbackThread](Error &&value) {
+        error = value.value;
+        callbackThread = QThread::currentThread();
+    });
+    EXPECT_EQ(error, 0); // Not invoked synchronously
+
+    EXPECT_TRUE(wait([&error]() { return error != 0; }));
+    EXPECT_EQ(error, -123);
+    EXPECT_EQ(callbackThread, QThread::currentThread());
+    EXPECT_NE(m_jobFactory.thread.load(), QThread::currentThread());
+}
+
+TEST_F(TstThreadedJobFactory, TestCallerThreadIsFree)
+{
+    // The job blocks until the caller thread releases the semaphore
+    // This can only succeed if the caller thread is not blocked
+    QSemaphore semaphore {};
+    m_jobFactory.semaphore = &semaphore;
+
+    int result {0};
+    std::unique_ptr<IJob<Result, Error>> job {m_factory->create(123)};
+    job->execute([&result](Result &&value) {
+        result = value.value;
+    }, [](Error &&) {
+        ADD_FAILURE();
+    });
+    semaphore.release();
+
+    EXPECT_TRUE(wait([&result]() { return result != 0; }));
+    EXPECT_EQ(result, 123);
+}
+
+TEST_F(TstThreadedJobFactory, TestDestroyedBeforeResult)
+{
+    QSemaphore semaphore {};
+    m_jobFactory.semaphore = &semaphore;
+
+    bool called {false};
+    std::unique_ptr<IJob<Result, Error>> job {m_factory->create(123)};
+    job->execute([&called](Result &&) {
+        called = true;
+    }, [&called](Error &&) {
+        called = true;
+    });
+    job.reset();
+    semaphore.release();
+
+    m_threadPool.waitForDone();
+    QTest::qWait(50);
+    EXPECT_FALSE(called);
+}
+
+TEST_F(TstThreadedJobFactory, TestBounded)
+{
+    QSemaphore semaphore {};
+    m_jobFactory.semaphore = &semaphore;
+
+    int count {0};
+    std::vector<std::unique_ptr<IJob<Result, Error>>> jobs {};
+    for (int i = 1; i <= 6; ++i) {
+        int request {i};
+        jobs.emplace_back(m_factory->create(std::move(request)));
+        jobs.back()->execute([&count](Result &&) {
+            ++count;
+        }, [](Error &&) {
+            ADD_FAILURE();
+        });
+    }
+    EXPECT_TRUE(wait([this]() { return m_jobFactory.running.load() == 2; }));
+    semaphore.release(6);
+
+    EXPECT_TRUE(wait([&count]() { return count == 6; }));
+    EXPECT_EQ(m_jobFactory.maxRunning.load(), 2);
+}
+
+using JsonPipe = Pipe<JsonRequest, JsonResult, JsonError>;
+
+TEST_F(TstThreadedJobFactory, TestLargeJson)
+{
+    QJsonArray array {};
+    for (int i = 0; i < 50000; ++i) {
+        array.append(QJsonObject {
+            {"id", i},
+            {"name", QString("item %1").arg(i)},
+            {"description", QString(64, QLatin1Char('x'))}
+        });
+    }
+    QByteArray data {QJsonDocument(array).toJson(QJsonDocument::Compact)};
+
+    JsonRequestFactory jsonFactory {};
+    ThreadedJobFactory<JsonRequest, JsonResult, JsonError> factory {jsonFactory, m_threadPool};
+
+    bool called {false};
+    int size {0};
+    QThread *callbackThread {nullptr};
+    JsonPipe pipe {factory, [&called, &size, &callbackThread](JsonResult &&result) {
+        called = true;
+        size = result.array().size();
+        callbackThread = QThread::currentThread();
+    }, [](JsonError &&) {
+        ADD_FAILURE();
+    }};
+
+    ::microcore::qt::QObjectPtr<QIODevice> bufferPtr {new QBuffer(&data)};
+    bufferPtr->open(QIODevice::ReadOnly);
+    pipe.send(JsonRequest(std::move(bufferPtr)));
+    EXPECT_FALSE(called); // Parsing is not performed in the caller thread
+
+    EXPECT_TRUE(wait([&called]() { return called; }));
+    EXPECT_EQ(size, 50000);
+    EXPECT_EQ(callbackThread, QThread::currentThread());
+}
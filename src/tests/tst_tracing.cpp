@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2016 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <gtest/gtest.h>
+#include <QtTest/QTest>
+#include <microcore/core/tracing.h>
+#include <microcore/core/executor.h>
+#include <microcore/core/pipe.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace ::testing;
+using namespace ::microcore::core;
+
+namespace {
+
+class Error
+{
+public:
+    explicit Error() = default;
+    explicit Error(int v) : value {v} {}
+    bool empty() const
+    {
+        return value == 0;
+    }
+    static Error cancelled()
+    {
+        return Error(-1);
+    }
+    static Error timeout()
+    {
+        return Error(-2);
+    }
+    int value {0};
+};
+
+class TestExecutor : public Executor<Error>
+{
+public:
+    void start()
+    {
+        doStart();
+    }
+    void finish()
+    {
+        doFinish();
+    }
+};
+
+class IncrementJobFactory final : public IJobFactory<int, int, Error>
+{
+public:
+    std::unique_ptr<IJob<int, Error>> create(int &&request) const override
+    {
+        return std::unique_ptr<IJob<int, Error>>(new Job(request));
+    }
+private:
+    class Job final : public IJob<int, Error>
+    {
+    public:
+        explicit Job(int request) : m_request {request} {}
+        void execute(OnResult &&onResult, OnError &&onError) override
+        {
+            Q_UNUSED(onError);
+            onResult(m_request + 1);
+        }
+    private:
+        int m_request {0};
+    };
+};
+
+std::size_t count(const std::string &json, const std::string &pattern)
+{
+    std::size_t result {0};
+    for (std::size_t i = json.find(pattern); i != std::string::npos; i = json.find(pattern, i + 1)) {
+        ++result;
+    }
+    return result;
+}
+
+class TstTracing : public Test
+{
+protected:
+    void SetUp() override
+    {
+        Tracer::global().clear();
+    }
+    void TearDown() override
+    {
+        Tracer::global().stop();
+        Tracer::global().clear();
+    }
+};
+
+}
+
+TEST_F(TstTracing, DisabledRecordsNothing)
+{
+    Tracer &tracer {Tracer::global()};
+    EXPECT_FALSE(tracer.isEnabled());
+    EXPECT_EQ(tracer.createFlow(), static_cast<std::uint64_t>(0));
+    {
+        TraceScope scope {"test", "test"};
+        scope.flow('s', 1);
+    }
+    EXPECT_EQ(tracer.eventCount(), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstTracing, Scope)
+{
+    Tracer &tracer {Tracer::global()};
+    tracer.start();
+    std::uint64_t flow {tracer.createFlow()};
+    EXPECT_NE(flow, static_cast<std::uint64_t>(0));
+    {
+        TraceScope scope {"outer", "test"};
+        scope.flow('s', flow);
+        TraceScope inner {"inner", "test"};
+    }
+    tracer.stop();
+    {
+        TraceScope scope {"ignored", "test"};
+    }
+
+    EXPECT_EQ(tracer.eventCount(), static_cast<std::size_t>(3));
+    std::string json {tracer.toJson()};
+    EXPECT_EQ(json.find("{\"traceEvents\":["), static_cast<std::size_t>(0));
+    EXPECT_EQ(count(json, "\"name\":\"outer\",\"cat\":\"test\",\"ph\":\"X\""), static_cast<std::size_t>(1));
+    EXPECT_EQ(count(json, "\"name\":\"inner\",\"cat\":\"test\",\"ph\":\"X\""), static_cast<std::size_t>(1));
+    EXPECT_EQ(count(json, "\"ph\":\"s\""), static_cast<std::size_t>(1));
+    EXPECT_EQ(count(json, "\"dur\":"), static_cast<std::size_t>(2));
+    EXPECT_EQ(count(json, "ignored"), static_cast<std::size_t>(0));
+}
+
+TEST_F(TstTracing, ThreadIds)
+{
+    Tracer &tracer {Tracer::global()};
+    tracer.start();
+    {
+        TraceScope scope {"main", "test"};
+    }
+    std::thread thread {[]() {
+        TraceScope scope {"worker", "test"};
+    }};
+    thread.join();
+
+    std::string json {tracer.toJson()};
+    std::size_t main {json.find("\"tid\":", json.find("\"main\""))};
+    std::size_t worker {json.find("\"tid\":", json.find("\"worker\""))};
+    ASSERT_NE(main, std::string::npos);
+    ASSERT_NE(worker, std::string::npos);
+    EXPECT_NE(json.substr(main, json.find_first_of(",}", main) - main),
+              json.substr(worker, json.find_first_of(",}", worker) - worker));
+}
+
+TEST_F(TstTracing, Pipeline)
+{
+    IncrementJobFactory factory {};
+    std::vector<int> results {};
+    Pipe<int, int, Error> pipe {factory, [&results](int &&result) {
+        results.push_back(result);
+    }, [](Error &&) {}};
+    std::unique_ptr<Pipe<int, int, Error>> first {pipe.prepend<int>(factory)};
+
+    Tracer &tracer {Tracer::global()};
+    tracer.start();
+    EXPECT_TRUE(first->send(1));
+    EXPECT_TRUE(first->send(10));
+    tracer.stop();
+
+    EXPECT_EQ(results, std::vector<int>({3, 12}));
+    std::string json {tracer.toJson()};
+    EXPECT_EQ(count(json, "\"name\":\"Pipe::send\""), static_cast<std::size_t>(2));
+    EXPECT_EQ(count(json, "\"name\":\"IJob::execute\""), static_cast<std::size_t>(4));
+    EXPECT_EQ(count(json, "\"name\":\"Pipe::release\""), static_cast<std::size_t>(2));
+    // Each request is a flow going through both stages
+    EXPECT_EQ(count(json, "\"ph\":\"s\""), static_cast<std::size_t>(2));
+    EXPECT_EQ(count(json, "\"ph\":\"t\""), static_cast<std::size_t>(2));
+    EXPECT_EQ(count(json, "\"ph\":\"f\""), static_cast<std::size_t>(2));
+    EXPECT_EQ(count(json, "\"ph\":\"b\""), static_cast<std::size_t>(4));
+    EXPECT_EQ(count(json, "\"ph\":\"e\""), static_cast<std::size_t>(4));
+}
+
+TEST_F(TstTracing, Executor)
+{
+    TestExecutor executor {};
+    Tracer &tracer {Tracer::global()};
+    tracer.start();
+    executor.start();
+    executor.finish();
+    tracer.stop();
+
+    std::string json {tracer.toJson()};
+    EXPECT_EQ(count(json, "\"name\":\"Executor::doStart\""), static_cast<std::size_t>(1));
+    EXPECT_EQ(count(json, "\"name\":\"Executor::doFinish\""), static_cast<std::size_t>(1));
+    std::size_t notifications {ListenerTracingEnabled ? 2u : 0u};
+    EXPECT_EQ(count(json, "\"name\":\"ListenerRepository::notify\""), notifications);
+}
+
+TEST_F(TstTracing, Capacity)
+{
+    Tracer &tracer {Tracer::global()};
+    EXPECT_NE(tracer.capacity(), static_cast<std::size_t>(0));
+    std::size_t capacity {tracer.capacity()};
+    tracer.setCapacity(3);
+    tracer.start();
+    const char *names[] {"first", "second", "third", "fourth", "fifth"};
+    for (const char *name : names) {
+        TraceScope scope {name, "test"};
+    }
+    tracer.stop();
+
+    EXPECT_EQ(tracer.eventCount(), static_cast<std::size_t>(3));
+    EXPECT_EQ(tracer.droppedCount(), static_cast<std::size_t>(2));
+    std::string json {tracer.toJson()};
+    EXPECT_EQ(count(json, "\"name\":\"first\""), static_cast<std::size_t>(0));
+    EXPECT_EQ(count(json, "\"name\":\"second\""), static_cast<std::size_t>(0));
+    // The remaining events are exported from the oldest
+    std::size_t third {json.find("\"name\":\"third\"")};
+    std::size_t fourth {json.find("\"name\":\"fourth\"")};
+    std::size_t fifth {json.find("\"name\":\"fifth\"")};
+    ASSERT_NE(third, std::string::npos);
+    EXPECT_LT(third, fourth);
+    EXPECT_LT(fourth, fifth);
+    EXPECT_NE(fifth, std::string::npos);
+
+    tracer.setCapacity(1);
+    EXPECT_EQ(tracer.eventCount(), static_cast<std::size_t>(1));
+    EXPECT_EQ(tracer.droppedCount(), static_cast<std::size_t>(4));
+    EXPECT_EQ(count(tracer.toJson(), "\"name\":\"fifth\""), static_cast<std::size_t>(1));
+
+    tracer.clear();
+    EXPECT_EQ(tracer.droppedCount(), static_cast<std::size_t>(0));
+    tracer.setCapacity(capacity);
+}
+
+TEST_F(TstTracing, Escape)
+{
+    Tracer &tracer {Tracer::global()};
+    tracer.start();
+    std::string longName (300, 'a');
+    {
+        TraceScope scope {"\"quoted\"\n", "back\\slash"};
+        TraceScope inner {longName.c_str(), "test"};
+    }
+    tracer.stop();
+
+    std::string json {tracer.toJson()};
+    EXPECT_EQ(count(json, "\"name\":\"\\\"quoted\\\"\\u000a\",\"cat\":\"back\\\\slash\""), static_cast<std::size_t>(1));
+    EXPECT_EQ(count(json, "\"name\":\"" + longName + "\",\"cat\":\"test\",\"ph\":\"X\""), static_cast<std::size_t>(1));
+}
+
+TEST_F(TstTracing, Save)
+{
+    Tracer &tracer {Tracer::global()};
+    tracer.start();
+    {
+        TraceScope scope {"test", "test"};
+    }
+    tracer.stop();
+
+    std::string path {"tst_tracing.json"};
+    ASSERT_TRUE(tracer.save(path));
+    std::ifstream file {path};
+    std::stringstream content {};
+    content << file.rdbuf();
+    EXPECT_EQ(content.str(), tracer.toJson());
+    std::remove(path.c_str());
+}
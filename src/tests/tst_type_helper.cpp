@@ -38,6 +38,18 @@ namespace {
 
 class Class {};
 
+class Fetchable
+{
+public:
+    bool canFetchMore() const
+    {
+        return true;
+    }
+    void fetchMore()
+    {
+    }
+};
+
 }
 
 TEST(KeyReference, Base)
@@ -83,3 +95,19 @@ TEST(KeyReference, Base)
         EXPECT_TRUE(value);
     }
 }
+
+TEST(Fetchable, Base)
+{
+    {
+        bool value = is_fetchable<Fetchable>::value;
+        EXPECT_TRUE(value);
+    }
+    {
+        bool value = is_fetchable<Class>::value;
+        EXPECT_FALSE(value);
+    }
+    {
+        bool value = is_fetchable<int>::value;
+        EXPECT_FALSE(value);
+    }
+}
@@ -31,19 +31,234 @@
 
 #include <gtest/gtest.h>
 #include <microcore/qt/viewcontroller.h>
+#include <QCoreApplication>
 
 using namespace ::testing;
+using namespace ::microcore::core;
+using namespace ::microcore::error;
 using namespace ::microcore::qt;
 
-class TstViewController: public Test
+namespace {
+
+// Executor that fails with a cancelled error when cancelled
+class TestExecutor : public Executor<Error>
+{
+public:
+    void start(int request)
+    {
+        if (!canStart()) {
+            return;
+        }
+        doStart();
+        started.push_back(request);
+        m_listener = std::make_shared<TokenListener>(*this);
+        token().addListener(m_listener);
+    }
+    void finish()
+    {
+        doFinish();
+    }
+    void fail()
+    {
+        doError(Error("test", QLatin1String("Error message"), QByteArray()));
+    }
+    std::vector<int> started {};
+    bool ignoreCancel {false};
+private:
+    class TokenListener final : public CancellationToken::IListener
+    {
+    public:
+        explicit TokenListener(TestExecutor &executor) : m_executor {executor} {}
+        void onCancel(CancellationToken::State) override
+        {
+            if (!m_executor.ignoreCancel) {
+                m_executor.doError(Error::cancelled());
+            }
+        }
+        void onInvalidation() override
+        {
+        }
+    private:
+        TestExecutor &m_executor;
+    };
+    std::shared_ptr<TokenListener> m_listener {};
+};
+
+class TestViewController : public ViewController
 {
 public:
+    explicit TestViewController()
+        : m_executor {std::make_shared<TestExecutor>()}
+    {
+        addExecutor(m_executor);
+    }
+    bool send(int request)
+    {
+        return start(*m_executor, std::move(request));
+    }
+    bool sendTo(TestExecutor &executor, int request)
+    {
+        return start(executor, std::move(request));
+    }
+    TestExecutor & executor()
+    {
+        return *m_executor;
+    }
+private:
+    std::shared_ptr<TestExecutor> m_executor {};
+};
 
+}
+
+class TstViewController: public Test
+{
+protected:
+    void SetUp() override
+    {
+        QObject::connect(&m_controller, &ViewController::statusChanged, [this]() {
+            m_statuses.push_back(m_controller.status());
+        });
+        QObject::connect(&m_controller, &ViewController::error, [this]() {
+            ++m_errors;
+        });
+    }
+    TestViewController m_controller {};
+    std::vector<ViewController::Status> m_statuses {};
+    int m_errors {0};
 };
 
 TEST_F(TstViewController, AddUnique)
 {
+    TestExecutor other {};
+    EXPECT_FALSE(m_controller.sendTo(other, 1));
+    EXPECT_TRUE(other.started.empty());
+    EXPECT_TRUE(m_controller.send(1));
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1}));
+}
+
+TEST_F(TstViewController, Reject)
+{
+    EXPECT_EQ(m_controller.startPolicy(), ViewController::Reject);
+    EXPECT_TRUE(m_controller.send(1));
+    EXPECT_FALSE(m_controller.send(2));
+    m_controller.executor().finish();
+    EXPECT_EQ(m_controller.status(), ViewController::Idle);
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1}));
+    EXPECT_EQ(m_controller.startMetrics().started, 1);
+    EXPECT_EQ(m_controller.startMetrics().dropped, 1);
+}
+
+TEST_F(TstViewController, Queue)
+{
+    m_controller.setStartPolicy(ViewController::Queue);
+    m_controller.setQueueLimit(2);
+    EXPECT_TRUE(m_controller.send(1));
+    EXPECT_TRUE(m_controller.send(2));
+    EXPECT_TRUE(m_controller.send(3));
+    EXPECT_FALSE(m_controller.send(4));
+
+    m_controller.executor().finish();
+    QCoreApplication::processEvents();
+    EXPECT_EQ(m_controller.status(), ViewController::Busy);
+    m_controller.executor().fail();
+    QCoreApplication::processEvents();
+    EXPECT_EQ(m_controller.status(), ViewController::Busy);
+    EXPECT_EQ(m_errors, 1);
+    m_controller.executor().finish();
+    QCoreApplication::processEvents();
+    EXPECT_EQ(m_controller.status(), ViewController::Idle);
+
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1, 2, 3}));
+    EXPECT_EQ(m_controller.startMetrics().started, 3);
+    EXPECT_EQ(m_controller.startMetrics().queued, 2);
+    EXPECT_EQ(m_controller.startMetrics().dropped, 1);
+}
+
+TEST_F(TstViewController, LatestWins)
+{
+    m_controller.setStartPolicy(ViewController::LatestWins);
+    EXPECT_TRUE(m_controller.send(1));
+    EXPECT_TRUE(m_controller.send(2));
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1}));
+    QCoreApplication::processEvents();
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1, 2}));
+    EXPECT_EQ(m_controller.status(), ViewController::Busy);
+    EXPECT_EQ(m_errors, 0);
+
+    m_controller.executor().finish();
+    EXPECT_EQ(m_controller.status(), ViewController::Idle);
+    EXPECT_EQ(m_statuses, std::vector<ViewController::Status>({ViewController::Busy, ViewController::Idle}));
+    EXPECT_EQ(m_controller.startMetrics().started, 2);
+    EXPECT_EQ(m_controller.startMetrics().superseded, 1);
+}
+
+TEST_F(TstViewController, LatestWinsCoalesce)
+{
+    m_controller.setStartPolicy(ViewController::LatestWins);
+    m_controller.executor().ignoreCancel = true;
+    EXPECT_TRUE(m_controller.send(1));
+    EXPECT_TRUE(m_controller.send(2));
+    EXPECT_TRUE(m_controller.send(3));
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1}));
+
+    m_controller.executor().finish();
+    QCoreApplication::processEvents();
+    EXPECT_EQ(m_controller.status(), ViewController::Busy);
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1, 3}));
+    EXPECT_EQ(m_controller.startMetrics().coalesced, 1);
+    EXPECT_EQ(m_controller.startMetrics().superseded, 1);
+}
+
+TEST_F(TstViewController, CancelDropsQueue)
+{
+    m_controller.setStartPolicy(ViewController::Queue);
+    EXPECT_TRUE(m_controller.send(1));
+    EXPECT_TRUE(m_controller.send(2));
+    m_controller.cancel();
+    EXPECT_EQ(m_controller.status(), ViewController::Error);
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1}));
+    EXPECT_EQ(m_controller.startMetrics().dropped, 1);
+}
+
+TEST_F(TstViewController, StartPendingDeferred)
+{
+    m_controller.setStartPolicy(ViewController::Queue);
+    EXPECT_TRUE(m_controller.send(1));
+    EXPECT_TRUE(m_controller.send(2));
+
+    // Waiting requests are not started while the executor notifies
+    std::vector<int> startedOnFinish {};
+    QObject::connect(&m_controller, &ViewController::finished, [this, &startedOnFinish]() {
+        startedOnFinish = m_controller.executor().started;
+    });
+    m_controller.executor().finish();
+    EXPECT_EQ(startedOnFinish, std::vector<int>({1}));
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1}));
+
+    // Requests sent meanwhile wait behind them
+    EXPECT_TRUE(m_controller.send(3));
+    QCoreApplication::processEvents();
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1, 2}));
+    EXPECT_EQ(m_controller.status(), ViewController::Busy);
+
+    m_controller.executor().finish();
+    QCoreApplication::processEvents();
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1, 2, 3}));
+}
+
+TEST_F(TstViewController, LatestWinsCancelled)
+{
+    m_controller.setStartPolicy(ViewController::LatestWins);
+    EXPECT_TRUE(m_controller.send(1));
+    EXPECT_TRUE(m_controller.send(2));
+    EXPECT_EQ(m_controller.status(), ViewController::Busy);
 
+    // The superseding request is dropped before it starts
+    m_controller.cancel();
+    QCoreApplication::processEvents();
+    EXPECT_EQ(m_controller.executor().started, std::vector<int>({1}));
+    EXPECT_EQ(m_controller.status(), ViewController::Idle);
+    EXPECT_EQ(m_errors, 0);
 }
 
 class ITest